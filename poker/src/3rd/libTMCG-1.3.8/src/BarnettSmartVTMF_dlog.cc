@@ -822,6 +822,36 @@ bool BarnettSmartVTMF_dlog::CP_Verify
 	}
 }
 
+// Same SPK as CP_Prove, but the commitments $a$ and $b$ are appended to
+// the output. Verifiers that only know CP_Verify read $c$ and $r$ and
+// ignore the rest, whereas VerifiableDecryptionProtocol_Verify_Batch uses
+// the commitments for the small exponent batch test [BGR98].
+void BarnettSmartVTMF_dlog::CP_Prove_Batch
+	(mpz_srcptr x, mpz_srcptr y, mpz_srcptr gg, mpz_srcptr hh,
+	mpz_srcptr alpha, std::ostream& out) const
+{
+	mpz_t a, b, omega, c, r;
+	mpz_init(c), mpz_init(r), mpz_init(a), mpz_init(b), mpz_init(omega);
+
+	// 1. commitment
+	mpz_srandomm(omega, q);
+	mpz_spowm(a, gg, omega, p);
+	mpz_spowm(b, hh, omega, p);
+	// 2. challenge
+	mpz_shash(c, 10, p, q, g, h, a, b, x, y, gg, hh);
+	// 3. response
+	mpz_mul(r, c, alpha);
+	mpz_neg(r, r);
+	mpz_add(r, r, omega);
+	mpz_mod(r, r, q);
+
+	// write SPK and commitments to output stream
+	out << c << std::endl << r << std::endl;
+	out << a << std::endl << b << std::endl;
+
+	mpz_clear(c), mpz_clear(r), mpz_clear(a), mpz_clear(b), mpz_clear(omega);
+}
+
 void BarnettSmartVTMF_dlog::OR_ProveFirst
 	(mpz_srcptr y_1, mpz_srcptr y_2, mpz_srcptr g_1, mpz_srcptr g_2,
 		mpz_srcptr alpha, std::ostream& out) const
@@ -1064,6 +1094,30 @@ void BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Remask
 	mpz_mod(c__2, c__2, p);
 }
 
+// The masking value $r$ and the powers $g^r$ and $h^r$ do not depend on the
+// card, thus they can be computed in advance once the common public key $h$
+// is fixed. Only the reentrant mpz_fspowm is used, hence this method may be
+// called by a background thread while the instance is used otherwise.
+void BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Precompute
+	(mpz_ptr r, mpz_ptr g_r, mpz_ptr h_r) const
+{
+	MaskingValue(r);
+	mpz_fspowm(fpowm_table_g, g_r, g, r, p);
+	mpz_fspowm(fpowm_table_h, h_r, h, r, p);
+}
+
+void BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Remask
+	(mpz_srcptr c_1, mpz_srcptr c_2, mpz_ptr c__1, mpz_ptr c__2,
+	mpz_srcptr g_r, mpz_srcptr h_r) const
+{
+	// compute $c'_1 = c_1 \cdot g^r \bmod p$ and $c'_2 = c_2 \cdot h^r \bmod p$
+	// with the precomputed powers
+	mpz_mul(c__1, c_1, g_r);
+	mpz_mod(c__1, c__1, p);
+	mpz_mul(c__2, c_2, h_r);
+	mpz_mod(c__2, c__2, p);
+}
+
 void BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Prove
 	(mpz_srcptr c_1, mpz_srcptr c_2, mpz_srcptr c__1, mpz_srcptr c__2,
 	mpz_srcptr r, std::ostream& out) const
@@ -1201,6 +1255,287 @@ void BarnettSmartVTMF_dlog::VerifiableDecryptionProtocol_Verify_Finalize
 	mpz_mod(m, m, p);
 }
 
+void BarnettSmartVTMF_dlog::VerifiableDecryptionProtocol_Prove_Batch
+	(mpz_srcptr c_1, std::ostream& out) const
+{
+	mpz_t d_i;
+	mpz_init(d_i);
+	assert(CheckElement(c_1));
+	
+	// compute $d_i = {c_1}^{x_i} \bmod p$
+	mpz_spowm(d_i, c_1, x_i, p);
+	out << d_i << std::endl << h_i_fp << std::endl;
+	
+	// invoke CP(d_i, h_i, c_1, g; x_i) as prover, with commitments
+	CP_Prove_Batch(d_i, h_i, c_1, g, x_i, out);
+	
+	mpz_clear(d_i);
+}
+
+// check $gg^r x^c = a$ and $hh^r y^c = b$
+static bool CP_CheckCommitments
+	(mpz_srcptr p, mpz_srcptr x, mpz_srcptr y, mpz_srcptr gg, mpz_srcptr hh,
+	mpz_srcptr c, mpz_srcptr r, mpz_srcptr a, mpz_srcptr b)
+{
+	mpz_t foo, bar;
+	mpz_init(foo), mpz_init(bar);
+	mpz_powm(foo, gg, r, p);
+	mpz_powm(bar, x, c, p);
+	mpz_mul(foo, foo, bar);
+	mpz_mod(foo, foo, p);
+	bool ok = !mpz_cmp(foo, a);
+	if (ok)
+	{
+		mpz_powm(foo, hh, r, p);
+		mpz_powm(bar, y, c, p);
+		mpz_mul(foo, foo, bar);
+		mpz_mod(foo, foo, p);
+		ok = !mpz_cmp(foo, b);
+	}
+	mpz_clear(foo), mpz_clear(bar);
+	return ok;
+}
+
+// Verifies the decryption shares $d_j$ for the cards $c_1[i]$ in one go.
+// Proofs that carry the commitments $a$ and $b$ (VerifiableDecryption-
+// Protocol_Prove_Batch) are checked together by the small exponent test
+// [BGR98] with random odd $\delta_i$ of TMCG_BATCH_L_E bits:
+//   $\prod a_i^{\delta_i} = \prod {c_1}_i^{\delta_i r_i} d_i^{\delta_i c_i}$ and
+//   $\prod b_i^{\delta_i} = g^{\sum \delta_i r_i} \prod h_j^{\sum \delta_i c_i}$,
+// where the exponents of equal bases (same card, same player) are summed
+// and each side is computed by one simultaneous exponentiation (mpz_mpowm).
+// The shares $d_j$ are used for decryption, thus each of them is checked
+// to be in $G$. The commitments are only range checked on their own, their
+// subgroup membership is checked once on the combined products instead.
+// A commitment outside of $G$ with a component of order 2 is always caught
+// there since the $\delta_i$ are odd; other components of small order $t$
+// are caught except with probability $1/t$, and then they cancel out and
+// the equations hold for the projections onto $G$, i.e., the share is
+// correct anyway.
+// If the batch fails, every proof is checked on its own (including the
+// full in-group check of its commitments) to find the culprit.
+// Proofs without commitments are checked on their own as in CP_Verify.
+// The shares are not accumulated, use VerifiableDecryptionProtocol_Verify_-
+// Accumulate for each share with result[i] == true.
+// [BGR98] Mihir Bellare, Juan A. Garay, Tal Rabin: 'Fast Batch Verification
+//         for Modular Exponentiation and Digital Signatures',
+//         Advances in Cryptology - EUROCRYPT'98, LNCS 1403, pp. 236--250, 1998.
+bool BarnettSmartVTMF_dlog::VerifiableDecryptionProtocol_Verify_Batch
+	(const std::vector<mpz_srcptr>& c_1, const std::vector<std::istream*>& in,
+	std::vector<bool>& result) const
+{
+	assert(c_1.size() == in.size());
+	
+	const size_t n = in.size();
+	std::vector<mpz_ptr> d_j, c, r, a, b;
+	std::vector<mpz_srcptr> y(n, NULL);
+	std::vector<size_t> batch;
+	mpz_t h_j_fp, foo, bar;
+	mpz_init(h_j_fp), mpz_init(foo), mpz_init(bar);
+	result.assign(n, false);
+	
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_ptr tmp = new mpz_t(), tmp2 = new mpz_t(), tmp3 = new mpz_t();
+		mpz_ptr tmp4 = new mpz_t(), tmp5 = new mpz_t();
+		mpz_init(tmp), mpz_init(tmp2), mpz_init(tmp3), mpz_init(tmp4),
+			mpz_init(tmp5);
+		d_j.push_back(tmp), c.push_back(tmp2), r.push_back(tmp3);
+		a.push_back(tmp4), b.push_back(tmp5);
+		
+		*in[i] >> d_j[i] >> h_j_fp >> c[i] >> r[i];
+		if (!in[i]->good())
+			continue;
+		
+		// public key stored?
+		std::ostringstream fp;
+		fp << h_j_fp;
+		std::map<std::string, mpz_ptr>::const_iterator j = h_j.find(fp.str());
+		if (j == h_j.end())
+			continue;
+		y[i] = j->second;
+		
+		// verify the in-group property and the sizes of $c$ and $r$
+		if (!CheckElement(d_j[i]))
+			continue;
+		if ((mpz_sizeinbase(c[i], 2L) / 8L) > mpz_shash_len())
+			continue;
+		if (mpz_cmpabs(r[i], q) >= 0)
+			continue;
+		
+		*in[i] >> a[i] >> b[i];
+		if (in[i]->fail())
+		{
+			// no commitments: recompute them as in CP_Verify
+			mpz_powm(foo, c_1[i], r[i], p);
+			mpz_powm(bar, d_j[i], c[i], p);
+			mpz_mul(a[i], foo, bar);
+			mpz_mod(a[i], a[i], p);
+			mpz_powm(foo, g, r[i], p);
+			mpz_powm(bar, y[i], c[i], p);
+			mpz_mul(b[i], foo, bar);
+			mpz_mod(b[i], b[i], p);
+			mpz_shash(foo, 10, p, q, g, h, a[i], b[i], d_j[i], y[i], c_1[i], g);
+			result[i] = !mpz_cmp(foo, c[i]);
+			continue;
+		}
+		// check $0 < a, b < p$, the subgroup is checked below
+		if ((mpz_cmp_ui(a[i], 0L) <= 0) || (mpz_cmp(a[i], p) >= 0) ||
+			(mpz_cmp_ui(b[i], 0L) <= 0) || (mpz_cmp(b[i], p) >= 0))
+				continue;
+		
+		// the challenge must be derived from the commitments
+		mpz_shash(foo, 10, p, q, g, h, a[i], b[i], d_j[i], y[i], c_1[i], g);
+		if (mpz_cmp(foo, c[i]))
+			continue;
+		batch.push_back(i);
+	}
+	
+	bool batch_ok = false;
+	if (batch.size() > 1)
+	{
+		mpz_t lhs_a, lhs_b, rhs_a, rhs_b, sum_r;
+		mpz_init(lhs_a), mpz_init(lhs_b), mpz_init(rhs_a), mpz_init(rhs_b),
+			mpz_init_set_ui(sum_r, 0L);
+		// $\delta_i$ and $\delta_i c_i$ for each proof, summed exponents for
+		// the cards $c_1$ and the public keys $h_j$
+		std::vector<mpz_ptr> delta, delta_c;
+		std::vector<std::pair<mpz_srcptr, mpz_ptr> > card_e, key_e;
+		
+		for (size_t k = 0; k < batch.size(); k++)
+		{
+			size_t i = batch[k];
+			mpz_ptr tmp = new mpz_t(), tmp2 = new mpz_t();
+			mpz_init(tmp), mpz_init(tmp2);
+			delta.push_back(tmp), delta_c.push_back(tmp2);
+			mpz_srandomb(delta[k], TMCG_BATCH_L_E);
+			mpz_setbit(delta[k], 0L);
+			
+			// $\delta_i r_i$ for $c_1$ and $g$
+			mpz_mul(foo, delta[k], r[i]);
+			mpz_mod(foo, foo, q);
+			mpz_add(sum_r, sum_r, foo);
+			size_t e = 0;
+			while ((e < card_e.size()) && mpz_cmp(card_e[e].first, c_1[i]))
+				e++;
+			if (e == card_e.size())
+			{
+				mpz_ptr tmp = new mpz_t();
+				mpz_init_set_ui(tmp, 0L);
+				card_e.push_back(std::pair<mpz_srcptr, mpz_ptr>(c_1[i], tmp));
+			}
+			mpz_add(card_e[e].second, card_e[e].second, foo);
+			
+			// $\delta_i c_i$ for $d_i$ and $h_j$
+			mpz_mul(delta_c[k], delta[k], c[i]);
+			mpz_mod(delta_c[k], delta_c[k], q);
+			e = 0;
+			while ((e < key_e.size()) && (key_e[e].first != y[i]))
+				e++;
+			if (e == key_e.size())
+			{
+				mpz_ptr tmp = new mpz_t();
+				mpz_init_set_ui(tmp, 0L);
+				key_e.push_back(std::pair<mpz_srcptr, mpz_ptr>(y[i], tmp));
+			}
+			mpz_add(key_e[e].second, key_e[e].second, delta_c[k]);
+		}
+		mpz_mod(sum_r, sum_r, q);
+		
+		// left-hand sides: $\prod a_i^{\delta_i}$ and $\prod b_i^{\delta_i}$
+		std::vector<mpz_srcptr> base_a, base_b, exp_a, exp_b;
+		for (size_t k = 0; k < batch.size(); k++)
+		{
+			base_a.push_back(a[batch[k]]), base_b.push_back(b[batch[k]]);
+			exp_a.push_back(delta[k]);
+		}
+		mpz_mpowm(lhs_a, &base_a[0], &exp_a[0], base_a.size(), p);
+		mpz_mpowm(lhs_b, &base_b[0], &exp_a[0], base_b.size(), p);
+		
+		// the combined commitments must be in $G$
+		if (CheckElement(lhs_a) && CheckElement(lhs_b))
+		{
+			// right-hand sides
+			base_a.clear(), base_b.clear(), exp_a.clear();
+			for (size_t k = 0; k < batch.size(); k++)
+			{
+				base_a.push_back(d_j[batch[k]]);
+				exp_a.push_back(delta_c[k]);
+			}
+			for (size_t e = 0; e < card_e.size(); e++)
+			{
+				mpz_mod(card_e[e].second, card_e[e].second, q);
+				base_a.push_back(card_e[e].first);
+				exp_a.push_back(card_e[e].second);
+			}
+			base_b.push_back(g), exp_b.push_back(sum_r);
+			for (size_t e = 0; e < key_e.size(); e++)
+			{
+				mpz_mod(key_e[e].second, key_e[e].second, q);
+				base_b.push_back(key_e[e].first);
+				exp_b.push_back(key_e[e].second);
+			}
+			mpz_mpowm(rhs_a, &base_a[0], &exp_a[0], base_a.size(), p);
+			mpz_mpowm(rhs_b, &base_b[0], &exp_b[0], base_b.size(), p);
+			batch_ok = !mpz_cmp(lhs_a, rhs_a) && !mpz_cmp(lhs_b, rhs_b);
+		}
+		
+		for (size_t k = 0; k < batch.size(); k++)
+		{
+			mpz_clear(delta[k]), mpz_clear(delta_c[k]);
+			delete [] delta[k], delete [] delta_c[k];
+		}
+		for (size_t e = 0; e < card_e.size(); e++)
+			mpz_clear(card_e[e].second), delete [] card_e[e].second;
+		for (size_t e = 0; e < key_e.size(); e++)
+			mpz_clear(key_e[e].second), delete [] key_e[e].second;
+		mpz_clear(lhs_a), mpz_clear(lhs_b), mpz_clear(rhs_a), mpz_clear(rhs_b),
+			mpz_clear(sum_r);
+	}
+	for (size_t k = 0; k < batch.size(); k++)
+	{
+		size_t i = batch[k];
+		if (batch_ok)
+			result[i] = true;
+		else
+			result[i] = CheckElement(a[i]) && CheckElement(b[i]) &&
+				CP_CheckCommitments(p, d_j[i], y[i], c_1[i], g, c[i], r[i],
+				a[i], b[i]);
+	}
+	
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_clear(d_j[i]), mpz_clear(c[i]), mpz_clear(r[i]), mpz_clear(a[i]),
+			mpz_clear(b[i]);
+		delete [] d_j[i], delete [] c[i], delete [] r[i], delete [] a[i],
+			delete [] b[i];
+	}
+	mpz_clear(h_j_fp), mpz_clear(foo), mpz_clear(bar);
+	
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!result[i])
+			return false;
+	}
+	return true;
+}
+
+void BarnettSmartVTMF_dlog::VerifiableDecryptionProtocol_Verify_Accumulate
+	(std::istream& in)
+{
+	mpz_t d_j;
+	mpz_init(d_j);
+	
+	// the share was verified by VerifiableDecryptionProtocol_Verify_Batch
+	in >> d_j;
+	
+	// update the value of $d$
+	mpz_mul(d, d, d_j);
+	mpz_mod(d, d, p);
+	
+	mpz_clear(d_j);
+}
+
 BarnettSmartVTMF_dlog::~BarnettSmartVTMF_dlog
 	()
 {
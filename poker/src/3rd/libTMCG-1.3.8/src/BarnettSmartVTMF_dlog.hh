@@ -59,6 +59,12 @@
 	// erasure-free distributed coinflip protocol [JL00]
 	#include "JareckiLysyanskayaASTC.hh"
 
+#ifndef TMCG_BATCH_L_E
+/* Define the size of the random exponents used by the small exponent
+   batch test for CP proofs (soundness error $2^{-TMCG_BATCH_L_E}$). */
+#define TMCG_BATCH_L_E 64
+#endif
+
 class BarnettSmartVTMF_dlog
 {
 	private:
@@ -150,6 +156,9 @@ class BarnettSmartVTMF_dlog
 			(mpz_srcptr x, mpz_srcptr y, mpz_srcptr gg,
 			mpz_srcptr hh, std::istream& in,
 			bool fpowm_usage = false) const;
+		void CP_Prove_Batch
+			(mpz_srcptr x, mpz_srcptr y, mpz_srcptr gg,
+			mpz_srcptr hh, mpz_srcptr alpha, std::ostream& out) const;
 		void OR_ProveFirst
 			(mpz_srcptr y_1, mpz_srcptr y_2, mpz_srcptr g_1,
 			mpz_srcptr g_2, mpz_srcptr alpha,
@@ -179,6 +188,11 @@ class BarnettSmartVTMF_dlog
 			(mpz_srcptr c_1, mpz_srcptr c_2, mpz_ptr c__1,
 			mpz_ptr c__2, mpz_srcptr r, 
 			bool TimingAttackProtection = true) const;
+		void VerifiableRemaskingProtocol_Precompute
+			(mpz_ptr r, mpz_ptr g_r, mpz_ptr h_r) const;
+		void VerifiableRemaskingProtocol_Remask
+			(mpz_srcptr c_1, mpz_srcptr c_2, mpz_ptr c__1,
+			mpz_ptr c__2, mpz_srcptr g_r, mpz_srcptr h_r) const;
 		void VerifiableRemaskingProtocol_Prove
 			(mpz_srcptr c_1, mpz_srcptr c_2, mpz_srcptr c__1,
 			mpz_srcptr c__2, mpz_srcptr r,
@@ -194,6 +208,14 @@ class BarnettSmartVTMF_dlog
 			(mpz_srcptr c_1, std::istream& in);
 		void VerifiableDecryptionProtocol_Verify_Finalize
 			(mpz_srcptr c_2, mpz_ptr m) const;
+		void VerifiableDecryptionProtocol_Prove_Batch
+			(mpz_srcptr c_1, std::ostream& out) const;
+		bool VerifiableDecryptionProtocol_Verify_Batch
+			(const std::vector<mpz_srcptr>& c_1,
+			const std::vector<std::istream*>& in,
+			std::vector<bool>& result) const;
+		void VerifiableDecryptionProtocol_Verify_Accumulate
+			(std::istream& in);
 		virtual ~BarnettSmartVTMF_dlog
 			();
 };
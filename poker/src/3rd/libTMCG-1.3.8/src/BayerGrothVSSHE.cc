@@ -0,0 +1,1322 @@
+/*******************************************************************************
+  BayerGrothVSSHE.cc, |V|erifiable |S|ecret |S|huffle of |H|omomorphic |E|ncryptions
+
+     [BG12] Stephanie Bayer and Jens Groth: 'Efficient Zero-Knowledge Argument
+             for Correctness of a Shuffle', EUROCRYPT 2012, LNCS 7237, 2012.
+
+   This file is part of LibTMCG.
+
+   LibTMCG is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   LibTMCG is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LibTMCG; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+*******************************************************************************/
+
+// include headers
+#ifdef HAVE_CONFIG_H
+	#include "libTMCG_config.h"
+#endif
+#include "BayerGrothVSSHE.hh"
+
+// allocate and release vectors of temporary values
+static void bg_init
+	(std::vector<mpz_ptr> &v, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		mpz_ptr tmp = new mpz_t();
+		mpz_init(tmp);
+		v.push_back(tmp);
+	}
+}
+
+static void bg_release
+	(std::vector<mpz_ptr> &v)
+{
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		mpz_clear(v[i]);
+		delete [] v[i];
+	}
+	v.clear();
+}
+
+// read an exponent and check whether $0 \le x < q$
+static bool bg_read_exponent
+	(std::istream &in, mpz_ptr x, mpz_srcptr q)
+{
+	in >> x;
+	return (in.good() && (mpz_sgn(x) >= 0) && (mpz_cmp(x, q) < 0));
+}
+
+// compute $xp_i = x^i \bmod q$ for $i = 0, \ldots, |xp| - 1$
+static void bg_powers
+	(std::vector<mpz_ptr> &xp, mpz_srcptr x, mpz_srcptr q)
+{
+	for (size_t i = 0; i < xp.size(); i++)
+	{
+		if (i == 0)
+			mpz_set_ui(xp[i], 1L);
+		else
+		{
+			mpz_mul(xp[i], xp[i-1], x);
+			mpz_mod(xp[i], xp[i], q);
+		}
+	}
+}
+
+BayerGrothVSSHE::BayerGrothVSSHE
+	(size_t N,
+	mpz_srcptr p_ENC, mpz_srcptr q_ENC, mpz_srcptr k_ENC,
+	mpz_srcptr g_ENC, mpz_srcptr h_ENC, size_t m_in,
+	unsigned long int ell_e, unsigned long int fieldsize,
+	unsigned long int subgroupsize):
+		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize)
+{
+	assert(N >= 2);
+
+	// if not given, choose the divisor $m$ of $N$ with the shortest argument:
+	// a single column needs $9$ group elements and $3n + 4$ exponents, while
+	// $m > 1$ columns need $11m + 2$ group elements and $5n + 7$ exponents
+	m = m_in;
+	if (m == 0)
+	{
+		size_t best = 0;
+		m = 1;
+		for (size_t i = 1; (N / i) >= 2; i++)
+		{
+			if ((N % i) != 0)
+				continue;
+			size_t cost = (i == 1) ?
+				((9 * fieldsize) + ((3 * (N / i) + 4) * subgroupsize)) :
+				(((11 * i + 2) * fieldsize) + ((5 * (N / i) + 7) * subgroupsize));
+			if ((best == 0) || (cost < best))
+				best = cost, m = i;
+		}
+	}
+	assert((N % m) == 0);
+	n = N / m;
+	assert(n >= 2);
+
+	mpz_init_set(p, p_ENC), mpz_init_set(q, q_ENC), mpz_init_set(g, g_ENC),
+		mpz_init_set(h, h_ENC);
+
+	// Initialize the commitment scheme for the columns of length $n$
+	com = new PedersenCommitmentScheme(n, p_ENC, q_ENC, k_ENC, h_ENC,
+		fieldsize, subgroupsize);
+
+	// Do the precomputation for the fast exponentiation.
+	fpowm_table_g = new mpz_t[TMCG_MAX_FPOWM_T]();
+	fpowm_table_h = new mpz_t[TMCG_MAX_FPOWM_T]();
+	mpz_fpowm_init(fpowm_table_g), mpz_fpowm_init(fpowm_table_h);
+	mpz_fpowm_precompute(fpowm_table_g, g, p, mpz_sizeinbase(q, 2L));
+	mpz_fpowm_precompute(fpowm_table_h, h, p, mpz_sizeinbase(q, 2L));
+}
+
+BayerGrothVSSHE::BayerGrothVSSHE
+	(size_t N, std::istream &in,
+	unsigned long int ell_e, unsigned long int fieldsize,
+	unsigned long int subgroupsize):
+		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize)
+{
+	mpz_t foo;
+
+	// read the number of columns, an invalid value is rejected by CheckGroup()
+	mpz_init(foo);
+	in >> foo;
+	m = 0, n = N;
+	if ((N >= 2) && (mpz_cmp_ui(foo, 0L) > 0) && (mpz_cmp_ui(foo, N) <= 0) &&
+		((N % mpz_get_ui(foo)) == 0) && ((N / mpz_get_ui(foo)) >= 2))
+	{
+		m = mpz_get_ui(foo);
+		n = N / m;
+	}
+	mpz_clear(foo);
+
+	mpz_init(p), mpz_init(q), mpz_init(g), mpz_init(h);
+	in >> p >> q >> g >> h;
+
+	// Initialize the commitment scheme for the columns of length $n$
+	com = new PedersenCommitmentScheme(n, in, fieldsize, subgroupsize);
+
+	// Do the precomputation for the fast exponentiation.
+	fpowm_table_g = new mpz_t[TMCG_MAX_FPOWM_T]();
+	fpowm_table_h = new mpz_t[TMCG_MAX_FPOWM_T]();
+	mpz_fpowm_init(fpowm_table_g), mpz_fpowm_init(fpowm_table_h);
+	mpz_fpowm_precompute(fpowm_table_g, g, p, mpz_sizeinbase(q, 2L));
+	mpz_fpowm_precompute(fpowm_table_h, h, p, mpz_sizeinbase(q, 2L));
+}
+
+void BayerGrothVSSHE::SetupGenerators_publiccoin
+	(mpz_srcptr a)
+{
+	com->SetupGenerators_publiccoin(a);
+}
+
+bool BayerGrothVSSHE::CheckGroup
+	() const
+{
+	// check the shape of the matrix
+	if ((m == 0) || (n < 2) || (com->g.size() != n))
+		return false;
+	// check, whether $|q| > 2^{\ell_e}$ (see proof of Theorem 5 [Gr05])
+	if ((mpz_sizeinbase(q, 2L) < l_e) || (mpz_sizeinbase(q, 2L) < l_e_nizk))
+		return false;
+	// check whether the commitment scheme lives in the same group
+	if (mpz_cmp(p, com->p) || mpz_cmp(q, com->q) || mpz_cmp(h, com->h))
+		return false;
+	return com->CheckGroup();
+}
+
+void BayerGrothVSSHE::PublishGroup
+	(std::ostream &out) const
+{
+	mpz_t foo;
+
+	mpz_init_set_ui(foo, m);
+	out << foo << std::endl;
+	mpz_clear(foo);
+	out << p << std::endl << q << std::endl << g << std::endl << h << std::endl;
+	com->PublishGroup(out);
+}
+
+void BayerGrothVSSHE::Challenge
+	(mpz_ptr x, mpz_ptr ch, const std::vector<mpz_ptr> &v) const
+{
+	// get the challenge from the 'random oracle', i.e. Fiat-Shamir heuristic,
+	// where $ch$ links all previous messages of the argument
+	mpz_shash_1vec(ch, v, 1, ch);
+	// reduce such that $x$ is from $\{0, 1\}^{\ell_e}$
+	// note that we follow the advice of section 2.5 [Gr05] by increasing the
+	// value of $\ell_e$ for the non-interactive protocol version
+	mpz_tdiv_r_2exp(x, ch, l_e_nizk);
+}
+
+void BayerGrothVSSHE::Bilinear
+	(mpz_ptr res, const std::vector<mpz_ptr> &a, size_t a_off,
+	const std::vector<mpz_ptr> &b, size_t b_off, mpz_srcptr y) const
+{
+	mpz_t foo;
+
+	// compute $a * b = \sum_{k=1}^n a_k b_k y^k$ by Horner's rule
+	mpz_init(foo);
+	mpz_set_ui(res, 0L);
+	for (size_t k = n; k > 0; k--)
+	{
+		mpz_mul(foo, a[a_off + k - 1], b[b_off + k - 1]);
+		mpz_add(res, res, foo);
+		mpz_mul(res, res, y);
+		mpz_mod(res, res, q);
+	}
+	mpz_clear(foo);
+}
+
+void BayerGrothVSSHE::CommitColumn
+	(mpz_ptr c, mpz_srcptr r, const std::vector<mpz_ptr> &A,
+	size_t j, bool TimingAttackProtection) const
+{
+	std::vector<mpz_ptr> col(A.begin() + (j * n), A.begin() + ((j + 1) * n));
+	com->CommitBy(c, r, col, TimingAttackProtection);
+}
+
+void BayerGrothVSSHE::MultiSPowm
+	(mpz_ptr res_first, mpz_ptr res_second,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+	const std::vector<mpz_ptr> &x) const
+{
+	assert(E.size() == x.size());
+	assert(x.size() > 0);
+
+	// The multi-exponentiation is not constant-time, thus each secret
+	// exponent is blinded as $(x_i \bmod q) + r_i q$ with random $r_i$.
+	// This is correct, because all $E_i$ are from the subgroup of order $q$.
+	mpz_t foo;
+	std::vector<mpz_srcptr> m_first, m_second, xx;
+	std::vector<mpz_ptr> blinded;
+	mpz_init(foo);
+	bg_init(blinded, x.size());
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		mpz_srandomb(blinded[i], 64L);
+		mpz_mul(blinded[i], blinded[i], q);
+		mpz_mod(foo, x[i], q);
+		mpz_add(blinded[i], blinded[i], foo);
+		m_first.push_back(E[i].first), m_second.push_back(E[i].second);
+		xx.push_back(blinded[i]);
+	}
+	mpz_mpowm(res_first, &m_first[0], &xx[0], xx.size(), p);
+	mpz_mpowm(res_second, &m_second[0], &xx[0], xx.size(), p);
+	mpz_clear(foo);
+	bg_release(blinded);
+}
+
+bool BayerGrothVSSHE::CheckElement
+	(mpz_srcptr a) const
+{
+	mpz_t foo;
+	bool ret;
+
+	// check whether $0 < a < p$ and $a^q \equiv 1 \pmod{p}$
+	if ((mpz_cmp_ui(a, 0L) <= 0) || (mpz_cmp(a, p) >= 0))
+		return false;
+	mpz_init(foo);
+	mpz_powm(foo, a, q, p);
+	ret = !mpz_cmp_ui(foo, 1L);
+	mpz_clear(foo);
+	return ret;
+}
+
+// =============================================================================
+
+void BayerGrothVSSHE::ProveProduct
+	(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+	mpz_ptr ch, std::ostream &out) const
+{
+	assert(A.size() == (m * n));
+	assert(r.size() == m);
+
+	// a single column is given directly to the single value product argument
+	if (m == 1)
+	{
+		ProveSingleValueProduct(A, r[0], ch, out);
+		return;
+	}
+
+	// initialize
+	mpz_t s, foo;
+	std::vector<mpz_ptr> b, c;
+	mpz_init(s), mpz_init(foo);
+	bg_init(b, n), bg_init(c, 1);
+
+	// commit to $b = \prod_{j=1}^m a_{1j}, \ldots, \prod_{j=1}^m a_{nj}$
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_set(b[k], A[k]);
+		for (size_t j = 1; j < m; j++)
+		{
+			mpz_mul(b[k], b[k], A[(j * n) + k]);
+			mpz_mod(b[k], b[k], q);
+		}
+	}
+	mpz_srandomm(s, q);
+	com->CommitBy(c[0], s, b);
+	out << c[0] << std::endl;
+	Challenge(foo, ch, c); // link $c_b$
+
+	// the columns multiply to $b$, and the values of $b$ multiply to $\prod a_{ij}$
+	ProveHadamard(A, r, b, s, ch, out);
+	ProveSingleValueProduct(b, s, ch, out);
+
+	// release
+	mpz_clear(s), mpz_clear(foo);
+	bg_release(b), bg_release(c);
+}
+
+bool BayerGrothVSSHE::VerifyProduct
+	(const std::vector<mpz_ptr> &c_A, mpz_srcptr b,
+	mpz_ptr ch, std::istream &in) const
+{
+	assert(c_A.size() == m);
+
+	if (m == 1)
+		return VerifySingleValueProduct(c_A[0], b, ch, in);
+
+	// initialize
+	mpz_t foo;
+	std::vector<mpz_ptr> c;
+	mpz_init(foo);
+	bg_init(c, 1);
+
+	try
+	{
+		in >> c[0];
+		if (!in.good() || !com->TestMembership(c[0]))
+			throw false;
+		Challenge(foo, ch, c); // link $c_b$
+		if (!VerifyHadamard(c_A, c[0], ch, in))
+			throw false;
+		if (!VerifySingleValueProduct(c[0], b, ch, in))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(foo);
+		bg_release(c);
+		// return
+		return return_value;
+	}
+}
+
+void BayerGrothVSSHE::ProveHadamard
+	(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+	const std::vector<mpz_ptr> &b, mpz_srcptr s,
+	mpz_ptr ch, std::ostream &out) const
+{
+	assert(m >= 2);
+
+	// initialize
+	mpz_t x, y;
+	std::vector<mpz_ptr> B, s_B, c, empty, xp, A_Z, r_Z, B_Z, s_Z;
+	mpz_init(x), mpz_init(y);
+	bg_init(B, m * n), bg_init(s_B, m), bg_init(c, m - 2), bg_init(xp, m),
+		bg_init(A_Z, m * n), bg_init(r_Z, m), bg_init(B_Z, m * n),
+		bg_init(s_Z, m);
+
+	// prover: first move
+	// $b_1 = a_1$, $b_j = b_{j-1} \circ a_j$, and $b_m = b$
+	for (size_t k = 0; k < n; k++)
+		mpz_set(B[k], A[k]);
+	for (size_t j = 1; j < m; j++)
+	{
+		for (size_t k = 0; k < n; k++)
+		{
+			mpz_mul(B[(j * n) + k], B[((j - 1) * n) + k], A[(j * n) + k]);
+			mpz_mod(B[(j * n) + k], B[(j * n) + k], q);
+		}
+	}
+	mpz_set(s_B[0], r[0]);
+	mpz_set(s_B[m - 1], s);
+	for (size_t j = 1; j < (m - 1); j++)
+	{
+		mpz_srandomm(s_B[j], q);
+		CommitColumn(c[j - 1], s_B[j], B, j);
+		out << c[j - 1] << std::endl;
+	}
+
+	// prover: second move
+	Challenge(x, ch, c);
+	Challenge(y, ch, empty);
+	bg_powers(xp, x, q);
+
+	// prover: third move (zero argument)
+	// $0 = \sum_{i=1}^{m-1} a_{i+1} * (x^i b_i) - 1 * \sum_{i=1}^{m-1} x^i b_{i+1}$
+	for (size_t i = 0; i < (m - 1); i++)
+	{
+		for (size_t k = 0; k < n; k++)
+		{
+			mpz_set(A_Z[(i * n) + k], A[((i + 1) * n) + k]);
+			mpz_mul(B_Z[(i * n) + k], xp[i + 1], B[(i * n) + k]);
+			mpz_mod(B_Z[(i * n) + k], B_Z[(i * n) + k], q);
+			mpz_addmul(B_Z[((m - 1) * n) + k], xp[i + 1], B[((i + 1) * n) + k]);
+			mpz_mod(B_Z[((m - 1) * n) + k], B_Z[((m - 1) * n) + k], q);
+		}
+		mpz_set(r_Z[i], r[i + 1]);
+		mpz_mul(s_Z[i], xp[i + 1], s_B[i]);
+		mpz_mod(s_Z[i], s_Z[i], q);
+		mpz_addmul(s_Z[m - 1], xp[i + 1], s_B[i + 1]);
+		mpz_mod(s_Z[m - 1], s_Z[m - 1], q);
+	}
+	for (size_t k = 0; k < n; k++)
+		mpz_sub_ui(A_Z[((m - 1) * n) + k], q, 1L);
+	mpz_set_ui(r_Z[m - 1], 0L);
+	ProveZero(A_Z, r_Z, B_Z, s_Z, y, ch, out);
+
+	// release
+	mpz_clear(x), mpz_clear(y);
+	bg_release(B), bg_release(s_B), bg_release(c), bg_release(xp),
+		bg_release(A_Z), bg_release(r_Z), bg_release(B_Z), bg_release(s_Z);
+}
+
+bool BayerGrothVSSHE::VerifyHadamard
+	(const std::vector<mpz_ptr> &c_A, mpz_srcptr c_b,
+	mpz_ptr ch, std::istream &in) const
+{
+	assert(m >= 2);
+
+	// initialize
+	mpz_t x, y, foo;
+	std::vector<mpz_ptr> c, empty, xp, c_AZ, c_BZ, minus_one;
+	mpz_init(x), mpz_init(y), mpz_init(foo);
+	bg_init(c, m - 2), bg_init(xp, m), bg_init(c_AZ, m), bg_init(c_BZ, m),
+		bg_init(minus_one, n);
+
+	try
+	{
+		// verifier: first move
+		for (size_t j = 0; j < c.size(); j++)
+			in >> c[j];
+		if (!in.good())
+			throw false;
+		for (size_t j = 0; j < c.size(); j++)
+		{
+			if (!com->TestMembership(c[j]))
+				throw false;
+		}
+
+		// verifier: second move
+		Challenge(x, ch, c);
+		Challenge(y, ch, empty);
+		bg_powers(xp, x, q);
+
+		// verifier: third move (zero argument)
+		// $c_{B_1} = c_{A_1}$, $c_{B_2}, \ldots, c_{B_{m-1}}$ received, and $c_{B_m} = c_b$
+		std::vector<mpz_srcptr> c_B, bases, exps;
+		c_B.push_back(c_A[0]);
+		for (size_t j = 0; j < c.size(); j++)
+			c_B.push_back(c[j]);
+		c_B.push_back(c_b);
+		for (size_t i = 0; i < (m - 1); i++)
+		{
+			mpz_set(c_AZ[i], c_A[i + 1]);
+			mpz_powm(c_BZ[i], c_B[i], xp[i + 1], com->p);
+			bases.push_back(c_B[i + 1]), exps.push_back(xp[i + 1]);
+		}
+		// $c_{-1} = \mathrm{com}(-1, \ldots, -1; 0)$
+		for (size_t k = 0; k < n; k++)
+			mpz_sub_ui(minus_one[k], q, 1L);
+		mpz_set_ui(foo, 0L);
+		com->CommitBy(c_AZ[m - 1], foo, minus_one, false);
+		// $c_D = \prod_{i=1}^{m-1} c_{B_{i+1}}^{x^i}$
+		mpz_mpowm(c_BZ[m - 1], &bases[0], &exps[0], bases.size(), com->p);
+		if (!VerifyZero(c_AZ, c_BZ, y, ch, in))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(x), mpz_clear(y), mpz_clear(foo);
+		bg_release(c), bg_release(xp), bg_release(c_AZ), bg_release(c_BZ),
+			bg_release(minus_one);
+		// return
+		return return_value;
+	}
+}
+
+void BayerGrothVSSHE::ProveZero
+	(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+	const std::vector<mpz_ptr> &B, const std::vector<mpz_ptr> &s,
+	mpz_srcptr y, mpz_ptr ch, std::ostream &out) const
+{
+	size_t mm = r.size();
+	assert(A.size() == (mm * n));
+	assert(B.size() == (mm * n));
+	assert(s.size() == mm);
+
+	// initialize
+	mpz_t x, foo, rr, ss, tt;
+	std::vector<mpz_ptr> a, r_a, b, s_b, d, t, c, xp, aa, bb;
+	mpz_init(x), mpz_init(foo), mpz_init(rr), mpz_init(ss), mpz_init(tt);
+	bg_init(a, (mm + 1) * n), bg_init(r_a, mm + 1), bg_init(b, (mm + 1) * n),
+		bg_init(s_b, mm + 1), bg_init(d, (2 * mm) + 1), bg_init(t, (2 * mm) + 1),
+		bg_init(c, 2 * (mm + 1)), bg_init(xp, (2 * mm) + 1), bg_init(aa, n),
+		bg_init(bb, n);
+
+	// prover: first move
+	// $a_0 = a_1, \ldots, a_m$ and $b_1, \ldots, b_m, b_{m+1}$, where
+	// $a_0$ and $b_{m+1}$ are chosen at random
+	for (size_t k = 0; k < (mm * n); k++)
+	{
+		mpz_set(a[n + k], A[k]);
+		mpz_set(b[k], B[k]);
+	}
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_srandomm(a[k], q);
+		mpz_srandomm(b[(mm * n) + k], q);
+	}
+	mpz_srandomm(r_a[0], q);
+	mpz_srandomm(s_b[mm], q);
+	for (size_t i = 0; i < mm; i++)
+	{
+		mpz_set(r_a[i + 1], r[i]);
+		mpz_set(s_b[i], s[i]);
+	}
+	// $d_k = \sum_{i - j + m + 1 = k} a_i * b_j$ for $k = 0, \ldots, 2m$,
+	// where $d_{m+1} = 0$ by the statement
+	for (size_t i = 0; i <= mm; i++)
+	{
+		for (size_t j = 0; j <= mm; j++)
+		{
+			Bilinear(foo, a, i * n, b, j * n, y);
+			mpz_add(d[i + mm - j], d[i + mm - j], foo);
+			mpz_mod(d[i + mm - j], d[i + mm - j], q);
+		}
+	}
+	CommitColumn(c[0], r_a[0], a, 0);
+	CommitColumn(c[1], s_b[mm], b, mm);
+	for (size_t k = 0, l = 2; k <= (2 * mm); k++)
+	{
+		if (k == (mm + 1))
+			continue;
+		std::vector<mpz_ptr> dk(1, d[k]);
+		mpz_srandomm(t[k], q);
+		com->CommitBy(c[l++], t[k], dk);
+	}
+	// $c_{D_{m+1}} = \mathrm{com}(0; 0)$ is not sent
+	for (size_t l = 0; l < c.size(); l++)
+		out << c[l] << std::endl;
+
+	// prover: second move
+	Challenge(x, ch, c);
+	bg_powers(xp, x, q);
+
+	// prover: third move
+	// $a = \sum_{i=0}^m x^i a_i$, $b = \sum_{j=1}^{m+1} x^{m+1-j} b_j$, and $t = \sum_{k=0}^{2m} x^k t_k$
+	for (size_t i = 0; i <= mm; i++)
+	{
+		for (size_t k = 0; k < n; k++)
+		{
+			mpz_addmul(aa[k], xp[i], a[(i * n) + k]);
+			mpz_addmul(bb[k], xp[mm - i], b[(i * n) + k]);
+		}
+		mpz_addmul(rr, xp[i], r_a[i]);
+		mpz_addmul(ss, xp[mm - i], s_b[i]);
+	}
+	for (size_t k = 0; k <= (2 * mm); k++)
+		mpz_addmul(tt, xp[k], t[k]);
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_mod(aa[k], aa[k], q);
+		out << aa[k] << std::endl;
+	}
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_mod(bb[k], bb[k], q);
+		out << bb[k] << std::endl;
+	}
+	mpz_mod(rr, rr, q), mpz_mod(ss, ss, q), mpz_mod(tt, tt, q);
+	out << rr << std::endl << ss << std::endl << tt << std::endl;
+
+	// release
+	mpz_clear(x), mpz_clear(foo), mpz_clear(rr), mpz_clear(ss), mpz_clear(tt);
+	bg_release(a), bg_release(r_a), bg_release(b), bg_release(s_b),
+		bg_release(d), bg_release(t), bg_release(c), bg_release(xp),
+		bg_release(aa), bg_release(bb);
+}
+
+bool BayerGrothVSSHE::VerifyZero
+	(const std::vector<mpz_ptr> &c_A, const std::vector<mpz_ptr> &c_B,
+	mpz_srcptr y, mpz_ptr ch, std::istream &in) const
+{
+	size_t mm = c_A.size();
+	assert(c_B.size() == mm);
+
+	// initialize
+	mpz_t x, foo, bar, rr, ss, tt;
+	std::vector<mpz_ptr> c, xp, aa, bb, ab;
+	mpz_init(x), mpz_init(foo), mpz_init(bar), mpz_init(rr), mpz_init(ss),
+		mpz_init(tt);
+	bg_init(c, 2 * (mm + 1)), bg_init(xp, (2 * mm) + 1), bg_init(aa, n),
+		bg_init(bb, n), bg_init(ab, 1);
+
+	try
+	{
+		// verifier: first move
+		for (size_t l = 0; l < c.size(); l++)
+			in >> c[l];
+		if (!in.good())
+			throw false;
+		for (size_t l = 0; l < c.size(); l++)
+		{
+			if (!com->TestMembership(c[l]))
+				throw false;
+		}
+
+		// verifier: second move
+		Challenge(x, ch, c);
+		bg_powers(xp, x, q);
+
+		// verifier: third move
+		for (size_t k = 0; k < n; k++)
+		{
+			if (!bg_read_exponent(in, aa[k], q))
+				throw false;
+		}
+		for (size_t k = 0; k < n; k++)
+		{
+			if (!bg_read_exponent(in, bb[k], q))
+				throw false;
+		}
+		if (!bg_read_exponent(in, rr, q) || !bg_read_exponent(in, ss, q) ||
+			!bg_read_exponent(in, tt, q))
+				throw false;
+
+		// check whether $c_{A_0} \prod_{i=1}^m c_{A_i}^{x^i} = \mathrm{com}(a; r)$
+		std::vector<mpz_srcptr> bases, exps;
+		bases.push_back(c[0]), exps.push_back(xp[0]);
+		for (size_t i = 0; i < mm; i++)
+			bases.push_back(c_A[i]), exps.push_back(xp[i + 1]);
+		mpz_mpowm(foo, &bases[0], &exps[0], bases.size(), com->p);
+		com->CommitBy(bar, rr, aa, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+		// check whether $\prod_{j=1}^m c_{B_j}^{x^{m+1-j}} c_{B_{m+1}} = \mathrm{com}(b; s)$
+		bases.clear(), exps.clear();
+		for (size_t j = 0; j < mm; j++)
+			bases.push_back(c_B[j]), exps.push_back(xp[mm - j]);
+		bases.push_back(c[1]), exps.push_back(xp[0]);
+		mpz_mpowm(foo, &bases[0], &exps[0], bases.size(), com->p);
+		com->CommitBy(bar, ss, bb, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+		// check whether $\prod_{k=0}^{2m} c_{D_k}^{x^k} = \mathrm{com}(a * b; t)$
+		bases.clear(), exps.clear();
+		for (size_t k = 0, l = 2; k <= (2 * mm); k++)
+		{
+			if (k == (mm + 1))
+				continue;
+			bases.push_back(c[l++]), exps.push_back(xp[k]);
+		}
+		mpz_mpowm(foo, &bases[0], &exps[0], bases.size(), com->p);
+		Bilinear(ab[0], aa, 0, bb, 0, y);
+		com->CommitBy(bar, tt, ab, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(x), mpz_clear(foo), mpz_clear(bar), mpz_clear(rr),
+			mpz_clear(ss), mpz_clear(tt);
+		bg_release(c), bg_release(xp), bg_release(aa), bg_release(bb),
+			bg_release(ab);
+		// return
+		return return_value;
+	}
+}
+
+void BayerGrothVSSHE::ProveSingleValueProduct
+	(const std::vector<mpz_ptr> &a, mpz_srcptr r,
+	mpz_ptr ch, std::ostream &out) const
+{
+	assert(a.size() == n);
+
+	// initialize
+	mpz_t x, r_d, s_1, s_x, foo;
+	std::vector<mpz_ptr> b, d, delta, v_delta, v_Delta, c;
+	mpz_init(x), mpz_init(r_d), mpz_init(s_1), mpz_init(s_x), mpz_init(foo);
+	bg_init(b, n), bg_init(d, n), bg_init(delta, n), bg_init(v_delta, n - 1),
+		bg_init(v_Delta, n - 1), bg_init(c, 3);
+
+	// prover: first move
+	// $b_1 = a_1, b_2 = a_1 a_2, \ldots, b_n = \prod_{k=1}^n a_k$
+	mpz_set(b[0], a[0]);
+	for (size_t k = 1; k < n; k++)
+	{
+		mpz_mul(b[k], b[k - 1], a[k]);
+		mpz_mod(b[k], b[k], q);
+	}
+	// $\delta_1 = d_1$, $\delta_n = 0$, and all other values at random
+	for (size_t k = 0; k < n; k++)
+		mpz_srandomm(d[k], q);
+	mpz_set(delta[0], d[0]);
+	for (size_t k = 1; k < (n - 1); k++)
+		mpz_srandomm(delta[k], q);
+	mpz_set_ui(delta[n - 1], 0L);
+	mpz_srandomm(r_d, q), mpz_srandomm(s_1, q), mpz_srandomm(s_x, q);
+	for (size_t k = 0; k < (n - 1); k++)
+	{
+		// $-\delta_k d_{k+1}$
+		mpz_mul(v_delta[k], delta[k], d[k + 1]);
+		mpz_neg(v_delta[k], v_delta[k]);
+		mpz_mod(v_delta[k], v_delta[k], q);
+		// $\delta_{k+1} - a_{k+1} \delta_k - b_k d_{k+1}$
+		mpz_mul(foo, a[k + 1], delta[k]);
+		mpz_sub(v_Delta[k], delta[k + 1], foo);
+		mpz_mul(foo, b[k], d[k + 1]);
+		mpz_sub(v_Delta[k], v_Delta[k], foo);
+		mpz_mod(v_Delta[k], v_Delta[k], q);
+	}
+	com->CommitBy(c[0], r_d, d);
+	com->CommitBy(c[1], s_1, v_delta);
+	com->CommitBy(c[2], s_x, v_Delta);
+	out << c[0] << std::endl << c[1] << std::endl << c[2] << std::endl;
+
+	// prover: second move
+	Challenge(x, ch, c);
+
+	// prover: third move
+	// $\tilde{a}_k = x a_k + d_k$ and $\tilde{b}_k = x b_k + \delta_k$, where
+	// $\tilde{b}_1 = \tilde{a}_1$ and $\tilde{b}_n = x b$ are not sent
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_mul(foo, x, a[k]);
+		mpz_add(foo, foo, d[k]);
+		mpz_mod(foo, foo, q);
+		out << foo << std::endl;
+	}
+	for (size_t k = 1; k < (n - 1); k++)
+	{
+		mpz_mul(foo, x, b[k]);
+		mpz_add(foo, foo, delta[k]);
+		mpz_mod(foo, foo, q);
+		out << foo << std::endl;
+	}
+	mpz_mul(foo, x, r);
+	mpz_add(foo, foo, r_d);
+	mpz_mod(foo, foo, q);
+	out << foo << std::endl;
+	mpz_mul(foo, x, s_x);
+	mpz_add(foo, foo, s_1);
+	mpz_mod(foo, foo, q);
+	out << foo << std::endl;
+
+	// release
+	mpz_clear(x), mpz_clear(r_d), mpz_clear(s_1), mpz_clear(s_x),
+		mpz_clear(foo);
+	bg_release(b), bg_release(d), bg_release(delta), bg_release(v_delta),
+		bg_release(v_Delta), bg_release(c);
+}
+
+bool BayerGrothVSSHE::VerifySingleValueProduct
+	(mpz_srcptr c_a, mpz_srcptr b,
+	mpz_ptr ch, std::istream &in) const
+{
+	// initialize
+	mpz_t x, rr, ss, foo, bar;
+	std::vector<mpz_ptr> c, aa, bb, v;
+	mpz_init(x), mpz_init(rr), mpz_init(ss), mpz_init(foo), mpz_init(bar);
+	bg_init(c, 3), bg_init(aa, n), bg_init(bb, n), bg_init(v, n - 1);
+
+	try
+	{
+		// verifier: first move
+		in >> c[0] >> c[1] >> c[2];
+		if (!in.good())
+			throw false;
+		for (size_t l = 0; l < c.size(); l++)
+		{
+			if (!com->TestMembership(c[l]))
+				throw false;
+		}
+
+		// verifier: second move
+		Challenge(x, ch, c);
+
+		// verifier: third move
+		for (size_t k = 0; k < n; k++)
+		{
+			if (!bg_read_exponent(in, aa[k], q))
+				throw false;
+		}
+		for (size_t k = 1; k < (n - 1); k++)
+		{
+			if (!bg_read_exponent(in, bb[k], q))
+				throw false;
+		}
+		if (!bg_read_exponent(in, rr, q) || !bg_read_exponent(in, ss, q))
+			throw false;
+		// $\tilde{b}_1 = \tilde{a}_1$ and $\tilde{b}_n = x b$
+		mpz_set(bb[0], aa[0]);
+		mpz_mul(bb[n - 1], x, b);
+		mpz_mod(bb[n - 1], bb[n - 1], q);
+
+		// check whether $c_a^x c_d = \mathrm{com}(\tilde{a}; \tilde{r})$
+		mpz_powm(foo, c_a, x, com->p);
+		mpz_mul(foo, foo, c[0]);
+		mpz_mod(foo, foo, com->p);
+		com->CommitBy(bar, rr, aa, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+		// check whether $c_{\Delta}^x c_{\delta} = \mathrm{com}(x \tilde{b}_{k+1} - \tilde{b}_k \tilde{a}_{k+1}; \tilde{s})$
+		for (size_t k = 0; k < (n - 1); k++)
+		{
+			mpz_mul(foo, bb[k], aa[k + 1]);
+			mpz_mul(v[k], x, bb[k + 1]);
+			mpz_sub(v[k], v[k], foo);
+			mpz_mod(v[k], v[k], q);
+		}
+		mpz_powm(foo, c[2], x, com->p);
+		mpz_mul(foo, foo, c[1]);
+		mpz_mod(foo, foo, com->p);
+		com->CommitBy(bar, ss, v, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(x), mpz_clear(rr), mpz_clear(ss), mpz_clear(foo),
+			mpz_clear(bar);
+		bg_release(c), bg_release(aa), bg_release(bb), bg_release(v);
+		// return
+		return return_value;
+	}
+}
+
+void BayerGrothVSSHE::ProveMultiExpo
+	(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+	const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+	mpz_srcptr rho, mpz_ptr ch, std::ostream &out) const
+{
+	assert(E.size() == (m * n));
+	assert(A.size() == (m * n));
+	assert(r.size() == m);
+
+	// initialize
+	mpz_t x, foo, bar, aa_r, bb, ss, tau;
+	std::vector<mpz_ptr> a0, b, s, t, c, xp, aa, E_first, E_second;
+	mpz_init(x), mpz_init(foo), mpz_init(bar), mpz_init(aa_r), mpz_init(bb),
+		mpz_init(ss), mpz_init(tau);
+	bg_init(a0, n), bg_init(b, 2 * m), bg_init(s, 2 * m), bg_init(t, 2 * m),
+		bg_init(c, 2 * m), bg_init(xp, 2 * m), bg_init(aa, n),
+		bg_init(E_first, 2 * m), bg_init(E_second, 2 * m);
+
+	// prover: first move
+	// $a_0$, $r_0$, and $b_k, s_k, \tau_k$ at random, except $b_m = s_m = 0$ and $\tau_m = \rho$
+	for (size_t k = 0; k < n; k++)
+		mpz_srandomm(a0[k], q);
+	mpz_srandomm(aa_r, q);
+	for (size_t k = 0; k < (2 * m); k++)
+	{
+		if (k == m)
+		{
+			mpz_set_ui(b[k], 0L), mpz_set_ui(s[k], 0L), mpz_set(t[k], rho);
+			continue;
+		}
+		mpz_srandomm(b[k], q), mpz_srandomm(s[k], q), mpz_srandomm(t[k], q);
+	}
+	com->CommitBy(c[0], aa_r, a0);
+	out << c[0] << std::endl;
+	for (size_t k = 0; k < (2 * m); k++)
+	{
+		if (k == m)
+			continue;
+		std::vector<mpz_ptr> bk(1, b[k]);
+		com->CommitBy(foo, s[k], bk);
+		out << foo << std::endl;
+		mpz_set(c[k + ((k < m) ? 1 : 0)], foo);
+	}
+	// $E_k = E(g^{b_k}; \tau_k) \prod_{i=1, j=(k-m)+i}^{m} C_i^{a_j}$ for $0 \le j \le m$
+	for (size_t k = 0; k < (2 * m); k++)
+	{
+		if (k == m)
+			continue;
+		std::vector<std::pair<mpz_ptr, mpz_ptr> > EE;
+		std::vector<mpz_ptr> AA;
+		for (size_t i = 1; i <= m; i++)
+		{
+			if (((k + i) < m) || ((k + i) > (2 * m)))
+				continue;
+			size_t j = (k + i) - m;
+			for (size_t l = 0; l < n; l++)
+			{
+				EE.push_back(E[((i - 1) * n) + l]);
+				AA.push_back((j == 0) ? a0[l] : A[((j - 1) * n) + l]);
+			}
+		}
+		MultiSPowm(E_first[k], E_second[k], EE, AA);
+		mpz_fspowm(fpowm_table_g, foo, g, t[k], p);
+		mpz_mul(E_first[k], E_first[k], foo);
+		mpz_mod(E_first[k], E_first[k], p);
+		mpz_fspowm(fpowm_table_h, foo, h, t[k], p);
+		mpz_fspowm(fpowm_table_g, bar, g, b[k], p);
+		mpz_mul(foo, foo, bar);
+		mpz_mod(foo, foo, p);
+		mpz_mul(E_second[k], E_second[k], foo);
+		mpz_mod(E_second[k], E_second[k], p);
+		out << E_first[k] << std::endl << E_second[k] << std::endl;
+	}
+	// the challenge links $c_{A_0}$, all $c_{B_k}$, and all $E_k$
+	for (size_t k = 0; k < (2 * m); k++)
+	{
+		if (k == m)
+			continue;
+		c.push_back(E_first[k]), c.push_back(E_second[k]);
+	}
+
+	// prover: second move
+	Challenge(x, ch, c);
+	c.resize(2 * m);
+	bg_powers(xp, x, q);
+
+	// prover: third move
+	// $a = a_0 + \sum_{j=1}^m x^j a_j$, $r = r_0 + \sum_{j=1}^m x^j r_j$,
+	// $b = \sum_{k=0}^{2m-1} x^k b_k$, $s = \sum x^k s_k$, and $\tau = \sum x^k \tau_k$
+	for (size_t l = 0; l < n; l++)
+	{
+		mpz_set(aa[l], a0[l]);
+		for (size_t j = 1; j <= m; j++)
+			mpz_addmul(aa[l], xp[j], A[((j - 1) * n) + l]);
+		mpz_mod(aa[l], aa[l], q);
+		out << aa[l] << std::endl;
+	}
+	for (size_t j = 1; j <= m; j++)
+		mpz_addmul(aa_r, xp[j], r[j - 1]);
+	for (size_t k = 0; k < (2 * m); k++)
+	{
+		mpz_addmul(bb, xp[k], b[k]);
+		mpz_addmul(ss, xp[k], s[k]);
+		mpz_addmul(tau, xp[k], t[k]);
+	}
+	mpz_mod(aa_r, aa_r, q), mpz_mod(bb, bb, q), mpz_mod(ss, ss, q),
+		mpz_mod(tau, tau, q);
+	out << aa_r << std::endl << bb << std::endl << ss << std::endl <<
+		tau << std::endl;
+
+	// release
+	mpz_clear(x), mpz_clear(foo), mpz_clear(bar), mpz_clear(aa_r),
+		mpz_clear(bb), mpz_clear(ss), mpz_clear(tau);
+	bg_release(a0), bg_release(b), bg_release(s), bg_release(t),
+		bg_release(c), bg_release(xp), bg_release(aa), bg_release(E_first),
+		bg_release(E_second);
+}
+
+bool BayerGrothVSSHE::VerifyMultiExpo
+	(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+	const std::vector<mpz_ptr> &t,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+	const std::vector<mpz_ptr> &c_A,
+	mpz_ptr ch, std::istream &in) const
+{
+	assert(e.size() == (m * n));
+	assert(t.size() == e.size());
+	assert(E.size() == e.size());
+	assert(c_A.size() == m);
+
+	// initialize
+	mpz_t x, foo, bar, baz, aa_r, bb, ss, tau;
+	std::vector<mpz_ptr> c, xp, aa, E_first, E_second, v, ex;
+	mpz_init(x), mpz_init(foo), mpz_init(bar), mpz_init(baz), mpz_init(aa_r),
+		mpz_init(bb), mpz_init(ss), mpz_init(tau);
+	bg_init(c, 2 * m), bg_init(xp, 2 * m), bg_init(aa, n),
+		bg_init(E_first, 2 * m), bg_init(E_second, 2 * m), bg_init(v, 1),
+		bg_init(ex, e.size() + E.size());
+
+	try
+	{
+		// verifier: first move
+		for (size_t k = 0; k < (2 * m); k++)
+			in >> c[k];
+		for (size_t k = 0; k < (2 * m); k++)
+		{
+			if (k == m)
+				continue;
+			in >> E_first[k] >> E_second[k];
+		}
+		if (!in.good())
+			throw false;
+		for (size_t k = 0; k < (2 * m); k++)
+		{
+			if (!com->TestMembership(c[k]))
+				throw false;
+			if (k == m)
+				continue;
+			if (!CheckElement(E_first[k]) || !CheckElement(E_second[k]))
+				throw false;
+		}
+		std::vector<mpz_ptr> ch_v(c);
+		for (size_t k = 0; k < (2 * m); k++)
+		{
+			if (k == m)
+				continue;
+			ch_v.push_back(E_first[k]), ch_v.push_back(E_second[k]);
+		}
+
+		// verifier: second move
+		Challenge(x, ch, ch_v);
+		bg_powers(xp, x, q);
+
+		// verifier: third move
+		for (size_t l = 0; l < n; l++)
+		{
+			if (!bg_read_exponent(in, aa[l], q))
+				throw false;
+		}
+		if (!bg_read_exponent(in, aa_r, q) || !bg_read_exponent(in, bb, q) ||
+			!bg_read_exponent(in, ss, q) || !bg_read_exponent(in, tau, q))
+				throw false;
+
+		// check whether $c_{A_0} \prod_{j=1}^m c_{A_j}^{x^j} = \mathrm{com}(a; r)$
+		std::vector<mpz_srcptr> bases, exps;
+		bases.push_back(c[0]), exps.push_back(xp[0]);
+		for (size_t j = 1; j <= m; j++)
+			bases.push_back(c_A[j - 1]), exps.push_back(xp[j]);
+		mpz_mpowm(foo, &bases[0], &exps[0], bases.size(), com->p);
+		com->CommitBy(bar, aa_r, aa, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+		// check whether $\prod_{k=0}^{2m-1} c_{B_k}^{x^k} = \mathrm{com}(b; s)$,
+		// where $c_{B_m} = \mathrm{com}(0; 0)$ is omitted
+		bases.clear(), exps.clear();
+		for (size_t k = 0; k < (2 * m); k++)
+		{
+			if (k == m)
+				continue;
+			bases.push_back(c[k + ((k < m) ? 1 : 0)]), exps.push_back(xp[k]);
+		}
+		mpz_mpowm(foo, &bases[0], &exps[0], bases.size(), com->p);
+		mpz_set(v[0], bb);
+		com->CommitBy(bar, ss, v, false);
+		if (mpz_cmp(foo, bar))
+			throw false;
+
+		// check whether $\prod_{k=0}^{2m-1} E_k^{x^k} = E(g^b; \tau) \prod_{i=1}^m C_i^{x^{m-i} a}$,
+		// where $E_m = \prod_{i=1}^{mn} e_i^{t_i}$, by a single multi-exponentiation
+		// $\prod_{k \neq m} E_k^{x^k} \prod_{i=1}^{mn} e_i^{t_i x^m} \prod_{i=1}^m C_i^{-x^{m-i} a}$
+		std::vector<mpz_srcptr> b_first, b_second;
+		bases.clear(), exps.clear();
+		for (size_t k = 0; k < (2 * m); k++)
+		{
+			if (k == m)
+				continue;
+			b_first.push_back(E_first[k]), b_second.push_back(E_second[k]);
+			exps.push_back(xp[k]);
+		}
+		for (size_t i = 0; i < e.size(); i++)
+		{
+			mpz_mul(ex[i], t[i], xp[m]);
+			mpz_mod(ex[i], ex[i], q);
+			b_first.push_back(e[i].first), b_second.push_back(e[i].second);
+			exps.push_back(ex[i]);
+		}
+		for (size_t i = 1; i <= m; i++)
+		{
+			for (size_t l = 0; l < n; l++)
+			{
+				size_t idx = ((i - 1) * n) + l;
+				mpz_mul(ex[e.size() + idx], xp[m - i], aa[l]);
+				mpz_neg(ex[e.size() + idx], ex[e.size() + idx]);
+				mpz_mod(ex[e.size() + idx], ex[e.size() + idx], q);
+				b_first.push_back(E[idx].first), b_second.push_back(E[idx].second);
+				exps.push_back(ex[e.size() + idx]);
+			}
+		}
+		mpz_mpowm(foo, &b_first[0], &exps[0], exps.size(), p);
+		mpz_fpowm(fpowm_table_g, bar, g, tau, p);
+		if (mpz_cmp(foo, bar))
+			throw false;
+		mpz_mpowm(foo, &b_second[0], &exps[0], exps.size(), p);
+		mpz_fpowm(fpowm_table_h, bar, h, tau, p);
+		mpz_fpowm(fpowm_table_g, baz, g, bb, p);
+		mpz_mul(bar, bar, baz);
+		mpz_mod(bar, bar, p);
+		if (mpz_cmp(foo, bar))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(x), mpz_clear(foo), mpz_clear(bar), mpz_clear(baz),
+			mpz_clear(aa_r), mpz_clear(bb), mpz_clear(ss), mpz_clear(tau);
+		bg_release(c), bg_release(xp), bg_release(aa), bg_release(E_first),
+			bg_release(E_second), bg_release(v), bg_release(ex);
+		// return
+		return return_value;
+	}
+}
+
+// =============================================================================
+
+void BayerGrothVSSHE::Prove_noninteractive
+	(const std::vector<size_t> &pi, const std::vector<mpz_ptr> &R,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+	std::ostream &out) const
+{
+	assert(pi.size() == (m * n));
+	assert(pi.size() == R.size());
+	assert(R.size() == e.size());
+	assert(e.size() == E.size());
+
+	// initialize
+	mpz_t ch, x, y, z, rho, foo;
+	std::vector<mpz_ptr> a, r, c_A, b, s, c_B, xp, d, t, empty;
+	mpz_init(ch), mpz_init(x), mpz_init(y), mpz_init(z), mpz_init(rho),
+		mpz_init(foo);
+	bg_init(a, m * n), bg_init(r, m), bg_init(c_A, m), bg_init(b, m * n),
+		bg_init(s, m), bg_init(c_B, m), bg_init(xp, (m * n) + 1),
+		bg_init(d, m * n), bg_init(t, m);
+
+	// the 'random oracle' is initialized with the statement and the parameters
+	mpz_shash_2pairvec(ch, e, E, 5, p, q, g, h, com->h);
+	mpz_shash_1vec(ch, com->g, 1, ch);
+
+	// prover: first move
+	// commit to $a = (\pi(1), \ldots, \pi(mn))$ column by column
+	for (size_t i = 0; i < a.size(); i++)
+		mpz_set_ui(a[i], pi[i] + 1L); // adjust shifted index
+	for (size_t j = 0; j < m; j++)
+	{
+		mpz_srandomm(r[j], q);
+		CommitColumn(c_A[j], r[j], a, j);
+		out << c_A[j] << std::endl;
+	}
+
+	// prover: second move
+	Challenge(x, ch, c_A);
+	bg_powers(xp, x, q);
+
+	// prover: third move
+	// commit to $b = (x^{\pi(1)}, \ldots, x^{\pi(mn)})$
+	for (size_t i = 0; i < b.size(); i++)
+		mpz_set(b[i], xp[pi[i] + 1]);
+	for (size_t j = 0; j < m; j++)
+	{
+		mpz_srandomm(s[j], q);
+		CommitColumn(c_B[j], s[j], b, j);
+		out << c_B[j] << std::endl;
+	}
+
+	// prover: fourth move
+	Challenge(y, ch, c_B);
+	Challenge(z, ch, empty);
+
+	// prover: fifth move (product argument)
+	// $\prod_{i=1}^{mn} (y a_i + b_i - z) = \prod_{i=1}^{mn} (y i + x^i - z)$
+	for (size_t i = 0; i < d.size(); i++)
+	{
+		mpz_mul(d[i], y, a[i]);
+		mpz_add(d[i], d[i], b[i]);
+		mpz_sub(d[i], d[i], z);
+		mpz_mod(d[i], d[i], q);
+	}
+	for (size_t j = 0; j < m; j++)
+	{
+		mpz_mul(t[j], y, r[j]);
+		mpz_add(t[j], t[j], s[j]);
+		mpz_mod(t[j], t[j], q);
+	}
+	ProveProduct(d, t, ch, out);
+
+	// prover: sixth move (multi-exponentiation argument)
+	// $\prod_{i=1}^{mn} e_i^{x^i} = E(1; \rho) \prod_{i=1}^{mn} E_i^{b_i}$
+	// with $\rho = -\sum_{i=1}^{mn} R_i b_i$
+	for (size_t i = 0; i < b.size(); i++)
+	{
+		mpz_mul(foo, R[i], b[i]);
+		mpz_sub(rho, rho, foo);
+		mpz_mod(rho, rho, q);
+	}
+	ProveMultiExpo(E, b, s, rho, ch, out);
+
+	// release
+	mpz_clear(ch), mpz_clear(x), mpz_clear(y), mpz_clear(z), mpz_clear(rho),
+		mpz_clear(foo);
+	bg_release(a), bg_release(r), bg_release(c_A), bg_release(b),
+		bg_release(s), bg_release(c_B), bg_release(xp), bg_release(d),
+		bg_release(t);
+}
+
+bool BayerGrothVSSHE::Verify_noninteractive
+	(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+	std::istream &in) const
+{
+	assert(e.size() == E.size());
+
+	if (e.size() != (m * n))
+		return false;
+
+	// initialize
+	mpz_t ch, x, y, z, b, foo;
+	std::vector<mpz_ptr> c_A, c_B, c_D, xp, minus_z, empty;
+	mpz_init(ch), mpz_init(x), mpz_init(y), mpz_init(z), mpz_init(b),
+		mpz_init(foo);
+	bg_init(c_A, m), bg_init(c_B, m), bg_init(c_D, m),
+		bg_init(xp, (m * n) + 1), bg_init(minus_z, n);
+
+	try
+	{
+		// the 'random oracle' is initialized with the statement and the parameters
+		mpz_shash_2pairvec(ch, e, E, 5, p, q, g, h, com->h);
+		mpz_shash_1vec(ch, com->g, 1, ch);
+
+		// verifier: first move
+		for (size_t j = 0; j < m; j++)
+			in >> c_A[j];
+		if (!in.good())
+			throw false;
+		for (size_t j = 0; j < m; j++)
+		{
+			if (!com->TestMembership(c_A[j]))
+				throw false;
+		}
+
+		// verifier: second move
+		Challenge(x, ch, c_A);
+		bg_powers(xp, x, q);
+
+		// verifier: third move
+		for (size_t j = 0; j < m; j++)
+			in >> c_B[j];
+		if (!in.good())
+			throw false;
+		for (size_t j = 0; j < m; j++)
+		{
+			if (!com->TestMembership(c_B[j]))
+				throw false;
+		}
+
+		// verifier: fourth move
+		Challenge(y, ch, c_B);
+		Challenge(z, ch, empty);
+
+		// verifier: fifth move (product argument)
+		// $c_{D_j} = c_{A_j}^y c_{B_j} \mathrm{com}(-z, \ldots, -z; 0)$
+		for (size_t k = 0; k < n; k++)
+		{
+			mpz_neg(minus_z[k], z);
+			mpz_mod(minus_z[k], minus_z[k], q);
+		}
+		mpz_set_ui(b, 0L);
+		com->CommitBy(foo, b, minus_z, false);
+		for (size_t j = 0; j < m; j++)
+		{
+			mpz_powm(c_D[j], c_A[j], y, com->p);
+			mpz_mul(c_D[j], c_D[j], c_B[j]);
+			mpz_mod(c_D[j], c_D[j], com->p);
+			mpz_mul(c_D[j], c_D[j], foo);
+			mpz_mod(c_D[j], c_D[j], com->p);
+		}
+		// $b = \prod_{i=1}^{mn} (y i + x^i - z)$
+		mpz_set_ui(b, 1L);
+		for (size_t i = 1; i <= (m * n); i++)
+		{
+			mpz_mul_ui(foo, y, i);
+			mpz_add(foo, foo, xp[i]);
+			mpz_sub(foo, foo, z);
+			mpz_mul(b, b, foo);
+			mpz_mod(b, b, q);
+		}
+		if (!VerifyProduct(c_D, b, ch, in))
+			throw false;
+
+		// verifier: sixth move (multi-exponentiation argument)
+		std::vector<mpz_ptr> t(xp.begin() + 1, xp.end());
+		if (!VerifyMultiExpo(e, t, E, c_B, ch, in))
+			throw false;
+
+		throw true;
+	}
+	catch (bool return_value)
+	{
+		// release
+		mpz_clear(ch), mpz_clear(x), mpz_clear(y), mpz_clear(z), mpz_clear(b),
+			mpz_clear(foo);
+		bg_release(c_A), bg_release(c_B), bg_release(c_D), bg_release(xp),
+			bg_release(minus_z);
+		// return
+		return return_value;
+	}
+}
+
+BayerGrothVSSHE::~BayerGrothVSSHE
+	()
+{
+	mpz_clear(p), mpz_clear(q), mpz_clear(g), mpz_clear(h);
+	delete com;
+
+	mpz_fpowm_done(fpowm_table_g), mpz_fpowm_done(fpowm_table_h);
+	delete [] fpowm_table_g, delete [] fpowm_table_h;
+}
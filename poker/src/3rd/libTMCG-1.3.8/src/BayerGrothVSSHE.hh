@@ -0,0 +1,153 @@
+/*******************************************************************************
+  BayerGrothVSSHE.hh, |V|erifiable |S|ecret |S|huffle of |H|omomorphic |E|ncryptions
+
+     [BG12] Stephanie Bayer and Jens Groth: 'Efficient Zero-Knowledge Argument
+             for Correctness of a Shuffle', EUROCRYPT 2012, LNCS 7237, 2012.
+
+   This file is part of LibTMCG.
+
+   LibTMCG is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   LibTMCG is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LibTMCG; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+*******************************************************************************/
+
+#ifndef INCLUDED_BayerGrothVSSHE_HH
+	#define INCLUDED_BayerGrothVSSHE_HH
+
+	// C and STL header
+	#include <cstdio>
+	#include <cstdlib>
+	#include <cassert>
+	#include <string>
+	#include <iostream>
+	#include <sstream>
+	#include <vector>
+
+	// GNU crypto library
+	#include <gcrypt.h>
+
+	// GNU multiple precision library
+	#include <gmp.h>
+
+	#include "mpz_srandom.h"
+	#include "mpz_spowm.h"
+	#include "mpz_sprime.h"
+	#include "mpz_helper.hh"
+	#include "mpz_shash.hh"
+
+	// generalized Pedersen commitment scheme
+	#include "PedersenCOM.hh"
+
+/* The N = mn ciphertexts are arranged as a matrix with m columns of length n
+   and each column is committed by the generalized Pedersen commitment scheme,
+   thus the argument has O(m) group elements and O(n) exponents [BG12]. As in
+   GrothVSSHE the commitment scheme uses the public key h of the encryption
+   scheme. Only the non-interactive version (Fiat-Shamir heuristic) is
+   implemented. */
+class BayerGrothVSSHE
+{
+	private:
+		const unsigned long int			l_e, l_e_nizk;
+		const unsigned long int			F_size, G_size;
+		mpz_t					*fpowm_table_g, *fpowm_table_h;
+
+		void Challenge
+			(mpz_ptr x, mpz_ptr ch, const std::vector<mpz_ptr> &v) const;
+		void Bilinear
+			(mpz_ptr res, const std::vector<mpz_ptr> &a, size_t a_off,
+			const std::vector<mpz_ptr> &b, size_t b_off, mpz_srcptr y) const;
+		void CommitColumn
+			(mpz_ptr c, mpz_srcptr r, const std::vector<mpz_ptr> &A,
+			size_t j, bool TimingAttackProtection = true) const;
+		void MultiSPowm
+			(mpz_ptr res_first, mpz_ptr res_second,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+			const std::vector<mpz_ptr> &x) const;
+		bool CheckElement
+			(mpz_srcptr a) const;
+
+		void ProveProduct
+			(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+			mpz_ptr ch, std::ostream &out) const;
+		bool VerifyProduct
+			(const std::vector<mpz_ptr> &c_A, mpz_srcptr b,
+			mpz_ptr ch, std::istream &in) const;
+		void ProveHadamard
+			(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+			const std::vector<mpz_ptr> &b, mpz_srcptr s,
+			mpz_ptr ch, std::ostream &out) const;
+		bool VerifyHadamard
+			(const std::vector<mpz_ptr> &c_A, mpz_srcptr c_b,
+			mpz_ptr ch, std::istream &in) const;
+		void ProveZero
+			(const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+			const std::vector<mpz_ptr> &B, const std::vector<mpz_ptr> &s,
+			mpz_srcptr y, mpz_ptr ch, std::ostream &out) const;
+		bool VerifyZero
+			(const std::vector<mpz_ptr> &c_A, const std::vector<mpz_ptr> &c_B,
+			mpz_srcptr y, mpz_ptr ch, std::istream &in) const;
+		void ProveSingleValueProduct
+			(const std::vector<mpz_ptr> &a, mpz_srcptr r,
+			mpz_ptr ch, std::ostream &out) const;
+		bool VerifySingleValueProduct
+			(mpz_srcptr c_a, mpz_srcptr b,
+			mpz_ptr ch, std::istream &in) const;
+		void ProveMultiExpo
+			(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+			const std::vector<mpz_ptr> &A, const std::vector<mpz_ptr> &r,
+			mpz_srcptr rho, mpz_ptr ch, std::ostream &out) const;
+		bool VerifyMultiExpo
+			(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+			const std::vector<mpz_ptr> &t,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+			const std::vector<mpz_ptr> &c_A,
+			mpz_ptr ch, std::istream &in) const;
+
+	public:
+		size_t					m, n;
+		mpz_t					p, q, g, h;
+		PedersenCommitmentScheme		*com;
+
+		BayerGrothVSSHE
+			(size_t N,
+			mpz_srcptr p_ENC, mpz_srcptr q_ENC, mpz_srcptr k_ENC,
+			mpz_srcptr g_ENC, mpz_srcptr h_ENC,
+			size_t m_in = 0,
+			unsigned long int ell_e = TMCG_GROTH_L_E,
+			unsigned long int fieldsize = TMCG_DDH_SIZE,
+			unsigned long int subgroupsize = TMCG_DLSE_SIZE);
+		BayerGrothVSSHE
+			(size_t N, std::istream &in,
+			unsigned long int ell_e = TMCG_GROTH_L_E,
+			unsigned long int fieldsize = TMCG_DDH_SIZE,
+			unsigned long int subgroupsize = TMCG_DLSE_SIZE);
+		void SetupGenerators_publiccoin
+			(mpz_srcptr a);
+		bool CheckGroup
+			() const;
+		void PublishGroup
+			(std::ostream &out) const;
+		void Prove_noninteractive
+			(const std::vector<size_t> &pi, const std::vector<mpz_ptr> &R,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+			std::ostream &out) const;
+		bool Verify_noninteractive
+			(const std::vector<std::pair<mpz_ptr, mpz_ptr> > &e,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &E,
+			std::istream &in) const;
+		~BayerGrothVSSHE
+			();
+};
+
+#endif
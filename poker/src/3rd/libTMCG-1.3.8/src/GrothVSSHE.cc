@@ -29,6 +29,7 @@
 	#include "libTMCG_config.h"
 #endif
 #include "GrothVSSHE.hh"
+#include "parallel_helper.hh"
 
 GrothSKC::GrothSKC
 	(size_t n,
@@ -62,6 +63,12 @@ bool GrothSKC::SetupGenerators_publiccoin
 	return com->SetupGenerators_publiccoin(whoami, aiou, rbc, edcf, err);
 }
 
+void GrothSKC::SetWorkers
+	(size_t workers_in)
+{
+	com->workers = workers_in;
+}
+
 bool GrothSKC::CheckGroup
 	() const
 {
@@ -415,10 +422,27 @@ void GrothSKC::Prove_interactive_publiccoin
 void GrothSKC::Prove_noninteractive
 	(const std::vector<size_t> &pi, mpz_srcptr r,
 	const std::vector<mpz_ptr> &m, std::ostream &out) const
+{
+	std::vector<mpz_ptr> rand;
+	std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+	Prove_noninteractive(pi, r, m, rand, masks, out);
+}
+
+void GrothSKC::Prove_noninteractive
+	(const std::vector<size_t> &pi, mpz_srcptr r,
+	const std::vector<mpz_ptr> &m,
+	const std::vector<mpz_ptr> &rand,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+	std::ostream &out) const
 {
 	assert(com->g.size() >= pi.size());
 	assert(pi.size() == m.size());
 	assert(m.size() >= 2);
+	assert(rand.size() == masks.size());
+	
+	// use the precomputed randomizers $r_d, r_{\Delta}, r_a$ and their
+	// powers $h^{r_d}, h^{r_{\Delta}}, h^{r_a}$, if there are enough
+	bool precomputed = (rand.size() >= TMCG_GROTH_SKC_PRECOMPUTED);
 	
 	mpz_t x, r_d, r_Delta, r_a, c_d, c_Delta, c_a, e, z, z_Delta, foo, bar;
 	std::vector<mpz_ptr> d, Delta, a, f, f_Delta, lej;
@@ -446,8 +470,18 @@ void GrothSKC::Prove_noninteractive
 		mpz_tdiv_r_2exp(x, x, l_e_nizk);
 	
 	// prover: second move
-	mpz_srandomm(r_d, com->q); // $r_d \gets \mathbb{Z}_q$
-	mpz_srandomm(r_Delta, com->q); // $r_{\Delta} \gets \mathbb{Z}_q$
+	if (precomputed)
+	{
+		mpz_set(r_d, rand[0]);
+		mpz_set(r_Delta, rand[1]);
+		mpz_set(r_a, rand[2]);
+	}
+	else
+	{
+		mpz_srandomm(r_d, com->q); // $r_d \gets \mathbb{Z}_q$
+		mpz_srandomm(r_Delta, com->q); // $r_{\Delta} \gets \mathbb{Z}_q$
+		mpz_srandomm(r_a, com->q); // $r_a \gets \mathbb{Z}_q$
+	}
 	for (size_t i = 0; i < d.size(); i++)
 		mpz_srandomm(d[i], com->q); // $d_1,\ldots,d_n \gets \mathbb{Z}_q$
 	mpz_set(Delta[0], d[0]); // $\Delta_1 := d_1$
@@ -467,9 +501,11 @@ void GrothSKC::Prove_noninteractive
 			mpz_mod(a[i], a[i], com->q);
 		}
 	}
-	mpz_srandomm(r_a, com->q); // $r_a \gets \mathbb{Z}_q$
 	// $c_d = \mathrm{com}_{ck}(d_1,\ldots,d_n;r_d)$
-	com->CommitBy(c_d, r_d, d);
+	if (precomputed)
+		com->CommitBy_precomputed(c_d, masks[0].second, d);
+	else
+		com->CommitBy(c_d, r_d, d);
 	for (size_t i = 0; i < lej.size(); i++)
 	{
 		if (i < (lej.size() - 1))
@@ -484,7 +520,10 @@ void GrothSKC::Prove_noninteractive
 	}
 	// $c_{\Delta} = \mathrm{com}_{ck}(-\Delta_1 d_2,\ldots,
 	//                                 -\Delta_{n-1} d_n;r_{\Delta})$
-	com->CommitBy(c_Delta, r_Delta, lej);
+	if (precomputed)
+		com->CommitBy_precomputed(c_Delta, masks[1].second, lej);
+	else
+		com->CommitBy(c_Delta, r_Delta, lej);
 	for (size_t i = 0; i < lej.size(); i++)
 	{
 		if (i < (lej.size() - 1))
@@ -508,7 +547,10 @@ void GrothSKC::Prove_noninteractive
 	// $c_a = \mathrm{com}_{ck}(\Delta_2 - (m_{\pi(2)} - x)\Delta_1 - a_1 d_2,
 	//                          \ldots,\Delta_n - (m_{\pi(n)} - x)\Delta_{n-1}
 	//                                  - a_{n-1} d_n;r_a)$
-	com->CommitBy(c_a, r_a, lej);
+	if (precomputed)
+		com->CommitBy_precomputed(c_a, masks[2].second, lej);
+	else
+		com->CommitBy(c_a, r_a, lej);
 	// send $c_d$, $c_\Delta$, and $c_a$ to the verifier
 	out << c_d << std::endl << c_Delta << std::endl << c_a << std::endl;
 	
@@ -664,21 +706,17 @@ bool GrothSKC::Verify_interactive
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -692,7 +730,7 @@ bool GrothSKC::Verify_interactive
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -850,21 +888,17 @@ bool GrothSKC::Verify_interactive_publiccoin
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -878,7 +912,7 @@ bool GrothSKC::Verify_interactive_publiccoin
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -1039,21 +1073,17 @@ bool GrothSKC::Verify_noninteractive
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -1067,7 +1097,7 @@ bool GrothSKC::Verify_noninteractive
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -1226,21 +1256,17 @@ bool GrothSKC::Verify_interactive
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -1264,7 +1290,7 @@ bool GrothSKC::Verify_interactive
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -1435,21 +1461,17 @@ bool GrothSKC::Verify_interactive_publiccoin
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -1473,7 +1495,7 @@ bool GrothSKC::Verify_interactive_publiccoin
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -1646,21 +1668,17 @@ bool GrothSKC::Verify_noninteractive
 		{
 			// randomization technique from section 6,
 			// paragraph 'Batch verification' [Gr05]
-			mpz_t alpha;
-			mpz_init(alpha);
+			mpz_t alpha, alpha_e;
+			mpz_init(alpha), mpz_init(alpha_e);
 			// pick $\alpha\in_R\{0, 1\}^{\ell_e}$ at random
 			mpz_srandomb(alpha, l_e_nizk);
-			// compute $(c^e c_d)^{\alpha}$
-			mpz_powm(foo, c, e, com->p);
-			mpz_mul(foo, foo, c_d);
-			mpz_mod(foo, foo, com->p);
-			mpz_powm(foo, foo, alpha, com->p);
-			// compute $c_a^e c_{\Delta}$
-			mpz_powm(bar, c_a, e, com->p);
-			mpz_mul(bar, bar, c_Delta);
-			mpz_mod(bar, bar, com->p);
-			// compute the product
-			mpz_mul(foo, foo, bar);
+			// compute $(c^e c_d)^{\alpha} c_a^e c_{\Delta}$ as
+			// $c^{e\alpha} c_d^{\alpha} c_a^e c_{\Delta}$ by multi-exponentiation
+			mpz_mul(alpha_e, alpha, e);
+			mpz_srcptr bases[3] = { c, c_d, c_a };
+			mpz_srcptr exps[3] = { alpha_e, alpha, e };
+			mpz_mpowm(foo, bases, exps, 3, com->p);
+			mpz_mul(foo, foo, c_Delta);
 			mpz_mod(foo, foo, com->p);
 			// compute the messages for the commitment
 			for (size_t i = 0; i < f.size(); i++)
@@ -1684,7 +1702,7 @@ bool GrothSKC::Verify_noninteractive
 			mpz_mod(bar, bar, com->q);
 			mpz_add(bar, bar, z_Delta);
 			mpz_mod(bar, bar, com->q);
-			mpz_clear(alpha);
+			mpz_clear(alpha), mpz_clear(alpha_e);
 			// check the randomized commitments
 			if (!com->Verify(foo, bar, lej))
 				throw false;
@@ -1786,7 +1804,8 @@ GrothVSSHE::GrothVSSHE
 	mpz_srcptr g_ENC, mpz_srcptr h_ENC,
 	unsigned long int ell_e, unsigned long int fieldsize,
 	unsigned long int subgroupsize):
-		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize)
+		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize),
+		workers(1)
 {
 	std::stringstream lej;
 	
@@ -1811,7 +1830,8 @@ GrothVSSHE::GrothVSSHE
 	(size_t n, std::istream& in,
 	unsigned long int ell_e, unsigned long int fieldsize,
 	unsigned long int subgroupsize):
-		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize)
+		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize),
+		workers(1)
 {
 	std::stringstream lej;
 	
@@ -1837,7 +1857,8 @@ GrothVSSHE::GrothVSSHE
 	(size_t n, std::stringstream& in,
 	unsigned long int ell_e, unsigned long int fieldsize,
 	unsigned long int subgroupsize):
-		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize)
+		l_e(ell_e), l_e_nizk(ell_e * 2L), F_size(fieldsize), G_size(subgroupsize),
+		workers(1)
 {
 	std::stringstream lej;
 	
@@ -1858,6 +1879,113 @@ GrothVSSHE::GrothVSSHE
 }
 
 
+void GrothVSSHE::MultiPowm
+	(mpz_ptr res_first, mpz_ptr res_second,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+	const std::vector<mpz_ptr>& x) const
+{
+	assert(E.size() == x.size());
+	assert(x.size() > 0);
+	
+	// compute $\prod_{i=1}^n E_i^{x_i}$ componentwise by multi-exponentiation
+	std::vector<mpz_srcptr> m_first, m_second, xx;
+	for (size_t i = 0; i < E.size(); i++)
+	{
+		m_first.push_back(E[i].first), m_second.push_back(E[i].second);
+		xx.push_back(x[i]);
+	}
+	mpz_mpowm(res_first, &m_first[0], &xx[0], xx.size(), p);
+	mpz_mpowm(res_second, &m_second[0], &xx[0], xx.size(), p);
+}
+
+// the task $t$ computes the component $t \bmod 2$ of the slice $t / 2$
+struct GrothVSSHE_MultiSPowm_args
+{
+	mpz_srcptr					p;
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >	*E;
+	const std::vector<mpz_ptr>			*x;
+	size_t						slices;
+	std::vector<mpz_ptr>				partial;
+};
+
+static void GrothVSSHE_MultiSPowm_worker
+	(size_t t, void *arg)
+{
+	GrothVSSHE_MultiSPowm_args *a = (GrothVSSHE_MultiSPowm_args*)arg;
+	size_t n = a->x->size(), j = t / 2;
+	size_t lo = (j * n) / a->slices, hi = ((j + 1) * n) / a->slices;
+	std::vector<mpz_srcptr> bases, exps;
+	for (size_t i = lo; i < hi; i++)
+	{
+		if (t % 2)
+			bases.push_back((*a->E)[i].second);
+		else
+			bases.push_back((*a->E)[i].first);
+		exps.push_back((*a->x)[i]);
+	}
+	mpz_mpowm(a->partial[t], &bases[0], &exps[0], exps.size(), a->p);
+}
+
+void GrothVSSHE::MultiSPowm
+	(mpz_ptr res_first, mpz_ptr res_second,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+	const std::vector<mpz_ptr>& x) const
+{
+	assert(E.size() == x.size());
+	
+	// The multi-exponentiation is not constant-time, thus each secret
+	// exponent is blinded as $(x_i \bmod q) + r_i q$ with random $r_i$.
+	// This is correct, because all $E_i$ are from the subgroup of order $q$.
+	std::vector<mpz_ptr> xx;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		mpz_ptr tmp = new mpz_t(), tmp2 = new mpz_t();
+		mpz_init(tmp), mpz_init(tmp2);
+		mpz_srandomb(tmp, 64L);
+		mpz_mul(tmp, tmp, q);
+		mpz_mod(tmp2, x[i], q);
+		mpz_add(tmp, tmp, tmp2);
+		mpz_clear(tmp2);
+		delete [] tmp2;
+		xx.push_back(tmp);
+	}
+	if ((workers > 1) && (xx.size() > 1))
+	{
+		// split both multi-exponentiations into slices of the bases
+		// and multiply the partial results of the workers afterwards
+		GrothVSSHE_MultiSPowm_args args;
+		args.p = p, args.E = &E, args.x = &xx;
+		args.slices = (workers + 1) / 2;
+		if (args.slices > xx.size())
+			args.slices = xx.size();
+		for (size_t t = 0; t < (2 * args.slices); t++)
+		{
+			mpz_ptr tmp = new mpz_t();
+			mpz_init(tmp);
+			args.partial.push_back(tmp);
+		}
+		TMCG_ParallelHelper::run(workers, args.partial.size(),
+			GrothVSSHE_MultiSPowm_worker, &args);
+		mpz_set_ui(res_first, 1L), mpz_set_ui(res_second, 1L);
+		for (size_t t = 0; t < args.partial.size(); t++)
+		{
+			mpz_ptr res = (t % 2) ? res_second : res_first;
+			mpz_mul(res, res, args.partial[t]);
+			mpz_mod(res, res, p);
+			mpz_clear(args.partial[t]);
+			delete [] args.partial[t];
+		}
+	}
+	else
+		MultiPowm(res_first, res_second, E, xx);
+	for (size_t i = 0; i < xx.size(); i++)
+	{
+		mpz_clear(xx[i]);
+		delete [] xx[i];
+	}
+	xx.clear();
+}
+
 void GrothVSSHE::SetupGenerators_publiccoin
 	(mpz_srcptr a)
 {
@@ -1867,6 +1995,7 @@ void GrothVSSHE::SetupGenerators_publiccoin
 	com->PublishGroup(lej);
 	delete skc;
 	skc = new GrothSKC(com->g.size(), lej, l_e, F_size, G_size);
+	SetWorkers(workers);
 }
 
 bool GrothVSSHE::SetupGenerators_publiccoin
@@ -1881,10 +2010,19 @@ bool GrothVSSHE::SetupGenerators_publiccoin
 	com->PublishGroup(lej);
 	delete skc;
 	skc = new GrothSKC(com->g.size(), lej, l_e, F_size, G_size);
+	SetWorkers(workers);
 
 	return true;
 }
 
+void GrothVSSHE::SetWorkers
+	(size_t workers_in)
+{
+	workers = workers_in;
+	com->workers = workers_in;
+	skc->SetWorkers(workers_in);
+}
+
 bool GrothVSSHE::CheckGroup
 	() const
 {
@@ -1946,17 +2084,8 @@ void GrothVSSHE::Prove_interactive
 		mpz_set_ui(m[i], pi[i] + 1L); // adjust shifted index
 	com->CommitBy(c, r, m);
 	com->CommitBy(c_d, r_d, d);
-	mpz_set_ui(E_d.first, 1L), mpz_set_ui(E_d.second, 1L);
-	for (size_t i = 0; i < d.size(); i++)
-	{
-		// Compute and multiply $E_i^{-d_i}$
-		mpz_spowm(foo, E[i].first, d[i], p);
-		mpz_mul(E_d.first, E_d.first, foo);
-		mpz_mod(E_d.first, E_d.first, p);
-		mpz_spowm(bar, E[i].second, d[i], p);
-		mpz_mul(E_d.second, E_d.second, bar);
-		mpz_mod(E_d.second, E_d.second, p);
-	}
+	// Compute and multiply $E_i^{-d_i}$
+	MultiSPowm(E_d.first, E_d.second, E, d);
 	// Compute and multiply $E(1;R_d)$
 	mpz_fspowm(fpowm_table_g, foo, g, R_d, p);
 	mpz_mul(E_d.first, E_d.first, foo);
@@ -2090,17 +2219,8 @@ void GrothVSSHE::Prove_interactive_publiccoin
 		mpz_set_ui(m[i], pi[i] + 1L); // adjust shifted index
 	com->CommitBy(c, r, m);
 	com->CommitBy(c_d, r_d, d);
-	mpz_set_ui(E_d.first, 1L), mpz_set_ui(E_d.second, 1L);
-	for (size_t i = 0; i < d.size(); i++)
-	{
-		// Compute and multiply $E_i^{-d_i}$
-		mpz_spowm(foo, E[i].first, d[i], p);
-		mpz_mul(E_d.first, E_d.first, foo);
-		mpz_mod(E_d.first, E_d.first, p);
-		mpz_spowm(bar, E[i].second, d[i], p);
-		mpz_mul(E_d.second, E_d.second, bar);
-		mpz_mod(E_d.second, E_d.second, p);
-	}
+	// Compute and multiply $E_i^{-d_i}$
+	MultiSPowm(E_d.first, E_d.second, E, d);
 	// Compute and multiply $E(1;R_d)$
 	mpz_fspowm(fpowm_table_g, foo, g, R_d, p);
 	mpz_mul(E_d.first, E_d.first, foo);
@@ -2195,12 +2315,32 @@ void GrothVSSHE::Prove_noninteractive
 	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& e,
 	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
 	std::ostream& out) const
+{
+	std::vector<mpz_ptr> rand;
+	std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+	Prove_noninteractive(pi, R, e, E, rand, masks, out);
+}
+
+void GrothVSSHE::Prove_noninteractive
+	(const std::vector<size_t>& pi, const std::vector<mpz_ptr>& R,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& e,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+	const std::vector<mpz_ptr>& rand,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> >& masks,
+	std::ostream& out) const
 {
 	assert(com->g.size() >= pi.size());
 	assert(pi.size() == R.size());
 	assert(R.size() == e.size());
 	assert(e.size() == E.size());
 	assert(E.size() >= 2);
+	assert(rand.size() == masks.size());
+	
+	// use the precomputed randomizers $r, r_d, R_d$ with their powers
+	// $(g^r, h^r)$ and pass the rest to SKC, if there are enough; the
+	// commitment scheme must share $h$, since $h^r$ is used for both
+	bool precomputed = (rand.size() >= TMCG_GROTH_PRECOMPUTED);
+	assert(!precomputed || !mpz_cmp(com->h, h));
 	
 	// initialize
 	mpz_t r, R_d, r_d, c, c_d, Z, lambda, rho, foo, bar;
@@ -2220,8 +2360,18 @@ void GrothVSSHE::Prove_noninteractive
 	}
 	
 	// prover: first move
-	mpz_srandomm(r, com->q);	// $r \gets \mathbb{Z}_q$
-	mpz_srandomm(R_d, q);		// $R_d \gets \mathcal{R}_{pk}
+	if (precomputed)
+	{
+		mpz_set(r, rand[0]);
+		mpz_set(r_d, rand[1]);
+		mpz_set(R_d, rand[2]);
+	}
+	else
+	{
+		mpz_srandomm(r, com->q);	// $r \gets \mathbb{Z}_q$
+		mpz_srandomm(r_d, com->q);	// $r_d \gets \mathbb{Z}_q$
+		mpz_srandomm(R_d, q);		// $R_d \gets \mathcal{R}_{pk}
+	}
 	for (size_t i = 0; i < d.size(); i++)
 	{
 		// see note in [Gr05] for omitting $\ell_s$ here
@@ -2229,27 +2379,33 @@ void GrothVSSHE::Prove_noninteractive
 		// store $d_i$ as negative value for convenience
 		mpz_neg(d[i], d[i]);
 	}
-	mpz_srandomm(r_d, com->q);	// $r_d \gets \mathbb{Z}_q$
 	for (size_t i = 0; i < m.size(); i++)
 		mpz_set_ui(m[i], pi[i] + 1L); // adjust shifted index
-	com->CommitBy(c, r, m);
-	com->CommitBy(c_d, r_d, d);
-	mpz_set_ui(E_d.first, 1L), mpz_set_ui(E_d.second, 1L);
-	for (size_t i = 0; i < d.size(); i++)
+	if (precomputed)
+	{
+		com->CommitBy_precomputed(c, masks[0].second, m);
+		com->CommitBy_precomputed(c_d, masks[1].second, d);
+	}
+	else
 	{
-		// Compute and multiply $E_i^{-d_i}$
-		mpz_spowm(foo, E[i].first, d[i], p);
-		mpz_mul(E_d.first, E_d.first, foo);
-		mpz_mod(E_d.first, E_d.first, p);
-		mpz_spowm(bar, E[i].second, d[i], p);
-		mpz_mul(E_d.second, E_d.second, bar);
-		mpz_mod(E_d.second, E_d.second, p);
+		com->CommitBy(c, r, m);
+		com->CommitBy(c_d, r_d, d);
 	}
+	// Compute and multiply $E_i^{-d_i}$
+	MultiSPowm(E_d.first, E_d.second, E, d);
 	// Compute and multiply $E(1;R_d)$
-	mpz_fspowm(fpowm_table_g, foo, g, R_d, p);
+	if (precomputed)
+	{
+		mpz_set(foo, masks[2].first);
+		mpz_set(bar, masks[2].second);
+	}
+	else
+	{
+		mpz_fspowm(fpowm_table_g, foo, g, R_d, p);
+		mpz_fspowm(fpowm_table_h, bar, h, R_d, p);
+	}
 	mpz_mul(E_d.first, E_d.first, foo);
 	mpz_mod(E_d.first, E_d.first, p);
-	mpz_fspowm(fpowm_table_h, bar, h, R_d, p);
 	mpz_mul(E_d.second, E_d.second, bar);
 	mpz_mod(E_d.second, E_d.second, p);
 	
@@ -2328,7 +2484,15 @@ void GrothVSSHE::Prove_noninteractive
 			mpz_add(m[i], m[i], t[i]);
 			mpz_mod(m[i], m[i], com->q);
 		}
-	skc->Prove_noninteractive(pi, rho, m, out);
+	if (precomputed)
+	{
+		std::vector<mpz_ptr> rand_skc(rand.begin() + 3, rand.end());
+		std::vector<std::pair<mpz_ptr, mpz_ptr> > masks_skc(masks.begin() + 3,
+			masks.end());
+		skc->Prove_noninteractive(pi, rho, m, rand_skc, masks_skc, out);
+	}
+	else
+		skc->Prove_noninteractive(pi, rho, m, out);
 	
 	// release
 	mpz_clear(r), mpz_clear(R_d), mpz_clear(r_d), mpz_clear(c), mpz_clear(c_d),
@@ -2449,30 +2613,10 @@ bool GrothVSSHE::Verify_interactive
 		
 		// check whether
 		// $\prod_{i=1}^n e_i^{-t_i} \prod_{i=1}^n E_i^{f_i} E_d = E(1;Z)$
-		mpz_set_ui(foo2, 1L), mpz_set_ui(bar2, 1L);
-		for (size_t i = 0; i < e.size(); i++)
-		{
-			mpz_powm(foo, e[i].first, t[i], p);
-			if (!mpz_invert(foo, foo, p))
-				throw false;
-			mpz_mul(foo2, foo2, foo);
-			mpz_mod(foo2, foo2, p);
-			mpz_powm(bar, e[i].second, t[i], p);
-			if (!mpz_invert(bar, bar, p))
-				throw false;
-			mpz_mul(bar2, bar2, bar);
-			mpz_mod(bar2, bar2, p);
-		}
-		mpz_set_ui(foo3, 1L), mpz_set_ui(bar3, 1L);
-		for (size_t i = 0; i < E.size(); i++)
-		{
-			mpz_powm(foo, E[i].first, f[i], p);
-			mpz_mul(foo3, foo3, foo);
-			mpz_mod(foo3, foo3, p);
-			mpz_powm(bar, E[i].second, f[i], p);
-			mpz_mul(bar3, bar3, bar);
-			mpz_mod(bar3, bar3, p);
-		}
+		MultiPowm(foo2, bar2, e, t);
+		if (!mpz_invert(foo2, foo2, p) || !mpz_invert(bar2, bar2, p))
+			throw false;
+		MultiPowm(foo3, bar3, E, f);
 		mpz_mul(foo3, foo3, E_d.first);
 		mpz_mod(foo3, foo3, p);
 		mpz_mul(bar3, bar3, E_d.second);
@@ -2617,30 +2761,10 @@ bool GrothVSSHE::Verify_interactive_publiccoin
 		
 		// check whether
 		// $\prod_{i=1}^n e_i^{-t_i} \prod_{i=1}^n E_i^{f_i} E_d = E(1;Z)$
-		mpz_set_ui(foo2, 1L), mpz_set_ui(bar2, 1L);
-		for (size_t i = 0; i < e.size(); i++)
-		{
-			mpz_powm(foo, e[i].first, t[i], p);
-			if (!mpz_invert(foo, foo, p))
-				throw false;
-			mpz_mul(foo2, foo2, foo);
-			mpz_mod(foo2, foo2, p);
-			mpz_powm(bar, e[i].second, t[i], p);
-			if (!mpz_invert(bar, bar, p))
-				throw false;
-			mpz_mul(bar2, bar2, bar);
-			mpz_mod(bar2, bar2, p);
-		}
-		mpz_set_ui(foo3, 1L), mpz_set_ui(bar3, 1L);
-		for (size_t i = 0; i < E.size(); i++)
-		{
-			mpz_powm(foo, E[i].first, f[i], p);
-			mpz_mul(foo3, foo3, foo);
-			mpz_mod(foo3, foo3, p);
-			mpz_powm(bar, E[i].second, f[i], p);
-			mpz_mul(bar3, bar3, bar);
-			mpz_mod(bar3, bar3, p);
-		}
+		MultiPowm(foo2, bar2, e, t);
+		if (!mpz_invert(foo2, foo2, p) || !mpz_invert(bar2, bar2, p))
+			throw false;
+		MultiPowm(foo3, bar3, E, f);
 		mpz_mul(foo3, foo3, E_d.first);
 		mpz_mod(foo3, foo3, p);
 		mpz_mul(bar3, bar3, E_d.second);
@@ -2792,30 +2916,10 @@ bool GrothVSSHE::Verify_noninteractive
 		
 		// check whether
 		// $\prod_{i=1}^n e_i^{-t_i} \prod_{i=1}^n E_i^{f_i} E_d = E(1;Z)$
-		mpz_set_ui(foo2, 1L), mpz_set_ui(bar2, 1L);
-		for (size_t i = 0; i < e.size(); i++)
-		{
-			mpz_powm(foo, e[i].first, t[i], p);
-			if (!mpz_invert(foo, foo, p))
-				throw false;
-			mpz_mul(foo2, foo2, foo);
-			mpz_mod(foo2, foo2, p);
-			mpz_powm(bar, e[i].second, t[i], p);
-			if (!mpz_invert(bar, bar, p))
-				throw false;
-			mpz_mul(bar2, bar2, bar);
-			mpz_mod(bar2, bar2, p);
-		}
-		mpz_set_ui(foo3, 1L), mpz_set_ui(bar3, 1L);
-		for (size_t i = 0; i < E.size(); i++)
-		{
-			mpz_powm(foo, E[i].first, f[i], p);
-			mpz_mul(foo3, foo3, foo);
-			mpz_mod(foo3, foo3, p);
-			mpz_powm(bar, E[i].second, f[i], p);
-			mpz_mul(bar3, bar3, bar);
-			mpz_mod(bar3, bar3, p);
-		}
+		MultiPowm(foo2, bar2, e, t);
+		if (!mpz_invert(foo2, foo2, p) || !mpz_invert(bar2, bar2, p))
+			throw false;
+		MultiPowm(foo3, bar3, E, f);
 		mpz_mul(foo3, foo3, E_d.first);
 		mpz_mod(foo3, foo3, p);
 		mpz_mul(bar3, bar3, E_d.second);
@@ -54,6 +54,11 @@
 	// erasure-free distributed coinflip protocol [JL00]
 	#include "JareckiLysyanskayaASTC.hh"
 
+	// number of precomputed randomizers used by the non-interactive provers,
+	// i.e. $r_d, r_{\Delta}, r_a$ for SKC and additionally $r, r_d, R_d$
+	#define TMCG_GROTH_SKC_PRECOMPUTED 3
+	#define TMCG_GROTH_PRECOMPUTED (3 + TMCG_GROTH_SKC_PRECOMPUTED)
+
 class GrothSKC
 {
 	private:
@@ -77,6 +82,8 @@ class GrothSKC
 			(const size_t whoami, aiounicast *aiou,
 			CachinKursawePetzoldShoupRBC *rbc,
 			JareckiLysyanskayaEDCF *edcf, std::ostream &err);
+		void SetWorkers
+			(size_t workers_in);
 		bool CheckGroup
 			() const;
 		void PublishGroup
@@ -93,6 +100,14 @@ class GrothSKC
 		void Prove_noninteractive
 			(const std::vector<size_t> &pi, mpz_srcptr r,
 			const std::vector<mpz_ptr> &m, std::ostream &out) const;
+		// The same with the precomputed randomizers rand and the powers
+		// masks[i].second = $h^{rand_i}$ (the first element is not used).
+		void Prove_noninteractive
+			(const std::vector<size_t> &pi, mpz_srcptr r,
+			const std::vector<mpz_ptr> &m,
+			const std::vector<mpz_ptr> &rand,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+			std::ostream &out) const;
 		bool Verify_interactive
 			(mpz_srcptr c, const std::vector<mpz_ptr> &m,
 			std::istream &in, std::ostream &out, bool optimizations = true) const;
@@ -129,6 +144,16 @@ class GrothVSSHE
 		const unsigned long int			F_size, G_size;
 		mpz_t					*fpowm_table_g, *fpowm_table_h;
 		GrothSKC				*skc;
+		size_t					workers;
+		
+		void MultiPowm
+			(mpz_ptr res_first, mpz_ptr res_second,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+			const std::vector<mpz_ptr>& x) const;
+		void MultiSPowm
+			(mpz_ptr res_first, mpz_ptr res_second,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+			const std::vector<mpz_ptr>& x) const;
 	
 	public:
 		mpz_t					p, q, g, h;
@@ -160,6 +185,10 @@ class GrothVSSHE
 			(const size_t whoami, aiounicast *aiou,
 			CachinKursawePetzoldShoupRBC *rbc,
 			JareckiLysyanskayaEDCF *edcf, std::ostream &err);
+		// The prover distributes the commitments with timing attack
+		// protection and the multi-exponentiations over workers threads.
+		void SetWorkers
+			(size_t workers_in);
 		bool CheckGroup
 			() const;
 		void PublishGroup
@@ -180,6 +209,17 @@ class GrothVSSHE
 			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& e,
 			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
 			std::ostream& out) const;
+		// The same with TMCG_GROTH_PRECOMPUTED randomizers rand and their
+		// powers masks[i] = $(g^{rand_i}, h^{rand_i})$, e.g. computed by
+		// BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Precompute().
+		// With fewer values all randomizers are chosen here as usual.
+		void Prove_noninteractive
+			(const std::vector<size_t>& pi, const std::vector<mpz_ptr>& R,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& e,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
+			const std::vector<mpz_ptr>& rand,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& masks,
+			std::ostream& out) const;
 		bool Verify_interactive
 			(const std::vector<std::pair<mpz_ptr, mpz_ptr> >& e,
 			const std::vector<std::pair<mpz_ptr, mpz_ptr> >& E,
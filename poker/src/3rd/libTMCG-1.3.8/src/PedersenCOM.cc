@@ -32,11 +32,12 @@
 	#include "libTMCG_config.h"
 #endif
 #include "PedersenCOM.hh"
+#include "parallel_helper.hh"
 
 /* This variation of the Pedersen commitment scheme is due to Groth [Gr05]. */
 PedersenCommitmentScheme::PedersenCommitmentScheme
 	(size_t n, unsigned long int fieldsize, unsigned long int subgroupsize):
-		F_size(fieldsize), G_size(subgroupsize)
+		F_size(fieldsize), G_size(subgroupsize), workers(1)
 {
 	mpz_t foo;
 	assert(n >= 1);
@@ -95,7 +96,7 @@ PedersenCommitmentScheme::PedersenCommitmentScheme
 	(size_t n, mpz_srcptr p_ENC, mpz_srcptr q_ENC, 
 	mpz_srcptr k_ENC, mpz_srcptr h_ENC, 
 	unsigned long int fieldsize, unsigned long int subgroupsize):
-		F_size(fieldsize), G_size(subgroupsize)
+		F_size(fieldsize), G_size(subgroupsize), workers(1)
 {
 	mpz_t foo;
 	assert(n >= 1);
@@ -141,7 +142,7 @@ PedersenCommitmentScheme::PedersenCommitmentScheme
 PedersenCommitmentScheme::PedersenCommitmentScheme
 	(size_t n, std::istream &in,
 	unsigned long int fieldsize, unsigned long int subgroupsize):
-		F_size(fieldsize), G_size(subgroupsize)
+		F_size(fieldsize), G_size(subgroupsize), workers(1)
 {
 	assert(n >= 1);
 	
@@ -381,28 +382,111 @@ void PedersenCommitmentScheme::CommitBy
 	assert(mpz_cmp(r, q) < 0);
 	
 	// Compute the commitment $c := g_1^{m_1} \cdots g_n^{m_n} h^r \bmod p$
+	if (!TimingAttackProtection)
+	{
+		MultiPowm(c, r, m);
+		return;
+	}
+	CommitBy_powers(c, r, NULL, m);
+}
+
+void PedersenCommitmentScheme::CommitBy_precomputed
+	(mpz_ptr c, mpz_srcptr h_r, const std::vector<mpz_ptr> &m) const
+{
+	assert(m.size() <= g.size());
+	
+	// Compute the commitment $c := g_1^{m_1} \cdots g_n^{m_n} h^r \bmod p$
+	// with the precomputed power $h^r$, e.g. $h_r$ from the mask of
+	// BarnettSmartVTMF_dlog::VerifiableRemaskingProtocol_Precompute()
+	// if both share the same group and the same $h$
+	CommitBy_powers(c, NULL, h_r, m);
+}
+
+void PedersenCommitmentScheme::CommitBy_powers
+	(mpz_ptr c, mpz_srcptr r, mpz_srcptr h_r,
+	const std::vector<mpz_ptr> &m) const
+{
+	// exactly one of $r$ and the precomputed $h^r$ is given
+	assert((r == NULL) != (h_r == NULL));
+	if ((workers > 1) && (m.size() > 1))
+	{
+		// compute the powers $h^r, g_1^{m_1}, \ldots, g_n^{m_n}$ in parallel
+		// and multiply them afterwards by the calling thread
+		std::vector<mpz_ptr> powers;
+		for (size_t i = 0; i <= m.size(); i++)
+		{
+			mpz_ptr tmp = new mpz_t();
+			mpz_init(tmp);
+			powers.push_back(tmp);
+		}
+		CommitBy_args args = { this, r, h_r, &m, &powers };
+		TMCG_ParallelHelper::run(workers, powers.size(), CommitBy_worker,
+			&args);
+		mpz_set(c, powers[0]);
+		for (size_t i = 1; i < powers.size(); i++)
+		{
+			mpz_mul(c, c, powers[i]);
+			mpz_mod(c, c, p);
+		}
+		for (size_t i = 0; i < powers.size(); i++)
+		{
+			mpz_clear(powers[i]);
+			delete [] powers[i];
+		}
+		return;
+	}
 	mpz_t tmp;
 	mpz_init(tmp);
-	if (TimingAttackProtection)
-		mpz_fspowm(fpowm_table_h, c, h, r, p);
+	if (h_r != NULL)
+		mpz_set(c, h_r);
 	else
-		mpz_fpowm(fpowm_table_h, c, h, r, p);
+		mpz_fspowm(fpowm_table_h, c, h, r, p);
 	for (size_t i = 0; i < m.size(); i++)
 	{
 		if (i < TMCG_MAX_FPOWM_N)
-		{
-			if (TimingAttackProtection)
-				mpz_fspowm(fpowm_table_g[i], tmp, g[i], m[i], p);
-			else
-				mpz_fpowm(fpowm_table_g[i], tmp, g[i], m[i], p);
-		}
+			mpz_fspowm(fpowm_table_g[i], tmp, g[i], m[i], p);
 		else
-		{
-			if (TimingAttackProtection)
-				mpz_spowm(tmp, g[i], m[i], p);
-			else
-				mpz_powm(tmp, g[i], m[i], p);
-		}
+			mpz_spowm(tmp, g[i], m[i], p);
+		mpz_mul(c, c, tmp);
+		mpz_mod(c, c, p);
+	}
+	mpz_clear(tmp);
+}
+
+void PedersenCommitmentScheme::CommitBy_worker
+	(size_t i, void *arg)
+{
+	CommitBy_args *a = (CommitBy_args*)arg;
+	const PedersenCommitmentScheme *com = a->com;
+	
+	// only the reentrant functions mpz_fspowm and mpz_spowm are used here
+	if ((i == 0) && (a->h_r != NULL))
+		mpz_set((*a->powers)[0], a->h_r);
+	else if (i == 0)
+		mpz_fspowm(com->fpowm_table_h, (*a->powers)[0], com->h, a->r, com->p);
+	else if ((i - 1) < TMCG_MAX_FPOWM_N)
+		mpz_fspowm(com->fpowm_table_g[i - 1], (*a->powers)[i],
+			com->g[i - 1], (*a->m)[i - 1], com->p);
+	else
+		mpz_spowm((*a->powers)[i], com->g[i - 1], (*a->m)[i - 1], com->p);
+}
+
+void PedersenCommitmentScheme::MultiPowm
+	(mpz_ptr c, mpz_srcptr r, const std::vector<mpz_ptr> &m) const
+{
+	// $c := g_1^{m_1} \cdots g_n^{m_n} h^r \bmod p$ with the precomputed
+	// comb tables of all generators sharing their squarings
+	std::vector<mpz_t*> tables;
+	std::vector<mpz_srcptr> exps;
+	mpz_t tmp;
+	mpz_init(tmp);
+	tables.push_back(fpowm_table_h), exps.push_back(r);
+	for (size_t i = 0; ((i < m.size()) && (i < TMCG_MAX_FPOWM_N)); i++)
+		tables.push_back(fpowm_table_g[i]), exps.push_back(m[i]);
+	mpz_fpowm_multi(&tables[0], c, &exps[0], exps.size(), p);
+	for (size_t i = TMCG_MAX_FPOWM_N; i < m.size(); i++)
+	{
+		mpz_powm(tmp, g[i], m[i], p);
 		mpz_mul(c, c, tmp);
 		mpz_mod(c, c, p);
 	}
@@ -423,8 +507,8 @@ bool PedersenCommitmentScheme::Verify
 {
 	assert(m.size() <= g.size());
 	
-	mpz_t tmp, c2;
-	mpz_init(tmp), mpz_init(c2);
+	mpz_t c2;
+	mpz_init(c2);
 	try
 	{
 		// Check whether $r < q$ holds 
@@ -433,20 +517,7 @@ bool PedersenCommitmentScheme::Verify
 
 		// Compute the commitment for verification
 		// $c' := g_1^{m_1} \cdots g_n^{m_n} h^r \bmod p$
-		mpz_fpowm(fpowm_table_h, c2, h, r, p);
-		for (size_t i = 0; i < m.size(); i++)
-		{
-			if (i < TMCG_MAX_FPOWM_N)
-			{
-				mpz_fpowm(fpowm_table_g[i], tmp, g[i], m[i], p);
-			}
-			else
-			{
-				mpz_powm(tmp, g[i], m[i], p);
-			}
-			mpz_mul(c2, c2, tmp);
-			mpz_mod(c2, c2, p);
-		}
+		MultiPowm(c2, r, m);
 		// Verify the commitment: 1. $c\in\mathbb{Z}_p\setminus\{0\}$
 		if ((mpz_cmp_ui(c, 0L) <= 0) || (mpz_cmp(c, p) >= 0))
 			throw false;
@@ -459,7 +530,7 @@ bool PedersenCommitmentScheme::Verify
 	}
 	catch (bool return_value)
 	{
-		mpz_clear(tmp), mpz_clear(c2);
+		mpz_clear(c2);
 		return return_value;
 	}
 }
@@ -61,10 +61,26 @@ class PedersenCommitmentScheme
 		mpz_t					*fpowm_table_h;
 		std::vector<mpz_t*>			fpowm_table_g;
 		const unsigned long int			F_size, G_size;
+		
+		void MultiPowm
+			(mpz_ptr c, mpz_srcptr r, const std::vector<mpz_ptr> &m) const;
+		void CommitBy_powers
+			(mpz_ptr c, mpz_srcptr r, mpz_srcptr h_r,
+			const std::vector<mpz_ptr> &m) const;
+		struct CommitBy_args
+		{
+			const PedersenCommitmentScheme		*com;
+			mpz_srcptr				r, h_r;
+			const std::vector<mpz_ptr>		*m;
+			std::vector<mpz_ptr>			*powers;
+		};
+		static void CommitBy_worker
+			(size_t i, void *arg);
 	
 	public:
 		mpz_t					p, q, k, h;
 		std::vector<mpz_ptr>			g;
+		size_t					workers; // threads for CommitBy with TAP
 		
 		PedersenCommitmentScheme
 			(size_t n,
@@ -97,6 +113,9 @@ class PedersenCommitmentScheme
 			(mpz_ptr c, mpz_srcptr r, 
 			const std::vector<mpz_ptr> &m,
 			bool TimingAttackProtection = true) const;
+		void CommitBy_precomputed
+			(mpz_ptr c, mpz_srcptr h_r,
+			const std::vector<mpz_ptr> &m) const;
 		bool TestMembership
 			(mpz_srcptr c) const;
 		bool Verify
@@ -29,6 +29,7 @@
 	#include "libTMCG_config.h"
 #endif
 #include "SchindelhauerTMCG.hh"
+#include "parallel_helper.hh"
 
 SchindelhauerTMCG::SchindelhauerTMCG
 	(unsigned long int security, size_t k, size_t w):
@@ -46,6 +47,32 @@ SchindelhauerTMCG::SchindelhauerTMCG
 	message_space = new mpz_t[TMCG_MaxCardType]();
 	for (size_t i = 0; i < TMCG_MaxCardType; i++)
 		mpz_init_set_ui(message_space[i], 0L); // values are set later
+	
+	// the parallel mode is disabled by default
+	TMCG_Workers = 1;
+}
+
+void SchindelhauerTMCG::TMCG_SetWorkers
+	(size_t workers)
+{
+	TMCG_Workers = workers;
+}
+
+void SchindelhauerTMCG::TMCG_PrecomputeMessageSpace
+	(BarnettSmartVTMF_dlog *vtmf)
+{
+	if (message_index.size() == TMCG_MaxCardType)
+		return;
+	
+	// set the whole message space to elements from group G at once and
+	// index them by their least significant limb, such that decoding a
+	// card type requires only a lookup and one comparison of integers
+	message_index.clear();
+	for (size_t t = 0; t < TMCG_MaxCardType; t++)
+	{
+		vtmf->IndexElement(message_space[t], t);
+		message_index.insert(std::make_pair(mpz_getlimbn(message_space[t], 0), t));
+	}
 }
 
 void SchindelhauerTMCG::TMCG_ProveQuadraticResidue
@@ -780,9 +807,7 @@ void SchindelhauerTMCG::TMCG_CreateOpenCard
 	if (type < TMCG_MaxCardType)
 	{
 		mpz_set_ui(c.c_1, 1L);
-		// set the message space to an element from group G
-		if (!mpz_cmp_ui(message_space[type], 0L))
-			vtmf->IndexElement(message_space[type], type);
+		TMCG_PrecomputeMessageSpace(vtmf);
 		mpz_set(c.c_2, message_space[type]);
 	}
 }
@@ -872,9 +897,7 @@ void SchindelhauerTMCG::TMCG_CreatePrivateCard
 {
 	assert(type < TMCG_MaxCardType);
 	
-	// set message space to an element from group G
-	if (!mpz_cmp_ui(message_space[type], 0L))
-		vtmf->IndexElement(message_space[type], type);
+	TMCG_PrecomputeMessageSpace(vtmf);
 	vtmf->VerifiableMaskingProtocol_Mask(message_space[type],
 		c.c_1, c.c_2, cs.r);
 }
@@ -1113,14 +1136,16 @@ size_t SchindelhauerTMCG::TMCG_TypeOfCard
 	mpz_init_set_ui(m, 0L);
 	vtmf->VerifiableDecryptionProtocol_Verify_Finalize(c.c_2, m);
 	
-	for (size_t t = 0; t < TMCG_MaxCardType; t++)
+	TMCG_PrecomputeMessageSpace(vtmf);
+	std::pair<std::multimap<mp_limb_t, size_t>::const_iterator,
+		std::multimap<mp_limb_t, size_t>::const_iterator> range =
+			message_index.equal_range(mpz_getlimbn(m, 0));
+	for (std::multimap<mp_limb_t, size_t>::const_iterator it = range.first;
+		it != range.second; ++it)
 	{
-		// set message space to an element from group G
-		if (!mpz_cmp_ui(message_space[t], 0L))
-			vtmf->IndexElement(message_space[t], t);
-		if (!mpz_cmp(m, message_space[t]))
+		if (!mpz_cmp(m, message_space[it->second]))
 		{
-			type = t;
+			type = it->second;
 			break;
 		}
 	}
@@ -1272,6 +1297,19 @@ void SchindelhauerTMCG::TMCG_MixStack
 	
 	// mask all cards, permutate, and build a new stack
 	s2.clear();
+	if ((TMCG_Workers > 1) && (s.size() > 1))
+	{
+		// the cards are masked independently by the workers, because
+		// VerifiableRemaskingProtocol_Remask is reentrant
+		std::vector<VTMF_Card> cards(s.size());
+		TMCG_MixStack_args args = { this, &s, &ss, vtmf,
+			TimingAttackProtection, &cards };
+		TMCG_ParallelHelper::run(TMCG_Workers, s.size(),
+			TMCG_MixStack_worker, &args);
+		for (size_t i = 0; i < cards.size(); i++)
+			s2.push(cards[i]);
+		return;
+	}
 	for (size_t i = 0; i < s.size(); i++)
 	{
 		VTMF_Card c;
@@ -1281,6 +1319,38 @@ void SchindelhauerTMCG::TMCG_MixStack
 	}
 }
 
+void SchindelhauerTMCG::TMCG_MixStack
+	(const TMCG_Stack<VTMF_Card> &s, TMCG_Stack<VTMF_Card> &s2,
+	const TMCG_StackSecret<VTMF_CardSecret> &ss,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+	BarnettSmartVTMF_dlog *vtmf)
+{
+	assert(s.size() == ss.size());
+	assert(s.size() == masks.size());
+	
+	// mask all cards with the powers $(g^{r_j}, h^{r_j})$ that were
+	// precomputed for $r_j$ of ss[j], permutate, and build a new stack
+	s2.clear();
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		VTMF_Card c;
+		size_t j = ss[i].first;
+		vtmf->VerifiableRemaskingProtocol_Remask(s[j].c_1, s[j].c_2,
+			c.c_1, c.c_2, masks[j].first, masks[j].second);
+		s2.push(c);
+	}
+}
+
+void SchindelhauerTMCG::TMCG_MixStack_worker
+	(size_t i, void *arg)
+{
+	TMCG_MixStack_args *a = (TMCG_MixStack_args*)arg;
+	size_t j = (*a->ss)[i].first;
+	
+	a->tmcg->TMCG_MaskCard((*a->s)[j], (*a->cards)[i], (*a->ss)[j].second,
+		a->vtmf, a->TimingAttackProtection);
+}
+
 void SchindelhauerTMCG::TMCG_GlueStackSecret
 	(const TMCG_StackSecret<TMCG_CardSecret> &sigma,
 	TMCG_StackSecret<TMCG_CardSecret> &pi, const TMCG_PublicKeyRing &ring)
@@ -1618,6 +1688,60 @@ void SchindelhauerTMCG::TMCG_ProveStackEquality_Groth_noninteractive
 	TMCG_ReleaseStackEquality_Groth(pi, R, e, E);
 }
 
+void SchindelhauerTMCG::TMCG_ProveStackEquality_Groth_noninteractive
+	(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+	const TMCG_StackSecret<VTMF_CardSecret> &ss,
+	const std::vector<mpz_ptr> &rand,
+	const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+	BarnettSmartVTMF_dlog *vtmf, GrothVSSHE *vsshe,
+	std::ostream &out)
+{
+	assert((s.size() == s2.size()) && (s.size() == ss.size()));
+	assert(!mpz_cmp(vtmf->h, vsshe->com->h));
+	assert(!mpz_cmp(vtmf->q, vsshe->com->q));
+	assert(!mpz_cmp(vtmf->p, vsshe->p));
+	assert(!mpz_cmp(vtmf->q, vsshe->q));
+	assert(!mpz_cmp(vtmf->g, vsshe->g));
+	assert(!mpz_cmp(vtmf->h, vsshe->h));
+	assert((s.size() <= vsshe->com->g.size()));
+	assert(rand.size() == masks.size());
+	
+	std::vector<mpz_ptr> R;
+	std::vector<std::pair<mpz_ptr, mpz_ptr> > e, E;
+	std::vector<size_t> pi;
+	
+	// the randomizers of the proof with the precomputed masks of vtmf,
+	// i.e. rand[i] and masks[i] from VerifiableRemaskingProtocol_Precompute()
+	TMCG_InitializeStackEquality_Groth(pi, R, e, E, s, s2, ss);
+	vsshe->Prove_noninteractive(pi, R, e, E, rand, masks, out);
+	TMCG_ReleaseStackEquality_Groth(pi, R, e, E);
+}
+
+void SchindelhauerTMCG::TMCG_ProveStackEquality_BayerGroth_noninteractive
+	(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+	const TMCG_StackSecret<VTMF_CardSecret> &ss,
+	BarnettSmartVTMF_dlog *vtmf, BayerGrothVSSHE *vsshe,
+	std::ostream &out)
+{
+	assert((s.size() == s2.size()) && (s.size() == ss.size()));
+	assert(!mpz_cmp(vtmf->h, vsshe->com->h));
+	assert(!mpz_cmp(vtmf->q, vsshe->com->q));
+	assert(!mpz_cmp(vtmf->p, vsshe->p));
+	assert(!mpz_cmp(vtmf->q, vsshe->q));
+	assert(!mpz_cmp(vtmf->g, vsshe->g));
+	assert(!mpz_cmp(vtmf->h, vsshe->h));
+	assert(s.size() == (vsshe->m * vsshe->n));
+	
+	std::vector<mpz_ptr> R;
+	std::vector<std::pair<mpz_ptr, mpz_ptr> > e, E;
+	std::vector<size_t> pi;
+	
+	// the same witness and statement as for Groth's shuffle proof
+	TMCG_InitializeStackEquality_Groth(pi, R, e, E, s, s2, ss);
+	vsshe->Prove_noninteractive(pi, R, e, E, out);
+	TMCG_ReleaseStackEquality_Groth(pi, R, e, E);
+}
+
 void SchindelhauerTMCG::TMCG_ProveStackEquality_Hoogh
 	(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
 	const TMCG_StackSecret<VTMF_CardSecret> &ss,
@@ -1935,6 +2059,37 @@ bool SchindelhauerTMCG::TMCG_VerifyStackEquality_Groth_noninteractive
 	return return_value;
 }
 
+bool SchindelhauerTMCG::TMCG_VerifyStackEquality_BayerGroth_noninteractive
+	(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+	BarnettSmartVTMF_dlog *vtmf, BayerGrothVSSHE *vsshe,
+	std::istream &in)
+{
+	// check whether the parameters of VSSHE and VTMF match
+	if (mpz_cmp(vtmf->h, vsshe->com->h) || mpz_cmp(vtmf->q, vsshe->com->q) || 
+		mpz_cmp(vtmf->p, vsshe->p) || mpz_cmp(vtmf->q, vsshe->q) || 
+		mpz_cmp(vtmf->g, vsshe->g) || mpz_cmp(vtmf->h, vsshe->h) || 
+		(s.size() != (vsshe->m * vsshe->n)))
+			return false;
+	
+	if (s.size() != s2.size())
+		return false;
+	
+	// check whether the elements of the shuffled stack belong to the group
+	for (size_t i = 0; i < s2.size(); i++)
+	{
+		if (!vtmf->CheckElement(s2[i].c_1) || !vtmf->CheckElement(s2[i].c_2))
+			return false;
+	}
+	
+	std::vector<std::pair<mpz_ptr, mpz_ptr> > e, E;
+	
+	TMCG_InitializeStackEquality_Groth(e, E, s, s2);
+	bool return_value = vsshe->Verify_noninteractive(e, E, in);
+	TMCG_ReleaseStackEquality_Groth(e, E);
+	
+	return return_value;
+}
+
 bool SchindelhauerTMCG::TMCG_VerifyStackEquality_Hoogh
 	(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
 	BarnettSmartVTMF_dlog *vtmf, HooghSchoenmakersSkoricVillegasVRHE *vrhe,
@@ -35,6 +35,7 @@
 	#include <sstream>
 	#include <iostream>
 	#include <vector>
+	#include <map>
 	
 	// GNU crypto library
 	#include <gcrypt.h>
@@ -56,6 +57,7 @@
 	#include "BarnettSmartVTMF_dlog.hh"
 	#include "BarnettSmartVTMF_dlog_GroupQR.hh"
 	#include "GrothVSSHE.hh"
+	#include "BayerGrothVSSHE.hh"
 	#include "HooghSchoenmakersSkoricVillegasVRHE.hh"
 	#include "mpz_srandom.h"
 	#include "mpz_sqrtm.h"
@@ -65,6 +67,12 @@ class SchindelhauerTMCG
 	private:
 		size_t							TMCG_MaxCardType;
 		mpz_t							*message_space;
+		std::multimap<mp_limb_t, size_t>	message_index;
+		size_t							TMCG_Workers;
+		
+		// precomputation of the message space for the VTMF scheme
+		void TMCG_PrecomputeMessageSpace
+			(BarnettSmartVTMF_dlog *vtmf);
 		
 		// private zero-knowledge proofs on values
 		void TMCG_ProveQuadraticResidue
@@ -121,6 +129,19 @@ class SchindelhauerTMCG
 			const TMCG_StackSecret<VTMF_CardSecret> &ss, 
 			BarnettSmartVTMF_dlog *vtmf);
 		
+		// helper for the parallel mode of TMCG_MixStack
+		struct TMCG_MixStack_args
+		{
+			SchindelhauerTMCG					*tmcg;
+			const TMCG_Stack<VTMF_Card>				*s;
+			const TMCG_StackSecret<VTMF_CardSecret>			*ss;
+			BarnettSmartVTMF_dlog					*vtmf;
+			bool							TimingAttackProtection;
+			std::vector<VTMF_Card>					*cards;
+		};
+		static void TMCG_MixStack_worker
+			(size_t i, void *arg);
+		
 		// helper methods for Groth's shuffle proof
 		void TMCG_InitializeStackEquality_Groth
 			(std::vector<size_t> &pi, std::vector<mpz_ptr> &R,
@@ -162,6 +183,10 @@ class SchindelhauerTMCG
 		~SchindelhauerTMCG
 			();
 		
+		// number of threads for TMCG_MixStack in the VTMF instantiation
+		void TMCG_SetWorkers
+			(size_t workers);
+		
 		// operations and proofs on cards
 		void TMCG_CreateOpenCard
 			(TMCG_Card &c, const TMCG_PublicKeyRing &ring, size_t type);
@@ -238,6 +263,11 @@ class SchindelhauerTMCG
 			(const TMCG_Stack<VTMF_Card> &s, TMCG_Stack<VTMF_Card> &s2,
 			const TMCG_StackSecret<VTMF_CardSecret> &ss,
 			BarnettSmartVTMF_dlog *vtmf, bool TimingAttackProtection = true);
+		void TMCG_MixStack
+			(const TMCG_Stack<VTMF_Card> &s, TMCG_Stack<VTMF_Card> &s2,
+			const TMCG_StackSecret<VTMF_CardSecret> &ss,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+			BarnettSmartVTMF_dlog *vtmf);
 		void TMCG_ProveStackEquality
 			(const TMCG_Stack<TMCG_Card> &s, const TMCG_Stack<TMCG_Card> &s2,
 			const TMCG_StackSecret<TMCG_CardSecret> &ss, bool cyclic,
@@ -257,6 +287,18 @@ class SchindelhauerTMCG
 			const TMCG_StackSecret<VTMF_CardSecret> &ss,
 			BarnettSmartVTMF_dlog *vtmf, GrothVSSHE *vsshe,
 			std::ostream &out);
+		void TMCG_ProveStackEquality_Groth_noninteractive
+			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+			const TMCG_StackSecret<VTMF_CardSecret> &ss,
+			const std::vector<mpz_ptr> &rand,
+			const std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+			BarnettSmartVTMF_dlog *vtmf, GrothVSSHE *vsshe,
+			std::ostream &out);
+		void TMCG_ProveStackEquality_BayerGroth_noninteractive
+			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+			const TMCG_StackSecret<VTMF_CardSecret> &ss,
+			BarnettSmartVTMF_dlog *vtmf, BayerGrothVSSHE *vsshe,
+			std::ostream &out);
 		void TMCG_ProveStackEquality_Hoogh
 			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
 			const TMCG_StackSecret<VTMF_CardSecret> &ss,
@@ -289,6 +331,10 @@ class SchindelhauerTMCG
 			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2, 
 			BarnettSmartVTMF_dlog *vtmf, GrothVSSHE *vsshe,
 			std::stringstream &in);
+		bool TMCG_VerifyStackEquality_BayerGroth_noninteractive
+			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+			BarnettSmartVTMF_dlog *vtmf, BayerGrothVSSHE *vsshe,
+			std::istream &in);
 
 		bool TMCG_VerifyStackEquality_Hoogh
 			(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
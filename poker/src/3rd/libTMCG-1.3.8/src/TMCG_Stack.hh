@@ -27,6 +27,7 @@
 	#include <cassert>
 	#include <string>
 	#include <iostream>
+	#include <sstream>
 	#include <vector>
 	#include <algorithm>
 	#include <functional>
@@ -258,6 +259,19 @@ template <typename CardType> struct TMCG_Stack
 template<typename CardType> std::ostream& operator <<
 	(std::ostream& out, const TMCG_Stack<CardType>& stack)
 {
+	if (TMCG_ParseHelper::is_binary(out))
+	{
+		// number of cards, and each card as length-prefixed binary string
+		TMCG_ParseHelper::put_size(out, stack.size());
+		for (size_t i = 0; i < stack.size(); i++)
+		{
+			std::ostringstream card;
+			TMCG_ParseHelper::set_binary(card);
+			card << stack[i];
+			TMCG_ParseHelper::put_blob(out, card.str());
+		}
+		return out;
+	}
 	out << "stk^" << stack.size() << "^";
 	for (size_t i = 0; i < stack.size(); i++)
 		out << stack[i] << "^";
@@ -273,6 +287,36 @@ template<typename CardType> std::ostream& operator <<
 template<typename CardType> std::istream& operator >>
 	(std::istream& in, TMCG_Stack<CardType>& stack)
 {
+	if (TMCG_ParseHelper::is_binary(in))
+	{
+		size_t size = 0;
+		if (!TMCG_ParseHelper::get_size(in, size) || (size <= 0) ||
+			(size > TMCG_MAX_CARDS))
+		{
+			in.setstate(std::istream::iostate(std::istream::failbit));
+			return in;
+		}
+		for (size_t i = 0; i < size; i++)
+		{
+			std::string card_str;
+			CardType c;
+			if (!TMCG_ParseHelper::get_blob(in, card_str, TMCG_MAX_CARD_CHARS))
+			{
+				in.setstate(std::istream::iostate(std::istream::failbit));
+				return in;
+			}
+			std::istringstream card(card_str);
+			TMCG_ParseHelper::set_binary(card);
+			if (!(card >> c))
+			{
+				in.setstate(std::istream::iostate(std::istream::failbit));
+				return in;
+			}
+			stack.push(c);
+		}
+		TMCG_ParseHelper::skip_newline(in);
+		return in;
+	}
 	char *tmp = new char[TMCG_MAX_STACK_CHARS];
 	in.getline(tmp, TMCG_MAX_STACK_CHARS);
 	if (!stack.import(std::string(tmp)))
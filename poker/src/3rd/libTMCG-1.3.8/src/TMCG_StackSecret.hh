@@ -27,6 +27,7 @@
 	#include <cassert>
 	#include <string>
 	#include <iostream>
+	#include <sstream>
 	#include <vector>
 	#include <algorithm>
 	#include <functional>
@@ -218,6 +219,21 @@ template <typename CardSecretType> struct TMCG_StackSecret
 template<typename CardSecretType> std::ostream& operator <<
 	(std::ostream& out, const TMCG_StackSecret<CardSecretType>& stacksecret)
 {
+	if (TMCG_ParseHelper::is_binary(out))
+	{
+		// number of pairs, and each pair as permutation index followed
+		// by the card secret as length-prefixed binary string
+		TMCG_ParseHelper::put_size(out, stacksecret.size());
+		for (size_t i = 0; i < stacksecret.size(); i++)
+		{
+			std::ostringstream cs;
+			TMCG_ParseHelper::set_binary(cs);
+			cs << stacksecret[i].second;
+			TMCG_ParseHelper::put_size(out, stacksecret[i].first);
+			TMCG_ParseHelper::put_blob(out, cs.str());
+		}
+		return out;
+	}
 	out << "sts^" << stacksecret.size() << "^";
 	for (size_t i = 0; i < stacksecret.size(); i++)
 		out << stacksecret[i].first << "^" << stacksecret[i].second << "^";
@@ -233,6 +249,47 @@ template<typename CardSecretType> std::ostream& operator <<
 template<typename CardSecretType> std::istream& operator >>
 	(std::istream& in, TMCG_StackSecret<CardSecretType>& stacksecret)
 {
+	if (TMCG_ParseHelper::is_binary(in))
+	{
+		size_t size = 0;
+		if (!TMCG_ParseHelper::get_size(in, size) || (size <= 0) ||
+			(size > TMCG_MAX_CARDS))
+		{
+			in.setstate(std::istream::iostate(std::istream::failbit));
+			return in;
+		}
+		for (size_t i = 0; i < size; i++)
+		{
+			size_t index = 0;
+			std::string cs_str;
+			CardSecretType cs;
+			if (!TMCG_ParseHelper::get_size(in, index) || (index >= size) ||
+				!TMCG_ParseHelper::get_blob(in, cs_str, TMCG_MAX_CARD_CHARS))
+			{
+				in.setstate(std::istream::iostate(std::istream::failbit));
+				return in;
+			}
+			std::istringstream cs_in(cs_str);
+			TMCG_ParseHelper::set_binary(cs_in);
+			if (!(cs_in >> cs))
+			{
+				in.setstate(std::istream::iostate(std::istream::failbit));
+				return in;
+			}
+			stacksecret.push(index, cs);
+		}
+		// check whether the index component is a correct permutation
+		for (size_t i = 0; i < size; i++)
+		{
+			if (stacksecret.find_position(i) >= stacksecret.size())
+			{
+				in.setstate(std::istream::iostate(std::istream::failbit));
+				return in;
+			}
+		}
+		TMCG_ParseHelper::skip_newline(in);
+		return in;
+	}
 	char *tmp = new char[TMCG_MAX_STACK_CHARS];
 	in.getline(tmp, TMCG_MAX_STACK_CHARS);
 	if (!stacksecret.import(std::string(tmp)))
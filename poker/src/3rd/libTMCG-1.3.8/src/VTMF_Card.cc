@@ -93,6 +93,8 @@ VTMF_Card::~VTMF_Card()
 std::ostream& operator <<
 	(std::ostream& out, const VTMF_Card& card)
 {
+	if (TMCG_ParseHelper::is_binary(out))
+		return out << card.c_1 << card.c_2;
 	out << "crd|" << card.c_1 << "|" << card.c_2 << "|";
 	return out;
 }
@@ -100,6 +102,12 @@ std::ostream& operator <<
 std::istream& operator >>
 	(std::istream& in, VTMF_Card& card)
 {
+	if (TMCG_ParseHelper::is_binary(in))
+	{
+		if (!(in >> card.c_1 >> card.c_2))
+			mpz_set_ui(card.c_1, 0L), mpz_set_ui(card.c_2, 0L);
+		return in;
+	}
 	char *tmp = new char[TMCG_MAX_CARD_CHARS];
 	in.getline(tmp, TMCG_MAX_CARD_CHARS);
 	if (!card.import(std::string(tmp)))
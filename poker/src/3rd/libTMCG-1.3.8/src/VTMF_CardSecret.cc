@@ -76,12 +76,16 @@ VTMF_CardSecret::~VTMF_CardSecret
 std::ostream& operator <<
 	(std::ostream& out, const VTMF_CardSecret& cardsecret)
 {
+	if (TMCG_ParseHelper::is_binary(out))
+		return out << cardsecret.r;
 	return out << "crs|" << cardsecret.r << "|";
 }
 
 std::istream& operator >>
 	(std::istream& in, VTMF_CardSecret& cardsecret)
 {
+	if (TMCG_ParseHelper::is_binary(in))
+		return in >> cardsecret.r;
 	char *tmp = new char[TMCG_MAX_CARD_CHARS];
 	in.getline(tmp, TMCG_MAX_CARD_CHARS);
 	if (!cardsecret.import(std::string(tmp)))
@@ -23,6 +23,7 @@
 	#include "libTMCG_config.h"
 #endif
 #include "mpz_helper.hh"
+#include "parse_helper.hh"
 
 // get content of mpz_t into gcry_mpi_t
 bool mpz_get_gcry_mpi
@@ -89,6 +90,18 @@ size_t get_gcry_mpi_ui
 std::ostream& operator <<
 	(std::ostream &out, mpz_srcptr value)
 {
+	if (TMCG_ParseHelper::is_binary(out))
+	{
+		// sign, length of the magnitude, and the magnitude (big-endian)
+		size_t count = 0;
+		char *buf = new char[(mpz_sizeinbase(value, 2L) + 7) / 8];
+		mpz_export(buf, &count, 1, 1, 1, 0, value);
+		out.put((mpz_sgn(value) < 0) ? '-' : '+');
+		TMCG_ParseHelper::put_size(out, count);
+		out.write(buf, count);
+		delete [] buf;
+		return out;
+	}
 	size_t size = mpz_sizeinbase(value, TMCG_MPZ_IO_BASE);
 	size_t bufsize = size + 2; // two extra bytes are for a possible minus sign, and the null-terminator
 	char *buf = new char[bufsize];
@@ -101,6 +114,26 @@ std::ostream& operator <<
 std::istream& operator >>
 	(std::istream &in, mpz_ptr value)
 {
+	if (TMCG_ParseHelper::is_binary(in))
+	{
+		std::string buf;
+		int sign = in.get();
+		if (((sign != '+') && (sign != '-')) ||
+			!TMCG_ParseHelper::get_blob(in, buf, TMCG_MAX_VALUE_CHARS))
+		{
+			mpz_set_ui(value, 0L); // indicates an error
+			in.setstate(std::istream::iostate(std::istream::failbit));
+			return in;
+		}
+		if (buf.length())
+			mpz_import(value, buf.length(), 1, 1, 1, 0, buf.data());
+		else
+			mpz_set_ui(value, 0L);
+		if (sign == '-')
+			mpz_neg(value, value);
+		TMCG_ParseHelper::skip_newline(in);
+		return in;
+	}
 	char *buf = new char[TMCG_MAX_VALUE_CHARS];
 	in.getline(buf, TMCG_MAX_VALUE_CHARS - 1);
 	if (mpz_set_str(value, buf, TMCG_MPZ_IO_BASE) < 0)
@@ -25,46 +25,70 @@
 #endif
 #include "mpz_spowm.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 /* Kocher's efficient blinding technique for modular exponentiation [Ko96] */
-mpz_t bvi, bvf, bx, bp;
 
-void mpz_spowm_init
-	(mpz_srcptr x, mpz_srcptr p)
+void mpz_spowm_ctx_init
+	(mpz_spowm_ctx ctx, mpz_srcptr x, mpz_srcptr p)
 {
 	int ret;
 	
 	/* initalize the seed variables */
-	mpz_init(bvi), mpz_init(bvf), mpz_init_set(bx, x), mpz_init_set(bp, p);
+	mpz_init(ctx->bvi), mpz_init(ctx->bvf), mpz_init_set(ctx->bx, x),
+		mpz_init_set(ctx->bp, p);
 	
 	/* choose a random blinding value and compute the seed */
 	do
 	{
-		mpz_srandomm(bvi, bp);
-		ret = mpz_invert(bvf, bvi, bp);
+		mpz_srandomm(ctx->bvi, ctx->bp);
+		ret = mpz_invert(ctx->bvf, ctx->bvi, ctx->bp);
 	}
 	while (!ret);
-	mpz_powm(bvf, bvf, bx, bp);
+	mpz_powm(ctx->bvf, ctx->bvf, ctx->bx, ctx->bp);
 }
 
-void mpz_spowm_calc
-	(mpz_ptr res, mpz_srcptr m)
+void mpz_spowm_ctx_calc
+	(mpz_spowm_ctx ctx, mpz_ptr res, mpz_srcptr m)
 {
 	/* modular exponentiation (res = m^x mod p) */
-	mpz_mul(res, m, bvi);
-	mpz_mod(res, res, bp);
-	mpz_powm(res, res, bx, bp);
-	mpz_mul(res, res, bvf);
-	mpz_mod(res, res, bp);
+	mpz_mul(res, m, ctx->bvi);
+	mpz_mod(res, res, ctx->bp);
+	mpz_powm(res, res, ctx->bx, ctx->bp);
+	mpz_mul(res, res, ctx->bvf);
+	mpz_mod(res, res, ctx->bp);
 	
 	/* compute the new seed */
-	mpz_powm_ui(bvi, bvi, 2L, bp);
-	mpz_powm_ui(bvf, bvf, 2L, bp);
+	mpz_powm_ui(ctx->bvi, ctx->bvi, 2L, ctx->bp);
+	mpz_powm_ui(ctx->bvf, ctx->bvf, 2L, ctx->bp);
+}
+
+void mpz_spowm_ctx_clear
+	(mpz_spowm_ctx ctx)
+{
+	mpz_clear(ctx->bvi), mpz_clear(ctx->bvf), mpz_clear(ctx->bx),
+		mpz_clear(ctx->bp);
+}
+
+static mpz_spowm_ctx spowm_ctx;
+
+void mpz_spowm_init
+	(mpz_srcptr x, mpz_srcptr p)
+{
+	mpz_spowm_ctx_init(spowm_ctx, x, p);
+}
+
+void mpz_spowm_calc
+	(mpz_ptr res, mpz_srcptr m)
+{
+	mpz_spowm_ctx_calc(spowm_ctx, res, m);
 }
 
 void mpz_spowm_clear
 	()
 {
-	mpz_clear(bvi), mpz_clear(bvf), mpz_clear(bx), mpz_clear(bp);
+	mpz_spowm_ctx_clear(spowm_ctx);
 }
 
 /* Chaum's blinding technique for modular exponentiation */
@@ -159,6 +183,12 @@ void mpz_spowm
 
 /* Fast modular exponentiation using precomputed tables */
 
+/* The tables implement the fixed-base comb method of Lim and Lee [LL94]
+   with TMCG_FPOWM_COMB_W teeth: for an exponent of at most w*d bits,
+   fpowm_table[j] = \prod_{k: bit k of j is set} m^{2^{kd}} mod p for
+   0 < j < 2^w, and fpowm_table[0] stores the tooth distance d. Thus an
+   exponentiation costs only d squarings and at most d multiplications. */
+
 void mpz_fpowm_init
 	(mpz_t fpowm_table[])
 {
@@ -172,47 +202,113 @@ void mpz_fpowm_precompute
 	(mpz_t fpowm_table[],
 	mpz_srcptr m, mpz_srcptr p, const size_t t)
 {
-	size_t i;
+	size_t j, k, d, top;
+	mpz_t b;
 	
-	mpz_set(fpowm_table[0], m);
-	for (i = 1; ((i < t) && (i < TMCG_MAX_FPOWM_T)); i++)
+	assert(((size_t)1 << TMCG_FPOWM_COMB_W) <= TMCG_MAX_FPOWM_T);
+	d = (t + TMCG_FPOWM_COMB_W - 1) / TMCG_FPOWM_COMB_W;
+	if (d == 0)
+		d = 1;
+	mpz_set_ui(fpowm_table[0], d);
+	
+	/* b runs through $m^{2^{kd}}$ for the teeth $k = 0, \ldots, w-1$ */
+	mpz_init_set(b, m);
+	mpz_mod(b, b, p);
+	for (k = 0; k < TMCG_FPOWM_COMB_W; k++)
 	{
-		mpz_mul(fpowm_table[i], fpowm_table[i-1], fpowm_table[i-1]);
-		mpz_mod(fpowm_table[i], fpowm_table[i], p);
+		top = ((size_t)1 << k);
+		mpz_set(fpowm_table[top], b);
+		for (j = 1; j < top; j++)
+		{
+			mpz_mul(fpowm_table[top + j], fpowm_table[j], b);
+			mpz_mod(fpowm_table[top + j], fpowm_table[top + j], p);
+		}
+		for (j = 0; j < d; j++)
+		{
+			mpz_mul(b, b, b);
+			mpz_mod(b, b, p);
+		}
+	}
+	mpz_clear(b);
+}
+
+static size_t mpz_fpowm_comb_digit
+	(mpz_srcptr x, const size_t i, const size_t d)
+{
+	size_t k, j = 0;
+	
+	for (k = 0; k < TMCG_FPOWM_COMB_W; k++)
+		j |= ((size_t)mpz_tstbit(x, i + (k * d)) << k);
+	return j;
+}
+
+/* Select the table entry j (the entry 0 is replaced by 1) into res without
+   a secret dependent memory access: every entry is read completely and
+   combined with a mask, that is all ones only for the entry j. The buffer
+   buf must hold n limbs, where n is the number of limbs of the modulus. */
+
+static mp_limb_t mpz_fpowm_comb_mask
+	(const size_t a, const size_t b)
+{
+	size_t c = a ^ b;
+	
+	/* the most significant bit of (c | -c) is set iff c != 0 */
+	c = ((c | ((size_t)0 - c)) >> ((sizeof(size_t) * 8) - 1)) ^ 1;
+	return (mp_limb_t)0 - (mp_limb_t)c;
+}
+
+static void mpz_fpowm_comb_select
+	(mpz_t fpowm_table[], mpz_ptr res, const size_t j,
+	mp_limb_t *buf, const size_t n)
+{
+	size_t t, k;
+	mp_limb_t mask;
+	
+	memset(buf, 0, n * sizeof(mp_limb_t));
+	buf[0] = mpz_fpowm_comb_mask(0, j) & 1;
+	for (t = 1; t < ((size_t)1 << TMCG_FPOWM_COMB_W); t++)
+	{
+		mask = mpz_fpowm_comb_mask(t, j);
+		for (k = 0; k < n; k++)
+			buf[k] |= (mpz_getlimbn(fpowm_table[t], k) & mask);
 	}
+	mpz_import(res, n, -1, sizeof(mp_limb_t), 0, GMP_NAIL_BITS, buf);
 }
 
 void mpz_fpowm
 	(mpz_t fpowm_table[],
 	mpz_ptr res, mpz_srcptr m, mpz_srcptr x, mpz_srcptr p)
 {
-	size_t i;
+	size_t i, j, d = mpz_get_ui(fpowm_table[0]);
 	mpz_t xx;
 	
 	mpz_init_set(xx, x);
 	if (mpz_sgn(x) == -1)
 		mpz_neg(xx, x);
 	
-	if (mpz_sizeinbase(xx, 2L) <= TMCG_MAX_FPOWM_T)
+	if (mpz_sizeinbase(xx, 2L) <= (TMCG_FPOWM_COMB_W * d))
 	{
 		mpz_set_ui(res, 1L);
-		for (i = 0; i < mpz_sizeinbase(xx, 2L); i++)
+		for (i = d; i > 0; i--)
 		{
-			if (mpz_tstbit(xx, i))
+			mpz_mul(res, res, res);
+			mpz_mod(res, res, p);
+			j = mpz_fpowm_comb_digit(xx, i - 1, d);
+			if (j)
 			{
-				mpz_mul(res, res, fpowm_table[i]);
+				mpz_mul(res, res, fpowm_table[j]);
 				mpz_mod(res, res, p);
 			}
 		}
-		/* invert the result, if x was negative */
-		if (mpz_sgn(x) == -1)
-		{
-			if (!mpz_invert(res, res, p))
-				mpz_set_ui(res, 0L); /* indicates an error */
-		}
 	}
 	else
-		mpz_set_ui(res, 0L); /* indicates an error */
+		mpz_powm(res, fpowm_table[1], xx, p); /* exponent exceeds the table */
+	/* invert the result, if x was negative */
+	if (mpz_sgn(x) == -1)
+	{
+		if (!mpz_invert(res, res, p))
+			mpz_set_ui(res, 0L); /* indicates an error */
+	}
 	mpz_clear(xx);
 }
 
@@ -220,24 +316,10 @@ void mpz_fpowm_ui
 	(mpz_t fpowm_table[],
 	mpz_ptr res, mpz_srcptr m, const unsigned long int x_ui, mpz_srcptr p)
 {
-	size_t i;
 	mpz_t x;
 	
 	mpz_init_set_ui(x, x_ui);
-	if (mpz_sizeinbase(x, 2L) <= TMCG_MAX_FPOWM_T)
-	{
-		mpz_set_ui(res, 1L);
-		for (i = 0; i < mpz_sizeinbase(x, 2L); i++)
-		{
-			if (mpz_tstbit(x, i))
-			{
-				mpz_mul(res, res, fpowm_table[i]);
-				mpz_mod(res, res, p);
-			}
-		}
-	}
-	else
-		mpz_set_ui(res, 0L); /* indicates an error */
+	mpz_fpowm(fpowm_table, res, m, x, p);
 	mpz_clear(x);
 }
 
@@ -245,7 +327,8 @@ void mpz_fspowm
 	(mpz_t fpowm_table[],
 	mpz_ptr res, mpz_srcptr m, mpz_srcptr x, mpz_srcptr p)
 {
-	size_t i;
+	size_t i, j, d = mpz_get_ui(fpowm_table[0]), n = mpz_size(p);
+	mp_limb_t *buf;
 	mpz_t foo, bar, baz, xx;
 	
 	mpz_init(foo), mpz_init(bar), mpz_init(baz), mpz_init_set(xx, x);
@@ -253,45 +336,103 @@ void mpz_fspowm
 		mpz_neg(xx, x);
 	else
 		mpz_neg(bar, x);
-	if (mpz_sizeinbase(xx, 2L) <= TMCG_MAX_FPOWM_T)
+	if (mpz_sizeinbase(xx, 2L) <= (TMCG_FPOWM_COMB_W * d))
 	{
-		/* compute result by multiplying precomputed values */
+		/* compute result by multiplying precomputed values, where the
+		   number of steps and the accessed memory do not depend on the
+		   exponent: a zero digit multiplies by a selected 1 */
+		buf = (mp_limb_t*)malloc(n * sizeof(mp_limb_t));
 		mpz_set_ui(res, 1L);
-		for (i = 0; i < mpz_sizeinbase(xx, 2L); i++)
+		for (i = d; i > 0; i--)
 		{
-			mpz_mul(foo, res, fpowm_table[i]);
-			mpz_mod(foo, foo, p);
-			mpz_add(bar, bar, foo); /* dummy bar usage */
-			if (mpz_tstbit(xx, i))
-				mpz_set(res, foo);
-			else
-				mpz_set(bar, foo);
+			mpz_mul(res, res, res);
+			mpz_mod(res, res, p);
+			j = mpz_fpowm_comb_digit(xx, i - 1, d);
+			mpz_fpowm_comb_select(fpowm_table, foo, j, buf, n);
+			mpz_mul(res, res, foo);
+			mpz_mod(res, res, p);
 		}
-		/* invert the input, if x was negative */
-		mpz_set(baz, res);
-		if (!mpz_invert(foo, res, p))
-			mpz_set_ui(foo, 0L); /* indicates an error */
-		if (mpz_sgn(x) == -1)
-			mpz_set(res, foo);
-		else
-			mpz_set(baz, foo);
-		/* additional dummy to prevent compiler optimizations */
-		if (!mpz_invert(foo, bar, p))
-			mpz_set_ui(foo, 1L), mpz_set_ui(bar, 1L);
-		mpz_mul(res, bar, res); /* res = bar * res * bar^{-1} mod p */
-		mpz_mod(res, res, p);
-		mpz_mul(res, res, foo);
-		mpz_mod(res, res, p);
-		if (!mpz_invert(foo, baz, p))
-			mpz_set_ui(foo, 1L), mpz_set_ui(baz, 1L);
-		mpz_mul(res, baz, res); /* res = baz * res * baz^{-1} mod p */
+		memset(buf, 0, n * sizeof(mp_limb_t));
+		free(buf);
+	}
+	else
+		mpz_spowm(res, fpowm_table[1], xx, p); /* exponent exceeds the table */
+	/* invert the input, if x was negative */
+	mpz_set(baz, res);
+	if (!mpz_invert(foo, res, p))
+		mpz_set_ui(foo, 0L); /* indicates an error */
+	if (mpz_sgn(x) == -1)
+		mpz_set(res, foo);
+	else
+		mpz_set(baz, foo);
+	/* additional dummy to prevent compiler optimizations */
+	if (!mpz_invert(foo, bar, p))
+		mpz_set_ui(foo, 1L), mpz_set_ui(bar, 1L);
+	mpz_mul(res, bar, res); /* res = bar * res * bar^{-1} mod p */
+	mpz_mod(res, res, p);
+	mpz_mul(res, res, foo);
+	mpz_mod(res, res, p);
+	if (!mpz_invert(foo, baz, p))
+		mpz_set_ui(foo, 1L), mpz_set_ui(baz, 1L);
+	mpz_mul(res, baz, res); /* res = baz * res * baz^{-1} mod p */
+	mpz_mod(res, res, p);
+	mpz_mul(res, res, foo);
+	mpz_mod(res, res, p);
+	mpz_clear(foo), mpz_clear(bar), mpz_clear(baz), mpz_clear(xx);
+}
+
+void mpz_fpowm_multi
+	(mpz_t *fpowm_tables[],
+	mpz_ptr res, mpz_srcptr x[], const size_t n, mpz_srcptr p)
+{
+	size_t i, j, k, d = 0;
+	char *comb;
+	mpz_t foo;
+	
+	mpz_init(foo);
+	mpz_set_ui(res, 1L);
+	comb = (char*)malloc(n + 1);
+	for (k = 0; k < n; k++)
+	{
+		/* negative or too large exponents and tables of other size are
+		   not handled by the shared comb */
+		comb[k] = 0;
+		if (mpz_sgn(x[k]) == -1)
+			continue;
+		if (d == 0)
+			d = mpz_get_ui(fpowm_tables[k][0]);
+		if ((d != 0) && (mpz_get_ui(fpowm_tables[k][0]) == d) &&
+			(mpz_sizeinbase(x[k], 2L) <= (TMCG_FPOWM_COMB_W * d)))
+				comb[k] = 1;
+	}
+	
+	/* all combs share the squarings */
+	for (i = d; i > 0; i--)
+	{
+		mpz_mul(res, res, res);
 		mpz_mod(res, res, p);
+		for (k = 0; k < n; k++)
+		{
+			if (!comb[k])
+				continue;
+			j = mpz_fpowm_comb_digit(x[k], i - 1, d);
+			if (j)
+			{
+				mpz_mul(res, res, fpowm_tables[k][j]);
+				mpz_mod(res, res, p);
+			}
+		}
+	}
+	for (k = 0; k < n; k++)
+	{
+		if (comb[k])
+			continue;
+		mpz_fpowm(fpowm_tables[k], foo, fpowm_tables[k][1], x[k], p);
 		mpz_mul(res, res, foo);
 		mpz_mod(res, res, p);
 	}
-	else
-		mpz_set_ui(res, 0L); /* indicates an error */
-	mpz_clear(foo), mpz_clear(bar), mpz_clear(baz), mpz_clear(xx);
+	free(comb);
+	mpz_clear(foo);
 }
 
 void mpz_fpowm_done
@@ -302,3 +443,219 @@ void mpz_fpowm_done
 	for (i = 0; i < TMCG_MAX_FPOWM_T; i++)
 		mpz_clear(fpowm_table[i]);
 }
+
+/* Simultaneous multi-exponentiation */
+
+static size_t mpz_mpowm_digit
+	(mpz_srcptr x, const size_t lo, const size_t w)
+{
+	size_t j, d = 0;
+	
+	for (j = 0; j < w; j++)
+	{
+		if (mpz_tstbit(x, lo + j))
+			d |= ((size_t)1 << j);
+	}
+	return d;
+}
+
+static void mpz_mpowm_straus
+	(mpz_ptr res, mpz_t mm[], mpz_t xx[], const size_t n,
+	mpz_srcptr p, const size_t b, const size_t w)
+{
+	size_t i, j, k, d, nw = (b + w - 1) / w, tw = ((size_t)1 << w);
+	mpz_t *tab;
+	
+	/* precompute m_i^d for d = 1, ..., 2^w - 1 */
+	tab = (mpz_t*)malloc(n * tw * sizeof(mpz_t));
+	for (i = 0; i < n; i++)
+	{
+		mpz_init_set(tab[(i * tw) + 1], mm[i]);
+		for (d = 2; d < tw; d++)
+		{
+			mpz_init(tab[(i * tw) + d]);
+			mpz_mul(tab[(i * tw) + d], tab[(i * tw) + d - 1], mm[i]);
+			mpz_mod(tab[(i * tw) + d], tab[(i * tw) + d], p);
+		}
+	}
+	
+	/* interleaved left-to-right scan of all exponents with shared squarings */
+	mpz_set_ui(res, 1L);
+	for (k = nw; k > 0; k--)
+	{
+		if (k < nw)
+		{
+			for (j = 0; j < w; j++)
+			{
+				mpz_mul(res, res, res);
+				mpz_mod(res, res, p);
+			}
+		}
+		for (i = 0; i < n; i++)
+		{
+			d = mpz_mpowm_digit(xx[i], (k - 1) * w, w);
+			if (d)
+			{
+				mpz_mul(res, res, tab[(i * tw) + d]);
+				mpz_mod(res, res, p);
+			}
+		}
+	}
+	
+	for (i = 0; i < n; i++)
+	{
+		for (d = 1; d < tw; d++)
+			mpz_clear(tab[(i * tw) + d]);
+	}
+	free(tab);
+}
+
+static void mpz_mpowm_pippenger
+	(mpz_ptr res, mpz_t mm[], mpz_t xx[], const size_t n,
+	mpz_srcptr p, const size_t b, const size_t c)
+{
+	size_t i, j, k, d, nw = (b + c - 1) / c, nb = ((size_t)1 << c);
+	int run_used, sum_used;
+	char *used;
+	mpz_t *bucket, run, sum;
+	
+	bucket = (mpz_t*)malloc(nb * sizeof(mpz_t));
+	used = (char*)malloc(nb);
+	for (d = 1; d < nb; d++)
+		mpz_init(bucket[d]);
+	mpz_init(run), mpz_init(sum);
+	
+	mpz_set_ui(res, 1L);
+	for (k = nw; k > 0; k--)
+	{
+		if (k < nw)
+		{
+			for (j = 0; j < c; j++)
+			{
+				mpz_mul(res, res, res);
+				mpz_mod(res, res, p);
+			}
+		}
+		/* sort the bases into buckets by their current exponent digit */
+		memset(used, 0, nb);
+		for (i = 0; i < n; i++)
+		{
+			d = mpz_mpowm_digit(xx[i], (k - 1) * c, c);
+			if (d)
+			{
+				if (used[d])
+				{
+					mpz_mul(bucket[d], bucket[d], mm[i]);
+					mpz_mod(bucket[d], bucket[d], p);
+				}
+				else
+					mpz_set(bucket[d], mm[i]), used[d] = 1;
+			}
+		}
+		/* sum = \prod_d bucket[d]^d by running products (empty buckets are 1) */
+		run_used = 0, sum_used = 0;
+		for (d = nb - 1; d > 0; d--)
+		{
+			if (used[d])
+			{
+				if (run_used)
+				{
+					mpz_mul(run, run, bucket[d]);
+					mpz_mod(run, run, p);
+				}
+				else
+					mpz_set(run, bucket[d]), run_used = 1;
+			}
+			if (run_used)
+			{
+				if (sum_used)
+				{
+					mpz_mul(sum, sum, run);
+					mpz_mod(sum, sum, p);
+				}
+				else
+					mpz_set(sum, run), sum_used = 1;
+			}
+		}
+		if (sum_used)
+		{
+			mpz_mul(res, res, sum);
+			mpz_mod(res, res, p);
+		}
+	}
+	
+	for (d = 1; d < nb; d++)
+		mpz_clear(bucket[d]);
+	mpz_clear(run), mpz_clear(sum);
+	free(bucket), free(used);
+}
+
+void mpz_mpowm
+	(mpz_ptr res, mpz_srcptr m[], mpz_srcptr x[], const size_t n,
+	mpz_srcptr p)
+{
+	size_t i, w, c, b = 0, best_w = 1, best_c = 1;
+	size_t cost, cost_straus = 0, cost_pippenger = 0;
+	int ok = 1;
+	mpz_t *mm, *xx, acc;
+	
+	if (n == 0)
+	{
+		mpz_set_ui(res, 1L);
+		return;
+	}
+	
+	/* res may alias an element of m[] or x[], thus all inputs are copied
+	   before and the result is accumulated in acc */
+	mpz_init_set_ui(acc, 1L);
+	
+	/* make all exponents non-negative by inverting the bases */
+	mm = (mpz_t*)malloc(n * sizeof(mpz_t));
+	xx = (mpz_t*)malloc(n * sizeof(mpz_t));
+	for (i = 0; i < n; i++)
+	{
+		mpz_init(mm[i]), mpz_init_set(xx[i], x[i]);
+		mpz_mod(mm[i], m[i], p);
+		if (mpz_sgn(xx[i]) == -1)
+		{
+			mpz_neg(xx[i], xx[i]);
+			if (!mpz_invert(mm[i], mm[i], p))
+				ok = 0;
+		}
+		if ((mpz_sgn(xx[i]) != 0) && (mpz_sizeinbase(xx[i], 2L) > b))
+			b = mpz_sizeinbase(xx[i], 2L);
+	}
+	
+	if (!ok)
+		mpz_set_ui(acc, 0L); /* indicates an error */
+	else if ((b > 0) && (n == 1))
+		mpz_powm(acc, mm[0], xx[0], p);
+	else if (b > 0)
+	{
+		/* estimate the number of modular multiplications of both methods */
+		for (w = 1; w <= 6; w++)
+		{
+			cost = (n * ((((size_t)1 << w) - 2) + ((b + w - 1) / w))) + b;
+			if ((w == 1) || (cost < cost_straus))
+				cost_straus = cost, best_w = w;
+		}
+		for (c = 1; c <= 16; c++)
+		{
+			cost = (((b + c - 1) / c) * (n + ((size_t)2 << c))) + b;
+			if ((c == 1) || (cost < cost_pippenger))
+				cost_pippenger = cost, best_c = c;
+		}
+		if (cost_straus <= cost_pippenger)
+			mpz_mpowm_straus(acc, mm, xx, n, p, b, best_w);
+		else
+			mpz_mpowm_pippenger(acc, mm, xx, n, p, b, best_c);
+	}
+	else
+		mpz_mod(acc, acc, p);
+	
+	for (i = 0; i < n; i++)
+		mpz_clear(mm[i]), mpz_clear(xx[i]);
+	free(mm), free(xx);
+	mpz_set(res, acc);
+	mpz_clear(acc);
+}
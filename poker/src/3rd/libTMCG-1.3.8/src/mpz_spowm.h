@@ -29,13 +29,38 @@
 	
 	#include "mpz_srandom.h"
 	
+	#ifndef TMCG_FPOWM_COMB_W
+		/* Define the number of teeth of the fixed-base comb tables */
+		#define TMCG_FPOWM_COMB_W 8
+	#endif
+	
 	#if defined (__cplusplus)
 		extern "C"
 		{
 	#endif
 			/* Kocher's efficient blinding technique for modular exponentiation [Ko96] 
                            -- cf. scientific discussion e.g. https://eprint.iacr.org/2013/447 
-			   https://eprint.iacr.org/2014/869 and https://eprint.iacr.org/2016/597 */
+			   https://eprint.iacr.org/2014/869 and https://eprint.iacr.org/2016/597
+			   The blinding state for the fixed exponent x is owned by the caller,
+			   thus different contexts can be used concurrently. Only the base is
+			   blinded and the running time still depends on x, thus mpz_spowm()
+			   has to be used for secret exponents such as private keys. */
+			typedef struct
+			{
+				mpz_t bvi, bvf, bx, bp;
+			} mpz_spowm_ctx_struct;
+			typedef mpz_spowm_ctx_struct mpz_spowm_ctx[1];
+			
+			void mpz_spowm_ctx_init
+				(mpz_spowm_ctx ctx, mpz_srcptr x, mpz_srcptr p);
+			
+			void mpz_spowm_ctx_calc
+				(mpz_spowm_ctx ctx, mpz_ptr res, mpz_srcptr m);
+			
+			void mpz_spowm_ctx_clear
+				(mpz_spowm_ctx ctx);
+			
+			/* The same with a single static context (not reentrant) */
 			void mpz_spowm_init
 				(mpz_srcptr x, mpz_srcptr p);
 			
@@ -56,7 +81,8 @@
 			void mpz_spowm
 				(mpz_ptr res, mpz_srcptr m, mpz_srcptr x, mpz_srcptr p);
 			
-			/* Fast modular exponentiation using precomputed tables */
+			/* Fast modular exponentiation using precomputed tables
+			   (fixed-base comb method of Lim and Lee [LL94]) */
 			void mpz_fpowm_init
 				(mpz_t fpowm_table[]);
 			
@@ -76,9 +102,26 @@
 				(mpz_t fpowm_table[],
 				mpz_ptr res, mpz_srcptr m, mpz_srcptr x, mpz_srcptr p);
 			
+			/* Simultaneous exponentiation res = \prod_i m_i^{x_i} mod p for
+			   fixed bases m_i, whose tables share all squarings */
+			void mpz_fpowm_multi
+				(mpz_t *fpowm_tables[],
+				mpz_ptr res, mpz_srcptr x[], const size_t n, mpz_srcptr p);
+			
 			void mpz_fpowm_done
 				(mpz_t fpowm_table[]);
 			
+			/* Simultaneous multi-exponentiation res = \prod_i m[i]^x[i] mod p,
+			   by Straus' interleaved window method for few bases and by
+			   Pippenger's bucket method for many bases. The running time
+			   depends on the exponents, thus use it only with public
+			   exponents or blind them before. Negative exponents are
+			   handled by inverting the corresponding base. The result res
+			   may alias any of the bases or exponents. */
+			void mpz_mpowm
+				(mpz_ptr res, mpz_srcptr m[], mpz_srcptr x[], const size_t n,
+				mpz_srcptr p);
+			
 	#if defined(__cplusplus)
 		}
 	#endif
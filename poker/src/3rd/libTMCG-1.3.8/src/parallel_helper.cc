@@ -0,0 +1,80 @@
+/*******************************************************************************
+   This file is part of LibTMCG.
+
+   LibTMCG is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   LibTMCG is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LibTMCG; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+*******************************************************************************/
+
+// include headers
+#ifdef HAVE_CONFIG_H
+	#include "libTMCG_config.h"
+#endif
+#include "parallel_helper.hh"
+
+#include <vector>
+#include <pthread.h>
+
+// the calls with $i \equiv t \pmod{workers}$ are done by the $t$-th worker
+struct TMCG_ParallelHelper_stripe
+{
+	size_t t, workers, n;
+	void (*fn)(size_t, void*);
+	void *arg;
+};
+
+static void *TMCG_ParallelHelper_thread
+	(void *p)
+{
+	TMCG_ParallelHelper_stripe *s = (TMCG_ParallelHelper_stripe*)p;
+	for (size_t i = s->t; i < s->n; i += s->workers)
+		s->fn(i, s->arg);
+	return NULL;
+}
+
+void TMCG_ParallelHelper::run
+	(size_t workers, size_t n,
+	void (*fn)(size_t i, void *arg), void *arg)
+{
+	if (workers > TMCG_MAX_WORKERS)
+		workers = TMCG_MAX_WORKERS;
+	if (workers > n)
+		workers = n;
+	if (workers <= 1)
+	{
+		for (size_t i = 0; i < n; i++)
+			fn(i, arg);
+		return;
+	}
+	
+	std::vector<TMCG_ParallelHelper_stripe> stripes(workers);
+	std::vector<pthread_t> threads(workers);
+	std::vector<bool> started(workers, false);
+	for (size_t t = 0; t < workers; t++)
+	{
+		stripes[t].t = t, stripes[t].workers = workers, stripes[t].n = n;
+		stripes[t].fn = fn, stripes[t].arg = arg;
+	}
+	for (size_t t = 1; t < workers; t++)
+		started[t] = !pthread_create(&threads[t], NULL,
+			TMCG_ParallelHelper_thread, &stripes[t]);
+	// the calling thread does the first stripe and those of failed threads
+	TMCG_ParallelHelper_thread(&stripes[0]);
+	for (size_t t = 1; t < workers; t++)
+	{
+		if (started[t])
+			pthread_join(threads[t], NULL);
+		else
+			TMCG_ParallelHelper_thread(&stripes[t]);
+	}
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+   This file is part of LibTMCG.
+
+   LibTMCG is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   LibTMCG is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LibTMCG; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+*******************************************************************************/
+
+#ifndef INCLUDED_parallel_helper_HH
+	#define INCLUDED_parallel_helper_HH
+	
+	#include <cstddef>
+	
+	#ifndef TMCG_MAX_WORKERS
+		/* Define the maximum number of threads for the parallel mode */
+		#define TMCG_MAX_WORKERS 64
+	#endif
+	
+	namespace TMCG_ParallelHelper
+	{
+		// Call fn(i, arg) for all $0 \le i < n$ distributed over at most
+		// workers threads, where the calling thread is one of them. The
+		// calls must be independent, i.e., each call writes only its own
+		// results. Secret exponentiations inside fn must use reentrant
+		// functions (mpz_spowm, mpz_fspowm, or an own mpz_spowm_ctx) and
+		// never the static context of mpz_spowm_init(). With at most one
+		// worker all calls are done in order by the calling thread.
+		void run
+			(size_t workers, size_t n,
+			void (*fn)(size_t i, void *arg), void *arg);
+	}
+#endif
@@ -62,3 +62,69 @@ bool TMCG_ParseHelper::gs
 		return false;
 	return true;
 }
+
+// index of the stream format flag in std::ios_base::iword()
+static const int binary_index = std::ios_base::xalloc();
+
+void TMCG_ParseHelper::set_binary
+	(std::ios_base &s, bool binary)
+{
+	s.iword(binary_index) = binary ? 1L : 0L;
+}
+
+bool TMCG_ParseHelper::is_binary
+	(std::ios_base &s)
+{
+	return (s.iword(binary_index) != 0L);
+}
+
+void TMCG_ParseHelper::put_size
+	(std::ostream &out, size_t size)
+{
+	// four bytes in big-endian order; sizes are far below $2^{24}$ here,
+	// thus the first byte is always zero and never taken for a newline
+	char buf[4];
+	for (size_t i = 0; i < 4; i++)
+		buf[i] = (char)((size >> (8 * (3 - i))) & 0xFF);
+	out.write(buf, 4);
+}
+
+bool TMCG_ParseHelper::get_size
+	(std::istream &in, size_t &size)
+{
+	unsigned char buf[4];
+	if (!in.read((char*)buf, 4))
+		return false;
+	size = 0;
+	for (size_t i = 0; i < 4; i++)
+		size = (size << 8) | buf[i];
+	return true;
+}
+
+void TMCG_ParseHelper::put_blob
+	(std::ostream &out, const std::string &blob)
+{
+	put_size(out, blob.length());
+	out.write(blob.data(), blob.length());
+}
+
+bool TMCG_ParseHelper::get_blob
+	(std::istream &in, std::string &blob, size_t max)
+{
+	size_t size = 0;
+	if (!get_size(in, size) || (size > max))
+		return false;
+	blob.resize(size);
+	if (size && !in.read(&blob[0], size))
+		return false;
+	return true;
+}
+
+void TMCG_ParseHelper::skip_newline
+	(std::istream &in)
+{
+	// the text format delimits values by newlines, which are consumed by
+	// getline(); binary values may be followed by such a delimiter, too
+	if (in.peek() == '\n')
+		in.ignore(1);
+}
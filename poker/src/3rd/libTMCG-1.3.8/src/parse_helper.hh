@@ -22,6 +22,7 @@
 	#define INCLUDED_parse_helper_HH
 	
 	#include <string>
+	#include <iostream>
 	
 	namespace TMCG_ParseHelper
 	{
@@ -32,5 +33,22 @@
 			(std::string &s, char p);
 		bool gs
 			(const std::string &s, char p, std::string &out);
+		
+		// compact binary format (selected per stream, length-prefixed
+		// and big-endian) as an alternative to the text format above
+		void set_binary
+			(std::ios_base &s, bool binary = true);
+		bool is_binary
+			(std::ios_base &s);
+		void put_size
+			(std::ostream &out, size_t size);
+		bool get_size
+			(std::istream &in, size_t &size);
+		void put_blob
+			(std::ostream &out, const std::string &blob);
+		bool get_blob
+			(std::istream &in, std::string &blob, size_t max);
+		void skip_newline
+			(std::istream &in);
 	}
 #endif
@@ -0,0 +1,172 @@
+/*******************************************************************************
+   This file is part of LibTMCG.
+
+   LibTMCG is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   LibTMCG is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LibTMCG; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+*******************************************************************************/
+
+// include headers
+#ifdef HAVE_CONFIG_H
+	#include "libTMCG_config.h"
+#endif
+#include <libTMCG.hh>
+
+#include <sstream>
+#include <vector>
+#include <cassert>
+
+#include "test_helper.h"
+
+#undef NDEBUG
+#define DECKSIZE 52
+
+int main
+	(int argc, char **argv)
+{
+	assert(init_libTMCG());
+
+	SchindelhauerTMCG *tmcg = new SchindelhauerTMCG(64, 1, 6);
+	BarnettSmartVTMF_dlog *vtmf;
+	GrothVSSHE *vsshe;
+	TMCG_OpenStack<VTMF_Card> os;
+	TMCG_Stack<VTMF_Card> s, s2;
+	TMCG_StackSecret<VTMF_CardSecret> ss, ss2;
+
+	// create the group and a single key
+	std::cout << "BarnettSmartVTMF_dlog()" << std::endl;
+	vtmf = new BarnettSmartVTMF_dlog();
+	assert(vtmf->CheckGroup());
+	vtmf->KeyGenerationProtocol_GenerateKey();
+	vtmf->KeyGenerationProtocol_Finalize();
+
+	// create the deck and shuffle it
+	for (size_t type = 0; type < DECKSIZE; type++)
+	{
+		VTMF_Card c;
+		tmcg->TMCG_CreateOpenCard(c, vtmf, type);
+		os.push(type, c);
+	}
+	s.push(os);
+	tmcg->TMCG_CreateStackSecret(ss, false, s.size(), vtmf);
+	tmcg->TMCG_MixStack(s, s2, ss, vtmf);
+	tmcg->TMCG_CreateStackSecret(ss2, false, s.size(), vtmf);
+
+	// Groth's shuffle argument as reference
+	std::cout << "GrothVSSHE(" << DECKSIZE << ", ...)" << std::endl;
+	vsshe = new GrothVSSHE(DECKSIZE, vtmf->p, vtmf->q, vtmf->k, vtmf->g,
+		vtmf->h);
+	assert(vsshe->CheckGroup());
+	{
+		std::stringstream proof, wrong;
+		std::cout << "TMCG_ProveStackEquality_Groth_noninteractive()" << std::endl;
+		start_clock();
+		tmcg->TMCG_ProveStackEquality_Groth_noninteractive(s, s2, ss, vtmf,
+			vsshe, proof);
+		stop_clock();
+		std::cout << elapsed_time() << " " << proof.str().length() <<
+			" bytes" << std::endl;
+		std::cout << "TMCG_VerifyStackEquality_Groth_noninteractive()" << std::endl;
+		start_clock();
+		assert(tmcg->TMCG_VerifyStackEquality_Groth_noninteractive(s, s2,
+			vtmf, vsshe, proof));
+		stop_clock();
+		std::cout << elapsed_time() << std::endl;
+		tmcg->TMCG_ProveStackEquality_Groth_noninteractive(s, s2, ss2, vtmf,
+			vsshe, wrong);
+		assert(!tmcg->TMCG_VerifyStackEquality_Groth_noninteractive(s, s2,
+			vtmf, vsshe, wrong));
+		// the randomizers of the proof precomputed like the masks
+		std::stringstream proof2;
+		std::vector<mpz_ptr> rand;
+		std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+		for (size_t i = 0; i < TMCG_GROTH_PRECOMPUTED; i++)
+		{
+			mpz_ptr r = new mpz_t(), g_r = new mpz_t(), h_r = new mpz_t();
+			mpz_init(r), mpz_init(g_r), mpz_init(h_r);
+			vtmf->VerifiableRemaskingProtocol_Precompute(r, g_r, h_r);
+			rand.push_back(r);
+			masks.push_back(std::pair<mpz_ptr, mpz_ptr>(g_r, h_r));
+		}
+		std::cout << "TMCG_ProveStackEquality_Groth_noninteractive(..., rand, " <<
+			"masks, ...)" << std::endl;
+		start_clock();
+		tmcg->TMCG_ProveStackEquality_Groth_noninteractive(s, s2, ss, rand,
+			masks, vtmf, vsshe, proof2);
+		stop_clock();
+		std::cout << elapsed_time() << std::endl;
+		assert(tmcg->TMCG_VerifyStackEquality_Groth_noninteractive(s, s2,
+			vtmf, vsshe, proof2));
+		for (size_t i = 0; i < rand.size(); i++)
+		{
+			mpz_clear(rand[i]), mpz_clear(masks[i].first),
+				mpz_clear(masks[i].second);
+			delete [] rand[i], delete [] masks[i].first,
+				delete [] masks[i].second;
+		}
+	}
+	delete vsshe;
+
+	// Bayer-Groth with different number of columns
+	size_t columns[] = { 1, 2, 4, 0 };
+	for (size_t l = 0; l < (sizeof(columns) / sizeof(size_t)); l++)
+	{
+		BayerGrothVSSHE *bg, *bg2;
+		std::stringstream lej, proof, wrong;
+
+		std::cout << "BayerGrothVSSHE(" << DECKSIZE << ", ..., " << columns[l] <<
+			")" << std::endl;
+		bg = new BayerGrothVSSHE(DECKSIZE, vtmf->p, vtmf->q, vtmf->k, vtmf->g,
+			vtmf->h, columns[l]);
+		assert(bg->CheckGroup());
+		std::cout << "m = " << bg->m << ", n = " << bg->n << std::endl;
+		// create a clone instance
+		bg->PublishGroup(lej);
+		bg2 = new BayerGrothVSSHE(DECKSIZE, lej);
+		assert(bg2->CheckGroup());
+		assert((bg2->m == bg->m) && (bg2->n == bg->n));
+
+		std::cout << "TMCG_ProveStackEquality_BayerGroth_noninteractive()" <<
+			std::endl;
+		start_clock();
+		tmcg->TMCG_ProveStackEquality_BayerGroth_noninteractive(s, s2, ss, vtmf,
+			bg, proof);
+		stop_clock();
+		std::cout << elapsed_time() << " " << proof.str().length() <<
+			" bytes" << std::endl;
+		std::cout << "TMCG_VerifyStackEquality_BayerGroth_noninteractive()" <<
+			std::endl;
+		start_clock();
+		assert(tmcg->TMCG_VerifyStackEquality_BayerGroth_noninteractive(s, s2,
+			vtmf, bg2, proof));
+		stop_clock();
+		std::cout << elapsed_time() << std::endl;
+		// a wrong permutation must be rejected
+		std::cout << "!TMCG_VerifyStackEquality_BayerGroth_noninteractive()" <<
+			std::endl;
+		tmcg->TMCG_ProveStackEquality_BayerGroth_noninteractive(s, s2, ss2, vtmf,
+			bg, wrong);
+		assert(!tmcg->TMCG_VerifyStackEquality_BayerGroth_noninteractive(s, s2,
+			vtmf, bg2, wrong));
+		// a different stack must be rejected
+		proof.clear(), proof.seekg(0);
+		assert(!tmcg->TMCG_VerifyStackEquality_BayerGroth_noninteractive(s2, s,
+			vtmf, bg2, proof));
+
+		delete bg, delete bg2;
+	}
+
+	delete vtmf, delete tmcg;
+
+	return 0;
+}
@@ -401,6 +401,29 @@ yTIVNwGjZ3pM73jsUA2RxCMfjHntG81euIBZgn8evIJRNvimC8aRh7ITAuU3soQSdQiIld2d\
 		}
 		mpz_spowm_clear();
 	}
+	std::cout << "mpz_spowm_ctx_init(), mpz_spowm_ctx_calc(), " <<
+		"mpz_spowm_ctx_clear()" << std::endl;
+	for (size_t i = 0; i < 50; i++)
+	{
+		mpz_spowm_ctx ctx1, ctx2;
+		mpz_t foo3, bar3;
+		mpz_init(foo3), mpz_init(bar3);
+		mpz_srandomm(bar2, foo), mpz_srandomm(foo2, foo);
+		mpz_spowm_ctx_init(ctx1, bar2, foo), mpz_spowm_ctx_init(ctx2, foo2, foo);
+		for (size_t j = 0; j < 50; j++)
+		{
+			// interleave both contexts
+			mpz_srandomm(bar, foo);
+			mpz_spowm_ctx_calc(ctx1, foo3, bar);
+			mpz_powm(bar3, bar, bar2, foo);
+			assert(!mpz_cmp(foo3, bar3));
+			mpz_spowm_ctx_calc(ctx2, foo3, bar);
+			mpz_powm(bar3, bar, foo2, foo);
+			assert(!mpz_cmp(foo3, bar3));
+		}
+		mpz_spowm_ctx_clear(ctx1), mpz_spowm_ctx_clear(ctx2);
+		mpz_clear(foo3), mpz_clear(bar3);
+	}
 	
 	// mpz_fpowm_init, mpz_fpowm_precompute, mpz_f(s)powm, mpz_fpowm_done
 	std::cout << "mpz_fpowm_init()" << std::endl;
@@ -437,6 +460,17 @@ yTIVNwGjZ3pM73jsUA2RxCMfjHntG81euIBZgn8evIJRNvimC8aRh7ITAuU3soQSdQiIld2d\
 		mpz_fspowm(fpowm_table_2, root, bar2, foo2, foo);
 		assert(!mpz_cmp(t1, t2) && !mpz_cmp(t1, root));
 	}
+	for (size_t i = 0; i < 1024; i += 67)
+	{
+		// test sparse exponents, whose comb digits are mostly zero
+		mpz_set_ui(foo2, 0L);
+		if (i > 0)
+			mpz_setbit(foo2, i);
+		mpz_powm(t1, bar2, foo2, foo);
+		mpz_fpowm(fpowm_table_2, t2, bar2, foo2, foo);
+		mpz_fspowm(fpowm_table_2, root, bar2, foo2, foo);
+		assert(!mpz_cmp(t1, t2) && !mpz_cmp(t1, root));
+	}
 	std::cout << "mpz_fpowm_done()" << std::endl;
 	mpz_fpowm_done(fpowm_table_1), mpz_fpowm_done(fpowm_table_2);
 
@@ -495,6 +529,109 @@ yTIVNwGjZ3pM73jsUA2RxCMfjHntG81euIBZgn8evIJRNvimC8aRh7ITAuU3soQSdQiIld2d\
 	// check whether fspowm() is slower than fpowm() for at least 2/3 of runs
 	assert(bad_cnt < 10);
 	
+	// mpz_mpowm against the product of mpz_powm; with 160-bit exponents the
+	// cost estimate chooses Straus' method up to some dozen bases and
+	// Pippenger's method for the 512 bases
+	std::cout << "mpz_mpowm()" << std::endl;
+	size_t mpowm_n[] = { 1, 2, 3, 16, 64, 512 };
+	for (size_t l = 0; l < (sizeof(mpowm_n) / sizeof(size_t)); l++)
+	{
+		size_t n = mpowm_n[l];
+		std::vector<mpz_ptr> m, x;
+		for (size_t i = 0; i < n; i++)
+		{
+			mpz_ptr tmp = new mpz_t(), tmp2 = new mpz_t();
+			mpz_init(tmp), mpz_init(tmp2);
+			m.push_back(tmp), x.push_back(tmp2);
+		}
+		for (size_t j = 0; j < 10; j++)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				do
+					mpz_srandomm(m[i], foo);
+				while (!mpz_cmp_ui(m[i], 0L));
+				mpz_srandomb(x[i], 160);
+				if ((j % 3) == 1)
+					mpz_neg(x[i], x[i]); // negative exponents
+				else if (((j % 3) == 2) && (i % 2))
+					mpz_set_ui(x[i], 0L); // zero exponents
+			}
+			mpz_set_ui(t1, 1L);
+			for (size_t i = 0; i < n; i++)
+			{
+				mpz_powm(t2, m[i], x[i], foo);
+				mpz_mul(t1, t1, t2);
+				mpz_mod(t1, t1, foo);
+			}
+			mpz_mpowm(t2, (mpz_srcptr*)&m[0], (mpz_srcptr*)&x[0], n, foo);
+			assert(!mpz_cmp(t1, t2));
+			// the result may alias a base or an exponent
+			mpz_set(root, m[0]);
+			mpz_mpowm(m[0], (mpz_srcptr*)&m[0], (mpz_srcptr*)&x[0], n, foo);
+			assert(!mpz_cmp(t1, m[0]));
+			mpz_set(m[0], root), mpz_set(root, x[n - 1]);
+			mpz_mpowm(x[n - 1], (mpz_srcptr*)&m[0], (mpz_srcptr*)&x[0], n, foo);
+			assert(!mpz_cmp(t1, x[n - 1]));
+			mpz_set(x[n - 1], root);
+		}
+		// all exponents zero
+		for (size_t i = 0; i < n; i++)
+			mpz_set_ui(x[i], 0L);
+		mpz_mpowm(t2, (mpz_srcptr*)&m[0], (mpz_srcptr*)&x[0], n, foo);
+		assert(!mpz_cmp_ui(t2, 1L));
+		for (size_t i = 0; i < n; i++)
+		{
+			mpz_clear(m[i]), mpz_clear(x[i]);
+			delete [] m[i], delete [] x[i];
+		}
+	}
+	mpz_mpowm(t2, NULL, NULL, 0, foo);
+	assert(!mpz_cmp_ui(t2, 1L));
+	
+	// mpz_mpowm vs. product of mpz_powm benchmark
+	for (size_t l = 3; l < (sizeof(mpowm_n) / sizeof(size_t)); l++)
+	{
+		size_t n = mpowm_n[l];
+		std::vector<mpz_ptr> m, x;
+		for (size_t i = 0; i < n; i++)
+		{
+			mpz_ptr tmp = new mpz_t(), tmp2 = new mpz_t();
+			mpz_init(tmp), mpz_init(tmp2);
+			mpz_srandomm(tmp, foo), mpz_srandomb(tmp2, 160);
+			m.push_back(tmp), x.push_back(tmp2);
+		}
+		std::cout << "mpz_powm() vs. mpz_mpowm() benchmark (" << n <<
+			" bases)" << std::endl;
+		start_clock();
+		for (size_t j = 0; j < 10; j++)
+		{
+			mpz_set_ui(t1, 1L);
+			for (size_t i = 0; i < n; i++)
+			{
+				mpz_powm(t2, m[i], x[i], foo);
+				mpz_mul(t1, t1, t2);
+				mpz_mod(t1, t1, foo);
+			}
+		}
+		stop_clock();
+		save_clock();
+		std::cout << elapsed_time() << " vs. ";
+		start_clock();
+		for (size_t j = 0; j < 10; j++)
+			mpz_mpowm(t2, (mpz_srcptr*)&m[0], (mpz_srcptr*)&x[0], n, foo);
+		stop_clock();
+		std::cout << elapsed_time() << std::endl;
+		assert(!mpz_cmp(t1, t2));
+		// check whether mpz_mpowm() is faster
+		assert((compare_elapsed_time_saved(0) > 0));
+		for (size_t i = 0; i < n; i++)
+		{
+			mpz_clear(m[i]), mpz_clear(x[i]);
+			delete [] m[i], delete [] x[i];
+		}
+	}
+	
 	// h, g, mpz_shash
 	size_t dlen = gcry_md_get_algo_dlen(TMCG_GCRY_MD_ALGO);
 	unsigned char tmp_ar1[1024], tmp_ar2[1024];
@@ -563,6 +700,33 @@ yTIVNwGjZ3pM73jsUA2RxCMfjHntG81euIBZgn8evIJRNvimC8aRh7ITAuU3soQSdQiIld2d\
 	gcry_mpi_release(a);
 	assert(!mpz_cmp(foo, bar));
 	
+	// operator <<, operator >> (text and binary format)
+	std::cout << "operator <<, operator >>" << std::endl;
+	for (size_t i = 0; i < 100; i++)
+	{
+		std::stringstream text, binary;
+		TMCG_ParseHelper::set_binary(binary);
+		mpz_wrandomb(foo, 2048L);
+		mpz_set_ui(foo2, i);
+		mpz_neg(root, foo);
+		text << foo << std::endl << foo2 << std::endl << root << std::endl;
+		binary << foo << std::endl << foo2 << root;
+		mpz_set_ui(bar, 0L), mpz_set_ui(bar2, 0L), mpz_set_ui(t1, 0L);
+		text >> bar >> bar2 >> t1;
+		assert(text.good());
+		assert(!mpz_cmp(bar, foo) && !mpz_cmp(bar2, foo2) && !mpz_cmp(t1, root));
+		mpz_set_ui(bar, 0L), mpz_set_ui(bar2, 0L), mpz_set_ui(t1, 0L);
+		binary >> bar >> bar2 >> t1;
+		assert(!binary.fail());
+		assert(!mpz_cmp(bar, foo) && !mpz_cmp(bar2, foo2) && !mpz_cmp(t1, root));
+		assert(binary.str().length() < text.str().length());
+		// truncated input
+		std::stringstream truncated(binary.str().substr(0, 100));
+		TMCG_ParseHelper::set_binary(truncated);
+		truncated >> bar >> bar2;
+		assert(truncated.fail());
+	}
+	
 	mpz_clear(foo), mpz_clear(bar), mpz_clear(foo2), mpz_clear(bar2),
 		mpz_clear(root), mpz_clear(t1), mpz_clear(t2);
 	
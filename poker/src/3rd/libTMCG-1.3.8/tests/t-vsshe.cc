@@ -166,6 +166,10 @@ int main
 	std::cout << "*.CommitBy(...)" << std::endl;
 	com->CommitBy(aa, b, mp);
 	assert(!mpz_cmp(a, aa));
+	std::cout << "*.CommitBy_precomputed(...)" << std::endl;
+	mpz_powm(bb, com->h, b, com->p);
+	com->CommitBy_precomputed(aa, bb, mp);
+	assert(!mpz_cmp(a, aa));
 	
 	// TestMembership
 	std::cout << "*.TestMembership(...)" << std::endl;
@@ -421,6 +425,50 @@ int main
 			std::cout << "NSHVZKA(" << NSHVZKA.size() << " bytes)" << std::endl;
 			assert(vsshe->Verify_noninteractive(e, E, lej3));
 			
+			// the parallel prover must compute a valid proof
+			std::stringstream lej4, lej5;
+			std::cout << "P: vsshe.SetWorkers(4)" << std::endl;
+			vsshe->SetWorkers(4);
+			start_clock();
+			vsshe->Prove_noninteractive(pi, R, e, E, lej4);
+			stop_clock();
+			std::cout << "P: " << elapsed_time() << std::endl;
+			assert(vsshe->Verify_noninteractive(e, E, lej4));
+			vsshe->Prove_noninteractive(xi, R, e, E, lej5);
+			assert(!vsshe->Verify_noninteractive(e, E, lej5));
+			vsshe->SetWorkers(1);
+			
+			// the prover with precomputed randomizers must compute a valid proof
+			std::stringstream lej6, lej7;
+			std::vector<mpz_ptr> rand;
+			std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+			for (size_t i = 0; i < TMCG_GROTH_PRECOMPUTED; i++)
+			{
+				mpz_ptr tmp = new mpz_t(), g_r = new mpz_t(), h_r = new mpz_t();
+				mpz_init(tmp), mpz_init(g_r), mpz_init(h_r);
+				mpz_srandomm(tmp, vsshe->q);
+				mpz_powm(g_r, vsshe->g, tmp, vsshe->p);
+				mpz_powm(h_r, vsshe->h, tmp, vsshe->p);
+				rand.push_back(tmp);
+				masks.push_back(std::pair<mpz_ptr, mpz_ptr>(g_r, h_r));
+			}
+			std::cout << "P: vsshe.Prove_noninteractive(..., rand, masks, ...)" <<
+				std::endl;
+			start_clock();
+			vsshe->Prove_noninteractive(pi, R, e, E, rand, masks, lej6);
+			stop_clock();
+			std::cout << "P: " << elapsed_time() << std::endl;
+			assert(vsshe->Verify_noninteractive(e, E, lej6));
+			vsshe->Prove_noninteractive(xi, R, e, E, rand, masks, lej7);
+			assert(!vsshe->Verify_noninteractive(e, E, lej7));
+			for (size_t i = 0; i < rand.size(); i++)
+			{
+				mpz_clear(rand[i]), mpz_clear(masks[i].first),
+					mpz_clear(masks[i].second);
+				delete [] rand[i], delete [] masks[i].first,
+					delete [] masks[i].second;
+			}
+			
 			// release
 			for (size_t i = 0; i < n; i++)
 			{
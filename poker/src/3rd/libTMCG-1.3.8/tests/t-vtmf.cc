@@ -222,6 +222,52 @@ void check
 			tmcg->TMCG_MixStack(sA, sAB, ssA, vtmf);
 			*pipe_out << sAB << std::endl;
 			
+			std::cout << "A: binary format of stacks and stack secrets" << std::endl;
+			std::stringstream lej;
+			TMCG_Stack<VTMF_Card> sAB2;
+			TMCG_StackSecret<VTMF_CardSecret> ssA2;
+			TMCG_ParseHelper::set_binary(lej);
+			lej << sAB << std::endl << ssA << std::endl;
+			lej >> sAB2 >> ssA2;
+			assert(!lej.fail());
+			assert(sAB2 == sAB);
+			assert(ssA2.size() == ssA.size());
+			for (size_t i = 0; i < ssA.size(); i++)
+			{
+				assert(ssA2[i].first == ssA[i].first);
+				assert(!mpz_cmp(ssA2[i].second.r, ssA[i].second.r));
+			}
+			
+			std::cout << "A: TMCG_SetWorkers(4), MixStack()" << std::endl;
+			TMCG_Stack<VTMF_Card> sAB3;
+			tmcg->TMCG_SetWorkers(4);
+			tmcg->TMCG_MixStack(sA, sAB3, ssA, vtmf);
+			tmcg->TMCG_SetWorkers(1);
+			assert(sAB3 == sAB);
+			
+			std::cout << "A: VerifiableRemaskingProtocol_Precompute(), MixStack()" <<
+				std::endl;
+			TMCG_StackSecret<VTMF_CardSecret> ssA3;
+			TMCG_Stack<VTMF_Card> sAB4, sAB5;
+			std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+			tmcg->TMCG_CreateStackSecret(ssA3, false, sA.size(), vtmf);
+			for (size_t i = 0; i < ssA3.size(); i++)
+			{
+				mpz_ptr g_r = new mpz_t(), h_r = new mpz_t();
+				mpz_init(g_r), mpz_init(h_r);
+				vtmf->VerifiableRemaskingProtocol_Precompute(ssA3[i].second.r,
+					g_r, h_r);
+				masks.push_back(std::pair<mpz_ptr, mpz_ptr>(g_r, h_r));
+			}
+			tmcg->TMCG_MixStack(sA, sAB4, ssA3, masks, vtmf);
+			tmcg->TMCG_MixStack(sA, sAB5, ssA3, vtmf);
+			assert(sAB4 == sAB5);
+			for (size_t i = 0; i < masks.size(); i++)
+			{
+				mpz_clear(masks[i].first), mpz_clear(masks[i].second);
+				delete [] masks[i].first, delete [] masks[i].second;
+			}
+			
 			std::cout << "A: ProveStackEquality()" << std::endl;
 			tmcg->TMCG_ProveStackEquality(sA, sAB, ssA, false, vtmf,
 				*pipe_in, *pipe_out);
@@ -265,6 +311,147 @@ void check
 	mpz_clear(a), mpz_clear(b), mpz_clear(c), mpz_clear(d), mpz_clear(e);
 }
 
+void check_batch
+	(BarnettSmartVTMF_dlog *vtmf)
+{
+	std::stringstream lej, key, key2, key3;
+	std::vector<mpz_ptr> cards;
+	std::vector<mpz_srcptr> c_1;
+	std::vector<std::string> proofs;
+	mpz_t x, y, fp, c, r, t, d, a, b;
+	
+	mpz_init(x), mpz_init(y), mpz_init(fp), mpz_init(c), mpz_init(r),
+		mpz_init(t), mpz_init(d), mpz_init(a), mpz_init(b);
+	// three players: A verifies the decryption shares of B and of a
+	// cheating player C, whose private key $x$ is known here
+	vtmf->PublishGroup(lej);
+	BarnettSmartVTMF_dlog *A = new BarnettSmartVTMF_dlog(lej);
+	lej.clear(), lej.seekg(0);
+	BarnettSmartVTMF_dlog *B = new BarnettSmartVTMF_dlog(lej);
+	A->KeyGenerationProtocol_GenerateKey();
+	B->KeyGenerationProtocol_GenerateKey();
+	A->KeyGenerationProtocol_PublishKey(key);
+	B->KeyGenerationProtocol_PublishKey(key2);
+	mpz_srandomm(x, A->q);
+	mpz_powm(y, A->g, x, A->p);
+	mpz_srandomm(r, A->q);
+	mpz_powm(t, A->g, r, A->p);
+	mpz_shash(c, 5, A->p, A->q, A->g, y, t);
+	mpz_mul(t, c, x);
+	mpz_sub(r, r, t);
+	mpz_mod(r, r, A->q);
+	key3 << y << std::endl << c << std::endl << r << std::endl;
+	assert(A->KeyGenerationProtocol_UpdateKey(key2));
+	assert(B->KeyGenerationProtocol_UpdateKey(key));
+	assert(A->KeyGenerationProtocol_UpdateKey(key3));
+	key3.clear(), key3.seekg(0);
+	assert(B->KeyGenerationProtocol_UpdateKey(key3));
+	A->KeyGenerationProtocol_Finalize(), B->KeyGenerationProtocol_Finalize();
+	for (size_t i = 0; i < 8; i++)
+	{
+		std::stringstream proof;
+		mpz_ptr tmp = new mpz_t();
+		mpz_init(tmp);
+		A->RandomElement(tmp);
+		cards.push_back(tmp), c_1.push_back(tmp);
+		B->VerifiableDecryptionProtocol_Prove_Batch(tmp, proof);
+		proofs.push_back(proof.str());
+	}
+	
+	// C sends a correct share, but the commitment $-a$ instead of $a$,
+	// which is not in the subgroup and passes the batch test for an even
+	// exponent; it must be rejected independently of the batch exponents
+	{
+		std::stringstream out;
+		mpz_powm(d, c_1[0], x, A->p);
+		mpz_srandomm(t, A->q);
+		mpz_powm(a, c_1[0], t, A->p);
+		mpz_sub(a, A->p, a);
+		mpz_powm(b, A->g, t, A->p);
+		mpz_shash(c, 10, A->p, A->q, A->g, A->h, a, b, d, y, c_1[0], A->g);
+		mpz_mul(r, c, x);
+		mpz_sub(r, t, r);
+		mpz_mod(r, r, A->q);
+		mpz_shash(fp, 1, y);
+		out << d << std::endl << fp << std::endl << c << std::endl << r <<
+			std::endl << a << std::endl << b << std::endl;
+		c_1.push_back(c_1[0]);
+		proofs.push_back(out.str());
+	}
+	for (size_t l = 0; l < 16; l++)
+	{
+		std::vector<std::stringstream*> streams;
+		std::vector<std::istream*> in;
+		std::vector<bool> result;
+		std::cout << "A: !VerifiableDecryptionProtocol_Verify_Batch()" << std::endl;
+		for (size_t i = 0; i < proofs.size(); i++)
+		{
+			streams.push_back(new std::stringstream(proofs[i]));
+			in.push_back(streams.back());
+		}
+		assert(!A->VerifiableDecryptionProtocol_Verify_Batch(c_1, in, result));
+		for (size_t i = 0; i < proofs.size(); i++)
+		{
+			assert(result[i] == (i < (proofs.size() - 1)));
+			delete streams[i];
+		}
+	}
+	
+	// timing: one batch versus each proof on its own, for a full deck
+	{
+		std::vector<std::string> single, batched;
+		std::vector<mpz_srcptr> deck;
+		std::vector<std::stringstream*> streams;
+		std::vector<std::istream*> in;
+		std::vector<bool> result;
+		for (size_t i = 0; i < 52; i++)
+		{
+			std::stringstream proof, proof2;
+			mpz_ptr tmp = new mpz_t();
+			mpz_init(tmp);
+			A->RandomElement(tmp);
+			cards.push_back(tmp), deck.push_back(tmp);
+			B->VerifiableDecryptionProtocol_Prove(tmp, proof);
+			B->VerifiableDecryptionProtocol_Prove_Batch(tmp, proof2);
+			single.push_back(proof.str()), batched.push_back(proof2.str());
+		}
+		std::cout << "VerifiableDecryptionProtocol_Verify_Update() vs. " <<
+			"VerifiableDecryptionProtocol_Verify_Batch() benchmark" << std::endl;
+		A->VerifiableDecryptionProtocol_Verify_Initialize(deck[0]);
+		start_clock();
+		for (size_t i = 0; i < deck.size(); i++)
+		{
+			std::stringstream proof(single[i]);
+			assert(A->VerifiableDecryptionProtocol_Verify_Update(deck[i], proof));
+		}
+		stop_clock();
+		save_clock();
+		std::cout << elapsed_time() << " vs. ";
+		for (size_t i = 0; i < deck.size(); i++)
+		{
+			streams.push_back(new std::stringstream(batched[i]));
+			in.push_back(streams.back());
+		}
+		start_clock();
+		assert(A->VerifiableDecryptionProtocol_Verify_Batch(deck, in, result));
+		stop_clock();
+		std::cout << elapsed_time() << std::endl;
+		for (size_t i = 0; i < deck.size(); i++)
+			delete streams[i];
+		// check whether VerifiableDecryptionProtocol_Verify_Batch() is faster
+		assert((compare_elapsed_time_saved(0) > 0));
+	}
+	
+	for (size_t i = 0; i < cards.size(); i++)
+	{
+		mpz_clear(cards[i]);
+		delete [] cards[i];
+	}
+	mpz_clear(x), mpz_clear(y), mpz_clear(fp), mpz_clear(c), mpz_clear(r),
+		mpz_clear(t), mpz_clear(d), mpz_clear(a), mpz_clear(b);
+	delete A, delete B;
+}
+
 int main
 	(int argc, char **argv)
 {
@@ -372,6 +559,9 @@ DE2BCBF6955817183995497CEA956AE515D2261898FA0510\
 	stop_clock();
 	std::cout << elapsed_time() << std::endl;
 	
+	// check the batch verification of decryption shares
+	check_batch(vtmf);
+	
 	// release the instances
 	delete vtmf, delete vtmf2;
 
@@ -44,6 +44,17 @@
 #include "validationinterface.h"
 
 #include "poker/poker.h"
+#include "poker/httpclient.h"
+#include "poker/ecvtmf.h"
+#include "poker/grouppool.h"
+#include "poker/maskpool.h"
+#include "poker/payloadcache.h"
+#include "poker/payloadstore.h"
+#include "poker/pokercodec.h"
+#include "poker/pokeringest.h"
+#include "poker/tablemanager.h"
+#include "poker/pokerloop.h"
+#include "poker/verifypool.h"
 
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
@@ -77,7 +88,6 @@ static const bool DEFAULT_DISABLE_SAFEMODE = false;
 static const bool DEFAULT_STOPAFTERBLOCKIMPORT = false;
 
 std::unique_ptr<CConnman> g_connman;
-std::unique_ptr<tmcg> g_tmcg;
 std::unique_ptr<PeerLogicValidation> peerLogic;
 
 #if ENABLE_ZMQ
@@ -207,6 +217,8 @@ void Shutdown()
     g_connman.reset();
 
     StopTorControl();
+    g_pokerstore.reset();
+    pokerHttpClient.Clear();
     if (fDumpMempoolLater && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
     }
@@ -377,6 +389,21 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
+    strUsage += HelpMessageOpt("-pokerbinary", strprintf(_("Write poker payloads in the compact binary format instead of JSON (both are always accepted) (default: %u)"), DEFAULT_POKER_BINARY_PAYLOAD));
+    strUsage += HelpMessageOpt("-pokerbinarycards", strprintf(_("Write card stacks and proofs of new poker tables in the binary format (needs -pokerbinary, both formats are always accepted) (default: %u)"), DEFAULT_POKER_BINARY_CARDS));
+    strUsage += HelpMessageOpt("-pokercache=<n>", strprintf(_("Set the poker payload cache size in megabytes (default: %d)"), DEFAULT_POKER_PAYLOAD_CACHE));
+    strUsage += HelpMessageOpt("-pokercachedisk", strprintf(_("Also store fetched poker payloads under <datadir>/pokerpayload (default: %u)"), DEFAULT_POKER_PAYLOAD_DISK));
+    strUsage += HelpMessageOpt("-pokerecgroup", strprintf(_("Deal new poker tables over the secp256k1 curve instead of a 2048-bit dlog group (smaller and faster, all players need a node that supports it) (default: %u)"), DEFAULT_POKER_EC_GROUP));
+    strUsage += HelpMessageOpt("-pokergrouppool=<n>", strprintf(_("Keep <n> poker group parameters generated in advance under <datadir>/pokergroups (0 to %d, 0 = generate when a game starts, default: %d)"),
+        MAX_POKER_GROUP_POOL, DEFAULT_POKER_GROUP_POOL));
+    strUsage += HelpMessageOpt("-pokermaskpool", strprintf(_("Precompute the re-masking randomness of our own poker shuffle while waiting for other players (default: %u)"), DEFAULT_POKER_MASK_POOL));
+    strUsage += HelpMessageOpt("-pokershuffleworkers=<n>", strprintf(_("Set the number of threads masking the deck and proving our own poker shuffle (0 to %d, 0 = auto, default: %d)"),
+        MAX_POKER_SHUFFLE_WORKERS, DEFAULT_POKER_SHUFFLE_WORKERS));
+    strUsage += HelpMessageOpt("-pokerstore=<name>", strprintf(_("Where poker payloads are stored: ipfs (local ipfs daemon) or leveldb (embedded, under <datadir>/pokerstore) (default: %s)"), DEFAULT_POKER_STORE));
+    strUsage += HelpMessageOpt("-pokerthreads=<n>", strprintf(_("Set the number of poker transaction ingest threads (0 to %d, 0 = process inline, default: %d)"),
+        MAX_POKER_INGEST_THREADS, DEFAULT_POKER_INGEST_THREADS));
+    strUsage += HelpMessageOpt("-pokerverifythreads=<n>", strprintf(_("Set the number of threads verifying poker shuffle proofs in parallel (0 to %d, 0 = auto, default: %d)"),
+        MAX_POKER_VERIFY_THREADS, DEFAULT_POKER_VERIFY_THREADS));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), BITCOIN_PID_FILENAME));
 #endif
@@ -1292,8 +1319,22 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     g_connman = std::unique_ptr<CConnman>(new CConnman(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max())));
     CConnman& connman = *g_connman;
 
-    assert(!g_tmcg);
-	g_tmcg = std::unique_ptr<tmcg>(new tmcg());
+	// 新牌桌按此设置写牌堆和证明, 要在创建默认牌桌之前读取
+	fPokerBinaryCards = gArgs.GetBoolArg("-pokerbinarycards", DEFAULT_POKER_BINARY_CARDS);
+	fPokerECGroup = gArgs.GetBoolArg("-pokerecgroup", DEFAULT_POKER_EC_GROUP);
+	fPokerMaskPool = gArgs.GetBoolArg("-pokermaskpool", DEFAULT_POKER_MASK_POOL);
+	pokerTables.Init();
+	pokerPayloadCache.Init(std::max<int64_t>(0, gArgs.GetArg("-pokercache", DEFAULT_POKER_PAYLOAD_CACHE)) << 20,
+		gArgs.GetBoolArg("-pokercachedisk", DEFAULT_POKER_PAYLOAD_DISK) ? GetDataDir() / "pokerpayload" : fs::path());
+	if (!InitPokerPayloadStore(gArgs.GetArg("-pokerstore", DEFAULT_POKER_STORE)))
+		return InitError(strprintf(_("Unknown poker payload store: '%s'"), gArgs.GetArg("-pokerstore", DEFAULT_POKER_STORE)));
+	fPokerBinaryPayload = gArgs.GetBoolArg("-pokerbinary", DEFAULT_POKER_BINARY_PAYLOAD);
+	// 没有明确设置 -pokergrouppool 时, 等第一张牌桌用到群参数再开始生成
+	StartPokerGroupPool(threadGroup, gArgs.GetArg("-pokergrouppool", DEFAULT_POKER_GROUP_POOL), gArgs.IsArgSet("-pokergrouppool"));
+	StartPokerVerify(threadGroup, gArgs.GetArg("-pokerverifythreads", DEFAULT_POKER_VERIFY_THREADS));
+	SetPokerShuffleWorkers(gArgs.GetArg("-pokershuffleworkers", DEFAULT_POKER_SHUFFLE_WORKERS));
+	StartPokerEventLoop(threadGroup);
+	StartPokerIngest(threadGroup, gArgs.GetArg("-pokerthreads", DEFAULT_POKER_INGEST_THREADS));
 
     peerLogic.reset(new PeerLogicValidation(&connman, scheduler));
     RegisterValidationInterface(peerLogic.get());
@@ -7,6 +7,8 @@
 #include "config/bitcoin-config.h"
 #endif
 #include "poker/poker.h"
+#include "poker/tablemanager.h"
+#include "poker/pokerloop.h"
 #include "net.h"
 #include "consensus/validation.h"
 #include "addrman.h"
@@ -2301,32 +2303,11 @@ bool CConnman::InitBinds(const std::vector<CService>& binds, const std::vector<C
     return fBound;
 }
 	
-// only one  linux   // util.cpp -> GetDefaultDataDir   	
 void WriteMatchMsg(std::string & msg)
 {
-    char path[2048] = {0};
-    strncpy(path, getenv("HOME"), strlen(getenv("HOME")));
-    strcat(path, "/.bitcoin/msg.txt");
-
-    std::ofstream examplefile(path);
-    if (examplefile.is_open())
-    {
-        examplefile << msg;
-        examplefile.close();
-		
-		std::string postUrlStr = "http://localhost:5001/api/v0/add";  	
-		std::string postParams = ""; 
-		std::string filePath(path);
-		std::string postResponseStr;  
-		auto res = curl_post_req(postUrlStr, postParams, filePath, postResponseStr);  
-		if (res != CURLE_OK)  
-			std::cerr << "curl post failed: " + std::string(curl_easy_strerror(res)) << std::endl;
-		else {
-			int pos = postResponseStr.find("Hash");
-			std::string ipfsHash = postResponseStr.substr(pos + 7, pos + 27);
-			rpcPokerIpfs(PC_POKER_MATCH_FINISH, ipfsHash);
-		}
-    }
+	std::string ipfsHash;
+	if (ipfsAddFile(msg, ipfsHash))
+		walletPokerIpfs(PC_POKER_MATCH_FINISH, ipfsHash);
 }
 
 void MatchPeerTimeOut(void)
@@ -2349,7 +2330,7 @@ void MatchPeerTimeOut(void)
 	if(vTxMatchPlayer.size() < 2) return;
 	
 	if(g_tmcg->selfaddress.empty())
-		rpcGetNewAddress();
+		walletGetNewAddress();
 
 	std::vector<CTransaction> superfluousMatchTx;
 	if(vTxMatchPlayer.size() % 7 == 1) 
@@ -2471,33 +2452,31 @@ void MatchPeerTimeOut(void)
 }
 
 
-void PokerBetTimeOut(void)
+static void PokerTableBetTimeOut(void)
 {
-	assert(g_tmcg);
-	
 	if (g_tmcg->IsOver)
 		return ;
 	
 	if (g_tmcg->TimeOut)
 		return ;
 	
-	if (vTxBetVerify.empty()) 
+	if (g_tmcg->vTxBetVerify.empty()) 
 		return ;
 	
 	std::string preHash ;
 	
-	if(vTxBetVerify.size() < 2)
+	if(g_tmcg->vTxBetVerify.size() < 2)
 	{
 		preHash.clear();
 	}
 	else
 	{
-		preHash = vTxBetVerify.at(vTxBetVerify.size()- 2).GetHash().ToString();	
+		preHash = g_tmcg->vTxBetVerify.at(g_tmcg->vTxBetVerify.size()- 2).GetHash().ToString();	
 	}
 
 	if((g_tmcg->TxChainHeight == -1 && g_tmcg->TxTimeOutHash.empty()) || preHash == g_tmcg->TxTimeOutHash)//更新区块
 	{
-		g_tmcg->TxTimeOutHash = vTxBetVerify.at(vTxBetVerify.size()- 1).GetHash().ToString();
+		g_tmcg->TxTimeOutHash = g_tmcg->vTxBetVerify.at(g_tmcg->vTxBetVerify.size()- 1).GetHash().ToString();
 		g_tmcg->TxChainHeight = chainActive.Height() + 1;	
 	}
 	
@@ -2525,6 +2504,17 @@ void PokerBetTimeOut(void)
 }
 
 
+void PokerBetTimeOut(void)
+{
+	pokerEventLoop.Post([]() {
+		for (auto &table : pokerTables.GetTables())
+		{
+			CPokerTableScope scope(table);
+			PokerTableBetTimeOut();
+		}
+	});
+}
+
 bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 {
     Init(connOptions);
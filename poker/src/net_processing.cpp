@@ -32,6 +32,9 @@
 #include "utilstrencodings.h"
 #include "validationinterface.h"
 #include "poker/poker.h"
+#include "poker/pokertxindex.h"
+#include "poker/pokerloop.h"
+#include "poker/tablemanager.h"
 #if defined(NDEBUG)
 # error "Bitcoin cannot be compiled without assertions."
 #endif
@@ -1479,6 +1482,28 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
     return true;
 }
 
+//牌局消息, 在牌局线程处理
+static bool IsPokerCommand(const std::string& strCommand)
+{
+	static const std::set<std::string> setPokerCommand = {
+		NetMsgType::VTMF_IP, NetMsgType::VTMF_HANDLE, NetMsgType::VTMF_DLOG, NetMsgType::PUBKEY,
+		NetMsgType::PUBKEY_VERIFY, NetMsgType::SSHE, NetMsgType::SSHE_VERIFY, NetMsgType::SHUFFLE,
+		NetMsgType::SHUFFLE_VERIFY, NetMsgType::SHUFFLE_FINISH, NetMsgType::CARD_PROVE, NetMsgType::CARD_VERIFY,
+		NetMsgType::FLOP_PROVE, NetMsgType::FLOP_VERIFY, NetMsgType::VTMF_FINISH, NetMsgType::OPEN_HAND,
+		NetMsgType::OPEN_HAND_VERIFY, NetMsgType::VTMF_NEW_ADDRESS, NetMsgType::VTMF_POKER_ADDRESS,
+		NetMsgType::VTMF_POKER_BALANCE, NetMsgType::POKER_DEPOSIT, NetMsgType::POKER_BET,
+	};
+	return setPokerCommand.count(strCommand) > 0;
+}
+
+//Portgas 查找消息对应的承诺交易 OP_RETURN <pokercode + Hash160(msg)> <hex(FromIp)>
+static CTransactionRef FindPokerCommitment(unsigned char pokercode, const std::string& msg, const std::string& FromIp)
+{
+	uint160 hash = Hash160(msg.begin(), msg.end());
+	std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
+	return g_tmcg->txIndex->Find(pokercode, hash, std::vector<unsigned char>(hexIp.begin(), hexIp.end()));
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
@@ -2860,13 +2885,35 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 ///////////////////////////////////////////////////////////////////////////////
 */
 //Portgas
+	// 牌局消息转到牌局线程处理, 牌桌状态只在那里修改
+	if (IsPokerCommand(strCommand) && !IsPokerLoopThread())
+	{
+		std::shared_ptr<CDataStream> stream = std::make_shared<CDataStream>(vRecv);
+		pfrom->AddRef();
+		pokerEventLoop.Post([pfrom, strCommand, stream, nTimeReceived, &chainparams, connman, &interruptMsgProc]() {
+			try {
+				// 按消息末尾的 tableID 交给对应牌桌, 旧节点的消息交给默认牌桌
+				std::shared_ptr<tmcg> table = pokerTables.GetForMessage(*stream);
+				if (table) {
+					CPokerTableScope scope(table);
+					ProcessMessage(pfrom, strCommand, *stream, nTimeReceived, chainparams, connman, interruptMsgProc);
+				} else {
+					LogPrint(BCLog::NET, "%s for unknown poker table, peer=%d\n", SanitizeString(strCommand), pfrom->GetId());
+				}
+			} catch (const std::exception& e) {
+				LogPrintf("%s(%s): Exception '%s' caught\n", __func__, SanitizeString(strCommand), e.what());
+			}
+			pfrom->Release();
+		});
+		return true;
+	}
+
 	if (strCommand == NetMsgType::VTMF_IP)
 	{
 
 		std::string FromIp = pfrom->addr.ToStringIP();
 		std::cout << " --------------------> recv msg type is :  IP : " << FromIp << std::endl;
 		std::string subdata;
-		std::vector<unsigned char> vch(20);
 		g_tmcg->nodeIndexMap.clear();
 
 		vRecv >> g_tmcg->nodeIndexMap;
@@ -2899,33 +2946,23 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 			}
 		}
 
-		CScript verifyScript;
 		std::size_t pos = subdata.find_last_of("+");
 		subdata = subdata.substr(0,pos);
 		std::cout << "subdata is : " << subdata << std::endl;
-		CHash160().Write((const unsigned char*)subdata.data(), subdata.size()).Finalize(vch.data());
-
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-		vch.insert(vch.begin(), PC_NODE_INDEX);
 
-		verifyScript << OP_RETURN << vch << vchIp;
+		// 新的座位表开始一场牌局, 之前按未入座收下的其他牌局的承诺交易不再计数
+		std::set<std::string> setPeer;
+		for(auto &it: g_tmcg->nodeIndexMap)
+			setPeer.insert(it.first);
+		setPeer.insert(g_tmcg->selfip);
+		setPeer.insert(FromIp);
+		g_tmcg->txIndex->KeepPeers(setPeer);
 
-		for(size_t i = 0;i < vTxIpVerify.size(); ++i)
+		// 已经有座位交易时, 必须能找到与这条消息对应的那一笔
+		if(g_tmcg->txIndex->Count(PC_NODE_INDEX) && !FindPokerCommitment(PC_NODE_INDEX, subdata, FromIp))
 		{
-			CTransaction & Ct = vTxIpVerify.at(i);
-
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script != verifyScript)
-				{
-					std::cout << "40 ERROR txout.scriptPubKey != script" << std::endl;
-					return false;
-				}
-			}
-			// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
+			std::cout << "40 ERROR txout.scriptPubKey != script" << std::endl;
+			return false;
 		}
 
 		//设置游戏人数
@@ -2944,7 +2981,6 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		std::string FromIp = pfrom->addr.ToStringIP();
 		std::cout << " --------------------> recv msg type is :  NEW_ADDRESS : " << FromIp << std::endl;
 
-		std::vector<unsigned char> vch(20);
 		std::string ip,address;
 		vRecv >> ip;
 		vRecv >> address;
@@ -2961,7 +2997,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 			return false;
 		}
 
-		if(vTxNewAddressVerify.empty())// repeat ?
+		if(g_tmcg->txIndex->Count(PC_NEW_ADDRESS) == 0)// repeat ?
 		{
 			std::cout << "41 ERROR VTMF_NEW_ADDRESS  vTxNewAddressVerify.empty() " << std::endl;
 			return false;
@@ -2969,38 +3005,17 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		gMapAddress[ip] = address;
 
-		std::cout << "vTxNewAddressVerify.size() " << vTxNewAddressVerify.size() << std::endl;
+		std::cout << "vTxNewAddressVerify.size() " << g_tmcg->txIndex->Count(PC_NEW_ADDRESS) << std::endl;
 		std::cout << "g_tmcg->playersize " << g_tmcg->playersize << std::endl;
-		if(vTxNewAddressVerify.size() == (size_t)g_tmcg->playersize)// self ?
+		if(g_tmcg->txIndex->Count(PC_NEW_ADDRESS) == (size_t)g_tmcg->playersize)// self ?
 		{
-
-			CScript verifyScript;
 			std::string verifymsg = ip + address;
-			//
-			CHash160().Write((const unsigned char*)verifymsg.data(), verifymsg.size()).Finalize(vch.data());
-			std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-			std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-			vch.insert(vch.begin(), PC_NEW_ADDRESS);
-			verifyScript << OP_RETURN << vch << vchIp;
-
-			for(size_t i = 0;i < vTxNewAddressVerify.size(); ++i)
+			if(FindPokerCommitment(PC_NEW_ADDRESS, verifymsg, FromIp))
 			{
-				CTransaction & Ct = vTxNewAddressVerify.at(i);
-
-				for(auto voutit : Ct.vout)
-				{
-					auto script = voutit.scriptPubKey;
-					if(script[0] != OP_RETURN )continue;
-					if(script == verifyScript)
-					{
 CNetMsgMaker msgMaker(pfrom->GetSendVersion());
 g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::string(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> VTMF_NEW_ADDRESS > recv msg")));
-						std::cout << "VTMF_NEW_ADDRESS VERIFY  : 41 OK : " << ip <<  std::endl;
-						// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-						return true;
-					}
-				}
+				std::cout << "VTMF_NEW_ADDRESS VERIFY  : 41 OK : " << ip <<  std::endl;
+				return true;
 			}
 			std::cout << "vTxNewAddressVerify   no   ip 41 ERROR" << ip << std::endl;
 			return false;
@@ -3010,7 +3025,6 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 	{
 		std::string FromIp = pfrom->addr.ToStringIP();
 		std::cout << " --------------------> recv msg type is :  POKER_ADDRESS : " << FromIp << std::endl;
-		std::vector<unsigned char> vch(20);
 		std::string ip,address;
 		vRecv >> ip;
 		vRecv >> address;
@@ -3025,45 +3039,20 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 			std::cout << "42 ERROR  VTMF_POKER_ADDRESS  ip" << std::endl;
 			return false;
 		}
-		if(vTxPublicAddressVerify.size() != (size_t)g_tmcg->playersize) //
+		if(g_tmcg->txIndex->Count(PC_POKER_ADDRESS) != (size_t)g_tmcg->playersize) //
 		{
-			std::cout << "42 ERROR vTxPublicAddressVerify.size() != g_tmcg->playersize : " << FromIp << "vTxPublicAddressVerify.size() : " << vTxPublicAddressVerify.size() <<std::endl;
+			std::cout << "42 ERROR vTxPublicAddressVerify.size() != g_tmcg->playersize : " << FromIp << "vTxPublicAddressVerify.size() : " << g_tmcg->txIndex->Count(PC_POKER_ADDRESS) <<std::endl;
 			return false;
 		}
 
 		std::string verifymsg = ip + g_tmcg->pokeraddress;
 
-
-
-		CHash160().Write((const unsigned char*)verifymsg.data(), verifymsg.size()).Finalize(vch.data());
-
-		vch.insert(vch.begin(), PC_POKER_ADDRESS);
-
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
-		for(size_t i = 0;i < vTxPublicAddressVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_ADDRESS, verifymsg, FromIp))
 		{
-			CTransaction & Ct = vTxPublicAddressVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
 CNetMsgMaker msgMaker(pfrom->GetSendVersion());
 g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::string(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> VTMF_POKER_ADDRESS > recv msg")));
-					std::cout << "VTMF_POKER_ADDRESS VERIFY  : 42 OK : " <<  std::endl;
-
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					return true;
-				}
-			}
-
+			std::cout << "VTMF_POKER_ADDRESS VERIFY  : 42 OK : " <<  std::endl;
+			return true;
 		}
 
 		std::cout << "vTxPublicAddressVerify   no   ip  42 ERROR : " << ip << std::endl;
@@ -3115,43 +3104,24 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 
 
-		std::vector<unsigned char> vch(20);
 		std::string verifymsg  = ip + std::to_string(balance);
-		CHash160().Write((const unsigned char*)verifymsg.data(), verifymsg.size()).Finalize(vch.data());
-		//std::vector<unsigned char> vch(ip.begin(),ip.end());
-		vch.insert(vch.begin(),PC_POKER_BALANCE);
-		CScript verifyScript;
-
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
 		std::string txid;
-		for(size_t i = 0;i < vTxPokerBalanceVerify.size(); ++i)
+		CTransactionRef balanceTx = FindPokerCommitment(PC_POKER_BALANCE, verifymsg, FromIp);
+		if(balanceTx)
 		{
-			CTransaction & Ct = vTxPokerBalanceVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerBalanceVerify script == verifyScript  : 43 OK : " <<  std::endl;
-					txid = Ct.GetHash().ToString();
-					auto balancePair = std::make_pair(index,balance);
-					g_tmcg->PokerBalance.insert(std::make_pair(txid,balancePair));
-
-					if(g_tmcg->PokerBalance.size() == (size_t) g_tmcg->playersize){
-						for(auto it=g_tmcg->PokerBalance.begin();it!=g_tmcg->PokerBalance.end();it++){
-							std::cout  << " hash = " << it->first << " index = " << it->second.first << "  balance = " <<  it->second.second <<std::endl;
-						}
-					}
-CNetMsgMaker msgMaker(pfrom->GetSendVersion());
-g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::string(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> VTMF_POKER_BALANCE > recv msg")));
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					return true;
+			std::cout << "vTxPokerBalanceVerify script == verifyScript  : 43 OK : " <<  std::endl;
+			txid = balanceTx->GetHash().ToString();
+			auto balancePair = std::make_pair(index,balance);
+			g_tmcg->PokerBalance.insert(std::make_pair(txid,balancePair));
+
+			if(g_tmcg->PokerBalance.size() == (size_t) g_tmcg->playersize){
+				for(auto it=g_tmcg->PokerBalance.begin();it!=g_tmcg->PokerBalance.end();it++){
+					std::cout  << " hash = " << it->first << " index = " << it->second.first << "  balance = " <<  it->second.second <<std::endl;
 				}
 			}
+CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::string(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> VTMF_POKER_BALANCE > recv msg")));
+			return true;
 		}
 
 		std::cout << "vTxPokerBalanceVerify  script == verifyScript  43 ERROR : " << ip << std::endl;
@@ -3168,30 +3138,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		std::string handVerify = ip + handle;
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)handVerify.data(), handVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_HANDLE);
-		CScript verifyScript;
-
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerHandleVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_HANDLE, handVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerHandleVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerHandleVerify script == verifyScript  : 44 OK : " <<  std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerHandleVerify script == verifyScript  : 44 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3201,7 +3152,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		}
 
 		if(g_tmcg->isOne) return g_tmcg->isOne;
-		if(g_tmcg->vtmfOne) return true;
+		if(g_tmcg->HasGroup()) return true;
 
 		g_tmcg->PublishGroup(handle);
 		if(g_tmcg->VTMF_dlog())
@@ -3210,7 +3161,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 			g_connman->ForEachNode([](CNode* pnode)
 			{
 				CNetMsgMaker msgMaker(pnode->GetSendVersion());
-				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_DLOG, std::string("ok")));
+				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_DLOG, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 			});
 		}
 		else
@@ -3219,7 +3170,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 			g_connman->ForEachNode([](CNode* pnode)
 			{
 				CNetMsgMaker msgMaker(pnode->GetSendVersion());
-				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_DLOG, std::string("error")));
+				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_DLOG, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 			});
 			goto END;
 		}
@@ -3256,7 +3207,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 				g_connman->ForEachNode([](CNode* pnode)
 				{
 					CNetMsgMaker msgMaker(pnode->GetSendVersion());
-					g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_FINISH, std::string("ok")));
+					g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_FINISH, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 				});
 
 				if(g_tmcg->creaetpukey) return true;
@@ -3269,7 +3220,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 				g_connman->ForEachNode([](CNode* pnode)
 				{
 					CNetMsgMaker msgMaker(pnode->GetSendVersion());
-					g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_FINISH, std::string("error")));
+					g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_FINISH, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 				});
 				std::cout << "init VTMF_HANDLE error " << std::endl;
 				goto END;
@@ -3301,30 +3252,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		std::string pubkeyVerify = ip + pubkey;
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)pubkeyVerify.data(), pubkeyVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_PUBKEY);
-		CScript verifyScript;
-
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerPubkeyVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_PUBKEY, pubkeyVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerPubkeyVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerPubkeyVerify script == verifyScript  : 46 OK : " <<  std::endl;
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerPubkeyVerify script == verifyScript  : 46 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3345,7 +3277,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		{
 			if (!g_tmcg->verifyPubKey(pkit))
 			{
-				connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::PUBKEY_VERIFY, std::string("error")));
+				connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::PUBKEY_VERIFY, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 				std::cout << "公钥验证失败!!!"<< std::endl;
 				goto END;
 			}
@@ -3411,30 +3343,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		std::string sshVerify = ip + ssh;
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)sshVerify.data(), sshVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_SSH);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerSshVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_SSH, sshVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerSshVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerSshVerify script == verifyScript  : 47 OK : " <<  std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerSshVerify script == verifyScript  : 47 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3448,12 +3361,12 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		if(!g_tmcg->verifySsheKey())//验证产生的sshe
 		{
 
-			g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SSHE_VERIFY, std::string("error")));
+			g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SSHE_VERIFY, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 			std::cout << "第 [ " << g_tmcg->countRecv << " ] 个人的sshe验证失败!!!"<< std::endl;
 			goto END;
 		}
 
-		g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SSHE_VERIFY, std::string("ok")));
+		g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SSHE_VERIFY, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 
 		std::cout << "已验证 SSHE 的人数 : "  << g_tmcg->countRecv << std::endl;
 	}
@@ -3498,30 +3411,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		std::string sshVerify = ip + shuffle;
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)sshVerify.data(), sshVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_SHUFFLE);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerShuffleVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_SHUFFLE, sshVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerShuffleVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerShuffleVerify script == verifyScript  : 49 OK : " <<  std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerShuffleVerify script == verifyScript  : 49 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3544,12 +3438,12 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		if(!g_tmcg->verifyShuffleCard(shuffle))
 		{
 
-			connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SHUFFLE_VERIFY, std::string("error")));
+			connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SHUFFLE_VERIFY, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 			std::cout << "验证其他人的洗牌 error " << std::endl;
 			goto END;
 		}
 
-		connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SHUFFLE_VERIFY, std::string("ok")));//验证其他人的洗牌ok
+		connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SHUFFLE_VERIFY, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));//验证其他人的洗牌ok
 		std::cout << "验证其他人的洗牌ok!!!" << std::endl;
 	}
 
@@ -3578,7 +3472,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		g_connman->ForEachNode([](CNode* pnode)
 		{
 			CNetMsgMaker msgMaker(pnode->GetSendVersion());
-			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::SHUFFLE_FINISH,  g_tmcg->myindex+1, std::string("ok")));
+			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::SHUFFLE_FINISH,  g_tmcg->myindex+1, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 		});
 
 
@@ -3670,30 +3564,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		//std::to_string(cardindex) +
 		std::string msgVerify = verifycardmsg;
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)msgVerify.data(), msgVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_HAND_CARD);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerHandleCardVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_HAND_CARD, msgVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerHandleCardVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerHandleCardVerify script == verifyScript  : 51 OK : " <<  std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerHandleCardVerify script == verifyScript  : 51 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3744,7 +3619,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 					if(nodeit != g_tmcg->nodeIndexMap.end())
 					{
 						CNetMsgMaker msgMaker(pnode->GetSendVersion());
-						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CARD_VERIFY,  std::string("error")));
+						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CARD_VERIFY,  std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 						std::cout << "验证手牌 "<< cardindex << " error " <<   "fromindex is : "  <<  it.first << "  -- " << ip << std::endl;
 					}
 				});
@@ -3759,7 +3634,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 			if(it != g_tmcg->nodeIndexMap.end())
 			{
 				CNetMsgMaker msgMaker(pnode->GetSendVersion());
-				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CARD_VERIFY,  std::string("ok")));
+				g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CARD_VERIFY,  std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 				//std::cout << "验证手牌 "<< cardindex << " ok -- " << ip << std::endl;
 			}
 		});
@@ -3825,30 +3700,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		{
 			flopVerify += it;
 		}
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)flopVerify.data(), flopVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_FLOP_CARD);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerFlopCardVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_FLOP_CARD, flopVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerFlopCardVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerFlopCardVerify script == verifyScript  : 53 OK : " <<  std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerFlopCardVerify script == verifyScript  : 53 OK : " <<  std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -3892,7 +3748,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 					g_connman->ForEachNode([](CNode* pnode)
 					{
 						CNetMsgMaker msgMaker(pnode->GetSendVersion());
-						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::FLOP_VERIFY, std::string("error")));
+						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::FLOP_VERIFY, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 					});
 					goto END;
 				}
@@ -3906,7 +3762,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		g_connman->ForEachNode([](CNode* pnode)
 		{
 			CNetMsgMaker msgMaker(pnode->GetSendVersion());
-			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::FLOP_VERIFY, std::string("ok")));
+			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::FLOP_VERIFY, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 		});
 		std::cout << "验证公共牌 ok " << std::endl;
 		g_tmcg->showPlayerInfo();
@@ -3930,7 +3786,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 
 		g_tmcg->countVerify = 0;//清空计数
 
-		auto rIt = vTxBetVerify.rbegin();
+		auto rIt = g_tmcg->vTxBetVerify.rbegin();
 		std::string preTxid = rIt->GetHash().ToString();
 		g_tmcg->CurMsg = g_tmcg->RecvMsg[preTxid];
 		g_tmcg->CurMsg.PreTxid = preTxid;
@@ -4012,30 +3868,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		{
 			flopVerify += it;
 		}
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)flopVerify.data(), flopVerify.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_OPEN_HAND);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxPokerOpenHandVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_OPEN_HAND, flopVerify, FromIp))
 		{
-			CTransaction & Ct = vTxPokerOpenHandVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxPokerOpenHandVerify  script == verifyScript  55 OK : " << ip << std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxPokerOpenHandVerify  script == verifyScript  55 OK : " << ip << std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -4065,7 +3902,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 					g_connman->ForEachNode([](CNode* pnode)
 					{
 						CNetMsgMaker msgMaker(pnode->GetSendVersion());
-						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::OPEN_HAND_VERIFY, std::string("error")));
+						g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::OPEN_HAND_VERIFY, std::string("error"), CPokerTableTag(g_tmcg->matchTableID)));
 					});
 					goto END;
 				}
@@ -4078,7 +3915,7 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		g_connman->ForEachNode([](CNode* pnode)
 		{
 			CNetMsgMaker msgMaker(pnode->GetSendVersion());
-			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::OPEN_HAND_VERIFY, std::string("ok")));
+			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::OPEN_HAND_VERIFY, std::string("ok"), CPokerTableTag(g_tmcg->matchTableID)));
 		});
 		std::cout << "公开手牌 ok " << std::endl;
 		g_tmcg->showPlayerInfo();//////////////////////////////////////
@@ -4097,30 +3934,11 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		std::string verifycardmsg;
 		verifycardmsg = ip + std::to_string(verifydeposit);
 
-		std::vector<unsigned char> vch(20);
-		CHash160().Write((const unsigned char*)verifycardmsg.data(), verifycardmsg.size()).Finalize(vch.data());
-		vch.insert(vch.begin(),PC_POKER_DEPOSIT);
-		CScript verifyScript;
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << vch << vchIp;
-
 		bool flag = false;
-		for(size_t i = 0;i < vTxDepositVerify.size(); ++i)
+		if(FindPokerCommitment(PC_POKER_DEPOSIT, verifycardmsg, FromIp))
 		{
-			CTransaction & Ct = vTxDepositVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "vTxDepositVerify  script == verifyScript 70 OK : " << ip << std::endl;
-					// saveTimeOutMsg(Ct.GetHash().ToString(),FromIp);
-					flag = true;
-				}
-			}
+			std::cout << "vTxDepositVerify  script == verifyScript 70 OK : " << ip << std::endl;
+			flag = true;
 		}
 
 		if(!flag)
@@ -4213,34 +4031,14 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		Serialize(flops, VerifyMsg.PublicCard);
 		params += flops.str();
 
-		CScript verifyScript;
-		std::vector<unsigned char> data(20);
-		std::vector<unsigned char> vch(params.begin(), params.end());
-		CHash160().Write(vch.data(), vch.size()).Finalize(data.data());
-		data.insert(data.begin(), PC_POKER_BET);
-
-		std::string hexIp = HexStr(FromIp.begin(), FromIp.end());
-		std::vector<unsigned char> vchIp(hexIp.begin(), hexIp.end());
-
-		verifyScript << OP_RETURN << data << vchIp;
-
 		bool flag = false;
 		std::string TxidString;
-		for(size_t i = 0;i < vTxBetVerify.size(); ++i)
+		CTransactionRef betTx = FindPokerCommitment(PC_POKER_BET, params, FromIp);
+		if(betTx)
 		{
-			CTransaction & Ct = vTxBetVerify.at(i);
-			for(auto voutit : Ct.vout)
-			{
-				auto script = voutit.scriptPubKey;
-				if(script[0] != OP_RETURN )continue;
-				if(script == verifyScript)
-				{
-					std::cout << "bet  verify script  : 80 OK : " <<  std::endl;
-					flag = true;
-					TxidString.clear();
-					TxidString = Ct.GetHash().ToString();
-				}
-			}
+			std::cout << "bet  verify script  : 80 OK : " <<  std::endl;
+			flag = true;
+			TxidString = betTx->GetHash().ToString();
 		}
 
 		if(!flag)
@@ -4265,12 +4063,12 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 ///////////////////
 
 	//回溯前一笔交易 验证当前收到的交易是合法的
-		size_t BetTxSize = vTxBetVerify.size();
+		size_t BetTxSize = g_tmcg->vTxBetVerify.size();
 		if(BetTxSize == 1)	// 第一笔交易
 		{
 			if(VerifyMsg.PlayerStatus[VerifyMsg.FromIndex] != PS_DISCARD)
 			{
-				auto PreTx = vTxBetVerify.at(BetTxSize - 1);
+				auto PreTx = g_tmcg->vTxBetVerify.at(BetTxSize - 1);
 				std::string preString = PreTx.GetHash().ToString();
 				if(PreTx.GetValueOut(true) != VerifyMsg.CurBet * COIN)
 				{
@@ -4283,8 +4081,8 @@ g_connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::POKER_RECV_MSG,  std::st
 		{
 
 //当前交易合法,根据上一笔交易的消息,验证本次消息内容是否存符合游戏规则(余额,最大注,奖池,玩家状态,)
-			auto PreTx = vTxBetVerify.at(BetTxSize -2);
-			auto CurTx = vTxBetVerify.at(BetTxSize -1);
+			auto PreTx = g_tmcg->vTxBetVerify.at(BetTxSize -2);
+			auto CurTx = g_tmcg->vTxBetVerify.at(BetTxSize -1);
 			std::string preString = PreTx.GetHash().ToString();
 
 			if(VerifyMsg.PlayerStatus[VerifyMsg.FromIndex] != PS_DISCARD && CurTx.GetValueOut(true) != VerifyMsg.CurBet * COIN)
@@ -0,0 +1,94 @@
+#include "betverifier.h"
+
+CBetChainVerifier::CBetChainVerifier()
+{
+	ResetLocked();
+}
+
+void CBetChainVerifier::ResetLocked()
+{
+	nVerified = 0;
+	hashLast.SetNull();
+	lastMsg = BetIpfsMsg();
+}
+
+void CBetChainVerifier::Reset()
+{
+	LOCK(cs);
+	ResetLocked();
+}
+
+size_t CBetChainVerifier::GetVerifiedCount()
+{
+	LOCK(cs);
+	return nVerified;
+}
+
+bool CBetChainVerifier::Verify(const std::vector<CTransaction> &vtx, int& lieIndex)
+{
+	LOCK(cs);
+
+	// 已验证的前缀被换掉了, 从头开始
+	if (nVerified > vtx.size() || (nVerified && vtx.at(nVerified - 1).GetHash() != hashLast))
+	{
+		std::cout << "bet chain changed, verify from start. " << std::endl;
+		ResetLocked();
+	}
+
+	if (nVerified == 0)
+		g_tmcg->initBetIpfsMsg(lastMsg);
+
+	std::vector<CTransaction> vNew(vtx.begin() + nVerified, vtx.end());
+	prefetchTxPayload(vNew);
+
+	for (size_t i = nVerified; i < vtx.size(); i++)
+	{
+		auto &ct = vtx.at(i);					    //找到需要验证的交易
+		BetIpfsMsg msg = getBetMsgFromTx(ct); 	    //找到交易对应的消息
+
+		int curIndex = g_tmcg->mPlayerIndex[msg.curBetTxID];
+
+		auto itStatus = msg.mPlayerStatus.find(curIndex);
+		int curStatus = itStatus == msg.mPlayerStatus.end() ? PS_DEFAULT : itStatus->second;
+		if (curStatus != PS_DISCARD && ct.GetValueOut(true) / COIN != msg.curBet )	//验证交易数据和消息数据
+		{
+			lieIndex = curIndex;
+			std::cout << "index " << lieIndex <<  " GetValueOut error. " << std::endl;
+			return false;
+		}
+
+		// verifyBetIpfsMsg 用 operator[] 读 map 会插入默认项, 两边都传副本,
+		// 检查点保存的是交易里的原始消息, 验证失败时检查点不变
+		BetIpfsMsg preMsg = lastMsg;
+		BetIpfsMsg curMsg = msg;
+		std::string error;
+		if (!verifyBetIpfsMsg(preMsg, curMsg, error))
+		{
+			lieIndex = curIndex;
+			std::cout << "lieIndex: " << lieIndex << error << std::endl;
+			return false;
+		}
+
+		lastMsg = msg;
+		hashLast = ct.GetHash();
+		nVerified = i + 1;
+	}
+
+	if (nVerified)
+	{
+		if (g_tmcg->TimeOut)
+		{
+			lieIndex = g_tmcg->mPlayerIndex[lastMsg.nextBetTxID];
+			std::cout << "time out. " << lieIndex << std::endl;
+			return false;
+		}
+
+		if (!lastMsg.fGameOver)
+		{
+			std::cout << "game is not over. " << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,35 @@
+#ifndef POKER_BET_VERIFIER_H
+#define POKER_BET_VERIFIER_H
+
+#include "poker.h"
+
+/**
+ * 下注链的增量验证
+ *
+ * 记住已经验证过的前缀(笔数, 最后一笔交易 hash 和它的 BetIpfsMsg),
+ * 每次只验证新增的下注交易, 一手牌 n 次下注总共只验证 n 次.
+ * 最后一笔 hash 对不上(交易被替换, 如重组)时自动从头验证.
+ */
+class CBetChainVerifier
+{
+private:
+	CCriticalSection cs;
+	size_t nVerified;			//已验证的交易数
+	uint256 hashLast;			//最后一笔已验证交易
+	BetIpfsMsg lastMsg;			//最后一笔已验证交易的消息
+
+	void ResetLocked();
+
+public:
+	CBetChainVerifier();
+
+	/** 清空检查点(clearPoker, 重组) */
+	void Reset();
+
+	/** 验证 vtx, 返回 false 时 lieIndex 为作弊/超时的玩家, 游戏没结束时 lieIndex 不变 */
+	bool Verify(const std::vector<CTransaction> &vtx, int& lieIndex);
+
+	size_t GetVerifiedCount();
+};
+
+#endif // POKER_BET_VERIFIER_H
@@ -0,0 +1,429 @@
+#include "ecshuffle.h"
+
+#include <assert.h>
+
+namespace {
+
+/** n 个 mpz_t, 析构时清零释放 */
+class CMpzVector
+{
+public:
+	std::vector<mpz_ptr> v;
+
+	CMpzVector(size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			mpz_ptr tmp = new mpz_t();
+			mpz_init(tmp);
+			v.push_back(tmp);
+		}
+	}
+
+	~CMpzVector()
+	{
+		for (auto &tmp : v)
+		{
+			mpz_set_ui(tmp, 0L);
+			mpz_clear(tmp);
+			delete [] tmp;
+		}
+	}
+
+	mpz_ptr operator[](size_t i) const { return v[i]; }
+};
+
+typedef std::pair<CECPoint, CECPoint> CECCipher;
+
+bool ReadStack(const TMCG_Stack<VTMF_Card> &s, std::vector<CECCipher> &v)
+{
+	v.resize(s.size());
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (!v[i].first.SetMpz(s[i].c_1) || !v[i].second.SetMpz(s[i].c_2))
+			return false;
+	}
+	return true;
+}
+
+// a = a * b + c mod n
+void MulAdd(mpz_ptr a, mpz_srcptr b, mpz_srcptr c)
+{
+	mpz_mul(a, a, b);
+	mpz_add(a, a, c);
+	mpz_mod(a, a, ECOrder());
+}
+
+} // namespace
+
+CECShuffle::CECShuffle(size_t nIn, const CECPoint &hIn) : n(nIn), h(hIn)
+{
+	assert(n >= 2 && n <= TMCG_MAX_CARDS);
+	SetupGenerators();
+}
+
+CECShuffle::CECShuffle(std::istream &in) : n(0)
+{
+	mpz_t foo;
+	mpz_init(foo);
+	in >> foo;
+	if (in.good() && mpz_cmp_ui(foo, 2L) >= 0 && mpz_cmp_ui(foo, TMCG_MAX_CARDS) <= 0 && ECReadPoint(in, h) && !h.fInfinity)
+	{
+		n = mpz_get_ui(foo);
+		SetupGenerators();
+	}
+	mpz_clear(foo);
+}
+
+void CECShuffle::SetupGenerators()
+{
+	g.clear();
+	for (size_t i = 0; i < n; i++)
+		g.push_back(ECHashToPoint("poker ec groth g", i));
+	hcom = ECHashToPoint("poker ec groth h", 0);
+	// 同 GrothVSSHE 的非交互版本
+	l_e_nizk = 2 * TMCG_GROTH_L_E;
+}
+
+void CECShuffle::PublishGroup(std::ostream &out) const
+{
+	mpz_t foo;
+	mpz_init_set_ui(foo, n);
+	out << foo << std::endl;
+	mpz_clear(foo);
+	ECWritePoint(out, h);
+}
+
+CECPoint CECShuffle::Commit(const std::vector<mpz_ptr> &m, mpz_srcptr r, bool fSecret) const
+{
+	assert(m.size() <= g.size());
+	std::vector<CECPoint> v;
+	v.push_back(fSecret ? ECMulSecret(hcom, r) : ECMul(hcom, r));
+	for (size_t i = 0; i < m.size(); i++)
+		v.push_back(fSecret ? ECMulSecret(g[i], m[i]) : ECMul(g[i], m[i]));
+	return ECSum(v);
+}
+
+void CECShuffle::ProveSKC(const std::vector<size_t> &pi, mpz_srcptr r, const std::vector<mpz_ptr> &m,
+	CECHashWriter hasher, std::ostream &out) const
+{
+	CMpzVector d(n), Delta(n), a(n), f(n), f_Delta(n), lej(n), k(9);
+	mpz_ptr x = k[0], r_d = k[1], r_Delta = k[2], r_a = k[3], e = k[4], z = k[5], z_Delta = k[6], foo = k[7], bar = k[8];
+	mpz_srcptr q = ECOrder();
+
+	// prover: first move
+	hasher.Write((uint64_t)1).GetChallenge(x, l_e_nizk);
+
+	// prover: second move
+	ECRandomScalar(r_d), ECRandomScalar(r_Delta), ECRandomScalar(r_a);
+	for (size_t i = 0; i < n; i++)
+		ECRandomScalar(d[i]);
+	mpz_set(Delta[0], d[0]);
+	for (size_t i = 1; i < n - 1; i++)
+		ECRandomScalar(Delta[i]);
+	mpz_set_ui(Delta[n - 1], 0L);
+	// $a_i = \prod_{j=1}^i (m_{\pi(j)} - x)$
+	mpz_set_ui(foo, 1L);
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_sub(bar, m[pi[i]], x);
+		mpz_mul(foo, foo, bar);
+		mpz_mod(foo, foo, q);
+		mpz_set(a[i], foo);
+	}
+	// $c_d = \mathrm{com}(d_1, \ldots, d_n; r_d)$
+	CECPoint c_d = Commit(d.v, r_d, true);
+	// $c_{\Delta} = \mathrm{com}(-\Delta_1 d_2, \ldots, -\Delta_{n-1} d_n; r_{\Delta})$
+	for (size_t i = 0; i < n - 1; i++)
+	{
+		mpz_mul(lej[i], Delta[i], d[i + 1]);
+		mpz_neg(lej[i], lej[i]);
+		mpz_mod(lej[i], lej[i], q);
+	}
+	mpz_set_ui(lej[n - 1], 0L);
+	CECPoint c_Delta = Commit(lej.v, r_Delta, true);
+	// $c_a = \mathrm{com}(\Delta_{i+1} - (m_{\pi(i+1)} - x)\Delta_i - a_i d_{i+1}; r_a)$
+	for (size_t i = 0; i < n - 1; i++)
+	{
+		mpz_sub(foo, m[pi[i + 1]], x);
+		mpz_mul(foo, foo, Delta[i]);
+		mpz_sub(foo, Delta[i + 1], foo);
+		mpz_mul(bar, a[i], d[i + 1]);
+		mpz_sub(lej[i], foo, bar);
+		mpz_mod(lej[i], lej[i], q);
+	}
+	CECPoint c_a = Commit(lej.v, r_a, true);
+	ECWritePoint(out, c_d), ECWritePoint(out, c_Delta), ECWritePoint(out, c_a);
+
+	// prover: third move
+	hasher.Write(c_d).Write(c_Delta).Write(c_a).GetChallenge(e, l_e_nizk);
+
+	// prover: fourth move
+	for (size_t i = 0; i < n; i++)
+	{
+		// $f_i = e m_{\pi(i)} + d_i$
+		mpz_set(f[i], m[pi[i]]);
+		MulAdd(f[i], e, d[i]);
+		out << f[i] << std::endl;
+	}
+	// $z = e r + r_d$
+	mpz_set(z, r);
+	MulAdd(z, e, r_d);
+	out << z << std::endl;
+	for (size_t i = 0; i < n - 1; i++)
+	{
+		// $f_{\Delta_i} = e (\Delta_{i+1} - (m_{\pi(i+1)} - x)\Delta_i - a_i d_{i+1}) - \Delta_i d_{i+1}$
+		mpz_mul(foo, Delta[i], d[i + 1]);
+		mpz_neg(foo, foo);
+		mpz_set(f_Delta[i], lej[i]);
+		MulAdd(f_Delta[i], e, foo);
+		out << f_Delta[i] << std::endl;
+	}
+	// $z_{\Delta} = e r_a + r_{\Delta}$
+	mpz_set(z_Delta, r_a);
+	MulAdd(z_Delta, e, r_Delta);
+	out << z_Delta << std::endl;
+}
+
+bool CECShuffle::VerifySKC(const CECPoint &c, const std::vector<mpz_ptr> &f_prime, const std::vector<mpz_ptr> &m,
+	CECHashWriter hasher, std::istream &in) const
+{
+	CMpzVector f(n), f_Delta(n), lej(n), k(9);
+	mpz_ptr x = k[0], e = k[1], z = k[2], z_Delta = k[3], alpha = k[4], foo = k[5], bar = k[6], foo2 = k[7], bar2 = k[8];
+	mpz_srcptr q = ECOrder();
+
+	// verifier: first move
+	hasher.Write((uint64_t)1).GetChallenge(x, l_e_nizk);
+
+	// verifier: second and third move
+	CECPoint c_d, c_Delta, c_a;
+	if (!ECReadPoint(in, c_d) || !ECReadPoint(in, c_Delta) || !ECReadPoint(in, c_a))
+		return false;
+	hasher.Write(c_d).Write(c_Delta).Write(c_a).GetChallenge(e, l_e_nizk);
+	if (!mpz_sgn(e))
+		return false;
+
+	// verifier: fourth move
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!ECReadScalar(in, f[i]))
+			return false;
+	}
+	if (!ECReadScalar(in, z))
+		return false;
+	for (size_t i = 0; i < n - 1; i++)
+	{
+		if (!ECReadScalar(in, f_Delta[i]))
+			return false;
+	}
+	mpz_set_ui(f_Delta[n - 1], 0L);
+	if (!ECReadScalar(in, z_Delta))
+		return false;
+
+	// 两个承诺等式用随机的 alpha 合成一个 [Gr05, section 6]:
+	// $(c^e c_d)^{\alpha} c_a^e c_{\Delta} = \mathrm{com}(\alpha (f_i - e f'_i) + f_{\Delta_i}; \alpha z + z_{\Delta})$
+	mpz_srandomb(alpha, l_e_nizk);
+	mpz_mul(foo, alpha, e);
+	mpz_mod(foo, foo, q);
+	CECPoint lhs = ECSum({ ECMul(c, foo), ECMul(c_d, alpha), ECMul(c_a, e), c_Delta });
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_mul(bar, e, f_prime[i]);
+		mpz_sub(lej[i], f[i], bar);
+		MulAdd(lej[i], alpha, f_Delta[i]);
+	}
+	mpz_set(bar, z);
+	MulAdd(bar, alpha, z_Delta);
+	if (lhs != Commit(lej.v, bar, false))
+		return false;
+
+	// check $F_n = e \prod_{i=1}^n (m_i - x)$
+	mpz_mul(foo, e, x);
+	mpz_mod(foo, foo, q);
+	if (!mpz_invert(bar, e, q))
+		return false;
+	mpz_set_ui(foo2, 1L);
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_sub(bar2, f[i], foo);
+		mpz_mul(bar2, bar2, foo2);
+		mpz_mod(bar2, bar2, q);
+		if (i > 0)
+		{
+			mpz_add(bar2, bar2, f_Delta[i - 1]);
+			mpz_mul(bar2, bar2, bar);
+			mpz_mod(bar2, bar2, q);
+		}
+		mpz_set(foo2, bar2);
+	}
+	mpz_set(foo2, e);
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_sub(foo, m[i], x);
+		mpz_mul(foo2, foo2, foo);
+		mpz_mod(foo2, foo2, q);
+	}
+	return !mpz_cmp(foo2, bar2);
+}
+
+void CECShuffle::Prove_noninteractive(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+	const TMCG_StackSecret<VTMF_CardSecret> &ss, std::ostream &out) const
+{
+	assert(s.size() == n && s2.size() == n && ss.size() == n);
+	std::vector<CECCipher> e, E;
+	bool fOk = ReadStack(s, e) && ReadStack(s2, E);
+	assert(fOk);
+
+	CMpzVector R(n), d(n), f(n), m(n), t(n), k(6);
+	mpz_ptr r = k[0], R_d = k[1], r_d = k[2], Z = k[3], lambda = k[4], rho = k[5];
+	mpz_srcptr q = ECOrder();
+	std::vector<size_t> pi(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		// E_i = e_{\pi(i)} + E(0; R_i)
+		pi[i] = ss[i].first;
+		mpz_set(R[i], ss[ss[i].first].second.r);
+	}
+
+	// prover: first move
+	ECRandomScalar(r), ECRandomScalar(R_d), ECRandomScalar(r_d);
+	for (size_t i = 0; i < n; i++)
+	{
+		// 同 GrothVSSHE, d_i 存成负数
+		ECRandomScalar(d[i]);
+		mpz_neg(d[i], d[i]);
+		mpz_set_ui(m[i], pi[i] + 1L);
+	}
+	CECPoint c = Commit(m.v, r, true);
+	CECPoint c_d = Commit(d.v, r_d, true);
+	// $E_d = \sum_{i=1}^n -d_i E_i + E(0; R_d)$
+	std::vector<CECPoint> v1, v2;
+	for (size_t i = 0; i < n; i++)
+	{
+		v1.push_back(ECMulSecret(E[i].first, d[i]));
+		v2.push_back(ECMulSecret(E[i].second, d[i]));
+	}
+	v1.push_back(ECMulG(R_d));
+	v2.push_back(ECMulSecret(h, R_d));
+	CECCipher E_d(ECSum(v1), ECSum(v2));
+	ECWritePoint(out, c), ECWritePoint(out, c_d), ECWritePoint(out, E_d.first), ECWritePoint(out, E_d.second);
+
+	// prover: second move
+	CECHashWriter hasher("poker ec shuffle");
+	hasher.Write((uint64_t)n).Write(h);
+	for (size_t i = 0; i < n; i++)
+		hasher.Write(e[i].first).Write(e[i].second).Write(E[i].first).Write(E[i].second);
+	hasher.Write(c).Write(c_d).Write(E_d.first).Write(E_d.second);
+	for (size_t i = 0; i < n; i++)
+	{
+		CECHashWriter hasher_t = hasher;
+		hasher_t.Write((uint64_t)i).GetChallenge(t[i], l_e_nizk);
+	}
+
+	// prover: third move
+	for (size_t i = 0; i < n; i++)
+	{
+		// $f_i = t_{\pi(i)} + d_i$
+		mpz_sub(f[i], t[pi[i]], d[i]);
+		mpz_mod(f[i], f[i], q);
+		out << f[i] << std::endl;
+		hasher.Write(f[i]);
+	}
+	// $Z = \sum_{i=1}^n t_{\pi(i)} R_i + R_d$
+	mpz_set(Z, R_d);
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_addmul(Z, t[pi[i]], R[i]);
+		mpz_mod(Z, Z, q);
+	}
+	out << Z << std::endl;
+
+	// prover: fourth move
+	hasher.Write(Z).GetChallenge(lambda, l_e_nizk);
+
+	// prover: fifth to seventh move (Shuffle of Known Content)
+	// $\rho = \lambda r + r_d$, $c^{\lambda} c_d \mathrm{com}(f; 0)$ 的内容是 $m_{\pi(i)}$
+	mpz_set(rho, lambda);
+	MulAdd(rho, r, r_d);
+	for (size_t i = 0; i < n; i++)
+	{
+		// $m_i = i \lambda + t_i$
+		mpz_set_ui(m[i], i + 1L);
+		MulAdd(m[i], lambda, t[i]);
+	}
+	ProveSKC(pi, rho, m.v, hasher, out);
+}
+
+bool CECShuffle::Verify_noninteractive(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+	std::istream &in) const
+{
+	if (!n || s.size() != n || s2.size() != n)
+		return false;
+	std::vector<CECCipher> e, E;
+	if (!ReadStack(s, e) || !ReadStack(s2, E))
+		return false;
+
+	CMpzVector f(n), m(n), t(n), k(3);
+	mpz_ptr Z = k[0], lambda = k[1], foo = k[2];
+	mpz_srcptr q = ECOrder();
+
+	// verifier: first move
+	CECPoint c, c_d;
+	CECCipher E_d;
+	if (!ECReadPoint(in, c) || !ECReadPoint(in, c_d) || !ECReadPoint(in, E_d.first) || !ECReadPoint(in, E_d.second))
+		return false;
+
+	// verifier: second move
+	CECHashWriter hasher("poker ec shuffle");
+	hasher.Write((uint64_t)n).Write(h);
+	for (size_t i = 0; i < n; i++)
+		hasher.Write(e[i].first).Write(e[i].second).Write(E[i].first).Write(E[i].second);
+	hasher.Write(c).Write(c_d).Write(E_d.first).Write(E_d.second);
+	for (size_t i = 0; i < n; i++)
+	{
+		CECHashWriter hasher_t = hasher;
+		hasher_t.Write((uint64_t)i).GetChallenge(t[i], l_e_nizk);
+	}
+
+	// verifier: third move
+	for (size_t i = 0; i < n; i++)
+	{
+		// check whether $2^{\ell_e} \le f_i < n$
+		if (!ECReadScalar(in, f[i]) || mpz_sizeinbase(f[i], 2L) < l_e_nizk)
+			return false;
+		hasher.Write(f[i]);
+	}
+	if (!ECReadScalar(in, Z) || !mpz_sgn(Z))
+		return false;
+
+	// verifier: fourth move
+	hasher.Write(Z).GetChallenge(lambda, l_e_nizk);
+
+	// verifier: fifth to seventh move (Shuffle of Known Content)
+	// SKC 的承诺 $c^{\lambda} c_d$, com(f; 0) 在 VerifySKC 里合并计算
+	CECPoint cc = ECAdd(ECMul(c, lambda), c_d);
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_set_ui(m[i], i + 1L);
+		MulAdd(m[i], lambda, t[i]);
+	}
+	if (!VerifySKC(cc, f.v, m.v, hasher, in))
+		return false;
+
+	// check whether $\sum_{i=1}^n -t_i e_i + \sum_{i=1}^n f_i E_i + E_d - E(0; Z) = 0$
+	std::vector<CECPoint> v1, v2;
+	for (size_t i = 0; i < n; i++)
+	{
+		mpz_sub(foo, q, t[i]);
+		v1.push_back(ECMul(e[i].first, foo));
+		v2.push_back(ECMul(e[i].second, foo));
+		v1.push_back(ECMul(E[i].first, f[i]));
+		v2.push_back(ECMul(E[i].second, f[i]));
+	}
+	v1.push_back(E_d.first);
+	v2.push_back(E_d.second);
+	mpz_sub(foo, q, Z);
+	v1.push_back(ECMulG(foo));
+	v2.push_back(ECMul(h, foo));
+	return ECSum(v1).fInfinity && ECSum(v2).fInfinity;
+}
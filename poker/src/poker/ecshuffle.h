@@ -0,0 +1,53 @@
+#ifndef POKER_EC_SHUFFLE_H
+#define POKER_EC_SHUFFLE_H
+
+#include "ecvtmf.h"
+
+#include <iostream>
+#include <vector>
+
+/**
+ * secp256k1 上的 Groth 洗牌证明(非交互), 对应 GrothVSSHE
+ *
+ * GrothVSSHE / GrothSKC 的 Prove_noninteractive, Verify_noninteractive 移植到 EC:
+ * 群乘法换成点加, 幂换成点乘, 证明由 Fiat-Shamir 得到的挑战取 2 * TMCG_GROTH_L_E 位.
+ * Pedersen 承诺的生成元按下标 hash 到曲线上, 主动方不用生成, 被动方也不用检查(CheckGroup);
+ * 除了牌数只有公钥 h 需要在牌桌上确认.
+ */
+class CECShuffle
+{
+private:
+	std::vector<CECPoint> g;		//承诺生成元 g_1, ..., g_n
+	CECPoint hcom;				//承诺随机数的生成元
+	size_t l_e_nizk;
+
+	void SetupGenerators();
+
+	/** com(m; r) = r hcom + sum m_i g_i, fSecret 时 m 和 r 是秘密的 */
+	CECPoint Commit(const std::vector<mpz_ptr> &m, mpz_srcptr r, bool fSecret) const;
+
+	/** 已知内容的洗牌(GrothSKC): 承诺是 m_pi(1), ..., m_pi(n), 随机数 r */
+	void ProveSKC(const std::vector<size_t> &pi, mpz_srcptr r, const std::vector<mpz_ptr> &m,
+		CECHashWriter hasher, std::ostream &out) const;
+	/** c + com(f_prime; 0) 的承诺是 m 的一个排列, 对应 GrothSKC 的优化版本 */
+	bool VerifySKC(const CECPoint &c, const std::vector<mpz_ptr> &f_prime, const std::vector<mpz_ptr> &m,
+		CECHashWriter hasher, std::istream &in) const;
+
+public:
+	size_t n;
+	CECPoint h;	//ElGamal 公钥
+
+	CECShuffle(size_t nIn, const CECPoint &hIn);
+	/** 被动方: 读 PublishGroup 的输出, 格式错误时 n 为 0 */
+	CECShuffle(std::istream &in);
+
+	void PublishGroup(std::ostream &out) const;
+
+	/** s2 由 CECVTMF::MixStack(s, s2, ss) 得到 */
+	void Prove_noninteractive(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+		const TMCG_StackSecret<VTMF_CardSecret> &ss, std::ostream &out) const;
+	bool Verify_noninteractive(const TMCG_Stack<VTMF_Card> &s, const TMCG_Stack<VTMF_Card> &s2,
+		std::istream &in) const;
+};
+
+#endif // POKER_EC_SHUFFLE_H
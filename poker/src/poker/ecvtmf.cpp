@@ -0,0 +1,496 @@
+#include "ecvtmf.h"
+#include "crypto/common.h"
+#include "random.h"
+#include "support/cleanse.h"
+
+#include <secp256k1_ecdh.h>
+
+#include <assert.h>
+#include <string.h>
+
+bool fPokerECGroup = DEFAULT_POKER_EC_GROUP;
+
+// 只读使用, 可以多线程共享
+static const secp256k1_context *GetECContext()
+{
+	static secp256k1_context *ctx = []() {
+		secp256k1_context *c = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+		unsigned char seed[32];
+		GetRandBytes(seed, 32);
+		int ret = secp256k1_context_randomize(c, seed);
+		assert(ret);
+		memory_cleanse(seed, 32);
+		return c;
+	}();
+	return ctx;
+}
+
+// k mod n 的 32 字节大端编码
+static void ScalarBytes(unsigned char out[32], mpz_srcptr k)
+{
+	mpz_t foo;
+	mpz_init(foo);
+	mpz_mod(foo, k, ECOrder());
+	unsigned char buf[32];
+	size_t count = 0;
+	mpz_export(buf, &count, 1, 1, 1, 0, foo);
+	memset(out, 0, 32);
+	memcpy(out + 32 - count, buf, count);
+	memory_cleanse(buf, 32);
+	mpz_clear(foo);
+}
+
+bool CECPoint::SetMpz(mpz_srcptr v)
+{
+	fInfinity = true;
+	if (!mpz_sgn(v))
+		return true;
+	if (mpz_sgn(v) < 0 || mpz_sizeinbase(v, 2) > 33 * 8)
+		return false;
+	unsigned char buf[33];
+	size_t count = 0;
+	mpz_export(buf, &count, 1, 1, 1, 0, v);
+	if (count != 33 || (buf[0] != 0x02 && buf[0] != 0x03))
+		return false;
+	if (!secp256k1_ec_pubkey_parse(GetECContext(), &pk, buf, 33))
+		return false;
+	fInfinity = false;
+	return true;
+}
+
+void CECPoint::GetMpz(mpz_ptr v) const
+{
+	if (fInfinity)
+	{
+		mpz_set_ui(v, 0L);
+		return ;
+	}
+	std::string bytes = GetBytes();
+	mpz_import(v, bytes.size(), 1, 1, 1, 0, bytes.data());
+}
+
+std::string CECPoint::GetBytes() const
+{
+	unsigned char buf[33];
+	memset(buf, 0, 33);
+	if (!fInfinity)
+	{
+		size_t len = 33;
+		secp256k1_ec_pubkey_serialize(GetECContext(), buf, &len, &pk, SECP256K1_EC_COMPRESSED);
+	}
+	return std::string((const char*)buf, 33);
+}
+
+bool CECPoint::operator==(const CECPoint &b) const
+{
+	if (fInfinity || b.fInfinity)
+		return fInfinity == b.fInfinity;
+	return GetBytes() == b.GetBytes();
+}
+
+mpz_srcptr ECOrder()
+{
+	static mpz_t n;
+	static bool fInit = [] {
+		mpz_init_set_str(n, "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", 16);
+		return true;
+	}();
+	(void)fInit;
+	return n;
+}
+
+bool ECIsScalar(mpz_srcptr k)
+{
+	return mpz_sgn(k) >= 0 && mpz_cmp(k, ECOrder()) < 0;
+}
+
+void ECRandomScalar(mpz_ptr k)
+{
+	mpz_srandomm(k, ECOrder());
+}
+
+CECPoint ECMulG(mpz_srcptr k)
+{
+	CECPoint R;
+	unsigned char buf[32];
+	ScalarBytes(buf, k);
+	R.fInfinity = !secp256k1_ec_pubkey_create(GetECContext(), &R.pk, buf);
+	memory_cleanse(buf, 32);
+	return R;
+}
+
+CECPoint ECMul(const CECPoint &P, mpz_srcptr k)
+{
+	CECPoint R = P;
+	if (R.fInfinity)
+		return R;
+	unsigned char buf[32];
+	ScalarBytes(buf, k);
+	// k = 0 时失败, 结果是无穷远点
+	R.fInfinity = !secp256k1_ec_pubkey_tweak_mul(GetECContext(), &R.pk, buf);
+	memory_cleanse(buf, 32);
+	return R;
+}
+
+CECPoint ECMulSecret(const CECPoint &P, mpz_srcptr k)
+{
+	CECPoint R = P;
+	if (R.fInfinity)
+		return R;
+	unsigned char buf[32];
+	ScalarBytes(buf, k);
+	// ecmult_const(ECDH 模块)是常数时间的; k = 0 时失败, 结果是无穷远点
+	R.fInfinity = !secp256k1_ecdh_point(GetECContext(), &R.pk, &P.pk, buf);
+	memory_cleanse(buf, 32);
+	return R;
+}
+
+CECPoint ECAdd(const CECPoint &a, const CECPoint &b)
+{
+	if (a.fInfinity)
+		return b;
+	if (b.fInfinity)
+		return a;
+	CECPoint R;
+	const secp256k1_pubkey *ins[2] = { &a.pk, &b.pk };
+	// 和为无穷远点时失败
+	R.fInfinity = !secp256k1_ec_pubkey_combine(GetECContext(), &R.pk, ins, 2);
+	return R;
+}
+
+CECPoint ECSum(const std::vector<CECPoint> &v)
+{
+	std::vector<const secp256k1_pubkey*> ins;
+	for (auto &P : v)
+	{
+		if (!P.fInfinity)
+			ins.push_back(&P.pk);
+	}
+	CECPoint R;
+	if (!ins.empty())
+		R.fInfinity = !secp256k1_ec_pubkey_combine(GetECContext(), &R.pk, ins.data(), ins.size());
+	return R;
+}
+
+CECPoint ECNeg(const CECPoint &a)
+{
+	CECPoint R = a;
+	if (!R.fInfinity)
+		secp256k1_ec_pubkey_negate(GetECContext(), &R.pk);
+	return R;
+}
+
+CECPoint ECHashToPoint(const std::string &tag, uint32_t i)
+{
+	CECPoint R;
+	for (uint32_t ctr = 0; R.fInfinity; ctr++)
+	{
+		// x = H(tag, i, ctr), 一半的 x 是曲线上的点
+		unsigned char buf[33];
+		unsigned char le[8];
+		WriteLE32(le, i), WriteLE32(le + 4, ctr);
+		CSHA256().Write((const unsigned char*)tag.data(), tag.size()).Write(le, 8).Finalize(buf + 1);
+		buf[0] = 0x02;
+		if (secp256k1_ec_pubkey_parse(GetECContext(), &R.pk, buf, 33))
+			R.fInfinity = false;
+	}
+	return R;
+}
+
+void ECWritePoint(std::ostream &out, const CECPoint &P)
+{
+	mpz_t v;
+	mpz_init(v);
+	P.GetMpz(v);
+	out << v << std::endl;
+	mpz_clear(v);
+}
+
+bool ECReadPoint(std::istream &in, CECPoint &P)
+{
+	mpz_t v;
+	mpz_init(v);
+	in >> v;
+	bool ret = in.good() && P.SetMpz(v);
+	mpz_clear(v);
+	return ret;
+}
+
+bool ECReadScalar(std::istream &in, mpz_ptr k)
+{
+	in >> k;
+	return in.good() && ECIsScalar(k);
+}
+
+CECHashWriter::CECHashWriter(const std::string &tag)
+{
+	Write((uint64_t)tag.size());
+	sha.Write((const unsigned char*)tag.data(), tag.size());
+}
+
+CECHashWriter &CECHashWriter::Write(const CECPoint &P)
+{
+	std::string bytes = P.GetBytes();
+	sha.Write((const unsigned char*)bytes.data(), bytes.size());
+	return *this;
+}
+
+CECHashWriter &CECHashWriter::Write(mpz_srcptr k)
+{
+	std::vector<unsigned char> buf((mpz_sizeinbase(k, 2) + 7) / 8 + 1);
+	size_t count = 0;
+	mpz_export(buf.data(), &count, 1, 1, 1, 0, k);
+	Write((uint64_t)count);
+	unsigned char sign = mpz_sgn(k) < 0;
+	sha.Write(&sign, 1);
+	sha.Write(buf.data(), count);
+	return *this;
+}
+
+CECHashWriter &CECHashWriter::Write(uint64_t v)
+{
+	unsigned char le[8];
+	WriteLE64(le, v);
+	sha.Write(le, 8);
+	return *this;
+}
+
+void CECHashWriter::GetChallenge(mpz_ptr c, size_t nBits) const
+{
+	assert(nBits <= 256);
+	CSHA256 copy = sha;
+	unsigned char hash[CSHA256::OUTPUT_SIZE];
+	copy.Finalize(hash);
+	mpz_import(c, CSHA256::OUTPUT_SIZE, 1, 1, 1, 0, hash);
+	mpz_tdiv_r_2exp(c, c, nBits);
+}
+
+void CECHashWriter::GetScalar(mpz_ptr c) const
+{
+	// 256 位 mod n, 偏差约 2^-128
+	GetChallenge(c, 256);
+	mpz_mod(c, c, ECOrder());
+}
+
+CECVTMF::CECVTMF(size_t nTypesIn) : nTypes(nTypesIn)
+{
+	mpz_init(x_i);
+	mpz_t m;
+	mpz_init(m);
+	for (size_t t = 0; t < nTypes; t++)
+	{
+		mpz_set_ui(m, t + 1);
+		message_index[ECMulG(m).GetBytes()] = t;
+	}
+	mpz_clear(m);
+}
+
+CECVTMF::~CECVTMF()
+{
+	mpz_set_ui(x_i, 0L);
+	mpz_clear(x_i);
+}
+
+void CECVTMF::KeyGenerationProtocol_GenerateKey()
+{
+	do
+		ECRandomScalar(x_i);
+	while (!mpz_sgn(x_i));
+	h_i = ECMulG(x_i);
+	h = h_i;
+	h_j.clear();
+}
+
+void CECVTMF::KeyGenerationProtocol_PublishKey(std::ostream &out) const
+{
+	// Schnorr 证明知道 x_i: a = w G, c = H(h_i, a), r = w - c x_i
+	mpz_t w, c, r;
+	mpz_init(w), mpz_init(c), mpz_init(r);
+	ECRandomScalar(w);
+	CECPoint a = ECMulG(w);
+	CECHashWriter("poker ec key").Write(h_i).Write(a).GetScalar(c);
+	mpz_mul(r, c, x_i);
+	mpz_sub(r, w, r);
+	mpz_mod(r, r, ECOrder());
+	ECWritePoint(out, h_i);
+	out << c << std::endl << r << std::endl;
+	mpz_set_ui(w, 0L);
+	mpz_clear(w), mpz_clear(c), mpz_clear(r);
+}
+
+bool CECVTMF::KeyGenerationProtocol_UpdateKey(std::istream &in)
+{
+	CECPoint key;
+	mpz_t c, r, foo;
+	mpz_init(c), mpz_init(r), mpz_init(foo);
+
+	bool ret = false;
+	do
+	{
+		if (!ECReadPoint(in, key) || !ECReadScalar(in, c) || !ECReadScalar(in, r))
+			break;
+		// 无穷远点或已有的公钥会抵消其他人的公钥
+		std::string fp = key.GetBytes();
+		if (key.fInfinity || key == h_i || h_j.count(fp))
+			break;
+		CECPoint a = ECAdd(ECMulG(r), ECMul(key, c));
+		CECHashWriter("poker ec key").Write(key).Write(a).GetScalar(foo);
+		if (mpz_cmp(foo, c))
+			break;
+		h_j[fp] = key;
+		h = ECAdd(h, key);
+		ret = true;
+	}while(0);
+
+	mpz_clear(c), mpz_clear(r), mpz_clear(foo);
+	return ret;
+}
+
+void CECVTMF::CreateOpenCard(VTMF_Card &c, size_t type) const
+{
+	assert(type < nTypes);
+	mpz_t m;
+	mpz_init_set_ui(m, type + 1);
+	mpz_set_ui(c.c_1, 0L);
+	ECMulG(m).GetMpz(c.c_2);
+	mpz_clear(m);
+}
+
+void CECVTMF::CreateStackSecret(TMCG_StackSecret<VTMF_CardSecret> &ss, size_t size) const
+{
+	assert(size > 0 && size <= TMCG_MAX_CARDS);
+
+	// Knuth 洗牌, 与 libTMCG 的 random_permutation_fast 相同
+	std::vector<size_t> pi;
+	for (size_t i = 0; i < size; i++)
+		pi.push_back(i);
+	for (size_t i = 0; i < (size - 1); i++)
+		std::swap(pi[i], pi[i + (size_t)mpz_srandom_mod(size - i)]);
+
+	ss.clear();
+	for (size_t i = 0; i < size; i++)
+	{
+		VTMF_CardSecret cs;
+		ECRandomScalar(cs.r);
+		ss.push(pi[i], cs);
+	}
+}
+
+void CECVTMF::MaskCard(const VTMF_Card &c, VTMF_Card &cc, const VTMF_CardSecret &cs) const
+{
+	CECPoint c_1, c_2;
+	bool fOk = c_1.SetMpz(c.c_1) && c_2.SetMpz(c.c_2);
+	assert(fOk);
+	ECAdd(c_1, ECMulG(cs.r)).GetMpz(cc.c_1);
+	ECAdd(c_2, ECMulSecret(h, cs.r)).GetMpz(cc.c_2);
+}
+
+void CECVTMF::MixStack(const TMCG_Stack<VTMF_Card> &s, TMCG_Stack<VTMF_Card> &s2, const TMCG_StackSecret<VTMF_CardSecret> &ss) const
+{
+	assert(s.size() == ss.size());
+	s2.clear();
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		VTMF_Card c;
+		MaskCard(s[ss[i].first], c, ss[ss[i].first].second);
+		s2.push(c);
+	}
+}
+
+void CECVTMF::VerifiableDecryptionProtocol_Prove(mpz_srcptr c_1, std::ostream &out) const
+{
+	CECPoint c1;
+	bool fOk = c1.SetMpz(c_1);
+	assert(fOk);
+	CECPoint d_i = ECMulSecret(c1, x_i);
+
+	// Chaum-Pedersen 证明 log_G h_i = log_c1 d_i: a = w G, b = w c_1, c = H(...), r = w - c x_i
+	mpz_t w, c, r;
+	mpz_init(w), mpz_init(c), mpz_init(r);
+	ECRandomScalar(w);
+	CECPoint a = ECMulG(w), b = ECMulSecret(c1, w);
+	CECHashWriter("poker ec share").Write(h_i).Write(c1).Write(d_i).Write(a).Write(b).GetScalar(c);
+	mpz_mul(r, c, x_i);
+	mpz_sub(r, w, r);
+	mpz_mod(r, r, ECOrder());
+	ECWritePoint(out, d_i), ECWritePoint(out, h_i);
+	out << c << std::endl << r << std::endl;
+	mpz_set_ui(w, 0L);
+	mpz_clear(w), mpz_clear(c), mpz_clear(r);
+}
+
+bool CECVTMF::VerifyShare(const CECPoint &c1, std::istream &in, CECPoint &d_j) const
+{
+	CECPoint key;
+	mpz_t c, r, foo;
+	mpz_init(c), mpz_init(r), mpz_init(foo);
+
+	bool ret = false;
+	do
+	{
+		if (!ECReadPoint(in, d_j) || !ECReadPoint(in, key) || !ECReadScalar(in, c) || !ECReadScalar(in, r))
+			break;
+		auto it = h_j.find(key.GetBytes());
+		if (it == h_j.end())
+			break;
+		CECPoint a = ECAdd(ECMulG(r), ECMul(it->second, c));
+		CECPoint b = ECAdd(ECMul(c1, r), ECMul(d_j, c));
+		CECHashWriter("poker ec share").Write(it->second).Write(c1).Write(d_j).Write(a).Write(b).GetScalar(foo);
+		ret = !mpz_cmp(foo, c);
+	}while(0);
+
+	mpz_clear(c), mpz_clear(r), mpz_clear(foo);
+	return ret;
+}
+
+void CECVTMF::VerifiableDecryptionProtocol_Verify_Initialize(mpz_srcptr c_1)
+{
+	CECPoint c1;
+	bool fOk = c1.SetMpz(c_1);
+	assert(fOk);
+	d = ECMulSecret(c1, x_i);
+}
+
+bool CECVTMF::VerifiableDecryptionProtocol_Verify_Update(mpz_srcptr c_1, std::istream &in)
+{
+	CECPoint c1, d_j;
+	if (!c1.SetMpz(c_1) || !VerifyShare(c1, in, d_j))
+		return false;
+	d = ECAdd(d, d_j);
+	return true;
+}
+
+bool CECVTMF::VerifiableDecryptionProtocol_Verify_Batch(const std::vector<mpz_srcptr> &c_1, const std::vector<std::istream*> &in,
+	std::vector<bool> &result) const
+{
+	assert(c_1.size() == in.size());
+
+	// 每个份额验证只要 4 次点乘, 不再做小指数批量验证
+	bool ret = true;
+	result.assign(in.size(), false);
+	for (size_t i = 0; i < in.size(); i++)
+	{
+		CECPoint c1, d_j;
+		result[i] = c1.SetMpz(c_1[i]) && VerifyShare(c1, *in[i], d_j);
+		ret = ret && result[i];
+	}
+	return ret;
+}
+
+void CECVTMF::VerifiableDecryptionProtocol_Verify_Accumulate(std::istream &in)
+{
+	CECPoint d_j;
+	if (ECReadPoint(in, d_j))
+		d = ECAdd(d, d_j);
+}
+
+size_t CECVTMF::TypeOfCard(const VTMF_Card &c) const
+{
+	CECPoint c2;
+	if (!c2.SetMpz(c.c_2))
+		return nTypes;
+	auto it = message_index.find(ECAdd(c2, ECNeg(d)).GetBytes());
+	if (it == message_index.end())
+		return nTypes;
+	return it->second;
+}
@@ -0,0 +1,139 @@
+#ifndef POKER_EC_VTMF_H
+#define POKER_EC_VTMF_H
+
+#include "crypto/sha256.h"
+
+#include <libTMCG.hh>
+#include <secp256k1.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/** secp256k1 牌桌的群句柄(PC_POKER_HANDLE), 代替 BarnettSmartVTMF_dlog::PublishGroup 的输出 */
+static const char * const POKER_EC_GROUP = "secp256k1";
+/** 默认新牌桌用 dlog 群, 旧节点不认识 secp256k1 句柄 */
+static const bool DEFAULT_POKER_EC_GROUP = false;
+
+extern bool fPokerECGroup;
+
+/**
+ * secp256k1 上的点
+ *
+ * secp256k1_pubkey 表示不了无穷远点(群的单位元), 用 fInfinity 单独标记.
+ * 放进 VTMF_Card 和 libTMCG 的流时, 把压缩编码(33 字节)按大端当作整数, 无穷远点为 0.
+ */
+class CECPoint
+{
+public:
+	bool fInfinity;
+	secp256k1_pubkey pk;
+
+	CECPoint() : fInfinity(true) {}
+
+	/** 不是合法的点时返回 false */
+	bool SetMpz(mpz_srcptr v);
+	void GetMpz(mpz_ptr v) const;
+
+	/** 压缩编码, 无穷远点为 33 个 0 */
+	std::string GetBytes() const;
+
+	bool operator==(const CECPoint &b) const;
+	bool operator!=(const CECPoint &b) const { return !(*this == b); }
+};
+
+/** 群的阶 n, 标量都在 [0, n) */
+mpz_srcptr ECOrder();
+bool ECIsScalar(mpz_srcptr k);
+void ECRandomScalar(mpz_ptr k);
+
+/** k G, 常数时间 */
+CECPoint ECMulG(mpz_srcptr k);
+/** k P, 可变时间, 只用于公开的标量 */
+CECPoint ECMul(const CECPoint &P, mpz_srcptr k);
+/** k P, 秘密标量, 常数时间(secp256k1_ecdh_point) */
+CECPoint ECMulSecret(const CECPoint &P, mpz_srcptr k);
+CECPoint ECAdd(const CECPoint &a, const CECPoint &b);
+CECPoint ECSum(const std::vector<CECPoint> &v);
+CECPoint ECNeg(const CECPoint &a);
+/** 按 (tag, i) 用 hash 找点, 没有人知道它们之间的离散对数 */
+CECPoint ECHashToPoint(const std::string &tag, uint32_t i);
+
+/** 按 libTMCG 的流格式(文本或二进制, 见 TMCG_ParseHelper::set_binary)读写点和标量, 读取格式错误时返回 false */
+void ECWritePoint(std::ostream &out, const CECPoint &P);
+bool ECReadPoint(std::istream &in, CECPoint &P);
+bool ECReadScalar(std::istream &in, mpz_ptr k);
+
+/** Fiat-Shamir 的 hash, 点和标量都带长度写入 */
+class CECHashWriter
+{
+private:
+	CSHA256 sha;
+
+public:
+	CECHashWriter(const std::string &tag);
+
+	CECHashWriter &Write(const CECPoint &P);
+	CECHashWriter &Write(mpz_srcptr k);
+	CECHashWriter &Write(uint64_t v);
+
+	/** 取 nBits(<= 256) 位的挑战, 不改变已写入的内容 */
+	void GetChallenge(mpz_ptr c, size_t nBits) const;
+	/** 取模 n 的挑战 */
+	void GetScalar(mpz_ptr c) const;
+};
+
+/**
+ * secp256k1 上的 VTMF(EC-ElGamal), 接口与 BarnettSmartVTMF_dlog 对应
+ *
+ * 牌是 (c_1, c_2) = (r G, M + r h), 第 t 种牌的明文 M = (t + 1) G, 解密后查表.
+ * 点按 CECPoint::GetMpz 存在 VTMF_Card 的 c_1, c_2 里, 牌堆的序列化和牌局流程不用改;
+ * 随机数存在 VTMF_CardSecret::r. 公钥和解密份额用 Schnorr / Chaum-Pedersen 证明.
+ */
+class CECVTMF
+{
+private:
+	mpz_t x_i;
+	std::map<std::string, CECPoint> h_j;			//其他玩家的公钥, 按压缩编码
+	CECPoint d;									//解密份额之和
+	std::map<std::string, size_t> message_index;	//明文的压缩编码 -> 牌型
+	size_t nTypes;
+
+	bool VerifyShare(const CECPoint &c_1, std::istream &in, CECPoint &d_j) const;
+
+public:
+	CECPoint h_i, h;
+
+	CECVTMF(size_t nTypesIn);
+	~CECVTMF();
+
+	void KeyGenerationProtocol_GenerateKey();
+	void KeyGenerationProtocol_PublishKey(std::ostream &out) const;
+	bool KeyGenerationProtocol_UpdateKey(std::istream &in);
+	/** 公钥在 UpdateKey 时已经累加, 与 dlog 的流程对应 */
+	void KeyGenerationProtocol_Finalize() {}
+
+	void CreateOpenCard(VTMF_Card &c, size_t type) const;
+	void CreateStackSecret(TMCG_StackSecret<VTMF_CardSecret> &ss, size_t size) const;
+	/** cc = c + (r G, r h) */
+	void MaskCard(const VTMF_Card &c, VTMF_Card &cc, const VTMF_CardSecret &cs) const;
+	/** s2[i] = s[ss[i].first] 重新加密, 随机数用 ss[ss[i].first].second, 与 SchindelhauerTMCG 相同 */
+	void MixStack(const TMCG_Stack<VTMF_Card> &s, TMCG_Stack<VTMF_Card> &s2, const TMCG_StackSecret<VTMF_CardSecret> &ss) const;
+
+	/** 解密份额 d_i = x_i c_1 和证明 */
+	void VerifiableDecryptionProtocol_Prove(mpz_srcptr c_1, std::ostream &out) const;
+	/** 从自己的份额开始累加 */
+	void VerifiableDecryptionProtocol_Verify_Initialize(mpz_srcptr c_1);
+	bool VerifiableDecryptionProtocol_Verify_Update(mpz_srcptr c_1, std::istream &in);
+	/** 逐个验证, 不累加; 全部通过返回 true */
+	bool VerifiableDecryptionProtocol_Verify_Batch(const std::vector<mpz_srcptr> &c_1, const std::vector<std::istream*> &in,
+		std::vector<bool> &result) const;
+	/** 累加 Verify_Batch 通过的份额 */
+	void VerifiableDecryptionProtocol_Verify_Accumulate(std::istream &in);
+
+	/** 用累加的份额解密, 不是合法的牌时返回 nTypes */
+	size_t TypeOfCard(const VTMF_Card &c) const;
+};
+
+#endif // POKER_EC_VTMF_H
@@ -0,0 +1,306 @@
+#include "grouppool.h"
+#include "hash.h"
+#include "init.h"
+#include "util.h"
+
+#include <libTMCG.hh>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+CPokerGroupPool pokerGroupPool;
+
+std::string PokerGroupHash(const BarnettSmartVTMF_dlog &vtmf)
+{
+	std::stringstream out;
+	vtmf.PublishGroup(out);
+	std::string group = out.str();
+	return Hash(group.begin(), group.end()).GetHex();
+}
+
+// 调用方持有 mutex
+void CPokerGroupPool::AddVerified(const std::string &hash)
+{
+	if (!setVerified.insert(hash).second)
+		return ;
+	queueVerified.push_back(hash);
+	while (queueVerified.size() > MAX_POKER_VERIFIED_GROUPS)
+	{
+		setVerified.erase(queueVerified.front());
+		queueVerified.pop_front();
+	}
+}
+
+// 调用方持有 mutex
+void CPokerGroupPool::WriteGroup(const std::string &hash, const std::string &group)
+{
+	if (pathDir.empty())
+		return ;
+
+	// 先写临时文件再改名, 避免读到半个文件
+	fs::path path = pathDir / "pool" / hash;
+	fs::path pathTmp = path;
+	pathTmp += ".tmp";
+	FILE *file = fsbridge::fopen(pathTmp, "wb");
+	if (!file)
+		return ;
+	bool fOk = fwrite(group.data(), 1, group.size(), file) == group.size();
+	fOk = (fclose(file) == 0) && fOk;
+	try {
+		if (fOk)
+			fs::rename(pathTmp, path);
+		else
+			fs::remove(pathTmp);
+	} catch (const fs::filesystem_error& e) {
+		std::cout << "poker group pool write " << hash << " failed : " << e.what() << std::endl;
+	}
+}
+
+void CPokerGroupPool::Init(size_t nTargetIn, const fs::path &pathDirIn, boost::thread_group *pThreadGroupIn)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	nTarget = nTargetIn;
+	pathDir = pathDirIn;
+	pThreadGroup = pThreadGroupIn;
+	if (pathDir.empty())
+		return ;
+
+	try {
+		fs::create_directories(pathDir / "pool");
+	} catch (const fs::filesystem_error& e) {
+		std::cout << "poker group pool disk disabled : " << e.what() << std::endl;
+		pathDir.clear();
+		return ;
+	}
+
+	// 已验证的群参数, 每行一个 hash
+	std::ifstream fileVerified((pathDir / "verified").string());
+	std::string line;
+	while (std::getline(fileVerified, line))
+	{
+		if (!line.empty())
+			AddVerified(line);
+	}
+	fileVerified.close();
+	if (!queueVerified.empty())
+	{
+		// 只保留最近的记录
+		std::ofstream out((pathDir / "verified").string(), std::ios::trunc);
+		for (auto &hash : queueVerified)
+			out << hash << std::endl;
+	}
+
+	// 预先生成的群参数, 文件名是参数的 hash
+	try {
+		std::vector<fs::path> vPath;
+		for (fs::directory_iterator it(pathDir / "pool"); it != fs::directory_iterator(); ++it)
+			vPath.push_back(it->path());
+		for (auto &path : vPath)
+		{
+			std::string hash = path.filename().string();
+			std::ifstream in(path.string());
+			std::stringstream group;
+			group << in.rdbuf();
+			in.close();
+			bool fOk = false;
+			if (path.extension() != ".tmp")
+			{
+				BarnettSmartVTMF_dlog vtmf(group, TMCG_DDH_SIZE, TMCG_DLSE_SIZE, false, false);
+				fOk = PokerGroupHash(vtmf) == hash;
+			}
+			if (!fOk || queueGroup.size() >= nTarget)
+			{
+				fs::remove(path);
+				continue;
+			}
+			queueGroup.push_back(std::make_pair(hash, group.str()));
+			AddVerified(hash);
+		}
+	} catch (const fs::filesystem_error& e) {
+		std::cout << "poker group pool load failed : " << e.what() << std::endl;
+	}
+	std::cout << "poker group pool loaded " << queueGroup.size() << " groups, " << setVerified.size() << " verified" << std::endl;
+}
+
+bool CPokerGroupPool::Take(std::string &group)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if (queueGroup.empty())
+		return false;
+	std::string hash = queueGroup.front().first;
+	group = queueGroup.front().second;
+	queueGroup.pop_front();
+	condRefill.notify_one();
+
+	if (!pathDir.empty())
+	{
+		try {
+			fs::remove(pathDir / "pool" / hash);
+		} catch (const fs::filesystem_error& e) {
+			std::cout << "poker group pool remove " << hash << " failed : " << e.what() << std::endl;
+		}
+	}
+	return true;
+}
+
+bool CPokerGroupPool::GetSession(std::string &group)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if (strSession.empty())
+		return false;
+	group = strSession;
+	return true;
+}
+
+void CPokerGroupPool::SetSession(const std::string &group)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	strSession = group;
+}
+
+bool CPokerGroupPool::IsVerified(const std::string &hash)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return setVerified.count(hash) > 0;
+}
+
+void CPokerGroupPool::MarkVerified(const std::string &hash)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if (setVerified.count(hash))
+		return ;
+	AddVerified(hash);
+	if (pathDir.empty())
+		return ;
+	std::ofstream out((pathDir / "verified").string(), std::ios::app);
+	out << hash << std::endl;
+}
+
+size_t CPokerGroupPool::Size()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return queueGroup.size();
+}
+
+static bool PokerGroupStop()
+{
+	return ShutdownRequested() || boost::this_thread::interruption_requested();
+}
+
+// 与 BarnettSmartVTMF_dlog() 生成群参数的方法相同(mpz_lprime, 随机 g),
+// 但每试一个素数候选都检查是否要退出, 退出时返回 false
+static bool GenerateGroup(std::string &group)
+{
+	const unsigned long int psize = TMCG_DDH_SIZE, qsize = TMCG_DLSE_SIZE;
+	mpz_t p, q, k, g, foo;
+	mpz_init(p), mpz_init(q), mpz_init(k), mpz_init(g), mpz_init(foo);
+	bool fOk = false;
+	do
+	{
+		// 素数 $q$
+		do
+			mpz_wrandomb(q, qsize);
+		while (!PokerGroupStop() && ((mpz_sizeinbase(q, 2L) < qsize) ||
+			!mpz_probab_prime_p(q, TMCG_MR_ITERATIONS)));
+		if (PokerGroupStop())
+			break;
+
+		// 偶数 $k$, 素数 $p = qk + 1$
+		do
+		{
+			do
+				mpz_wrandomb(k, psize - qsize);
+			while (mpz_sizeinbase(k, 2L) < (psize - qsize));
+			if (mpz_odd_p(k))
+				mpz_add_ui(k, k, 1L);
+			mpz_mul(p, q, k);
+			mpz_add_ui(p, p, 1L);
+			mpz_gcd(foo, k, q);
+		}
+		while (!PokerGroupStop() && (mpz_cmp_ui(foo, 1L) || (mpz_sizeinbase(p, 2L) < psize) ||
+			!mpz_probab_prime_p(p, TMCG_MR_ITERATIONS)));
+		if (PokerGroupStop())
+			break;
+
+		// 子群的生成元 $g = [bar]^k \bmod p$, $1 < g < p-1$
+		mpz_sub_ui(foo, p, 1L);
+		do
+		{
+			mpz_t bar;
+			mpz_init(bar);
+			mpz_wrandomm(bar, p);
+			mpz_powm(g, bar, k, p);
+			mpz_clear(bar);
+		}
+		while (!mpz_cmp_ui(g, 0L) || !mpz_cmp_ui(g, 1L) || !mpz_cmp(g, foo));
+
+		std::stringstream out;
+		out << p << std::endl << q << std::endl << g << std::endl << k << std::endl;
+		group = out.str();
+		fOk = true;
+	}
+	while (false);
+	mpz_clear(p), mpz_clear(q), mpz_clear(k), mpz_clear(g), mpz_clear(foo);
+	return fOk;
+}
+
+void CPokerGroupPool::Thread()
+{
+	while (true)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			while (queueGroup.size() >= nTarget)
+				condRefill.wait(lock);
+		}
+
+		// 生成群参数要几秒, 不持有锁
+		int64_t nStart = GetTimeMillis();
+		std::string group;
+		if (!GenerateGroup(group))
+		{
+			boost::this_thread::interruption_point();
+			return ;
+		}
+		std::stringstream in(group);
+		BarnettSmartVTMF_dlog vtmf(in);
+		if (!vtmf.CheckGroup())
+			continue;
+		std::stringstream out;
+		vtmf.PublishGroup(out);
+		std::string hash = PokerGroupHash(vtmf);
+		boost::this_thread::interruption_point();
+
+		boost::unique_lock<boost::mutex> lock(mutex);
+		queueGroup.push_back(std::make_pair(hash, out.str()));
+		WriteGroup(hash, out.str());
+		lock.unlock();
+		MarkVerified(hash);
+		std::cout << "poker group pool generated group " << hash << " in " << GetTimeMillis() - nStart << "ms" << std::endl;
+	}
+}
+
+static void ThreadPokerGroupPool()
+{
+	RenameThread("bitcoin-pokergrp");
+	pokerGroupPool.Thread();
+}
+
+void CPokerGroupPool::Start()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if (fStarted || !nTarget || !pThreadGroup)
+		return ;
+	fStarted = true;
+	pThreadGroup->create_thread(&ThreadPokerGroupPool);
+}
+
+void StartPokerGroupPool(boost::thread_group &threadGroup, int nGroups, bool fStartNow)
+{
+	nGroups = std::max(0, std::min(nGroups, MAX_POKER_GROUP_POOL));
+	pokerGroupPool.Init(nGroups, GetDataDir() / "pokergroups", &threadGroup);
+	if (fStartNow)
+		pokerGroupPool.Start();
+}
@@ -0,0 +1,84 @@
+#ifndef POKER_GROUP_POOL_H
+#define POKER_GROUP_POOL_H
+
+#include "fs.h"
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <set>
+#include <string>
+
+/** 默认预先生成的 vtmf 群参数个数, 0 = 不预先生成 */
+static const int DEFAULT_POKER_GROUP_POOL = 2;
+static const int MAX_POKER_GROUP_POOL = 64;
+/** 记住的已验证群参数个数 */
+static const size_t MAX_POKER_VERIFIED_GROUPS = 1024;
+
+class BarnettSmartVTMF_dlog;
+
+/** 群参数的 hash, 按 PublishGroup 的输出计算 */
+std::string PokerGroupHash(const BarnettSmartVTMF_dlog &vtmf);
+
+/**
+ * vtmf 群参数池
+ *
+ * 生成 2048 位的 p = qk + 1 群要几秒, 验证群(CheckGroup)也要做素性测试.
+ * 后台线程在空闲时生成群参数, 存在 datadir/pokergroups 下, 发起牌局时直接取用;
+ * 验证通过的群参数按 hash 记住(同样写入磁盘), 再次收到时不用重新验证.
+ */
+class CPokerGroupPool
+{
+private:
+	boost::mutex mutex;
+	boost::condition_variable condRefill;
+
+	std::deque<std::pair<std::string, std::string> > queueGroup;	//预先生成, 还没用过的(hash, 群参数)
+	std::set<std::string> setVerified;
+	std::deque<std::string> queueVerified;	//setVerified 的插入顺序, 超出上限时淘汰最早的
+	size_t nTarget;
+	fs::path pathDir;						//为空时不写磁盘
+	std::string strSession;					//本节点发起牌局沿用的群参数
+	boost::thread_group *pThreadGroup;		//Start 时在其中创建生成线程
+	bool fStarted;
+
+	void AddVerified(const std::string &hash);
+	void WriteGroup(const std::string &hash, const std::string &group);
+
+public:
+	CPokerGroupPool() : nTarget(0), pThreadGroup(nullptr), fStarted(false) {}
+
+	/** 读取磁盘上的群参数和已验证记录 */
+	void Init(size_t nTargetIn, const fs::path &pathDirIn, boost::thread_group *pThreadGroupIn);
+
+	/** 启动后台生成线程, 只启动一次 */
+	void Start();
+
+	/** 取一个预先生成的群参数, 池为空时返回 false */
+	bool Take(std::string &group);
+
+	/**
+	 * 本节点上一局发起牌局用的群参数, 还没有时返回 false.
+	 * 各局沿用同一群参数, 只重新生成密钥, vsshe 的承诺生成元也可以沿用
+	 */
+	bool GetSession(std::string &group);
+	void SetSession(const std::string &group);
+
+	bool IsVerified(const std::string &hash);
+	void MarkVerified(const std::string &hash);
+
+	size_t Size();
+
+	/** 后台生成线程主循环 */
+	void Thread();
+};
+
+extern CPokerGroupPool pokerGroupPool;
+
+/**
+ * 读取磁盘上的群参数池. fStartNow 为 false 时不马上生成,
+ * 等第一张 dlog 牌桌用到群参数时(tmcg::PublishGroup/VTMF_dlog)才开始填充
+ */
+void StartPokerGroupPool(boost::thread_group &threadGroup, int nGroups, bool fStartNow);
+
+#endif // POKER_GROUP_POOL_H
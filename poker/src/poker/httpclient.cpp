@@ -0,0 +1,256 @@
+#include "httpclient.h"
+
+#include <algorithm>
+
+CPokerHttpClient pokerHttpClient;
+
+static size_t httpWrite(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+	std::string *str = (std::string*)stream;
+	str->append((char*)ptr, size * nmemb);
+	return size * nmemb;
+}
+
+std::string CPokerHttpClient::Endpoint(const std::string &url)
+{
+	size_t pos = url.find("://");
+	pos = (pos == std::string::npos) ? 0 : pos + 3;
+	return url.substr(0, url.find('/', pos));
+}
+
+CPokerHttpClient::CPokerHttpClient() : multi(nullptr)
+{
+}
+
+CPokerHttpClient::~CPokerHttpClient()
+{
+	// 静态析构时其他线程都已退出, 不加锁: DEBUG_LOCKORDER 的锁记录可能已经先析构了
+	if (multi)
+		curl_multi_cleanup(multi);
+	for (auto &it : mapIdle)
+	{
+		for (CURL *curl : it.second)
+			curl_easy_cleanup(curl);
+	}
+}
+
+void CPokerHttpClient::Clear()
+{
+	{
+		LOCK(cs_multi);
+		if (multi)
+			curl_multi_cleanup(multi);
+		multi = nullptr;
+	}
+	LOCK(cs);
+	for (auto &it : mapIdle)
+	{
+		for (CURL *curl : it.second)
+			curl_easy_cleanup(curl);
+	}
+	mapIdle.clear();
+}
+
+CURL *CPokerHttpClient::Acquire(const std::string &endpoint)
+{
+	CURL *curl = nullptr;
+	{
+		LOCK(cs);
+		std::vector<CURL*> &vIdle = mapIdle[endpoint];
+		if (!vIdle.empty())
+		{
+			curl = vIdle.back();
+			vIdle.pop_back();
+		}
+	}
+
+	// reset 会清掉选项, 但保留连接缓存, 所以连接可以复用
+	if (curl)
+		curl_easy_reset(curl);
+	else
+		curl = curl_easy_init();
+	if (!curl)
+		return nullptr;
+
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, POKER_HTTP_TIMEOUT);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, POKER_HTTP_TIMEOUT);
+	curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+	curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+	return curl;
+}
+
+void CPokerHttpClient::Release(const std::string &endpoint, CURL *curl)
+{
+	{
+		LOCK(cs);
+		std::vector<CURL*> &vIdle = mapIdle[endpoint];
+		if (vIdle.size() < POKER_HTTP_MAX_IDLE)
+		{
+			vIdle.push_back(curl);
+			return ;
+		}
+	}
+	curl_easy_cleanup(curl);
+}
+
+void CPokerHttpClient::Record(const std::string &endpoint, CURL *curl, CURLcode res)
+{
+	double dTotal = 0;
+	long nConnects = 0;
+	curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &dTotal);
+	curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &nConnects);
+	uint64_t nMicros = (uint64_t)(dTotal * 1000000);
+
+	LOCK(cs);
+	PokerHttpStats &stats = mapStats[endpoint];
+	++stats.nRequests;
+	if (res != CURLE_OK)
+		++stats.nFailures;
+	stats.nConnects += nConnects;
+	stats.nTotalMicros += nMicros;
+	stats.nMaxMicros = std::max(stats.nMaxMicros, nMicros);
+}
+
+void CPokerHttpClient::SetupGet(CURL *curl, const std::string &url, std::string &response)
+{
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, httpWrite);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
+	curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L); // http >= 400 算失败, 不要把错误信息当成数据
+}
+
+CURLcode CPokerHttpClient::Get(const std::string &url, std::string &response)
+{
+	const std::string endpoint = Endpoint(url);
+	CURL *curl = Acquire(endpoint);
+	if (!curl)
+		return CURLE_FAILED_INIT;
+
+	SetupGet(curl, url, response);
+	CURLcode res = curl_easy_perform(curl);
+	Record(endpoint, curl, res);
+	Release(endpoint, curl);
+	return res;
+}
+
+CURLcode CPokerHttpClient::Post(const std::string &url, const std::string &postParams, const std::string &filepath, std::string &response)
+{
+	const std::string endpoint = Endpoint(url);
+	CURL *curl = Acquire(endpoint);
+	if (!curl)
+		return CURLE_FAILED_INIT;
+
+	curl_easy_setopt(curl, CURLOPT_POST, 1L);
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postParams.c_str());
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, httpWrite);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
+
+	struct curl_httppost* post = NULL;
+	struct curl_httppost* last = NULL;
+	if (!filepath.empty()) {
+		curl_formadd(&post, &last, CURLFORM_COPYNAME, "uploadfile", CURLFORM_FILE, filepath.c_str(), CURLFORM_END);
+		curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+	}
+
+	CURLcode res = curl_easy_perform(curl);
+	Record(endpoint, curl, res);
+	Release(endpoint, curl);
+	if (post)
+		curl_formfree(post);
+	return res;
+}
+
+CURLcode CPokerHttpClient::PostBuffer(const std::string &url, const std::string &name, const std::string &filename, const std::string &data, std::string &response)
+{
+	const std::string endpoint = Endpoint(url);
+	CURL *curl = Acquire(endpoint);
+	if (!curl)
+		return CURLE_FAILED_INIT;
+
+	// BUFFERPTR 不拷贝数据, data 在 perform 结束前一直有效
+	struct curl_httppost* post = NULL;
+	struct curl_httppost* last = NULL;
+	curl_formadd(&post, &last,
+		CURLFORM_COPYNAME, name.c_str(),
+		CURLFORM_BUFFER, filename.c_str(),
+		CURLFORM_BUFFERPTR, data.data(),
+		CURLFORM_BUFFERLENGTH, (long)data.size(),
+		CURLFORM_END);
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, httpWrite);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
+	curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+	CURLcode res = curl_easy_perform(curl);
+	Record(endpoint, curl, res);
+	Release(endpoint, curl);
+	curl_formfree(post);
+	return res;
+}
+
+void CPokerHttpClient::GetMulti(const std::vector<std::string> &urls, std::vector<std::string> &responses, std::vector<CURLcode> &codes)
+{
+	responses.assign(urls.size(), std::string());
+	codes.assign(urls.size(), CURLE_FAILED_INIT);
+	if (urls.empty())
+		return ;
+
+	// 批量请求的连接缓存在 multi 句柄上, 保留 multi 句柄以便下一批复用连接
+	LOCK(cs_multi);
+	if (!multi)
+	{
+		multi = curl_multi_init();
+		if (!multi)
+			return ;
+		curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, POKER_HTTP_MAX_HOST_CONNECTIONS);
+	}
+
+	std::vector<CURL*> vCurl(urls.size(), nullptr);
+	std::map<CURL*, size_t> mapIndex;
+	for (size_t i = 0; i < urls.size(); ++i)
+	{
+		CURL *curl = Acquire(Endpoint(urls[i]));
+		if (!curl)
+			continue;
+		SetupGet(curl, urls[i], responses[i]);
+		curl_multi_add_handle(multi, curl);
+		vCurl[i] = curl;
+		mapIndex[curl] = i;
+	}
+
+	int nRunning = 0;
+	do {
+		if (curl_multi_perform(multi, &nRunning) != CURLM_OK)
+			break;
+		if (nRunning > 0)
+			curl_multi_wait(multi, NULL, 0, 1000, NULL);
+
+		CURLMsg *msg;
+		int nQueued;
+		while ((msg = curl_multi_info_read(multi, &nQueued)))
+		{
+			if (msg->msg == CURLMSG_DONE && mapIndex.count(msg->easy_handle))
+				codes[mapIndex[msg->easy_handle]] = msg->data.result;
+		}
+	} while (nRunning > 0);
+
+	for (size_t i = 0; i < urls.size(); ++i)
+	{
+		if (!vCurl[i])
+			continue;
+		curl_multi_remove_handle(multi, vCurl[i]);
+		const std::string endpoint = Endpoint(urls[i]);
+		Record(endpoint, vCurl[i], codes[i]);
+		Release(endpoint, vCurl[i]);
+	}
+}
+
+std::map<std::string, PokerHttpStats> CPokerHttpClient::GetStats()
+{
+	LOCK(cs);
+	return mapStats;
+}
@@ -0,0 +1,75 @@
+#ifndef POKER_HTTP_CLIENT_H
+#define POKER_HTTP_CLIENT_H
+
+#include "sync.h"
+
+#include "curl/curl.h"
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** 每个地址最多保留的空闲句柄数 */
+static const size_t POKER_HTTP_MAX_IDLE = 8;
+/** 批量请求时每个地址的最大并发连接数 */
+static const long POKER_HTTP_MAX_HOST_CONNECTIONS = 8;
+/** 连接/传输超时(秒) */
+static const long POKER_HTTP_TIMEOUT = 20;
+
+struct PokerHttpStats
+{
+	PokerHttpStats() : nRequests(0), nFailures(0), nConnects(0), nTotalMicros(0), nMaxMicros(0) {}
+	uint64_t nRequests;
+	uint64_t nFailures;
+	uint64_t nConnects;		//新建的 tcp 连接数, 小于请求数说明连接被复用
+	uint64_t nTotalMicros;
+	uint64_t nMaxMicros;
+};
+
+/**
+ * http 客户端
+ *
+ * 按地址(scheme://host:port)缓存 curl 句柄, 句柄复用时保留 keep-alive 连接.
+ * GetMulti 用 curl_multi 并发发出一批 GET 请求.
+ */
+class CPokerHttpClient
+{
+private:
+	CCriticalSection cs;
+	std::map<std::string, std::vector<CURL*> > mapIdle;
+	std::map<std::string, PokerHttpStats> mapStats;
+	CCriticalSection cs_multi;
+	CURLM *multi;
+
+	CURL *Acquire(const std::string &endpoint);
+	void Release(const std::string &endpoint, CURL *curl);
+	void Record(const std::string &endpoint, CURL *curl, CURLcode res);
+	void SetupGet(CURL *curl, const std::string &url, std::string &response);
+
+public:
+	CPokerHttpClient();
+	~CPokerHttpClient();
+
+	CURLcode Get(const std::string &url, std::string &response);
+
+	/** POST, filepath 不为空时以 multipart 上传文件 */
+	CURLcode Post(const std::string &url, const std::string &postParams, const std::string &filepath, std::string &response);
+
+	/** multipart POST, 直接从内存上传 data(CURLFORM_BUFFER), 不经过磁盘文件 */
+	CURLcode PostBuffer(const std::string &url, const std::string &name, const std::string &filename, const std::string &data, std::string &response);
+
+	/** 并发 GET, responses/codes 与 urls 一一对应 */
+	void GetMulti(const std::vector<std::string> &urls, std::vector<std::string> &responses, std::vector<CURLcode> &codes);
+
+	std::map<std::string, PokerHttpStats> GetStats();
+
+	/** 释放所有空闲句柄 */
+	void Clear();
+
+	static std::string Endpoint(const std::string &url);
+};
+
+extern CPokerHttpClient pokerHttpClient;
+
+#endif // POKER_HTTP_CLIENT_H
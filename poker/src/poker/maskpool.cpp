@@ -0,0 +1,103 @@
+#include "maskpool.h"
+#include "util.h"
+
+bool fPokerMaskPool = DEFAULT_POKER_MASK_POOL;
+
+void CPokerMaskPool::Thread()
+{
+	RenameThread("bitcoin-pokermask");
+	int64_t nStart = GetTimeMillis();
+	while (true)
+	{
+		boost::this_thread::interruption_point();
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			if (queueMask.size() >= nTarget)
+				break;
+		}
+
+		// 计算时不持有锁, 只读 vtmf 的预计算表
+		std::unique_ptr<CPokerMask> mask(new CPokerMask());
+		vtmf->VerifiableRemaskingProtocol_Precompute(mask->r, mask->g_r, mask->h_r);
+
+		boost::unique_lock<boost::mutex> lock(mutex);
+		queueMask.push_back(std::move(mask));
+	}
+	LogPrint(BCLog::BENCH, "poker mask pool precomputed %u masks in %dms\n", nTarget, GetTimeMillis() - nStart);
+}
+
+void CPokerMaskPool::Start(const BarnettSmartVTMF_dlog *vtmfIn, size_t nTargetIn)
+{
+	Stop();
+	vtmf = vtmfIn;
+	nTarget = nTargetIn;
+	thread = boost::thread(&CPokerMaskPool::Thread, this);
+}
+
+void CPokerMaskPool::Stop()
+{
+	if (thread.joinable())
+	{
+		thread.interrupt();
+		thread.join();
+	}
+	boost::unique_lock<boost::mutex> lock(mutex);
+	queueMask.clear();
+	vtmf = nullptr;
+	nTarget = 0;
+}
+
+size_t CPokerMaskPool::GetReadyCount()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return queueMask.size();
+}
+
+bool CPokerMaskPool::Take(TMCG_StackSecret<VTMF_CardSecret> &ss, std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+	std::vector<std::unique_ptr<CPokerMask> > &vMask)
+{
+	std::vector<mpz_ptr> rand;
+	if (!Take(ss.size(), rand, masks, vMask))
+		return false;
+	for (size_t i = 0; i < ss.size(); i++)
+		mpz_set(ss[i].second.r, rand[i]);
+	return true;
+}
+
+bool CPokerMaskPool::Take(size_t n, std::vector<mpz_ptr> &rand, std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+	std::vector<std::unique_ptr<CPokerMask> > &vMask)
+{
+	// 线程停下后 queueMask 不再变化
+	if (thread.joinable())
+	{
+		thread.interrupt();
+		thread.join();
+	}
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if (queueMask.empty())
+		return false;
+
+	size_t nReady = std::min(queueMask.size(), n);
+	rand.clear();
+	masks.clear();
+	vMask.clear();
+	for (size_t i = 0; i < n; i++)
+	{
+		std::unique_ptr<CPokerMask> mask;
+		if (!queueMask.empty())
+		{
+			mask = std::move(queueMask.front());
+			queueMask.pop_front();
+		}
+		else
+		{
+			mask.reset(new CPokerMask());
+			vtmf->VerifiableRemaskingProtocol_Precompute(mask->r, mask->g_r, mask->h_r);
+		}
+		rand.push_back(mask->r);
+		masks.push_back(std::make_pair((mpz_ptr)mask->g_r, (mpz_ptr)mask->h_r));
+		vMask.push_back(std::move(mask));
+	}
+	LogPrint(BCLog::BENCH, "poker mask pool: %u of %u masks precomputed\n", nReady, n);
+	return true;
+}
@@ -0,0 +1,79 @@
+#ifndef POKER_MASK_POOL_H
+#define POKER_MASK_POOL_H
+
+#include <boost/thread.hpp>
+
+#include <libTMCG.hh>
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** 默认在等待其他玩家时预先计算重新加密用的随机数 */
+static const bool DEFAULT_POKER_MASK_POOL = true;
+
+extern bool fPokerMaskPool;
+
+/** 一组预先计算的 (r, g^r, h^r) */
+struct CPokerMask
+{
+	mpz_t r, g_r, h_r;
+
+	CPokerMask() { mpz_init(r); mpz_init(g_r); mpz_init(h_r); }
+	~CPokerMask() { mpz_clear(r); mpz_clear(g_r); mpz_clear(h_r); }
+
+private:
+	CPokerMask(const CPokerMask &);
+	CPokerMask &operator=(const CPokerMask &);
+};
+
+/**
+ * 牌桌的重新加密随机数池
+ *
+ * 洗牌时每张牌要算 g^r 和 h^r(VerifiableRemaskingProtocol_Remask), 它们与牌无关,
+ * 联合公钥 h 确定(KeyGenerationProtocol_Finalize)后就可以算. 轮到别人洗牌时
+ * 后台线程预先算好 nTarget 组, 自己洗牌时取出, 打乱牌堆只剩乘法; 多出的几组给洗牌证明的承诺用.
+ * 后台线程只读 vtmf 的预计算表, 调用方要在释放 vtmf 之前 Stop.
+ */
+class CPokerMaskPool
+{
+private:
+	boost::mutex mutex;
+	boost::thread thread;
+	const BarnettSmartVTMF_dlog *vtmf;
+	size_t nTarget;
+	std::deque<std::unique_ptr<CPokerMask> > queueMask;
+
+	void Thread();
+
+public:
+	CPokerMaskPool() : vtmf(nullptr), nTarget(0) {}
+	~CPokerMaskPool() { Stop(); }
+
+	/** 按 vtmfIn 的当前公钥开始预先计算 nTargetIn 组, 之前的结果丢弃 */
+	void Start(const BarnettSmartVTMF_dlog *vtmfIn, size_t nTargetIn);
+
+	/** 停止后台线程并丢弃结果 */
+	void Stop();
+
+	/** 已经算好的组数 */
+	size_t GetReadyCount();
+
+	/**
+	 * 停止后台线程, 把 ss 的随机数换成预先计算的值, masks[j] 为 ss[j] 对应的 (g^r, h^r),
+	 * vMask 持有 masks 指向的数据. 不够的当场计算; 一组都没有时返回 false, ss 不变.
+	 */
+	bool Take(TMCG_StackSecret<VTMF_CardSecret> &ss, std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+		std::vector<std::unique_ptr<CPokerMask> > &vMask);
+
+	/**
+	 * 同上, 取出 n 组给洗牌证明(TMCG_ProveStackEquality_Groth_noninteractive)用,
+	 * rand[j] 为随机数, masks[j] 为对应的 (g^r, h^r). Pedersen 承诺的 h 就是联合公钥,
+	 * h^r 可以直接用.
+	 */
+	bool Take(size_t n, std::vector<mpz_ptr> &rand, std::vector<std::pair<mpz_ptr, mpz_ptr> > &masks,
+		std::vector<std::unique_ptr<CPokerMask> > &vMask);
+};
+
+#endif // POKER_MASK_POOL_H
@@ -0,0 +1,156 @@
+#include "payloadcache.h"
+#include "payloadstore.h"
+
+#include <iostream>
+#include <stdio.h>
+
+CPokerPayloadCache pokerPayloadCache;
+
+bool IsValidPayloadHash(const std::string &hash)
+{
+	if(hash.empty() || hash.size() > 128)
+		return false;
+	for(char c : hash)
+	{
+		if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')))
+			return false;
+	}
+	return true;
+}
+
+CPokerPayloadCache::CPokerPayloadCache() : nMaxBytes(DEFAULT_POKER_PAYLOAD_CACHE << 20), nBytes(0)
+{
+	stats = PokerPayloadCacheStats();
+}
+
+void CPokerPayloadCache::Init(size_t nMaxBytesIn, const fs::path &pathDiskIn)
+{
+	LOCK(cs);
+	nMaxBytes = nMaxBytesIn;
+	pathDisk = pathDiskIn;
+	if(!pathDisk.empty())
+	{
+		try {
+			fs::create_directories(pathDisk);
+		} catch (const fs::filesystem_error& e) {
+			std::cout << "poker payload cache disk disabled : " << e.what() << std::endl;
+			pathDisk.clear();
+		}
+	}
+}
+
+fs::path CPokerPayloadCache::DiskPath(const std::string &hash) const
+{
+	return pathDisk / hash;
+}
+
+static bool readDiskPayload(const fs::path &path, std::string &data)
+{
+	FILE *file = fsbridge::fopen(path, "rb");
+	if(!file)
+		return false;
+	char buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), file)) > 0)
+		data.append(buf, n);
+	bool fError = ferror(file);
+	fclose(file);
+	return !fError && !data.empty();
+}
+
+// 调用方持有 cs
+void CPokerPayloadCache::Insert(const std::string &hash, const std::string &payload)
+{
+	if(mapPayload.count(hash) || payload.size() > nMaxBytes)
+		return ;
+
+	listLru.emplace_front(hash, payload);
+	mapPayload[hash] = listLru.begin();
+	nBytes += payload.size();
+
+	while(nBytes > nMaxBytes && !listLru.empty())
+	{
+		auto &back = listLru.back();
+		nBytes -= back.second.size();
+		mapPayload.erase(back.first);
+		listLru.pop_back();
+		++stats.nEvictions;
+	}
+}
+
+bool CPokerPayloadCache::Get(const std::string &hash, std::string &payload)
+{
+	fs::path path;
+	{
+		LOCK(cs);
+		auto it = mapPayload.find(hash);
+		if(it != mapPayload.end())
+		{
+			listLru.splice(listLru.begin(), listLru, it->second);
+			payload = it->second->second;
+			++stats.nHits;
+			return true;
+		}
+		if(!pathDisk.empty() && IsValidPayloadHash(hash))
+			path = DiskPath(hash);
+	}
+
+	// 读磁盘不持有 cs, 读出的内容重新计算 hash, 文件损坏或被改动时当作未命中
+	std::string data;
+	if(!path.empty() && readDiskPayload(path, data) && ComputePayloadHash(data) == hash)
+	{
+		LOCK(cs);
+		Insert(hash, data);
+		payload.swap(data);
+		++stats.nDiskHits;
+		return true;
+	}
+
+	LOCK(cs);
+	++stats.nMisses;
+	return false;
+}
+
+void CPokerPayloadCache::Put(const std::string &hash, const std::string &payload)
+{
+	if(payload.empty() || !IsValidPayloadHash(hash))
+		return ;
+
+	fs::path path;
+	{
+		LOCK(cs);
+		Insert(hash, payload);
+		if(pathDisk.empty())
+			return ;
+		path = DiskPath(hash);
+	}
+
+	// 写磁盘不持有 cs
+	try {
+		if(fs::exists(path))
+			return ;
+
+		// 先写临时文件再改名, 避免读到半个文件; 临时文件名随机, 同一 hash 并发写入互不影响
+		fs::path pathTmp = path.parent_path() / fs::unique_path(hash + ".%%%%%%%%.tmp");
+		FILE *file = fsbridge::fopen(pathTmp, "wb");
+		if(!file)
+			return ;
+		bool fOk = fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+		fOk = (fclose(file) == 0) && fOk;
+		if(fOk)
+			fs::rename(pathTmp, path);
+		else
+			fs::remove(pathTmp);
+	} catch (const fs::filesystem_error& e) {
+		std::cout << "poker payload cache write " << hash << " failed : " << e.what() << std::endl;
+	}
+}
+
+PokerPayloadCacheStats CPokerPayloadCache::GetStats()
+{
+	LOCK(cs);
+	PokerPayloadCacheStats ret = stats;
+	ret.nEntries = mapPayload.size();
+	ret.nBytes = nBytes;
+	return ret;
+}
@@ -0,0 +1,65 @@
+#ifndef POKER_PAYLOAD_CACHE_H
+#define POKER_PAYLOAD_CACHE_H
+
+#include "fs.h"
+#include "sync.h"
+
+#include <list>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+/** 默认内存缓存大小(MiB) */
+static const int64_t DEFAULT_POKER_PAYLOAD_CACHE = 16;
+/** 默认不写磁盘 */
+static const bool DEFAULT_POKER_PAYLOAD_DISK = false;
+
+struct PokerPayloadCacheStats
+{
+	uint64_t nHits;		//内存命中
+	uint64_t nDiskHits;	//磁盘命中
+	uint64_t nMisses;	//未命中, 需要访问 ipfs
+	uint64_t nEvictions;
+	size_t nEntries;
+	size_t nBytes;
+};
+
+/**
+ * ipfs 数据缓存
+ *
+ * 以 ipfs hash 为键, 内存中按 LRU 淘汰, 可选写入 datadir 下的目录.
+ * ipfs 内容不可变, 所以不需要失效处理. 磁盘读写不持有锁, 从磁盘读出的数据要校验 hash.
+ */
+class CPokerPayloadCache
+{
+private:
+	typedef std::list<std::pair<std::string, std::string> > PayloadList;
+
+	CCriticalSection cs;
+	PayloadList listLru;	//队首为最近使用
+	std::unordered_map<std::string, PayloadList::iterator> mapPayload;
+	size_t nMaxBytes;
+	size_t nBytes;
+	fs::path pathDisk;	//为空时不写磁盘
+	PokerPayloadCacheStats stats;
+
+	void Insert(const std::string &hash, const std::string &payload);
+	fs::path DiskPath(const std::string &hash) const;
+
+public:
+	CPokerPayloadCache();
+
+	void Init(size_t nMaxBytesIn, const fs::path &pathDiskIn);
+
+	bool Get(const std::string &hash, std::string &payload);
+	void Put(const std::string &hash, const std::string &payload);
+
+	PokerPayloadCacheStats GetStats();
+};
+
+extern CPokerPayloadCache pokerPayloadCache;
+
+/** ipfs hash 只允许字母和数字(同时用作磁盘文件名) */
+bool IsValidPayloadHash(const std::string &hash);
+
+#endif // POKER_PAYLOAD_CACHE_H
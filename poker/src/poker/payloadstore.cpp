@@ -0,0 +1,226 @@
+#include "payloadstore.h"
+#include "poker.h"
+#include "httpclient.h"
+#include "payloadcache.h"
+
+#include "base58.h"
+#include "crypto/sha256.h"
+#include "dbwrapper.h"
+#include "util.h"
+
+#include <sstream>
+
+std::unique_ptr<CPokerPayloadStore> g_pokerstore;
+
+// ipfs add 默认参数: size-262144 分块, 每个节点最多 174 个链接
+static const size_t IPFS_CHUNK_SIZE = 262144;
+static const size_t IPFS_MAX_LINKS = 174;
+
+static const char DB_PAYLOAD = 'p';
+
+static void pbVarint(std::string &out, uint64_t n)
+{
+	while (n >= 0x80) {
+		out.push_back((char)((n & 0x7f) | 0x80));
+		n >>= 7;
+	}
+	out.push_back((char)n);
+}
+
+static void pbBytes(std::string &out, unsigned char tag, const std::string &bytes)
+{
+	out.push_back((char)tag);
+	pbVarint(out, bytes.size());
+	out.append(bytes);
+}
+
+static std::string sha256Multihash(const std::string &node)
+{
+	unsigned char hash[CSHA256::OUTPUT_SIZE];
+	CSHA256().Write((const unsigned char*)node.data(), node.size()).Finalize(hash);
+	std::string mh;
+	mh.push_back((char)0x12); // sha2-256
+	mh.push_back((char)CSHA256::OUTPUT_SIZE);
+	mh.append((const char*)hash, sizeof(hash));
+	return mh;
+}
+
+// dag-pb 叶子节点: PBNode{Data: unixfs.Data{Type: File, Data: chunk, filesize}}
+static std::string leafNode(const std::string &chunk)
+{
+	std::string unixfs;
+	unixfs.push_back((char)0x08);
+	unixfs.push_back((char)0x02);
+	if (!chunk.empty())
+		pbBytes(unixfs, 0x12, chunk);
+	unixfs.push_back((char)0x18);
+	pbVarint(unixfs, chunk.size());
+
+	std::string node;
+	pbBytes(node, 0x0a, unixfs);
+	return node;
+}
+
+std::string ComputePayloadHash(const std::string &data)
+{
+	if (data.size() <= IPFS_CHUNK_SIZE)
+	{
+		std::string mh = sha256Multihash(leafNode(data));
+		return EncodeBase58(std::vector<unsigned char>(mh.begin(), mh.end()));
+	}
+
+	size_t nChunks = (data.size() + IPFS_CHUNK_SIZE - 1) / IPFS_CHUNK_SIZE;
+	if (nChunks > IPFS_MAX_LINKS)
+		return std::string();
+
+	// 根节点: 链接在前(dag-pb 编码顺序), 然后是 unixfs.Data{Type: File, filesize, blocksizes}
+	std::string links;
+	std::string unixfs;
+	unixfs.push_back((char)0x08);
+	unixfs.push_back((char)0x02);
+	unixfs.push_back((char)0x18);
+	pbVarint(unixfs, data.size());
+
+	for (size_t i = 0; i < nChunks; ++i)
+	{
+		std::string chunk = data.substr(i * IPFS_CHUNK_SIZE, IPFS_CHUNK_SIZE);
+		std::string leaf = leafNode(chunk);
+
+		std::string link;
+		pbBytes(link, 0x0a, sha256Multihash(leaf));
+		pbBytes(link, 0x12, std::string());
+		link.push_back((char)0x18);
+		pbVarint(link, leaf.size());
+		pbBytes(links, 0x12, link);
+
+		unixfs.push_back((char)0x20);
+		pbVarint(unixfs, chunk.size());
+	}
+
+	std::string root = links;
+	pbBytes(root, 0x0a, unixfs);
+	std::string mh = sha256Multihash(root);
+	return EncodeBase58(std::vector<unsigned char>(mh.begin(), mh.end()));
+}
+
+
+void CPokerPayloadStore::GetMany(const std::vector<std::string> &hashes, std::vector<std::string> &datas)
+{
+	datas.assign(hashes.size(), std::string());
+	for (size_t i = 0; i < hashes.size(); ++i)
+		Get(hashes[i], datas[i]);
+}
+
+
+// ipfs add 返回一行或多行 json, 取最后一个带 Hash 的对象
+static bool parseIpfsAddResponse(const std::string &response, std::string &hash)
+{
+	std::istringstream stream(response);
+	std::string line;
+	hash.clear();
+	while (std::getline(stream, line))
+	{
+		if (line.empty())
+			continue;
+		try {
+			json obj = json::parse(line);
+			if (obj.is_object() && obj.count("Hash") && obj["Hash"].is_string())
+				hash = obj["Hash"].get<std::string>();
+		} catch (const std::exception &e) {
+			std::cerr << "ipfs add: bad response " << e.what() << std::endl;
+			return false;
+		}
+	}
+	return IsValidPayloadHash(hash);
+}
+
+bool CIpfsPayloadStore::Put(const std::string &data, std::string &hash)
+{
+	std::string response;
+	auto res = pokerHttpClient.PostBuffer("http://localhost:5001/api/v0/add", "uploadfile", "msg.txt", data, response);
+	if (res != CURLE_OK)
+	{
+		std::cerr << "curl post failed: " + std::string(curl_easy_strerror(res)) << std::endl;
+		return false;
+	}
+	if (!parseIpfsAddResponse(response, hash))
+	{
+		std::cerr << "ipfs add: no hash in response " << response << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool CIpfsPayloadStore::Get(const std::string &hash, std::string &data)
+{
+	std::string url = "http://localhost:5001/api/v0/cat?arg=" + hash;
+	std::cout << "url : " << url << std::endl;
+	auto ret = curl_get_req(url, data);
+	if (ret != CURLE_OK)
+	{
+		std::cerr << "curl get failed: " + std::string(curl_easy_strerror(ret)) << std::endl;
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+void CIpfsPayloadStore::GetMany(const std::vector<std::string> &hashes, std::vector<std::string> &datas)
+{
+	std::vector<std::string> urls;
+	for (auto &hash : hashes)
+		urls.push_back("http://localhost:5001/api/v0/cat?arg=" + hash);
+
+	std::vector<CURLcode> codes;
+	pokerHttpClient.GetMulti(urls, datas, codes);
+	for (size_t i = 0; i < codes.size(); ++i)
+	{
+		if (codes[i] != CURLE_OK)
+		{
+			std::cerr << "curl get " << hashes[i] << " failed: " + std::string(curl_easy_strerror(codes[i])) << std::endl;
+			datas[i].clear();
+		}
+	}
+}
+
+CLevelDBPayloadStore::CLevelDBPayloadStore(const fs::path &path, size_t nCacheSize, bool fMemory, bool fWipe)
+	: db(new CDBWrapper(path, nCacheSize, fMemory, fWipe))
+{
+}
+
+CLevelDBPayloadStore::~CLevelDBPayloadStore()
+{
+}
+
+bool CLevelDBPayloadStore::Put(const std::string &data, std::string &hash)
+{
+	hash = ComputePayloadHash(data);
+	if (hash.empty())
+		return false;
+	if (db->Exists(std::make_pair(DB_PAYLOAD, hash)))
+		return true;
+	return db->Write(std::make_pair(DB_PAYLOAD, hash), data);
+}
+
+bool CLevelDBPayloadStore::Get(const std::string &hash, std::string &data)
+{
+	if (!db->Read(std::make_pair(DB_PAYLOAD, hash), data))
+	{
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+
+bool InitPokerPayloadStore(const std::string &name)
+{
+	if (name == "ipfs")
+		g_pokerstore.reset(new CIpfsPayloadStore());
+	else if (name == "leveldb")
+		g_pokerstore.reset(new CLevelDBPayloadStore(GetDataDir() / "pokerstore", POKER_STORE_DB_CACHE));
+	else
+		return false;
+	std::cout << "poker payload store : " << g_pokerstore->GetName() << std::endl;
+	return true;
+}
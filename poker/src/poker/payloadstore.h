@@ -0,0 +1,73 @@
+#ifndef POKER_PAYLOAD_STORE_H
+#define POKER_PAYLOAD_STORE_H
+
+#include "fs.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class CDBWrapper;
+
+/** 默认使用本地 ipfs 节点 */
+static const char * const DEFAULT_POKER_STORE = "ipfs";
+/** leveldb 存储的缓存大小 */
+static const size_t POKER_STORE_DB_CACHE = 2 << 20;
+
+/**
+ * 牌局数据存储接口
+ *
+ * 牌局消息(json)按内容寻址保存, hash 与 "ipfs add" 的结果一致,
+ * 所以交易里写入的 hash 与具体存储后端无关.
+ */
+class CPokerPayloadStore
+{
+public:
+	virtual ~CPokerPayloadStore() {}
+
+	/** 保存数据, 成功时 hash 为内容 hash */
+	virtual bool Put(const std::string &data, std::string &hash) = 0;
+
+	/** 按 hash 读取数据 */
+	virtual bool Get(const std::string &hash, std::string &data) = 0;
+
+	/** 批量读取, 读取失败的位置为空串 */
+	virtual void GetMany(const std::vector<std::string> &hashes, std::vector<std::string> &datas);
+
+	virtual std::string GetName() const = 0;
+};
+
+/** 本地 ipfs 节点(http api, localhost:5001) */
+class CIpfsPayloadStore : public CPokerPayloadStore
+{
+public:
+	bool Put(const std::string &data, std::string &hash) override;
+	bool Get(const std::string &hash, std::string &data) override;
+	void GetMany(const std::vector<std::string> &hashes, std::vector<std::string> &datas) override;
+	std::string GetName() const override { return "ipfs"; }
+};
+
+/** 内嵌 leveldb, 不依赖 ipfs 节点 */
+class CLevelDBPayloadStore : public CPokerPayloadStore
+{
+private:
+	std::unique_ptr<CDBWrapper> db;
+
+public:
+	CLevelDBPayloadStore(const fs::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+	~CLevelDBPayloadStore();
+
+	bool Put(const std::string &data, std::string &hash) override;
+	bool Get(const std::string &hash, std::string &data) override;
+	std::string GetName() const override { return "leveldb"; }
+};
+
+/** 计算与 "ipfs add"(CIDv0, 256KiB 分块) 相同的 hash, 失败返回空串 */
+std::string ComputePayloadHash(const std::string &data);
+
+extern std::unique_ptr<CPokerPayloadStore> g_pokerstore;
+
+/** 按名字创建存储后端(ipfs / leveldb), 名字无效返回 false */
+bool InitPokerPayloadStore(const std::string &name);
+
+#endif // POKER_PAYLOAD_STORE_H
@@ -1,9 +1,29 @@
 #include "poker.h"
+#include "payloadcache.h"
+#include "payloadstore.h"
+#include "httpclient.h"
+#include "pokercodec.h"
+#include "betverifier.h"
+#include "ecshuffle.h"
+#include "grouppool.h"
+#include "maskpool.h"
+#include "pokertxindex.h"
+#include "reorderbuffer.h"
+#include "sshecache.h"
+#include "tablemanager.h"
+#include "verifypool.h"
+
+#ifdef ENABLE_WALLET
+#include "wallet/rpcwallet.h"
+#include "wallet/wallet.h"
+#endif
+#include <univalue.h>
 
 #ifdef WIN32
     #pragma comment(lib, "libcurl.lib")
 #endif
 
+
 tmcg::tmcg()
 {
 	assert(init_libTMCG());//检测运行环境
@@ -12,8 +32,12 @@ tmcg::tmcg()
 
 	tmcgOne = nullptr;
 	vtmfOne = nullptr;
-	vsshe 	= nullptr;
 	vtmf1 	= nullptr;
+	betVerifier.reset(new CBetChainVerifier());
+	maskPool.reset(new CPokerMaskPool());
+	txIndex.reset(new CPokerTxIndex());
+	fBinaryCards = fPokerBinaryCards;
+	fECGroup = fPokerECGroup;
 
 	s.clear();
 	flop.clear();
@@ -26,7 +50,6 @@ tmcg::tmcg()
 	TxTimeOutHash.clear();
 	mMatchAddress.clear();
 	vWinIndex.clear();
-	vFlopCardMsg.clear();
 	countRecv = 0;
 	PublicIndex = 0;
 	countVerify = 0;
@@ -44,9 +67,10 @@ tmcg::tmcg()
 
 tmcg::~tmcg()
 {
+	// 后台线程读 vtmfOne, 先停下
+	maskPool->Stop();
 	delete tmcgOne;
 	delete vtmfOne;
-	delete vsshe;
 	delete vtmf1;
 	s.clear();
 	flop.clear();
@@ -60,10 +84,35 @@ tmcg::~tmcg()
 }
 void tmcg::PublishGroup()//产生全局句柄(主动)
 {
-	vtmfOne = new BarnettSmartVTMF_dlog();
+	if (fECGroup)
+	{
+		// secp256k1 的群参数是固定的, 句柄只标明后端
+		ecvtmf.reset(new CECVTMF(DECKSIZE));
+		vtmf_str << POKER_EC_GROUP;
+		return ;
+	}
+
+	// 沿用本节点上一局的群参数, 这样 vsshe 的承诺生成元也能沿用(pokerSsheCache);
+	// 第一局优先用后台预先生成并验证过的群参数
+	pokerGroupPool.Start();
+	std::string group;
+	if (pokerGroupPool.GetSession(group) || pokerGroupPool.Take(group))
+	{
+		std::stringstream in(group);
+		vtmfOne = new BarnettSmartVTMF_dlog(in);
+	}
+	else
+		vtmfOne = new BarnettSmartVTMF_dlog();
 	tmcgOne = new SchindelhauerTMCG(64, playersize, 6);
-	assert(vtmfOne->CheckGroup());
+	tmcgOne->TMCG_SetWorkers(nPokerShuffleWorkers);
+	std::string hash = PokerGroupHash(*vtmfOne);
+	if (!pokerGroupPool.IsVerified(hash))
+	{
+		assert(vtmfOne->CheckGroup());
+		pokerGroupPool.MarkVerified(hash);
+	}
 	vtmfOne->PublishGroup(vtmf_str);
+	pokerGroupPool.SetSession(vtmf_str.str());
 
 }
 const std::string tmcg::getVtmfHandle()//返回句柄(仅在主动产生情况下被调用)
@@ -77,9 +126,35 @@ void tmcg::PublishGroup(std::string &vtmf)//初始化全局句柄(被动)
 
 bool tmcg::VTMF_dlog()
 {
+	if (vtmf_str.str() == POKER_EC_GROUP)
+	{
+		if (!ecvtmf)
+			ecvtmf.reset(new CECVTMF(DECKSIZE));
+		return true;
+	}
+
+	pokerGroupPool.Start();
 	tmcgOne = new SchindelhauerTMCG(64, playersize, 6);
+	tmcgOne->TMCG_SetWorkers(nPokerShuffleWorkers);
 	vtmfOne = new BarnettSmartVTMF_dlog(vtmf_str);
-	return vtmfOne->CheckGroup();
+	// 验证过的群参数不再做素性测试
+	std::string hash = PokerGroupHash(*vtmfOne);
+	if (pokerGroupPool.IsVerified(hash))
+		return true;
+	if (!vtmfOne->CheckGroup())
+		return false;
+	pokerGroupPool.MarkVerified(hash);
+	return true;
+}
+
+bool tmcg::HasGroup() const
+{
+	return vtmfOne || ecvtmf;
+}
+
+bool tmcg::HasSshe() const
+{
+	return vsshe || ecsshe;
 }
 
 void tmcg::createPublicKey(std::string &pubkey)
@@ -88,8 +163,16 @@ void tmcg::createPublicKey(std::string &pubkey)
 		return;
 	}
 	std::stringstream pubkeystr;
-	vtmfOne->KeyGenerationProtocol_GenerateKey();//创建公钥
-	vtmfOne->KeyGenerationProtocol_PublishKey(pubkeystr);//导出
+	if (ecvtmf)
+	{
+		ecvtmf->KeyGenerationProtocol_GenerateKey();
+		ecvtmf->KeyGenerationProtocol_PublishKey(pubkeystr);
+	}
+	else
+	{
+		vtmfOne->KeyGenerationProtocol_GenerateKey();//创建公钥
+		vtmfOne->KeyGenerationProtocol_PublishKey(pubkeystr);//导出
+	}
 	pubkey = pubkeystr.str();
 	creaetpukey = true;
 }
@@ -98,37 +181,91 @@ bool tmcg::verifyPubKey(const std::string &pubkey)//验证公钥
 {
 	std::stringstream pubkeyVerify;
 	pubkeyVerify << pubkey;
+	if (ecvtmf)
+		return ecvtmf->KeyGenerationProtocol_UpdateKey(pubkeyVerify);
 	return vtmfOne->KeyGenerationProtocol_UpdateKey(pubkeyVerify);
 }
 
 void tmcg::updatePubkey()//更新公钥
 {
+	if (ecvtmf)
+	{
+		ecvtmf->KeyGenerationProtocol_Finalize();
+		return ;
+	}
 	vtmfOne->KeyGenerationProtocol_Finalize();
+	// 联合公钥已确定, 等待其他玩家时预先计算洗牌用的随机数
+	if (fPokerMaskPool)
+		maskPool->Start(vtmfOne, DECKSIZE + TMCG_GROTH_PRECOMPUTED);
 }
 
 bool tmcg::createSshe()// 创建sshe(主动)
 {
-	vsshe = new GrothVSSHE(DECKSIZE, vtmfOne->p, vtmfOne->q, vtmfOne->k, vtmfOne->g, vtmfOne->h);
-	return vsshe->CheckGroup();
+	// 生成元由 hash 得到, 不用检查
+	if (ecvtmf)
+	{
+		ecsshe.reset(new CECShuffle(DECKSIZE, ecvtmf->h));
+		return true;
+	}
+
+	// 群参数没变时沿用之前验证过的承诺生成元, 只换公钥
+	vsshe = pokerSsheCache.Get(DECKSIZE, *vtmfOne);
+	if (vsshe)
+	{
+		vsshe->SetWorkers(nPokerShuffleWorkers);
+		return true;
+	}
+	vsshe.reset(new GrothVSSHE(DECKSIZE, vtmfOne->p, vtmfOne->q, vtmfOne->k, vtmfOne->g, vtmfOne->h));
+	vsshe->SetWorkers(nPokerShuffleWorkers);
+	if (!vsshe->CheckGroup())
+		return false;
+	pokerSsheCache.Add(*vsshe);
+	return true;
 }
 void tmcg::createSshe(std::string &sshestr)// 创建sshe(被动)
 {
+	if (ecvtmf)
+	{
+		std::stringstream in(sshestr);
+		ecsshe.reset(new CECShuffle(in));
+		return ;
+	}
 	std::stringstream msgStream;
 	msgStream << sshestr;
-	vsshe = new GrothVSSHE(DECKSIZE, msgStream);
+	vsshe.reset(new GrothVSSHE(DECKSIZE, msgStream));
+	vsshe->SetWorkers(nPokerShuffleWorkers);
 }
 void tmcg::educeSshe(std::string &sshekey)//导出sshe(主动)
 {
 	std::stringstream sshestr;
-	vsshe->PublishGroup(sshestr);
+	if (ecsshe)
+		ecsshe->PublishGroup(sshestr);
+	else
+		vsshe->PublishGroup(sshestr);
 	sshekey = sshestr.str();
 }
 
 bool tmcg::verifySsheKey()// 验证sshe(被动)
 {
+	if (ecvtmf)
+	{
+		if (!ecsshe || ecsshe->n != (size_t)DECKSIZE)
+		{
+			std::cout << "EC shuffle instance was not correctly generated!" << std::endl;
+			return false;
+		}
+		if (ecsshe->h != ecvtmf->h)
+		{
+			std::cout << "EC shuffle: Common public key does not match!" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
 	do
 	{
-		if (!vsshe->CheckGroup())
+		// 验证过的生成元不再检查, 公钥 h 在下面与 vtmf 比较
+		if (!pokerSsheCache.IsVerified(*vsshe) && !vsshe->CheckGroup())
 		{
 			std::cout << "VSSHE instance was not correctly generated!" << std::endl;
 			break;
@@ -139,7 +276,7 @@ bool tmcg::verifySsheKey()// 验证sshe(被动)
 			std::cout << "VSSHE: Common public key does not match!" << std::endl;
 			break;
 		}
-		if (mpz_cmp(vtmfOne->q, vsshe->com->q))
+		if (mpz_cmp(vtmfOne->q, vsshe->com->q) || mpz_cmp(vtmfOne->p, vsshe->com->p))
 		{
 			std::cout << "VSSHE: Subgroup order does not match!" << std::endl;
 			break;
@@ -149,19 +286,81 @@ bool tmcg::verifySsheKey()// 验证sshe(被动)
 			std::cout << "VSSHE: Encryption scheme does not match!" << std::endl;
 			break;
 		}
+		pokerSsheCache.Add(*vsshe);
 		return true;
 	}while(0);
 
 	return false;
 }
 
+// 写牌堆/证明, 二进制格式时先写 POKER_CARD_BINARY_MAGIC
+static void beginCardMsg(std::ostream &out, bool fBinary)
+{
+	if (!fBinary)
+		return ;
+	out.put((char)POKER_CARD_BINARY_MAGIC);
+	TMCG_ParseHelper::set_binary(out);
+}
+
+// 读牌堆/证明, 按首字节判断格式, json 消息里的二进制格式是 hex
+static void openCardMsg(std::stringstream &in, const std::string &msgIn)
+{
+	std::string msg = DecodeHexCards(msgIn);
+	if (!msg.empty() && (unsigned char)msg[0] == POKER_CARD_BINARY_MAGIC)
+	{
+		in.str(msg.substr(1));
+		TMCG_ParseHelper::set_binary(in);
+	}
+	else
+		in.str(msg);
+}
+
+void tmcg::proveSecret(const VTMF_Card &c, std::ostream &out)
+{
+	if (ecvtmf)
+		ecvtmf->VerifiableDecryptionProtocol_Prove(c.c_1, out);
+	else
+		vtmfOne->VerifiableDecryptionProtocol_Prove_Batch(c.c_1, out);
+}
+
+void tmcg::selfSecret(const VTMF_Card &c)
+{
+	if (ecvtmf)
+		ecvtmf->VerifiableDecryptionProtocol_Verify_Initialize(c.c_1);
+	else
+		tmcgOne->TMCG_SelfCardSecret(c, vtmfOne);
+}
+
+bool tmcg::verifySecret(const VTMF_Card &c, std::istream &in)
+{
+	if (ecvtmf)
+		return ecvtmf->VerifiableDecryptionProtocol_Verify_Update(c.c_1, in);
+	std::stringstream out;
+	return tmcgOne->TMCG_VerifyCardSecret(c, vtmfOne, in, out);
+}
+
+int tmcg::typeOfCard(const VTMF_Card &c)
+{
+	if (ecvtmf)
+		return ecvtmf->TypeOfCard(c);
+	return tmcgOne->TMCG_TypeOfCard(c, vtmfOne);
+}
+
+bool tmcg::IsBinaryCards() const
+{
+	return fBinaryCards && fPokerBinaryPayload;
+}
+
 void tmcg::createCard()
 {
 	TMCG_OpenStack<VTMF_Card> deck;
 	for (int type = 0; type < DECKSIZE; type++)
 	{
 		VTMF_Card c;
-		tmcgOne->TMCG_CreateOpenCard(c, vtmfOne, type);
+		if (ecvtmf)
+			ecvtmf->CreateOpenCard(c, type);
+		else
+			tmcgOne->TMCG_CreateOpenCard(c, vtmfOne, type);
 		deck.push(type, c);
 	}
 	s.push(deck);
@@ -173,9 +372,29 @@ std::string tmcg::shuffleCard()//洗牌(主动)
 	TMCG_Stack<VTMF_Card> s2;
 	TMCG_StackSecret<VTMF_CardSecret> ss;
 	std::stringstream lej;
-	tmcgOne->TMCG_CreateStackSecret(ss, false, s.size(), vtmfOne);
-	tmcgOne->TMCG_MixStack(s, s2, ss, vtmfOne);
-	tmcgOne->TMCG_ProveStackEquality_Groth_noninteractive(s, s2,ss, vtmfOne, vsshe, lej);
+	beginCardMsg(cardMsg, IsBinaryCards());
+	TMCG_ParseHelper::set_binary(lej, IsBinaryCards());
+	if (ecvtmf)
+	{
+		ecvtmf->CreateStackSecret(ss, s.size());
+		ecvtmf->MixStack(s, s2, ss);
+		ecsshe->Prove_noninteractive(s, s2, ss, lej);
+	}
+	else
+	{
+		std::vector<std::pair<mpz_ptr, mpz_ptr> > masks, proofMasks;
+		std::vector<mpz_ptr> proofRand;
+		std::vector<std::unique_ptr<CPokerMask> > vMask, vProofMask;
+		tmcgOne->TMCG_CreateStackSecret(ss, false, s.size(), vtmfOne);
+		if (maskPool->Take(ss, masks, vMask))
+			tmcgOne->TMCG_MixStack(s, s2, ss, masks, vtmfOne);
+		else
+			tmcgOne->TMCG_MixStack(s, s2, ss, vtmfOne);
+		if (maskPool->Take(TMCG_GROTH_PRECOMPUTED, proofRand, proofMasks, vProofMask))
+			tmcgOne->TMCG_ProveStackEquality_Groth_noninteractive(s, s2, ss, proofRand, proofMasks, vtmfOne, vsshe.get(), lej);
+		else
+			tmcgOne->TMCG_ProveStackEquality_Groth_noninteractive(s, s2,ss, vtmfOne, vsshe.get(), lej);
+	}
 
 	cardMsg << s2 << std::endl;
 	cardMsg << lej.str();
@@ -187,13 +406,55 @@ std::string tmcg::shuffleCard()//洗牌(主动)
 bool tmcg::verifyShuffleCard(std::string &shuffleCardMsg)//验证洗牌(被动)
 {
 	std::stringstream msgStream;
-	msgStream << shuffleCardMsg;
+	openCardMsg(msgStream, shuffleCardMsg);
 	TMCG_Stack<VTMF_Card> s2;
 	msgStream >> s2;
-	bool ret = tmcgOne->TMCG_VerifyStackEquality_Groth_noninteractive(s, s2,vtmfOne, vsshe, msgStream);
+	bool ret;
+	if (ecvtmf)
+		ret = ecsshe->Verify_noninteractive(s, s2, msgStream);
+	else
+		ret = tmcgOne->TMCG_VerifyStackEquality_Groth_noninteractive(s, s2,vtmfOne, vsshe.get(), msgStream);
 	s = s2;
 	return ret;
 }
+
+void tmcg::verifyShuffleChain(const std::vector<std::string> &vShuffleMsg, const std::vector<bool> &vVerify,
+	std::vector<TMCG_Stack<VTMF_Card> > &vStack, std::vector<bool> &vResult)
+{
+	size_t n = vShuffleMsg.size();
+	vStack.clear();
+	vStack.resize(n);
+	std::vector<std::unique_ptr<std::stringstream> > vProof(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		vProof[i].reset(new std::stringstream());
+		openCardMsg(*vProof[i], vShuffleMsg[i]);
+		*vProof[i] >> vStack[i];
+	}
+
+	// 每条证明只依赖输入输出牌堆, 可以同时验证; vector<bool> 不能并发写, 先写到 char
+	// 默认不通过, 只有验证函数正常返回才写入结果, 任务抛出异常时该链接仍被拒绝
+	std::vector<char> vOk(n, 0);
+	std::vector<std::function<void()> > vTask;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!vVerify[i])
+		{
+			vOk[i] = 1;// 自己的洗牌不验证
+			continue;
+		}
+		const TMCG_Stack<VTMF_Card> &in = i ? vStack[i - 1] : s;
+		vTask.push_back([this, &in, &vStack, &vProof, &vOk, i]() {
+			if (ecvtmf)
+				vOk[i] = ecsshe->Verify_noninteractive(in, vStack[i], *vProof[i]);
+			else
+				vOk[i] = tmcgOne->TMCG_VerifyStackEquality_Groth_noninteractive(in, vStack[i], vtmfOne, vsshe.get(), *vProof[i]);
+		});
+	}
+	pokerVerifyPool.RunAll(vTask);
+
+	vResult.assign(vOk.begin(), vOk.end());
+}
 void tmcg::createHandCard()// 为每个人创建一副手牌
 {
 	for (int i = 0; i < playersize; i++)//选取手牌
@@ -209,30 +470,94 @@ void tmcg::createHandCard()// 为每个人创建一副手牌
 }
 std::string tmcg::proveCardSecret(const int m,const int k)// 产生第m个人第k张手牌消息
 {
-	std::stringstream in, out;
-	tmcgOne->TMCG_ProveCardSecret(hand[m][k], vtmfOne,in,out);
+	std::stringstream out;
+	beginCardMsg(out, IsBinaryCards());
+	proveSecret(hand[m][k], out);
 	return out.str();
 }
 
 void tmcg::selfCardSecret(const int m,const int k)
 {
-	tmcgOne->TMCG_SelfCardSecret(hand[m][k], vtmfOne);
+	selfSecret(hand[m][k]);
 }
 void tmcg::selfFlopSecret(const int k)
 {
 	//std::cout << "k is " << k << std::endl;
-	tmcgOne->TMCG_SelfCardSecret(flop[k], vtmfOne);
+	selfSecret(flop[k]);
 }
 bool tmcg::verifyCardSecret(const int m,const int k,std::string& handmsg)// 验证手牌(仅验证自己的)
 {
-	std::stringstream in, out;
-	in << handmsg;
-	return tmcgOne->TMCG_VerifyCardSecret(hand[m][k], vtmfOne, in, out);
+	std::stringstream in;
+	openCardMsg(in, handmsg);
+	return verifySecret(hand[m][k], in);
+}
+
+bool tmcg::verifyCardSecretBatch(const std::vector<const VTMF_Card*> &vCard, const std::vector<std::vector<std::string> > &vCardMsg)
+{
+	std::vector<mpz_srcptr> vC1;
+	std::vector<std::unique_ptr<std::stringstream> > vIn;
+	std::vector<std::pair<size_t, size_t> > vOwner;		//(第几张牌, 第几个份额)
+	for (size_t i = 0; i < vCard.size(); i++)
+	{
+		for (size_t j = 0; j < vCardMsg[i].size(); j++)
+		{
+			const std::string &msg = vCardMsg[i][j];
+			vOwner.push_back(std::make_pair(i, j));
+			vC1.push_back(vCard[i]->c_1);
+			vIn.push_back(std::unique_ptr<std::stringstream>(new std::stringstream()));
+			openCardMsg(*vIn.back(), msg);
+		}
+	}
+
+	// 分成几段交给验证线程池, 每段内部批量验证
+	size_t n = vIn.size();
+	size_t nChunk = std::min<size_t>(pokerVerifyPool.GetWorkers() + 1, (n + 3) / 4);
+	std::vector<std::vector<bool> > vChunkResult(nChunk);
+	std::vector<std::function<void()> > vTask;
+	for (size_t c = 0; c < nChunk; c++)
+	{
+		size_t begin = n * c / nChunk, end = n * (c + 1) / nChunk;
+		vTask.push_back([this, &vC1, &vIn, &vChunkResult, c, begin, end]() {
+			std::vector<mpz_srcptr> c_1(vC1.begin() + begin, vC1.begin() + end);
+			std::vector<std::istream*> in;
+			for (size_t i = begin; i < end; i++)
+				in.push_back(vIn[i].get());
+			if (ecvtmf)
+				ecvtmf->VerifiableDecryptionProtocol_Verify_Batch(c_1, in, vChunkResult[c]);
+			else
+				vtmfOne->VerifiableDecryptionProtocol_Verify_Batch(c_1, in, vChunkResult[c]);
+		});
+	}
+	pokerVerifyPool.RunAll(vTask);
+
+	bool ret = true;
+	size_t k = 0;
+	for (size_t c = 0; c < nChunk; c++)
+	{
+		for (size_t j = 0; j < vChunkResult[c].size(); j++, k++)
+		{
+			if (vChunkResult[c][j])
+				continue;
+			std::cout << "verify card secret error, card : " << vOwner[k].first << " share : " << vOwner[k].second << std::endl;
+			ret = false;
+		}
+	}
+	return ret && k == n;
+}
+
+void tmcg::updateCardSecret(const std::string &msg)
+{
+	std::stringstream in;
+	openCardMsg(in, msg);
+	if (ecvtmf)
+		ecvtmf->VerifiableDecryptionProtocol_Verify_Accumulate(in);
+	else
+		vtmfOne->VerifiableDecryptionProtocol_Verify_Accumulate(in);
 }
 
 void tmcg::saveHandCard(const int m,const int k)//验证通过后保存手牌
 {
-	int type = tmcgOne->TMCG_TypeOfCard(hand[m][k], vtmfOne);
+	int type = typeOfCard(hand[m][k]);
 	if(!private_hand.find(type))
 	{
 		private_hand.push(type, hand[m][k]);
@@ -251,46 +576,48 @@ void tmcg::createFlopCard()//创建公共牌
 
 std::string tmcg::proveFlopSecret(const int k)
 {
-	std::stringstream in, out;
-	tmcgOne->TMCG_ProveCardSecret(flop[k], vtmfOne, in, out);
+	std::stringstream out;
+	beginCardMsg(out, IsBinaryCards());
+	proveSecret(flop[k], out);
 	return out.str();
 }
 
 ///////////////////////////////////////////		hand_flop	start
 std::string tmcg::proveHandFlopSecret(const int k)
 {
-	std::stringstream in, out;
-	tmcgOne->TMCG_ProveCardSecret(hand_flop[k], vtmfOne, in, out);
+	std::stringstream out;
+	beginCardMsg(out, IsBinaryCards());
+	proveSecret(hand_flop[k], out);
 	return out.str();
 }
 bool tmcg::verifyHandFlopSecret(const int k, std::string &msg)
 {
-	std::stringstream in, out;
-	in << msg;
-	return tmcgOne->TMCG_VerifyCardSecret(hand_flop[k], vtmfOne, in, out);
+	std::stringstream in;
+	openCardMsg(in, msg);
+	return verifySecret(hand_flop[k], in);
 }
 void tmcg::selfHandFlopSecret(const int k)
 {
-	tmcgOne->TMCG_SelfCardSecret(hand_flop[k], vtmfOne);
+	selfSecret(hand_flop[k]);
 }
 void tmcg::saveHandFlopCard(const int i)
 {
-	int type = tmcgOne->TMCG_TypeOfCard(hand_flop[i], vtmfOne);
+	int type = typeOfCard(hand_flop[i]);
 	open_hand.push(type, hand_flop[i]);
 	std::cout << "saveHandFlopCard type is " << type << std::endl;
 }
 ///////////////////////////////////////////		hand_flop	end
 bool tmcg::verifyFlopSecret(const int k, std::string &msg)
 {
-	std::stringstream in, out;
-	in << msg;
-	return tmcgOne->TMCG_VerifyCardSecret(flop[k], vtmfOne, in, out);
+	std::stringstream in;
+	openCardMsg(in, msg);
+	return verifySecret(flop[k], in);
 }
 
 void tmcg::saveFlopCard(const int i)
 {
 
-	int type = tmcgOne->TMCG_TypeOfCard(flop[i], vtmfOne);
+	int type = typeOfCard(flop[i]);
 	open_flop.push(type, flop[i]);
 }
 
@@ -536,6 +863,10 @@ void tmcg::printBetIpfsMsg(BetIpfsMsg& msg)
 
 void tmcg::clearPoker()
 {
+	betVerifier->Reset();
+	txIndex->Clear();
+	pokerTables.Release(this);
+
 	for (int i = 0; i < playersize; i++) {
         hand[i].clear();
     }
@@ -545,6 +876,7 @@ void tmcg::clearPoker()
 	selfaddress.clear();
 	pokeraddress.clear();
 	matchTxID.clear();
+	pokerReorderBuffer.Clear(matchTableID);
 	matchTableID.clear();
 	fAllPubkeyVerify = false;
 	fMyPubkeyVerify = false;
@@ -559,6 +891,7 @@ void tmcg::clearPoker()
 	mOpenFlopVerify.clear();
 	mPokerBalanceTx.clear();
 	nextShuffleIndex = 0;
+	mShuffleMsg.clear();
 	nextBetTxID.clear();
 
 	fPokerAddressVerify = false;
@@ -579,9 +912,12 @@ void tmcg::clearPoker()
 	selfshuffle.clear();
 	vtmf_str.clear();
 	vtmf1 = nullptr;
+	maskPool->Stop();
 	tmcgOne = nullptr;
 	vtmfOne = nullptr;
-	vsshe = nullptr;
+	vsshe.reset();
+	ecvtmf.reset();
+	ecsshe.reset();
 	s.clear();
 	private_hand.clear();
 	flop.clear();
@@ -600,10 +936,6 @@ void tmcg::clearPoker()
 	gBetIpfsMsg.publicIndex = 0;
 	gBetIpfsMsg.fGameOver = false;
 	
-	// Egret
-	vShuffleMsg.clear();  
-	vHandCardMsg.clear();
-	vFlopCardMsg.clear();
 	mPokerTypes.clear();
 	mBestGroups.clear();
 	fDiscardMsg = false;
@@ -655,6 +987,18 @@ int isGameOver()
 	return -2;
 }
 
+// 这一轮要打开的第一张公共牌的下标, 不需要打开公共牌时返回 -1
+int flopCardIndex()
+{
+	int publicIndex = g_tmcg->gBetIpfsMsg.publicIndex;
+	if (isGameOver() == -1)
+		return publicIndex ? publicIndex + 2 : 0;
+	else if (publicIndex == 1)
+		return 0;
+	else if (publicIndex == 2 || publicIndex == 3)
+		return publicIndex + 1;
+	return -1;
+}
 
 int isGameOver(BetIpfsMsg msg)
 {
@@ -703,13 +1047,68 @@ int isGameOver(BetIpfsMsg msg)
 
 void ipfsCatFile(std::string & hash, std::string & getResponseStr)
 {
-	std::string url = "http://localhost:5001/api/v0/cat?arg=" + hash;
-	std::cout << "url : " << url << std::endl;
-	auto ret = curl_get_req(url, getResponseStr);
-	if (ret != CURLE_OK)
+	if (pokerPayloadCache.Get(hash, getResponseStr))
+		return ;
+
+	if (!g_pokerstore || !g_pokerstore->Get(hash, getResponseStr))
+		return ;
+	pokerPayloadCache.Put(hash, getResponseStr);
+}
+
+void ipfsCatFiles(const std::vector<std::string> & hashes, std::vector<std::string> & responses)
+{
+	responses.assign(hashes.size(), std::string());
+
+	std::vector<std::string> missHashes;
+	std::vector<size_t> missIndex;
+	for (size_t i = 0; i < hashes.size(); ++i)
+	{
+		if (!pokerPayloadCache.Get(hashes[i], responses[i]))
+		{
+			missHashes.push_back(hashes[i]);
+			missIndex.push_back(i);
+		}
+	}
+	if (missHashes.empty() || !g_pokerstore)
+		return ;
+
+	std::vector<std::string> missResponses;
+	g_pokerstore->GetMany(missHashes, missResponses);
+	for (size_t i = 0; i < missHashes.size(); ++i)
+	{
+		if (missResponses[i].empty())
+			continue;
+		pokerPayloadCache.Put(missHashes[i], missResponses[i]);
+		responses[missIndex[i]].swap(missResponses[i]);
+	}
+}
+
+// 一次并发拉取这些交易的 ipfs 数据放进缓存, 后面逐笔验证时直接命中
+void prefetchTxPayload(const std::vector<CTransaction> &vtx)
+{
+	std::vector<std::string> hashes;
+	for (auto &ct : vtx)
 	{
-		std::cerr << "curl get failed: " + std::string(curl_easy_strerror(ret)) << std::endl;
+		for (auto &it : ct.vout)
+		{
+			auto &script = it.scriptPubKey;
+			if (script.size() > 68 && script[0] == OP_RETURN)
+			{
+				hashes.push_back(std::string(script.begin() + 68, script.end()));
+				break;
+			}
+		}
 	}
+	std::vector<std::string> responses;
+	ipfsCatFiles(hashes, responses);
+}
+
+bool ipfsAddFile(const std::string & msg, std::string & hash)
+{
+	if (!g_pokerstore || !g_pokerstore->Put(msg, hash))
+		return false;
+	pokerPayloadCache.Put(hash, msg);
+	return true;
 }
 
 bool verifyBalcnceIpfs(const CScript &script, int& lieIndex)
@@ -731,6 +1130,11 @@ bool verifyBalcnceIpfs(const CScript &script, int& lieIndex)
 
 bool verifyBalcnce(int& lieIndex)
 {
+	std::vector<CTransaction> vtx;
+	for (auto &it: g_tmcg->mPokerBalanceTx)
+		vtx.push_back(it.second);
+	prefetchTxPayload(vtx);
+
 	for (auto &it: g_tmcg->mPokerBalanceTx)
 	{
 		for (auto voutit: it.second.vout)
@@ -967,39 +1371,6 @@ bool checkBetMsg(MsgNode &VerifyMsg,MsgNode &PreTxMsg)
 	return true;
 }
 
-void getPokerBetData(const json &jsonMsg, BetIpfsMsg &curBetMsg)
-{
-	curBetMsg.nextBetTxID = jsonMsg["nextBetTxID"].get<std::string>();
-	curBetMsg.curBetTxID = jsonMsg["curBetTxID"].get<std::string>();
-	curBetMsg.curBet = jsonMsg["curBet"].get<int>();
-	curBetMsg.maxBet = jsonMsg["maxBet"].get<int>();
-	curBetMsg.jackpot = jsonMsg["jackpot"].get<int>();
-	curBetMsg.publicIndex = jsonMsg["publicIndex"].get<int>();
-	curBetMsg.fGameOver = jsonMsg["fGameOver"].get<bool>();
-	curBetMsg.fFlopCard = jsonMsg["fFlopCard"].get<bool>();
-
-	for(auto &hasbetIt : jsonMsg["mHasBet"])
-	{
-		std::string htxid = hasbetIt["txID"].get<std::string>();
-		int hbet = hasbetIt["hasBet"].get<int>();
-		curBetMsg.mHasBet.insert(std::make_pair(htxid,hbet));
-	}
-
-	for(auto &hasbetIt : jsonMsg["mBalance"])
-	{
-		std::string btxid = hasbetIt["txID"].get<std::string>();
-		int balance = hasbetIt["balance"].get<int>();
-		curBetMsg.mBalance.insert(std::make_pair(btxid,balance));
-	}
-
-	for(auto &hasbetIt : jsonMsg["mPlayerStatus"])
-	{
-		int index = hasbetIt["txIndex"].get<int>();
-		int status = hasbetIt["status"].get<int>();
-		curBetMsg.mPlayerStatus.insert(std::make_pair(index,status));
-	}
-}
-
 BetIpfsMsg getBetMsgFromTx(const CTransaction &ctx)
 {
 	BetIpfsMsg resBetMsg;
@@ -1011,8 +1382,8 @@ BetIpfsMsg getBetMsgFromTx(const CTransaction &ctx)
 		std::string msgHash(script.begin() + 68, script.end());
 		std::string getResponseStr;
 		ipfsCatFile(msgHash, getResponseStr);
-		json jsonMsg = json::parse(getResponseStr);
-		getPokerBetData(jsonMsg, resBetMsg);
+		std::string txid;
+		DecodeBetMsg(getResponseStr, txid, resBetMsg);
 		break;
 	}
 	return resBetMsg;
@@ -1135,58 +1506,7 @@ bool verifyBetIpfsMsg(BetIpfsMsg& preBetMsg, BetIpfsMsg& curBetMsg, std::string
 
 bool verifyBet(int& lieIndex)
 {
-	for (size_t i= 0; i < vTxBetVerify.size(); i++)
-	{
-		auto &ct = vTxBetVerify.at(i);			    //找到需要验证的交易
-		BetIpfsMsg msg = getBetMsgFromTx(ct); 	    //找到交易对应的消息
-
-		int curIndex = g_tmcg->mPlayerIndex[msg.curBetTxID];
-		int nextIndex = g_tmcg->mPlayerIndex[msg.nextBetTxID];
-
-		if (msg.mPlayerStatus[curIndex] != PS_DISCARD && ct.GetValueOut(true) / COIN != msg.curBet )	//验证交易数据和消息数据
-		{
-			lieIndex = curIndex;
-			std::cout << "index " << lieIndex <<  " GetValueOut error. " << std::endl;
-			return false;
-		}
-
-		BetIpfsMsg preMsg;
-		if (i == 0)
-		{
-			g_tmcg->initBetIpfsMsg(preMsg);
-		}
-		else
-		{
-			auto &prect = vTxBetVerify.at(i - 1);			    //找到需要验证的交易
-			preMsg = getBetMsgFromTx(prect);
-		}
-
-		std::string error;
-		if (!verifyBetIpfsMsg(preMsg, msg, error))
-		{
-			lieIndex = curIndex;
-			std::cout << "lieIndex: " << lieIndex << error << std::endl;
-			return false;
-		}
-
-		if (i == vTxBetVerify.size()-1)
-		{
-			if (g_tmcg->TimeOut)
-			{
-				lieIndex = nextIndex;
-				std::cout << "time out. " << lieIndex << std::endl;
-				return false;
-			}
-
-			if (!msg.fGameOver)
-			{
-				std::cout << "game is not over. " << std::endl;
-				return false;
-			}
-		}
-	}
-
-	return true;
+	return g_tmcg->betVerifier->Verify(g_tmcg->vTxBetVerify, lieIndex);
 }
 
 /*
@@ -1217,12 +1537,12 @@ int pokerhistory(int& index, int& amount)
 	//3 TODO DepositVerify
 	// return 2;
 
-	if(vTxBetVerify.empty()){
+	if(g_tmcg->vTxBetVerify.empty()){
 		std::cout <<  "game is not beting. " << std::endl;
 		return 4;
 	}
 
-	CTransaction lastTx = vTxBetVerify.at(vTxBetVerify.size()-1);
+	CTransaction lastTx = g_tmcg->vTxBetVerify.at(g_tmcg->vTxBetVerify.size()-1);
 	BetIpfsMsg lastMsg = getBetMsgFromTx(lastTx);
 
 	//检测超时
@@ -1316,119 +1636,44 @@ size_t req_reply(void *ptr, size_t size, size_t nmemb, void *stream)
 // HTTP GET
 CURLcode curl_get_req(const std::string &url, std::string &response)
 {
-	// init curl
-	CURL *curl = curl_easy_init();
-	// res code
-	CURLcode res;
-	if (curl)
-	{
-		// set params
-		curl_easy_setopt(curl, CURLOPT_URL, url.c_str()); // url
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, false); // if want to use https
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, false); // set peer and host verify false
-		curl_easy_setopt(curl, CURLOPT_READFUNCTION, NULL);
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, req_reply);
-		curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
-		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
-		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 20); // set transport and time out time
-		curl_easy_setopt(curl, CURLOPT_TIMEOUT, 20);
-		// start req
-		res = curl_easy_perform(curl);
-	}
-	// release curl
-	curl_easy_cleanup(curl);
-	return res;
+	return pokerHttpClient.Get(url, response);
 }
 
 // HTTP POST
 CURLcode curl_post_req(const std::string &url, const std::string &postParams, std::string &filepath, std::string &response)
 {
-	// init curl
-	CURL *curl = curl_easy_init();
-	// res code
-	CURLcode res;
-	if (curl)
-	{
-		// set params
-		curl_easy_setopt(curl, CURLOPT_POST, 1); // post req
-		curl_easy_setopt(curl, CURLOPT_URL, url.c_str()); // url
-		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postParams.c_str()); // params
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, false); // if want to use https
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, false); // set peer and host verify false
-		curl_easy_setopt(curl, CURLOPT_READFUNCTION, NULL);
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, req_reply);
-		curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
-		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
-		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 20);
-		curl_easy_setopt(curl, CURLOPT_TIMEOUT, 20);
-
-		if (!filepath.empty()) {
-			struct curl_httppost* post = NULL;
-			struct curl_httppost* last = NULL;
-			curl_formadd(&post, &last, CURLFORM_COPYNAME, "uploadfile", CURLFORM_FILE, filepath.c_str(), CURLFORM_END);
-			curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
-		}
-
-		// start req
-		res = curl_easy_perform(curl);
-	}
-	// release curl
-	curl_easy_cleanup(curl);
-	return res;
+	return pokerHttpClient.Post(url, postParams, filepath, response);
 }
 
 
-CURLcode curl_bitcoin_req(const char *data, std::string &response, bool frespon)
+// 撮合节点直接调用钱包, 不再经过本地 rpc
+void walletGetNewAddress()
 {
-	CURL *curl = curl_easy_init();
-	struct curl_slist *headers = NULL;
-	CURLcode res;
-
-	const std::string url = "http://127.0.0.1:8332";
-
-	if (curl) {
-		// const char *data =
-		// "{\"jsonrpc\": \"1.0\", \"id\":\"curltest\", \"method\": \"addnode\", \"params\": [\"192.168.1.88\", \"add\"] }";
-
-		headers = curl_slist_append(headers, "content-type: text/plain;");
-		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-		curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) strlen(data));
-		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data);
-		if(frespon) {
-			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, req_reply);
-			curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
-		}
-		curl_easy_setopt(curl, CURLOPT_USERPWD, "hello:helloworld");
-		curl_easy_setopt(curl, CURLOPT_USE_SSL, CURLUSESSL_TRY);
-		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 20);
-		curl_easy_setopt(curl, CURLOPT_TIMEOUT, 20);
-		res = curl_easy_perform(curl);
+#ifdef ENABLE_WALLET
+	if (vpwallets.empty())
+		return ;
+	try {
+		PokerGetNewAddress(vpwallets[0]);
+	} catch (const UniValue& objError) {
+		std::cerr << "walletGetNewAddress failed: " << find_value(objError, "message").get_str() << std::endl;
+	} catch (const std::exception& e) {
+		std::cerr << "walletGetNewAddress failed: " << e.what() << std::endl;
 	}
-	curl_easy_cleanup(curl);
-
-	return res;
-}
-
-
-void rpcGetNewAddress()
-{
-	const char *data = "{\"jsonrpc\": \"1.0\", \"id\":\"curltest\", \"method\": \"getnewaddress\", \"params\": [] }";
-	std::string rpcReponse;
-	auto res = curl_bitcoin_req(data, rpcReponse, false);
-	if (res != CURLE_OK)
-		std::cerr << "curl rpcGetNewAddress failed: " + std::string(curl_easy_strerror(res)) << std::endl;
+#endif
 }
 
-void rpcPokerIpfs(const int pokercode, const std::string& ipfsHash)
+void walletPokerIpfs(const int pokercode, const std::string& ipfsHash)
 {
-	std::string rpcData = "{\"jsonrpc\": \"1.0\", \"id\":\"curltest\", \"method\": \"pokermatchfinish\", \"params\": [\"" + ipfsHash + "\"] }";
-	const char *data = rpcData.c_str();
-	std::string rpcReponse;
-	auto res = curl_bitcoin_req(data, rpcReponse, true);
-	if (res != CURLE_OK)
-		std::cerr << "curl rpcPokerIpfs failed: " + std::string(curl_easy_strerror(res)) << std::endl;
-	else {
-		std::cout << "rpcPokerIpfs success: " << pokercode << "\n" << rpcReponse << std::endl;
+#ifdef ENABLE_WALLET
+	if (vpwallets.empty())
+		return ;
+	try {
+		std::string txid = PokerMatchFinish(vpwallets[0], ipfsHash);
+		std::cout << "walletPokerIpfs success: " << pokercode << " " << txid << std::endl;
+	} catch (const UniValue& objError) {
+		std::cerr << "walletPokerIpfs failed: " << find_value(objError, "message").get_str() << std::endl;
+	} catch (const std::exception& e) {
+		std::cerr << "walletPokerIpfs failed: " << e.what() << std::endl;
 	}
+#endif
 }
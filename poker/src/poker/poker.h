@@ -30,8 +30,29 @@
 
 using json = nlohmann::json;
 class tmcg;
+class CBetChainVerifier;
+class CECShuffle;
+class CECVTMF;
+class CPokerMaskPool;
+class CPokerTxIndex;
+struct CPokerTableSnapshot;
+
+/**
+ * 当前牌桌
+ *
+ * 牌桌由 pokerTables(tablemanager.h) 管理, g_tmcg 指向当前线程正在处理的牌桌
+ * (CPokerTableScope 选定), 没有选定时指向默认牌桌.
+ */
+class CPokerTableRef
+{
+public:
+	tmcg *get() const;
+	tmcg *operator->() const { return get(); }
+	tmcg &operator*() const { return *get(); }
+	explicit operator bool() const { return get() != nullptr; }
+};
 
-extern std::unique_ptr<tmcg> g_tmcg;
+extern CPokerTableRef g_tmcg;
 extern std::map<std::string, std::string> gMapAddress;
 typedef std::pair<int,int> IndexBalance;
 #define HANDCARDSIZE 2
@@ -121,31 +142,11 @@ struct BetIpfsMsg
 extern const int DECKSIZE; //牌
 extern const int FLOPSIZE; //公共牌
 extern const int HANDSIZE; //手牌
-extern std::vector< CTransaction> vTxIpVerify;
-extern std::vector< CTransaction> vTxNewAddressVerify;
-extern std::vector< CTransaction> vTxPublicAddressVerify;
-extern std::vector< CTransaction> vTxPokerBalanceVerify;
-extern std::vector< CTransaction> vTxPokerHandleVerify; //44
-extern std::vector< CTransaction> vTxPokerDlogVerify; //45
-extern std::vector< CTransaction> vTxPokerPubkeyVerify; //46
-extern std::vector< CTransaction> vTxPokerSshVerify; //47
-extern std::vector< CTransaction> vTxPokerShuffleVerify; //48
-extern std::vector< CTransaction> vTxPokerHandleCardVerify; //51
-extern std::vector< CTransaction> vTxPokerFlopCardVerify; //53
-extern std::vector< CTransaction> vTxPokerOpenHandVerify; //55
-extern std::vector< CTransaction> vTxDepositVerify; //70
-
-//ipfs
-extern std::vector<CTransaction> vTxBetVerify; 				  //保存所有下注交易
-extern std::multimap<std::string, CTransaction> vTxBetPlayer; //保存每个人的下注交易
-
 
 extern std::vector< CTransaction> vTxTimeOut; //
 extern std::vector< MsgTimeOut > vMsgTimeOut; //
 
-extern std::map<std::string, CTransaction> vTxDepositPlayer;
-
-extern std::vector< CTransaction > vTxMatchPlayer;
+extern std::vector< CTransaction > vTxMatchPlayer; //匹配节点收到的匹配交易, 不属于某个牌桌
 
 bool verifyBalcnce(std::string& res, int& lieIndex);
 
@@ -171,13 +172,16 @@ int getNextIndex(MsgNode &betMsg);
 size_t req_reply(void *ptr, size_t size, size_t nmemb, void *stream);
 CURLcode curl_get_req(const std::string &url, std::string &response);
 CURLcode curl_post_req(const std::string &url, const std::string &postParams, std::string &filepath, std::string &response);
-CURLcode curl_bitcoin_req(const char *data, std::string &response);
-void rpcGetNewAddress();
-void rpcPokerIpfs(const int pokercode, const std::string& ipfsHash);
+void walletGetNewAddress();
+void walletPokerIpfs(const int pokercode, const std::string& ipfsHash);
 void ipfsCatFile(std::string & hash, std::string & getResponseStr);
+void ipfsCatFiles(const std::vector<std::string> & hashes, std::vector<std::string> & responses);
+bool ipfsAddFile(const std::string & msg, std::string & hash);
+void prefetchTxPayload(const std::vector<CTransaction> &vtx);
+BetIpfsMsg getBetMsgFromTx(const CTransaction &ctx);
 int isGameOver();
 int isGameOver(BetIpfsMsg curBetMsg);
-void getPokerBetData(const json &jsonMsg, BetIpfsMsg &curBetMsg);
+int flopCardIndex();
 bool verifyBetIpfsMsg(BetIpfsMsg& preBetMsg, BetIpfsMsg& curBetMsg, std::string &error);
 
 class tmcg
@@ -196,6 +200,10 @@ public:
 
 	bool VTMF_dlog();
 
+	bool HasGroup() const;// 是否已初始化群(dlog 或 secp256k1)
+
+	bool HasSshe() const;// 是否已创建 sshe
+
 	void createPublicKey(std::string &pubkey);
 
 	bool verifyPubKey(const std::string &pubkey);//验证公钥
@@ -212,10 +220,17 @@ public:
 
 	void createCard();
 
+	bool IsBinaryCards() const;// 本牌桌是否用二进制格式写牌堆和证明
+
 	std::string shuffleCard();//洗牌(主动)
 
 	bool verifyShuffleCard(std::string &shuffleCardMsg);//验证洗牌(被动)
 
+	// 并行验证一段洗牌链(被动): 第一条的输入是 s, 之后每条的输入是上一条的输出;
+	// vVerify[i] 为 false 的不验证(自己的洗牌), 每条给出输出牌堆和结果
+	void verifyShuffleChain(const std::vector<std::string> &vShuffleMsg, const std::vector<bool> &vVerify,
+		std::vector<TMCG_Stack<VTMF_Card> > &vStack, std::vector<bool> &vResult);
+
 	void createHandCard();// 为每个人创建一副手牌
 
 	std::string proveCardSecret(const int m,const int k);// 产生第m个人第k张手牌消息
@@ -226,6 +241,11 @@ public:
 
 	bool verifyCardSecret(const int m,const int k,std::string& handmsg);// 验证手牌(仅验证自己的)
 
+	// 批量验证解密份额(被动): vCardMsg[i] 为其他玩家对 vCard[i] 的份额证明, 全部通过返回 true
+	bool verifyCardSecretBatch(const std::vector<const VTMF_Card*> &vCard, const std::vector<std::vector<std::string> > &vCardMsg);
+
+	void updateCardSecret(const std::string &msg);// 累加批量验证通过的份额
+
 	void saveHandCard(const int m,const int k);//验证通过后保存手牌
 
 	void createFlopCard();//创建公共牌
@@ -261,13 +281,23 @@ public:
 	bool IsFlopOpen(BetIpfsMsg& msg);
 	void clearPoker();
 
+private:
+	// 按牌桌的后端(dlog 或 secp256k1)产生, 验证解密份额和解密
+	void proveSecret(const VTMF_Card &c, std::ostream &out);
+	void selfSecret(const VTMF_Card &c);
+	bool verifySecret(const VTMF_Card &c, std::istream &in);
+	int typeOfCard(const VTMF_Card &c);
+
 public:
 
 	std::stringstream 		vtmf_str;
 	BarnettSmartVTMF_dlog 	*vtmf1;
 	SchindelhauerTMCG 		*tmcgOne;
 	BarnettSmartVTMF_dlog 	*vtmfOne;
-	GrothVSSHE *vsshe;
+	std::shared_ptr<GrothVSSHE> vsshe;	//承诺生成元可能来自 pokerSsheCache
+	std::unique_ptr<CECVTMF> ecvtmf;	//secp256k1 牌桌用这两个代替 vtmfOne, vsshe
+	std::unique_ptr<CECShuffle> ecsshe;
+	std::unique_ptr<CPokerMaskPool> maskPool;	//轮到自己洗牌前预先计算重新加密的 (r, g^r, h^r)
 	TMCG_Stack<VTMF_Card> s;
 	TMCG_Stack<VTMF_Card> hand[7];
 	TMCG_OpenStack<VTMF_Card> private_hand;
@@ -304,7 +334,10 @@ public:
 	std::string pokeraddress;
 	std::string matchTxID;   	// 匹配txid
 	std::string matchTableID;	// tableid
+	uint32_t nLocalID = 0;		// 本节点内的牌桌编号, 匹配前用它指定牌桌
 	bool fMatchNode = false; 	// 是否匹配节点
+	bool fBinaryCards;			// 牌堆和证明写二进制格式(-pokerbinary 关闭时不生效), 读取时两种格式都支持
+	bool fECGroup;				// 发起牌局时用 secp256k1 群, 其他玩家按句柄判断
 	std::string nextMatchNode = "120.27.232.146"; // 下一个匹配节点
 
 	std::string selfpubkey;
@@ -329,6 +362,7 @@ public:
 	std::map<std::string, CTransaction> mPokerBalanceTx;  // 保存所有玩家初始余额交易
 
 	int nextShuffleIndex = 0;   // 下个洗牌的人
+	std::map<int, std::string> mShuffleMsg; // 还没验证的洗牌消息, 座位号 -> 牌堆和证明
 	std::string nextBetTxID;    // 下一个下注的人
 	BetIpfsMsg gBetIpfsMsg;     // 保存最新的下注消息内容
 	bool fPokerAddressVerify = false; // 是否验证所有人pokeraddress通过
@@ -343,11 +377,17 @@ public:
 	int lieIndex;               // 作弊的人
 	
 	// Egret
-	std::vector<std::string> vShuffleMsg;  // 洗牌交易比sshe先到达
-	std::vector<std::string> vHandCardMsg; // 手牌交易比最后一次洗牌交易先到达
-	std::vector<std::string> vFlopCardMsg; // 公共牌交易比下注交易先到达
 	
 	bool fDiscardMsg = false;
+
+	//ipfs
+	std::vector<CTransaction> vTxBetVerify; 				//保存所有下注交易
+	std::multimap<std::string, CTransaction> vTxBetPlayer; 	//保存每个人的下注交易
+	std::map<std::string, CTransaction> vTxDepositPlayer;
+	std::unique_ptr<CBetChainVerifier> betVerifier;			//下注链的增量验证
+	std::unique_ptr<CPokerTxIndex> txIndex;					//P2P 牌局消息的承诺交易
+
+	std::shared_ptr<const CPokerTableSnapshot> snapshot;	//最近发布的快照, 用 std::atomic_load/store 访问
 	
 	std::map<int, int> mPokerTypes;
 	std::map<int, std::vector<int>> mBestGroups;
@@ -0,0 +1,461 @@
+#include "pokercodec.h"
+#include "poker.h"
+
+#include "streams.h"
+#include "utilstrencodings.h"
+#include "version.h"
+
+#include <gmp.h>
+#include <univalue.h>
+
+bool fPokerBinaryPayload = DEFAULT_POKER_BINARY_PAYLOAD;
+bool fPokerBinaryCards = DEFAULT_POKER_BINARY_CARDS;
+
+// gmp 的 62 进制字母表与 libTMCG(TMCG_MPZ_IO_BASE) 一致: 0-9A-Za-z
+static inline bool isBase62(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static void packLiteral(CVectorWriter &w, const std::string &lit)
+{
+	if (lit.empty())
+		return ;
+	WriteVarInt<CVectorWriter, uint64_t>(w, (uint64_t)lit.size() << 1);
+	w.write(lit.data(), lit.size());
+}
+
+void CPackedProof::Pack(std::vector<unsigned char> &vch) const
+{
+	CVectorWriter w(SER_NETWORK, PROTOCOL_VERSION, vch, vch.size());
+
+	// 二进制格式的牌堆/证明已经是紧凑的字节, 原样写入
+	if (!str.empty() && (unsigned char)str[0] == POKER_CARD_BINARY_MAGIC)
+	{
+		packLiteral(w, str);
+		WriteVarInt<CVectorWriter, uint64_t>(w, 0);
+		return ;
+	}
+
+	std::string lit;
+	mpz_t n;
+	mpz_init(n);
+
+	size_t i = 0;
+	while (i < str.size())
+	{
+		size_t j = i;
+		while (j < str.size() && isBase62(str[j]))
+			j++;
+
+		if (j - i >= POKER_PROOF_MIN_DIGITS)
+		{
+			packLiteral(w, lit);
+			lit.clear();
+
+			std::string digits = str.substr(i, j - i);
+			mpz_set_str(n, digits.c_str(), 62);
+			std::vector<unsigned char> bytes((mpz_sizeinbase(n, 2) + 7) / 8);
+			size_t count = 0;
+			mpz_export(bytes.data(), &count, 1, 1, 1, 0, n);
+			bytes.resize(count);
+
+			WriteVarInt<CVectorWriter, uint64_t>(w, ((uint64_t)digits.size() << 1) | 1);
+			w << bytes;
+			i = j;
+		}
+		else if (j > i)
+		{
+			lit.append(str, i, j - i);
+			i = j;
+		}
+		else
+		{
+			lit.push_back(str[i]);
+			i++;
+		}
+	}
+	packLiteral(w, lit);
+	WriteVarInt<CVectorWriter, uint64_t>(w, 0);
+	mpz_clear(n);
+}
+
+bool CPackedProof::AppendDigits(uint64_t nDigits, const std::vector<unsigned char> &vch)
+{
+	mpz_t n;
+	mpz_init(n);
+	if (!vch.empty())
+		mpz_import(n, vch.size(), 1, 1, 1, 0, vch.data());
+	std::vector<char> buf(mpz_sizeinbase(n, 62) + 2);
+	mpz_get_str(buf.data(), 62, n);
+	mpz_clear(n);
+
+	std::string digits(buf.data());
+	if (digits.size() > nDigits)
+		return false;
+	str.append(nDigits - digits.size(), '0');
+	str.append(digits);
+	return true;
+}
+
+
+bool IsBinaryPayload(const std::string &payload)
+{
+	return !payload.empty() && (unsigned char)payload[0] == POKER_PAYLOAD_MAGIC;
+}
+
+static bool txidToSeat(const std::string &txid, uint32_t &nSeat)
+{
+	auto it = g_tmcg->mPlayerIndex.find(txid);
+	if (it == g_tmcg->mPlayerIndex.end() || it->second < 0 || (uint32_t)it->second >= MAX_POKER_SEATS)
+		return false;
+	nSeat = it->second;
+	return true;
+}
+
+static bool seatToTxid(uint32_t nSeat, std::string &txid)
+{
+	auto it = g_tmcg->mPlayerTxid.find(nSeat);
+	if (it == g_tmcg->mPlayerTxid.end())
+		return false;
+	txid = it->second;
+	return true;
+}
+
+static bool encodeAmount(int n, uint32_t &nOut)
+{
+	if (n < 0)
+		return false;
+	nOut = n;
+	return true;
+}
+
+static bool encodeHeader(int pokercode, const UniValue &val, CPokerPayloadHeader &header)
+{
+	std::string tableID = val["tableID"].get_str();
+	if (tableID.size() != 64 || !IsHex(tableID))
+		return false;
+	header.tableID = uint256S(tableID);
+	if (header.tableID.GetHex() != tableID)
+		return false;
+	header.nPokerCode = pokercode;
+	return txidToSeat(val["txID"].get_str(), header.nSeat);
+}
+
+static bool encodeBet(const UniValue &val, CPokerBetPayload &bet)
+{
+	std::string nextBetTxID = val["nextBetTxID"].get_str();
+	if (!nextBetTxID.empty()) {
+		if (!txidToSeat(nextBetTxID, bet.nNextBetSeat))
+			return false;
+		bet.nNextBetSeat++;
+	}
+	if (val["curBetTxID"].get_str() != val["txID"].get_str())
+		return false;
+	if (!encodeAmount(val["curBet"].get_int(), bet.nCurBet) ||
+		!encodeAmount(val["maxBet"].get_int(), bet.nMaxBet) ||
+		!encodeAmount(val["jackpot"].get_int(), bet.nJackpot) ||
+		!encodeAmount(val["publicIndex"].get_int(), bet.nPublicIndex))
+		return false;
+	if (val["fGameOver"].get_bool())
+		bet.nFlags |= CPokerBetPayload::FLAG_GAME_OVER;
+	if (val["fFlopCard"].get_bool())
+		bet.nFlags |= CPokerBetPayload::FLAG_FLOP_CARD;
+
+	uint32_t nSeat;
+	for (auto &it : val["mHasBet"].getValues()) {
+		if (!txidToSeat(it["txID"].get_str(), nSeat) || !encodeAmount(it["hasBet"].get_int(), bet.hasBet.mValue[nSeat]))
+			return false;
+	}
+	for (auto &it : val["mBalance"].getValues()) {
+		if (!txidToSeat(it["txID"].get_str(), nSeat) || !encodeAmount(it["balance"].get_int(), bet.balance.mValue[nSeat]))
+			return false;
+	}
+	for (auto &it : val["mPlayerStatus"].getValues()) {
+		int index = it["txIndex"].get_int();
+		if (index < 0 || (uint32_t)index >= MAX_POKER_SEATS || !encodeAmount(it["status"].get_int(), bet.playerStatus.mValue[index]))
+			return false;
+	}
+	return true;
+}
+
+bool EncodePokerPayload(int pokercode, const UniValue &val, std::string &payload)
+{
+	CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+	try {
+		if (pokercode == PC_POKER_SHUFFLE)
+		{
+			CPokerShufflePayload shuffle;
+			if (!encodeHeader(pokercode, val, shuffle.header))
+				return false;
+			shuffle.nNextShuffleIndex = val["nextShuffleIndex"].get_int();
+			shuffle.shuffle.str = val["tmcg_shuffle"].get_str();
+			ss << shuffle;
+		}
+		else if (pokercode == PC_POKER_HAND_CARD)
+		{
+			CPokerHandCardPayload hand;
+			if (!encodeHeader(pokercode, val, hand.header))
+				return false;
+			for (auto &it : val["handCards"].getValues()) {
+				uint32_t nSeat;
+				if (!txidToSeat(it["htxid"].get_str(), nSeat))
+					return false;
+				std::vector<CPackedProof> &vCard = hand.mHandCard[nSeat];
+				for (auto &card : it["hcard"].getValues())
+					vCard.push_back(CPackedProof(card.get_str()));
+			}
+			ss << hand;
+		}
+		else if (pokercode == PC_POKER_FLOP_CARD || pokercode == PC_POKER_OPEN_HAND)
+		{
+			CPokerCardsPayload cards;
+			if (!encodeHeader(pokercode, val, cards.header))
+				return false;
+			if (pokercode == PC_POKER_FLOP_CARD && !encodeAmount(val["flopIndex"].get_int(), cards.nFlopIndex))
+				return false;
+			for (auto &card : val[pokercode == PC_POKER_FLOP_CARD ? "flopCards" : "openhands"].getValues())
+				cards.vCard.push_back(CPackedProof(card.get_str()));
+			ss << cards;
+		}
+		else if (pokercode == PC_POKER_BET)
+		{
+			CPokerBetPayload bet;
+			if (!encodeHeader(pokercode, val, bet.header) || !encodeBet(val, bet))
+				return false;
+			ss << bet;
+		}
+		else
+		{
+			return false;
+		}
+	} catch (const std::exception &e) {
+		std::cout << "EncodePokerPayload " << pokercode << " failed : " << e.what() << std::endl;
+		return false;
+	}
+	payload.assign(ss.begin(), ss.end());
+	return true;
+}
+
+UniValue EncodeBinaryCardsAsHex(const UniValue &val)
+{
+	if (val.isStr())
+	{
+		const std::string &str = val.get_str();
+		if (!str.empty() && (unsigned char)str[0] == POKER_CARD_BINARY_MAGIC)
+			return UniValue(POKER_CARD_HEX_PREFIX + HexStr(str.begin(), str.end()));
+		return val;
+	}
+	if (val.isArray())
+	{
+		UniValue arr(UniValue::VARR);
+		for (auto &it : val.getValues())
+			arr.push_back(EncodeBinaryCardsAsHex(it));
+		return arr;
+	}
+	if (val.isObject())
+	{
+		UniValue obj(UniValue::VOBJ);
+		const std::vector<std::string> &keys = val.getKeys();
+		const std::vector<UniValue> &values = val.getValues();
+		for (size_t i = 0; i < keys.size(); i++)
+			obj.push_back(Pair(keys[i], EncodeBinaryCardsAsHex(values[i])));
+		return obj;
+	}
+	return val;
+}
+
+std::string DecodeHexCards(const std::string &msg)
+{
+	if (msg.empty() || msg[0] != POKER_CARD_HEX_PREFIX || !IsHex(msg.substr(1)))
+		return msg;
+	std::vector<unsigned char> vch = ParseHex(msg.substr(1));
+	if (vch.empty() || vch[0] != POKER_CARD_BINARY_MAGIC)
+		return msg;
+	return std::string(vch.begin(), vch.end());
+}
+
+
+template<typename T>
+static bool decodeBinary(const std::string &payload, int pokercode, T &obj, std::string &txID)
+{
+	try {
+		CDataStream ss(payload.data(), payload.data() + payload.size(), SER_NETWORK, PROTOCOL_VERSION);
+		ss >> obj;
+		if (!ss.empty())
+			return false;
+	} catch (const std::exception &e) {
+		std::cout << "decode poker payload " << pokercode << " failed : " << e.what() << std::endl;
+		return false;
+	}
+	if (obj.header.nVersion != POKER_PAYLOAD_VERSION || obj.header.nPokerCode != pokercode)
+		return false;
+	// 座位号按当前牌桌解释, 消息必须属于这个牌桌
+	if (obj.header.tableID.GetHex() != g_tmcg->matchTableID)
+	{
+		std::cout << "decode poker payload " << pokercode << " : wrong table " << obj.header.tableID.GetHex() << std::endl;
+		return false;
+	}
+	return seatToTxid(obj.header.nSeat, txID);
+}
+
+bool DecodeShuffleMsg(const std::string &payload, PokerShuffleMsg &msg)
+{
+	if (IsBinaryPayload(payload))
+	{
+		CPokerShufflePayload shuffle;
+		if (!decodeBinary(payload, PC_POKER_SHUFFLE, shuffle, msg.txID))
+			return false;
+		msg.nextShuffleIndex = shuffle.nNextShuffleIndex;
+		msg.shuffle.swap(shuffle.shuffle.str);
+		return true;
+	}
+
+	try {
+		json jsonMsg = json::parse(payload);
+		if(jsonMsg.find("txID") == jsonMsg.end() || jsonMsg.find("nextShuffleIndex") == jsonMsg.end()|| jsonMsg.find("tmcg_shuffle") == jsonMsg.end())
+			return false;
+		msg.txID = jsonMsg["txID"].get<std::string>();
+		msg.nextShuffleIndex = jsonMsg["nextShuffleIndex"].get<int>();
+		msg.shuffle = jsonMsg["tmcg_shuffle"].get<std::string>();
+	} catch (const std::exception &e) {
+		std::cout << "DecodeShuffleMsg : " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool DecodeHandCardMsg(const std::string &payload, PokerHandCardMsg &msg)
+{
+	if (IsBinaryPayload(payload))
+	{
+		CPokerHandCardPayload hand;
+		if (!decodeBinary(payload, PC_POKER_HAND_CARD, hand, msg.txID))
+			return false;
+		for (auto &it : hand.mHandCard) {
+			std::string htxid;
+			if (!seatToTxid(it.first, htxid))
+				return false;
+			std::vector<std::string> &vCard = msg.mHandCard[htxid];
+			for (auto &card : it.second)
+				vCard.push_back(card.str);
+		}
+		return true;
+	}
+
+	try {
+		json jsonMsg = json::parse(payload);
+		if(jsonMsg.find("txID") == jsonMsg.end() || jsonMsg.find("handCards") == jsonMsg.end() || !jsonMsg["handCards"].is_array())
+			return false;
+		msg.txID = jsonMsg["txID"].get<std::string>();
+		for(auto &arrayIt : jsonMsg["handCards"])
+		{
+			std::string htxid = arrayIt["htxid"].get<std::string>();
+			if(msg.mHandCard.count(htxid))
+				return false;
+			std::vector<std::string> &vCard = msg.mHandCard[htxid];
+			for(auto &card : arrayIt["hcard"])
+				vCard.push_back(card.get<std::string>());
+		}
+	} catch (const std::exception &e) {
+		std::cout << "DecodeHandCardMsg : " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool DecodeCardsMsg(const std::string &payload, int pokercode, PokerCardsMsg &msg)
+{
+	if (IsBinaryPayload(payload))
+	{
+		CPokerCardsPayload cards;
+		if (!decodeBinary(payload, pokercode, cards, msg.txID))
+			return false;
+		if (pokercode == PC_POKER_FLOP_CARD)
+			msg.flopIndex = cards.nFlopIndex;
+		for (auto &card : cards.vCard)
+			msg.vCard.push_back(card.str);
+		return true;
+	}
+
+	const char *key = pokercode == PC_POKER_FLOP_CARD ? "flopCards" : "openhands";
+	try {
+		json jsonMsg = json::parse(payload);
+		if(jsonMsg.find("txID") == jsonMsg.end() || jsonMsg.find(key) == jsonMsg.end() || !jsonMsg[key].is_array())
+			return false;
+		msg.txID = jsonMsg["txID"].get<std::string>();
+		if(pokercode == PC_POKER_FLOP_CARD && jsonMsg.find("flopIndex") != jsonMsg.end())
+			msg.flopIndex = jsonMsg["flopIndex"].get<int>();
+		for(auto &card : jsonMsg[key])
+			msg.vCard.push_back(card.get<std::string>());
+	} catch (const std::exception &e) {
+		std::cout << "DecodeCardsMsg : " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool decodeSeatValues(const CSeatValues &values, std::map<std::string, int> &mValue)
+{
+	for (auto &it : values.mValue) {
+		std::string txid;
+		if (!seatToTxid(it.first, txid))
+			return false;
+		mValue[txid] = it.second;
+	}
+	return true;
+}
+
+bool DecodeBetMsg(const std::string &payload, std::string &txID, BetIpfsMsg &msg)
+{
+	if (IsBinaryPayload(payload))
+	{
+		CPokerBetPayload bet;
+		if (!decodeBinary(payload, PC_POKER_BET, bet, txID))
+			return false;
+		msg.curBetTxID = txID;
+		msg.nextBetTxID.clear();
+		if (bet.nNextBetSeat && !seatToTxid(bet.nNextBetSeat - 1, msg.nextBetTxID))
+			return false;
+		msg.curBet = bet.nCurBet;
+		msg.maxBet = bet.nMaxBet;
+		msg.jackpot = bet.nJackpot;
+		msg.publicIndex = bet.nPublicIndex;
+		msg.fGameOver = (bet.nFlags & CPokerBetPayload::FLAG_GAME_OVER) != 0;
+		msg.fFlopCard = (bet.nFlags & CPokerBetPayload::FLAG_FLOP_CARD) != 0;
+		if (!decodeSeatValues(bet.hasBet, msg.mHasBet) || !decodeSeatValues(bet.balance, msg.mBalance))
+			return false;
+		for (auto &it : bet.playerStatus.mValue)
+			msg.mPlayerStatus[it.first] = it.second;
+		return true;
+	}
+
+	try {
+		json jsonMsg = json::parse(payload);
+		if(jsonMsg.find("tableID") == jsonMsg.end() || jsonMsg.find("txID") == jsonMsg.end())
+			return false;
+		if(!jsonMsg["mHasBet"].is_array() || !jsonMsg["mBalance"].is_array() || !jsonMsg["mPlayerStatus"].is_array())
+			return false;
+
+		txID = jsonMsg["txID"].get<std::string>();
+		msg.nextBetTxID = jsonMsg["nextBetTxID"].get<std::string>();
+		msg.curBetTxID = jsonMsg["curBetTxID"].get<std::string>();
+		msg.curBet = jsonMsg["curBet"].get<int>();
+		msg.maxBet = jsonMsg["maxBet"].get<int>();
+		msg.jackpot = jsonMsg["jackpot"].get<int>();
+		msg.publicIndex = jsonMsg["publicIndex"].get<int>();
+		msg.fGameOver = jsonMsg["fGameOver"].get<bool>();
+		msg.fFlopCard = jsonMsg["fFlopCard"].get<bool>();
+
+		for(auto &hasbetIt : jsonMsg["mHasBet"])
+			msg.mHasBet.insert(std::make_pair(hasbetIt["txID"].get<std::string>(), hasbetIt["hasBet"].get<int>()));
+		for(auto &balanceIt : jsonMsg["mBalance"])
+			msg.mBalance.insert(std::make_pair(balanceIt["txID"].get<std::string>(), balanceIt["balance"].get<int>()));
+		for(auto &statusIt : jsonMsg["mPlayerStatus"])
+			msg.mPlayerStatus.insert(std::make_pair(statusIt["txIndex"].get<int>(), statusIt["status"].get<int>()));
+	} catch (const std::exception &e) {
+		std::cout << "DecodeBetMsg : " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
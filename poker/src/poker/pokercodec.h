@@ -0,0 +1,286 @@
+#ifndef POKER_CODEC_H
+#define POKER_CODEC_H
+
+#include "serialize.h"
+#include "uint256.h"
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class UniValue;
+struct BetIpfsMsg;
+
+/**
+ * 牌局消息的二进制格式
+ *
+ * 首字节为 magic(json 总是以 '{' 开头, 以此区分两种格式), 然后是版本号和 pokercode.
+ * 玩家用座位号(g_tmcg->mPlayerIndex)表示, 金额用 varint, 卡牌证明按 base-62 数字段转成字节.
+ * 读取时两种格式都支持, 写入格式由 -pokerbinary 决定.
+ */
+static const unsigned char POKER_PAYLOAD_MAGIC = 0xb7;
+static const unsigned char POKER_PAYLOAD_VERSION = 2;
+/** 默认写 json, 旧节点只能读 json */
+static const bool DEFAULT_POKER_BINARY_PAYLOAD = false;
+/** 单个卡牌证明解码后的最大长度 */
+static const size_t MAX_POKER_PROOF_SIZE = 16 << 20;
+/** 座位号上限 */
+static const uint32_t MAX_POKER_SEATS = 64;
+/** 不少于这么多位的 base-62 数字段才转成字节 */
+static const size_t POKER_PROOF_MIN_DIGITS = 8;
+
+/**
+ * 牌堆和卡牌证明的二进制格式(libTMCG 的二进制流, 见 TMCG_ParseHelper::set_binary)以此字节开头,
+ * 文本格式总是以字母数字开头, 读取时按首字节判断. 只在二进制消息中使用.
+ */
+static const unsigned char POKER_CARD_BINARY_MAGIC = 0xb8;
+/** 二进制消息编码失败改写 json 时, 二进制的牌堆和证明转成 hex 并以此字符开头 */
+static const char POKER_CARD_HEX_PREFIX = '#';
+/** 默认新牌桌用文本格式写牌堆和证明, 旧节点只能读文本格式 */
+static const bool DEFAULT_POKER_BINARY_CARDS = false;
+
+extern bool fPokerBinaryPayload;
+extern bool fPokerBinaryCards;
+
+/**
+ * 卡牌证明(libTMCG 的文本格式: 由 '|' '^' '\n' 等分隔的 base-62 大数)
+ *
+ * 序列化为若干段, 每段以 varint h 开头: h 的最低位为 0 表示原样字节(长度 h>>1),
+ * 为 1 表示 h>>1 位的 base-62 数, 后面跟大端字节; h == 0 结束.
+ */
+class CPackedProof
+{
+public:
+	std::string str;
+
+	CPackedProof() {}
+	CPackedProof(const std::string &strIn) : str(strIn) {}
+
+	template<typename Stream>
+	void Serialize(Stream &s) const
+	{
+		std::vector<unsigned char> vch;
+		Pack(vch);
+		s.write((const char*)vch.data(), vch.size());
+	}
+
+	template<typename Stream>
+	void Unserialize(Stream &s)
+	{
+		str.clear();
+		while (true) {
+			uint64_t h = ReadVarInt<Stream, uint64_t>(s);
+			if (h == 0)
+				break;
+			uint64_t nLen = h >> 1;
+			if (nLen > MAX_POKER_PROOF_SIZE || str.size() + nLen > MAX_POKER_PROOF_SIZE)
+				throw std::ios_base::failure("CPackedProof: proof too large");
+			if (h & 1) {
+				std::vector<unsigned char> vch;
+				s >> vch;
+				if (!AppendDigits(nLen, vch))
+					throw std::ios_base::failure("CPackedProof: bad number");
+			} else {
+				size_t nPos = str.size();
+				str.resize(nPos + nLen);
+				s.read(&str[nPos], nLen);
+			}
+		}
+	}
+
+private:
+	void Pack(std::vector<unsigned char> &vch) const;
+	bool AppendDigits(uint64_t nDigits, const std::vector<unsigned char> &vch);
+};
+
+/** 按座位号保存的非负整数(下注额/余额/状态) */
+class CSeatValues
+{
+public:
+	std::map<uint32_t, uint32_t> mValue;
+
+	template<typename Stream>
+	void Serialize(Stream &s) const
+	{
+		WriteCompactSize(s, mValue.size());
+		for (auto &it : mValue) {
+			WriteVarInt<Stream, uint32_t>(s, it.first);
+			WriteVarInt<Stream, uint32_t>(s, it.second);
+		}
+	}
+
+	template<typename Stream>
+	void Unserialize(Stream &s)
+	{
+		mValue.clear();
+		uint64_t nSize = ReadCompactSize(s);
+		if (nSize > MAX_POKER_SEATS)
+			throw std::ios_base::failure("CSeatValues: too many seats");
+		for (uint64_t i = 0; i < nSize; i++) {
+			uint32_t nSeat = ReadVarInt<Stream, uint32_t>(s);
+			mValue[nSeat] = ReadVarInt<Stream, uint32_t>(s);
+		}
+	}
+};
+
+/** 二进制消息头 */
+class CPokerPayloadHeader
+{
+public:
+	unsigned char nMagic;
+	unsigned char nVersion;
+	unsigned char nPokerCode;
+	uint256 tableID;
+	uint32_t nSeat;		//发送者座位号
+
+	CPokerPayloadHeader() : nMagic(POKER_PAYLOAD_MAGIC), nVersion(POKER_PAYLOAD_VERSION), nPokerCode(0), nSeat(0) {}
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(nMagic);
+		READWRITE(nVersion);
+		READWRITE(nPokerCode);
+		READWRITE(tableID);
+		READWRITE(VARINT(nSeat));
+	}
+};
+
+/** PC_POKER_SHUFFLE */
+class CPokerShufflePayload
+{
+public:
+	CPokerPayloadHeader header;
+	uint32_t nNextShuffleIndex;
+	CPackedProof shuffle;
+
+	CPokerShufflePayload() : nNextShuffleIndex(0) {}
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(header);
+		READWRITE(VARINT(nNextShuffleIndex));
+		READWRITE(shuffle);
+	}
+};
+
+/** PC_POKER_HAND_CARD: 座位号 -> 该玩家的手牌证明 */
+class CPokerHandCardPayload
+{
+public:
+	CPokerPayloadHeader header;
+	std::map<uint32_t, std::vector<CPackedProof> > mHandCard;
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(header);
+		READWRITE(mHandCard);
+	}
+};
+
+/** PC_POKER_FLOP_CARD / PC_POKER_OPEN_HAND */
+class CPokerCardsPayload
+{
+public:
+	CPokerPayloadHeader header;
+	uint32_t nFlopIndex;	//第一张公共牌的下标, PC_POKER_OPEN_HAND 为 0
+	std::vector<CPackedProof> vCard;
+
+	CPokerCardsPayload() : nFlopIndex(0) {}
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(header);
+		READWRITE(VARINT(nFlopIndex));
+		READWRITE(vCard);
+	}
+};
+
+/** PC_POKER_BET, 对应 BetIpfsMsg */
+class CPokerBetPayload
+{
+public:
+	CPokerPayloadHeader header;		//header.nSeat 即 curBetTxID
+	uint32_t nNextBetSeat;			//座位号 + 1, 0 表示没有
+	uint32_t nCurBet;
+	uint32_t nMaxBet;
+	uint32_t nJackpot;
+	uint32_t nPublicIndex;
+	unsigned char nFlags;
+	CSeatValues hasBet;
+	CSeatValues balance;
+	CSeatValues playerStatus;
+
+	enum {
+		FLAG_GAME_OVER = 1,
+		FLAG_FLOP_CARD = 2,
+	};
+
+	CPokerBetPayload() : nNextBetSeat(0), nCurBet(0), nMaxBet(0), nJackpot(0), nPublicIndex(0), nFlags(0) {}
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(header);
+		READWRITE(VARINT(nNextBetSeat));
+		READWRITE(VARINT(nCurBet));
+		READWRITE(VARINT(nMaxBet));
+		READWRITE(VARINT(nJackpot));
+		READWRITE(VARINT(nPublicIndex));
+		READWRITE(nFlags);
+		READWRITE(hasBet);
+		READWRITE(balance);
+		READWRITE(playerStatus);
+	}
+};
+
+/** 解码后的洗牌消息 */
+struct PokerShuffleMsg
+{
+	std::string txID;
+	int nextShuffleIndex;
+	std::string shuffle;
+};
+
+/** 解码后的手牌消息, htxid -> 证明 */
+struct PokerHandCardMsg
+{
+	std::string txID;
+	std::map<std::string, std::vector<std::string> > mHandCard;
+};
+
+/** 解码后的公共牌/亮牌消息 */
+struct PokerCardsMsg
+{
+	std::string txID;
+	int flopIndex = -1;	//第一张公共牌的下标, 旧版本的消息没有时为 -1
+	std::vector<std::string> vCard;
+};
+
+bool IsBinaryPayload(const std::string &payload);
+
+/** 把 createIpfsMsg/createBetIpfs 生成的 json 转成二进制格式, 不支持的 pokercode 或无法编码时返回 false */
+bool EncodePokerPayload(int pokercode, const UniValue &val, std::string &payload);
+
+/** 把 val 中二进制的牌堆和证明转成 POKER_CARD_HEX_PREFIX + hex, 使它能写成 json */
+UniValue EncodeBinaryCardsAsHex(const UniValue &val);
+
+/** 牌堆和证明的 hex 形式还原成二进制, 其他格式原样返回 */
+std::string DecodeHexCards(const std::string &msg);
+
+/** 以下解码函数同时支持 json 和二进制格式, 格式错误返回 false */
+bool DecodeShuffleMsg(const std::string &payload, PokerShuffleMsg &msg);
+bool DecodeHandCardMsg(const std::string &payload, PokerHandCardMsg &msg);
+bool DecodeCardsMsg(const std::string &payload, int pokercode, PokerCardsMsg &msg);
+bool DecodeBetMsg(const std::string &payload, std::string &txID, BetIpfsMsg &msg);
+
+#endif // POKER_CODEC_H
@@ -0,0 +1,174 @@
+#include "pokeringest.h"
+#include "poker.h"
+#include "pokerloop.h"
+#include "txmempool.h"
+#include "util.h"
+
+#include <boost/bind.hpp>
+
+CPokerIngestQueue pokerIngestQueue;
+
+bool IsPokerScript(const CScript &script)
+{
+	if(script.size() < 3 || script[0] != OP_RETURN)
+		return false;
+
+	if(script[2] == PC_POKER_MATCH)
+		return true;
+
+	if(script[1] == OP_POKER)
+		return false;
+
+	if(script[2] == PC_POKER_MATCH_FINISH)
+		return script.size() > 3;
+
+	if(script.size() <= 68)
+		return false;
+
+	switch(script[3])
+	{
+	case PC_NEW_ADDRESS:
+	case PC_POKER_ADDRESS:
+	case PC_POKER_BALANCE:
+	case PC_POKER_HANDLE:
+	case PC_POKER_PUBKEY:
+	case PC_POKER_PUBKEY_VERIFY:
+	case PC_POKER_SSH:
+	case PC_POKER_SHUFFLE:
+	case PC_POKER_HAND_CARD:
+	case PC_POKER_FLOP_CARD:
+	case PC_POKER_OPEN_HAND:
+	case PC_POKER_BET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// ipfs cat, 不访问牌桌状态, 可以在任意线程调用
+static void FetchPayload(const CScript &script, std::string &getResponseStr)
+{
+	std::string hash;
+	if(script[2] == PC_POKER_MATCH)
+		return ;
+	else if(script[2] == PC_POKER_MATCH_FINISH)
+		hash.assign(script.begin() + 3, script.end());
+	else
+		hash.assign(script.begin() + 68, script.end());
+
+	ipfsCatFile(hash, getResponseStr);
+}
+
+// 更新牌桌状态, 在牌局线程执行
+static void ApplyPayload(const CScript &script, std::string &getResponseStr, const CTransaction &tx)
+{
+	try
+	{
+		if(script[2] == PC_POKER_MATCH)
+			parseMatchScript(script, tx);
+		else
+			parseTxScript(script, getResponseStr, tx);
+	}
+	catch(const std::exception &e)
+	{
+		std::cout << "poker ingest " << tx.GetHash().ToString() << " error : " << e.what() << std::endl;
+	}
+}
+
+CPokerIngestQueue::CPokerIngestQueue() : CPokerIngestQueue(FetchPayload, ApplyPayload)
+{
+}
+
+void CPokerIngestQueue::Push(const CScript &script, const CTransactionRef &tx)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(mutex);
+		if(nWorkers > 0)
+		{
+			uint64_t nSeq = nNextSeq++;
+			CPokerIngestItem &item = mapItems[nSeq];
+			item.script = script;
+			item.tx = tx;
+			queueFetch.push_back(nSeq);
+			condWorker.notify_one();
+			return ;
+		}
+	}
+
+	std::shared_ptr<std::string> payload = std::make_shared<std::string>();
+	fnFetch(script, *payload);
+	ApplyFn fn = fnApply;
+	pokerEventLoop.Post([fn, script, payload, tx]() { fn(script, *payload, *tx); });
+}
+
+void CPokerIngestQueue::ApplyReady()
+{
+	// 在 mutex 下按序号投递到牌局线程, 投递顺序即应用顺序
+	boost::unique_lock<boost::mutex> lock(mutex);
+	while(true)
+	{
+		auto it = mapItems.find(nNextApply);
+		if(it == mapItems.end() || !it->second.fFetched)
+			return ;
+		std::shared_ptr<CPokerIngestItem> item = std::make_shared<CPokerIngestItem>(std::move(it->second));
+		mapItems.erase(it);
+		++nNextApply;
+		ApplyFn fn = fnApply;
+		pokerEventLoop.Post([fn, item]() { fn(item->script, item->strPayload, *item->tx); });
+	}
+}
+
+void CPokerIngestQueue::Thread()
+{
+	while(true)
+	{
+		uint64_t nSeq;
+		CScript script;
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			while(queueFetch.empty())
+				condWorker.wait(lock);
+			nSeq = queueFetch.front();
+			queueFetch.pop_front();
+			script = mapItems[nSeq].script;
+		}
+
+		std::string getResponseStr;
+		fnFetch(script, getResponseStr);
+
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			CPokerIngestItem &item = mapItems[nSeq];
+			item.strPayload.swap(getResponseStr);
+			item.fFetched = true;
+		}
+		ApplyReady();
+	}
+}
+
+void CPokerIngestQueue::SetWorkers(int n)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	nWorkers = n;
+}
+
+size_t CPokerIngestQueue::Size()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return mapItems.size();
+}
+
+static void ThreadPokerIngest()
+{
+	RenameThread("bitcoin-pokerin");
+	pokerIngestQueue.Thread();
+}
+
+void StartPokerIngest(boost::thread_group &threadGroup, int nThreads)
+{
+	nThreads = std::max(0, std::min(nThreads, MAX_POKER_INGEST_THREADS));
+	std::cout << "Using " << nThreads << " threads for poker ingest" << std::endl;
+	pokerIngestQueue.SetWorkers(nThreads);
+	for(int i = 0; i < nThreads; ++i)
+		threadGroup.create_thread(&ThreadPokerIngest);
+}
@@ -0,0 +1,83 @@
+#ifndef POKER_INGEST_H
+#define POKER_INGEST_H
+
+#include "primitives/transaction.h"
+#include "script/script.h"
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <string>
+
+/** 默认摄取线程数, 0 = 在交易池线程内同步处理(旧行为) */
+static const int DEFAULT_POKER_INGEST_THREADS = 2;
+static const int MAX_POKER_INGEST_THREADS = 16;
+
+/** 是否为需要摄取的牌局输出(OP_RETURN + PC_POKER_*) */
+bool IsPokerScript(const CScript &script);
+
+/**
+ * 牌局交易摄取队列
+ *
+ * 交易池在 cs_main 下只给牌局输出打标签并入队, 工作线程在 cs_main 之外
+ * 拉取 ipfs 数据; 拉取可以并发完成, 但解析/验证/更新牌桌状态严格按入队
+ * 顺序投递到牌局线程(pokerloop.h)执行, 与原来同步处理时的顺序一致.
+ */
+class CPokerIngestQueue
+{
+public:
+	/** 拉取输出对应的数据, 在工作线程执行 */
+	typedef std::function<void(const CScript&, std::string&)> FetchFn;
+	/** 更新牌桌状态, 在牌局线程执行 */
+	typedef std::function<void(const CScript&, std::string&, const CTransaction&)> ApplyFn;
+
+private:
+	struct CPokerIngestItem
+	{
+		CPokerIngestItem() : fFetched(false) {}
+		CScript script;
+		CTransactionRef tx;
+		std::string strPayload;
+		bool fFetched;
+	};
+
+	boost::mutex mutex;
+	boost::condition_variable condWorker;
+
+	//! 入队序号 -> 待处理输出
+	std::map<uint64_t, CPokerIngestItem> mapItems;
+	//! 等待拉取的序号
+	std::deque<uint64_t> queueFetch;
+	uint64_t nNextSeq;
+	//! 下一个要应用到牌桌的序号
+	uint64_t nNextApply;
+	int nWorkers;
+	FetchFn fnFetch;
+	ApplyFn fnApply;
+
+	void ApplyReady();
+
+public:
+	/** 拉取 ipfs 数据, 用 parseTxScript/parseMatchScript 更新牌桌 */
+	CPokerIngestQueue();
+	CPokerIngestQueue(FetchFn fnFetchIn, ApplyFn fnApplyIn) : nNextSeq(0), nNextApply(0), nWorkers(0), fnFetch(fnFetchIn), fnApply(fnApplyIn) {}
+
+	/** 入队一个牌局输出, 没有工作线程时同步处理 */
+	void Push(const CScript &script, const CTransactionRef &tx);
+
+	/** 工作线程主循环 */
+	void Thread();
+
+	void SetWorkers(int n);
+
+	size_t Size();
+};
+
+extern CPokerIngestQueue pokerIngestQueue;
+
+void StartPokerIngest(boost::thread_group &threadGroup, int nThreads);
+
+#endif // POKER_INGEST_H
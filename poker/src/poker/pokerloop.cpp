@@ -0,0 +1,216 @@
+#include "pokerloop.h"
+#include "tablemanager.h"
+#include "util.h"
+
+#include <future>
+
+CPokerEventLoop pokerEventLoop;
+
+std::shared_ptr<const CPokerTableSnapshot> MakeTableSnapshot()
+{
+	std::shared_ptr<CPokerTableSnapshot> snap = std::make_shared<CPokerTableSnapshot>();
+	snap->matchTableID = g_tmcg->matchTableID;
+	snap->matchTxID = g_tmcg->matchTxID;
+	snap->myindex = g_tmcg->myindex;
+	snap->playersize = g_tmcg->playersize;
+	snap->nMatchAddress = g_tmcg->mMatchAddress.size();
+	snap->fPokerAddressVerify = g_tmcg->fPokerAddressVerify;
+	snap->mPokerBalance = g_tmcg->mPokerBalance;
+	snap->mPlayerTxid = g_tmcg->mPlayerTxid;
+	snap->mPlayerIndex = g_tmcg->mPlayerIndex;
+	snap->fHandle = !g_tmcg->getVtmfHandle().empty();
+	snap->fAllPubkeyVerify = g_tmcg->fAllPubkeyVerify;
+	snap->fMyPubkeyVerify = g_tmcg->fMyPubkeyVerify;
+	snap->fSelfSshe = !g_tmcg->selfsshe.empty();
+	snap->fVerifySSHE = g_tmcg->fVerifySSHE;
+	snap->nextShuffleIndex = g_tmcg->nextShuffleIndex;
+	for (size_t i = 0; i < g_tmcg->private_hand.size(); ++i)
+		snap->vHandCard.push_back(g_tmcg->showPokerNumber(g_tmcg->private_hand[i].first));
+	snap->nBetPlayer = g_tmcg->vTxBetPlayer.size();
+	snap->nBetVerify = g_tmcg->vTxBetVerify.size();
+	snap->gBetIpfsMsg = g_tmcg->gBetIpfsMsg;
+	for (size_t k = 0; k < g_tmcg->open_flop.size(); ++k)
+		snap->vFlopCard.push_back(g_tmcg->showPokerNumber(g_tmcg->open_flop[k].first));
+	for (size_t i = 0; i < g_tmcg->open_hand.size(); ++i)
+		snap->vOpenHand.push_back(g_tmcg->showPokerNumber(g_tmcg->open_hand[i].first));
+	if (g_tmcg->gBetIpfsMsg.fGameOver)
+		snap->nDiscardWinIndex = isGameOver();
+	snap->fDiscardMsg = g_tmcg->fDiscardMsg;
+	snap->vWinIndex = g_tmcg->vWinIndex;
+	snap->mPokerTypes = g_tmcg->mPokerTypes;
+	if (!g_tmcg->vWinIndex.empty() && g_tmcg->mBestGroups.count(g_tmcg->vWinIndex[0]))
+	{
+		for (auto &it : g_tmcg->mBestGroups[g_tmcg->vWinIndex[0]])
+			snap->vBestGroup.push_back(g_tmcg->showPokerNumber(it));
+	}
+	return snap;
+}
+
+std::shared_ptr<const CPokerTableSnapshot> GetTableSnapshot(const tmcg &table)
+{
+	std::shared_ptr<const CPokerTableSnapshot> snap = std::atomic_load(&table.snapshot);
+	if (!snap)
+		snap = std::make_shared<CPokerTableSnapshot>();
+	return snap;
+}
+
+static void PublishTableSnapshot(const std::shared_ptr<tmcg> &table)
+{
+	CPokerTableScope scope(table);
+	std::atomic_store(&table->snapshot, MakeTableSnapshot());
+}
+
+
+CPokerEventQueue::CPokerEventQueue() : head(new CNode()), tail(head.load())
+{
+}
+
+CPokerEventQueue::~CPokerEventQueue()
+{
+	std::function<void()> fn;
+	while (Pop(fn)) {}
+	delete tail;
+}
+
+void CPokerEventQueue::Push(std::function<void()> fn)
+{
+	CNode *node = new CNode();
+	node->fn = std::move(fn);
+	CNode *prev = head.exchange(node);
+	prev->next.store(node);
+}
+
+bool CPokerEventQueue::Pop(std::function<void()> &fn)
+{
+	CNode *next = tail->next.load();
+	if (!next)
+		return false;
+	// next 成为新的哑节点
+	fn = std::move(next->fn);
+	next->fn = nullptr;
+	delete tail;
+	tail = next;
+	return true;
+}
+
+bool CPokerEventQueue::Empty() const
+{
+	return tail->next.load() == nullptr;
+}
+
+
+bool CPokerEventLoop::IsLoopThread() const
+{
+	return fStarted && idThread == boost::this_thread::get_id();
+}
+
+void CPokerEventLoop::Post(std::function<void()> fn)
+{
+	// 投递时选定的牌桌, 执行时同样选定
+	std::shared_ptr<tmcg> table = CPokerTableScope::Current();
+	if (table)
+	{
+		std::function<void()> inner = std::move(fn);
+		fn = [table, inner]() {
+			CPokerTableScope scope(table);
+			inner();
+		};
+	}
+
+	if (!fStarted)
+	{
+		Run(fn);
+		return ;
+	}
+
+	queue.Push(std::move(fn));
+	// 与 Wait 中的 fWaiting/Empty 配对, 两边至少有一边能看到对方
+	if (fWaiting)
+	{
+		boost::lock_guard<boost::mutex> lock(mutex);
+		condEvent.notify_one();
+	}
+}
+
+void CPokerEventLoop::PostAndWait(std::function<void()> fn)
+{
+	std::promise<void> done;
+	std::future<void> future = done.get_future();
+	Post(std::move(fn));
+	// 同一生产者的事件按顺序执行, 这个事件执行时上一个事件的快照已经发布
+	Post([&done]() { done.set_value(); });
+	future.wait();
+}
+
+void CPokerEventLoop::Run(std::function<void()> &fn)
+{
+	CPokerTableRecorder recorder;
+	try
+	{
+		fn();
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << "poker event error : " << e.what() << std::endl;
+	}
+
+	// 默认牌桌(P2P 消息, 不带牌桌的 rpc)和事件里选定过的牌桌可能被修改了
+	std::shared_ptr<tmcg> def = pokerTables.GetCurrent();
+	if (def)
+		recorder.Add(def);
+	std::vector<std::shared_ptr<tmcg> > vTable = recorder.Get();
+	for (auto &table : vTable)
+		PublishTableSnapshot(table);
+}
+
+void CPokerEventLoop::Wait()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	fWaiting = true;
+	if (queue.Empty())
+		condEvent.wait(lock);
+	fWaiting = false;
+}
+
+void CPokerEventLoop::Thread()
+{
+	idThread = boost::this_thread::get_id();
+	fStarted = true;
+
+	std::function<void()> fn;
+	while (true)
+	{
+		if (!queue.Pop(fn))
+		{
+			Wait();
+			continue;
+		}
+		Run(fn);
+		fn = nullptr;
+	}
+}
+
+
+bool IsPokerLoopThread()
+{
+	return pokerEventLoop.IsLoopThread();
+}
+
+UniValue CallPokerRPC(rpcfn_type fn, const JSONRPCRequest& request)
+{
+	return pokerEventLoop.Call<UniValue>([fn, &request]() { return fn(request); });
+}
+
+static void ThreadPokerEventLoop()
+{
+	RenameThread("bitcoin-poker");
+	pokerEventLoop.Thread();
+}
+
+void StartPokerEventLoop(boost::thread_group &threadGroup)
+{
+	threadGroup.create_thread(&ThreadPokerEventLoop);
+	// 等牌局线程起来, 之后投递的事件都由它执行
+	while (!pokerEventLoop.IsStarted())
+		MilliSleep(1);
+}
@@ -0,0 +1,159 @@
+#ifndef POKER_LOOP_H
+#define POKER_LOOP_H
+
+#include "poker.h"
+#include "rpc/server.h"
+
+#include <boost/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * 牌桌状态快照, 由牌局线程生成, 生成后不再修改
+ *
+ * rpc 线程读快照, 不直接读 g_tmcg.
+ */
+struct CPokerTableSnapshot
+{
+	CPokerTableSnapshot() : myindex(-1), playersize(0), nMatchAddress(0), fPokerAddressVerify(false),
+		fHandle(false), fAllPubkeyVerify(false), fMyPubkeyVerify(false), fSelfSshe(false), fVerifySSHE(false),
+		nextShuffleIndex(0), nBetPlayer(0), nBetVerify(0), nDiscardWinIndex(-1), fDiscardMsg(false) {}
+
+	std::string matchTableID;
+	std::string matchTxID;
+	int myindex;
+	int playersize;
+	size_t nMatchAddress;
+	bool fPokerAddressVerify;
+	std::map<std::string, int> mPokerBalance;
+	std::map<int, std::string> mPlayerTxid;
+	std::map<std::string, int> mPlayerIndex;
+	bool fHandle;					//vtmf 句柄是否已产生
+	bool fAllPubkeyVerify;
+	bool fMyPubkeyVerify;
+	bool fSelfSshe;					//是否已产生 sshe
+	bool fVerifySSHE;
+	int nextShuffleIndex;
+	std::vector<int> vHandCard;		//已打开的手牌(showPokerNumber)
+	size_t nBetPlayer;
+	size_t nBetVerify;
+	BetIpfsMsg gBetIpfsMsg;
+	std::vector<int> vFlopCard;
+	std::vector<int> vOpenHand;
+	int nDiscardWinIndex;			//游戏结束且其他人都弃牌时的赢家, 否则 -1
+	bool fDiscardMsg;
+	std::vector<int> vWinIndex;
+	std::map<int, int> mPokerTypes;
+	std::vector<int> vBestGroup;
+};
+
+/** 生成当前牌桌(g_tmcg)的快照, 只在牌局线程调用 */
+std::shared_ptr<const CPokerTableSnapshot> MakeTableSnapshot();
+
+/** 读牌桌最近发布的快照, 可以在任意线程调用 */
+std::shared_ptr<const CPokerTableSnapshot> GetTableSnapshot(const tmcg &table);
+
+/**
+ * 多生产者单消费者无锁队列
+ *
+ * 链表实现, 生产者只做一次 exchange 和一次 store, 不加锁;
+ * 只有牌局线程出队.
+ */
+class CPokerEventQueue
+{
+private:
+	struct CNode
+	{
+		CNode() : next(nullptr) {}
+		std::atomic<CNode*> next;
+		std::function<void()> fn;
+	};
+
+	std::atomic<CNode*> head;	//最后入队的节点
+	CNode *tail;				//哑节点, 只有消费者访问
+
+public:
+	CPokerEventQueue();
+	~CPokerEventQueue();
+
+	void Push(std::function<void()> fn);
+
+	/** 只能由消费者调用, 队列为空时返回 false */
+	bool Pop(std::function<void()> &fn);
+
+	bool Empty() const;
+};
+
+/**
+ * 牌局事件循环
+ *
+ * 所有修改牌桌状态的操作(交易池摄取, P2P 牌局消息, 修改牌局的 rpc, 下注超时)
+ * 都作为事件投递到这里, 由唯一的牌局线程按投递顺序执行, 牌桌状态不需要加锁.
+ * 事件投递时若线程选定了牌桌(CPokerTableScope), 执行时使用同一牌桌.
+ * 每个事件执行完后重新发布它访问过的牌桌的快照.
+ */
+class CPokerEventLoop
+{
+private:
+	CPokerEventQueue queue;
+	boost::mutex mutex;
+	boost::condition_variable condEvent;
+	std::atomic<bool> fWaiting;
+	std::atomic<bool> fStarted;
+	boost::thread::id idThread;
+
+	void Run(std::function<void()> &fn);
+	void Wait();
+
+public:
+	CPokerEventLoop() : fWaiting(false), fStarted(false) {}
+
+	/** 投递事件, 牌局线程还没启动时直接执行 */
+	void Post(std::function<void()> fn);
+
+	/** 投递事件并等它执行完, 返回时它修改过的牌桌快照已经发布 */
+	void PostAndWait(std::function<void()> fn);
+
+	/** 在牌局线程执行 fn 并等待结果, 异常会重新抛给调用方 */
+	template<typename T>
+	T Call(std::function<T()> fn)
+	{
+		if (!fStarted || IsLoopThread())
+			return fn();
+
+		std::unique_ptr<T> result;
+		std::exception_ptr error;
+		PostAndWait([&]() {
+			try {
+				result.reset(new T(fn()));
+			} catch (...) {
+				error = std::current_exception();
+			}
+		});
+		if (error)
+			std::rethrow_exception(error);
+		return std::move(*result);
+	}
+
+	bool IsLoopThread() const;
+	bool IsStarted() const { return fStarted; }
+
+	/** 牌局线程主循环 */
+	void Thread();
+};
+
+extern CPokerEventLoop pokerEventLoop;
+
+/** 修改牌桌状态的 rpc 在开头调用: 不在牌局线程时转到牌局线程重新执行 fn */
+bool IsPokerLoopThread();
+UniValue CallPokerRPC(rpcfn_type fn, const JSONRPCRequest& request);
+
+void StartPokerEventLoop(boost::thread_group &threadGroup);
+
+#endif // POKER_LOOP_H
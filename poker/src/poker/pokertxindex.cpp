@@ -0,0 +1,117 @@
+#include "pokertxindex.h"
+#include "utilstrencodings.h"
+
+bool CPokerTxIndex::ParseCommitment(const CScript &script, PokerCommitKey &key, std::vector<unsigned char> &vchData)
+{
+	CScript::const_iterator pc = script.begin();
+	opcodetype opcode;
+	std::vector<unsigned char> vch;
+
+	if (!script.GetOp(pc, opcode) || opcode != OP_RETURN)
+		return false;
+	if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 + key.hash.size())
+		return false;
+	if (!script.GetOp(pc, opcode, vchData) || opcode > OP_PUSHDATA4 || pc != script.end())
+		return false;
+
+	key.nPokerCode = vch[0];
+	memcpy(key.hash.begin(), vch.data() + 1, key.hash.size());
+	return true;
+}
+
+bool CPokerTxIndex::GetCommitmentIps(const CTransaction &tx, std::set<std::string> &setIp)
+{
+	PokerCommitKey key;
+	std::vector<unsigned char> vchData;
+	bool fFound = false;
+
+	for (const CTxOut &txout : tx.vout)
+	{
+		if (!ParseCommitment(txout.scriptPubKey, key, vchData))
+			continue;
+		std::vector<unsigned char> vchIp = ParseHex(std::string(vchData.begin(), vchData.end()));
+		setIp.insert(std::string(vchIp.begin(), vchIp.end()));
+		fFound = true;
+	}
+	return fFound;
+}
+
+void CPokerTxIndex::Add(const CTransactionRef &tx)
+{
+	PokerCommitKey key;
+	std::vector<unsigned char> vchData;
+	std::set<unsigned char> setCode;
+
+	LOCK(cs);
+	for (const CTxOut &txout : tx->vout)
+	{
+		if (!ParseCommitment(txout.scriptPubKey, key, vchData))
+			continue;
+
+		// 同一承诺已有交易(断块后重新进入交易池, 或者被另一笔交易替换), 只换交易, 不重复计数
+		auto it = mapCommit.find(key);
+		if (it != mapCommit.end())
+		{
+			it->second.tx = tx;
+			it->second.vchData.swap(vchData);
+			continue;
+		}
+
+		CPokerCommitEntry &entry = mapCommit[key];
+		entry.tx = tx;
+		entry.vchData.swap(vchData);
+		setCode.insert(key.nPokerCode);
+	}
+
+	for (unsigned char nPokerCode : setCode)
+		++mapCount[nPokerCode];
+}
+
+CTransactionRef CPokerTxIndex::Find(unsigned char nPokerCode, const uint160 &hash, const std::vector<unsigned char> &vchData)
+{
+	PokerCommitKey key;
+	key.nPokerCode = nPokerCode;
+	key.hash = hash;
+
+	LOCK(cs);
+	auto it = mapCommit.find(key);
+	if (it == mapCommit.end() || it->second.vchData != vchData)
+		return CTransactionRef();
+	return it->second.tx;
+}
+
+size_t CPokerTxIndex::Count(unsigned char nPokerCode)
+{
+	LOCK(cs);
+	auto it = mapCount.find(nPokerCode);
+	return it == mapCount.end() ? 0 : it->second;
+}
+
+void CPokerTxIndex::KeepPeers(const std::set<std::string> &setIp)
+{
+	std::set<std::pair<unsigned char, uint256> > setCodeTx;
+
+	LOCK(cs);
+	for (auto it = mapCommit.begin(); it != mapCommit.end(); )
+	{
+		std::vector<unsigned char> vchIp = ParseHex(std::string(it->second.vchData.begin(), it->second.vchData.end()));
+		if (!setIp.count(std::string(vchIp.begin(), vchIp.end())))
+		{
+			it = mapCommit.erase(it);
+			continue;
+		}
+		setCodeTx.insert(std::make_pair(it->first.nPokerCode, it->second.tx->GetHash()));
+		++it;
+	}
+
+	mapCount.clear();
+	for (auto &it : setCodeTx)
+		++mapCount[it.first];
+}
+
+void CPokerTxIndex::Clear()
+{
+	LOCK(cs);
+	mapCommit.clear();
+	mapCount.clear();
+}
@@ -0,0 +1,78 @@
+#ifndef POKER_TX_INDEX_H
+#define POKER_TX_INDEX_H
+
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** 承诺的键: (pokercode, Hash160(消息)) */
+struct PokerCommitKey
+{
+	unsigned char nPokerCode;
+	uint160 hash;
+
+	bool operator==(const PokerCommitKey &other) const
+	{
+		return nPokerCode == other.nPokerCode && hash == other.hash;
+	}
+};
+
+struct PokerCommitKeyHasher
+{
+	size_t operator()(const PokerCommitKey &key) const
+	{
+		return key.hash.GetUint64(0) ^ key.nPokerCode;
+	}
+};
+
+/**
+ * 牌局承诺交易索引
+ *
+ * P2P 牌局消息对应一笔 OP_RETURN <pokercode + Hash160(消息)> <hex(ip)> 交易,
+ * 交易进入交易池时按 (pokercode, Hash160) 建索引, 收到消息时 O(1) 查找,
+ * 不再逐笔逐输出比较整个脚本. 每个牌桌一个(tmcg::txIndex), 承诺交易交给
+ * 认识发送者 ip 的牌桌, 计数只包含本桌玩家的交易.
+ */
+class CPokerTxIndex
+{
+private:
+	struct CPokerCommitEntry
+	{
+		CTransactionRef tx;
+		std::vector<unsigned char> vchData;		//第二个 push, 即 hex(ip)
+	};
+
+	CCriticalSection cs;
+	std::unordered_map<PokerCommitKey, CPokerCommitEntry, PokerCommitKeyHasher> mapCommit;
+	std::map<unsigned char, size_t> mapCount;	//pokercode -> 交易数
+
+public:
+	/** 解析 OP_RETURN <21 字节> <data> 形式的承诺输出 */
+	static bool ParseCommitment(const CScript &script, PokerCommitKey &key, std::vector<unsigned char> &vchData);
+
+	/** 交易里所有承诺输出的发送者 ip, 没有承诺输出时返回 false */
+	static bool GetCommitmentIps(const CTransaction &tx, std::set<std::string> &setIp);
+
+	/** 给交易里所有承诺输出建索引 */
+	void Add(const CTransactionRef &tx);
+
+	/** 查找承诺, data 也必须一致, 找不到返回空 */
+	CTransactionRef Find(unsigned char nPokerCode, const uint160 &hash, const std::vector<unsigned char> &vchData);
+
+	/** 该 pokercode 下的承诺交易数 */
+	size_t Count(unsigned char nPokerCode);
+
+	/** 只保留发送者 ip 在 setIp 中的承诺, 牌桌收到座位表时调用, 丢掉其他牌局的交易 */
+	void KeepPeers(const std::set<std::string> &setIp);
+
+	void Clear();
+};
+
+#endif // POKER_TX_INDEX_H
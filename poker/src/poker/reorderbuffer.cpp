@@ -0,0 +1,74 @@
+#include "reorderbuffer.h"
+
+#include <climits>
+#include <iostream>
+#include <iterator>
+
+CPokerReorderBuffer pokerReorderBuffer;
+
+bool CPokerReorderBuffer::Park(const std::string &tableID, PokerPhase phase, int nRound, uint32_t nSeat, std::function<void()> apply)
+{
+	Key key(tableID, phase, nRound, nSeat);
+	if (mapParked.count(key))
+		return false;
+	if (Count(tableID) >= MAX_POKER_PARKED_MSGS)
+	{
+		// 淘汰该牌桌协议顺序最靠后的消息, 它离就绪最远
+		auto itLast = std::prev(mapParked.upper_bound(Key(tableID, INT_MAX, INT_MAX, UINT32_MAX)));
+		if (!(key < itLast->first))
+			return false;
+		std::cout << "evict early msg, phase : " << std::get<1>(itLast->first) << " round : " << std::get<2>(itLast->first) << " seat : " << std::get<3>(itLast->first) << std::endl;
+		mapParked.erase(itLast);
+	}
+	mapParked[key] = std::move(apply);
+	std::cout << "park early msg, phase : " << phase << " round : " << nRound << " seat : " << nSeat << std::endl;
+	return true;
+}
+
+size_t CPokerReorderBuffer::Release(const std::string &tableID, const ReadyFn &fnReady)
+{
+	size_t nReleased = 0;
+	bool fProgress = true;
+	while (fProgress)
+	{
+		fProgress = false;
+		// 键按 (tableID, 阶段, 轮次, 座位号) 排序, 即协议顺序
+		auto it = mapParked.lower_bound(Key(tableID, INT_MIN, INT_MIN, 0));
+		while (it != mapParked.end() && std::get<0>(it->first) == tableID)
+		{
+			PokerPhase phase = (PokerPhase)std::get<1>(it->first);
+			int nRound = std::get<2>(it->first);
+			uint32_t nSeat = std::get<3>(it->first);
+			if (!fnReady(phase, nRound, nSeat))
+			{
+				++it;
+				continue;
+			}
+
+			std::function<void()> apply = std::move(it->second);
+			mapParked.erase(it);
+			std::cout << "release early msg, phase : " << phase << " round : " << nRound << " seat : " << nSeat << std::endl;
+			apply();
+			++nReleased;
+			// apply 可能改变其他消息的就绪状态, 从头再找
+			fProgress = true;
+			break;
+		}
+	}
+	return nReleased;
+}
+
+size_t CPokerReorderBuffer::Count(const std::string &tableID) const
+{
+	size_t n = 0;
+	for (auto it = mapParked.lower_bound(Key(tableID, INT_MIN, INT_MIN, 0)); it != mapParked.end() && std::get<0>(it->first) == tableID; ++it)
+		++n;
+	return n;
+}
+
+void CPokerReorderBuffer::Clear(const std::string &tableID)
+{
+	auto it = mapParked.lower_bound(Key(tableID, INT_MIN, INT_MIN, 0));
+	while (it != mapParked.end() && std::get<0>(it->first) == tableID)
+		it = mapParked.erase(it);
+}
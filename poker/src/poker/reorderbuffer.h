@@ -0,0 +1,58 @@
+#ifndef POKER_REORDER_BUFFER_H
+#define POKER_REORDER_BUFFER_H
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+
+/**
+ * 需要等待前置消息的牌局阶段, 按协议顺序排列.
+ * 洗牌不经过这里, 早到的洗牌按座位号存在 tmcg::mShuffleMsg, 由 parseShuffleChain 按顺序验证
+ */
+enum PokerPhase
+{
+	PP_HAND_CARD = 0,	//等最后一次洗牌
+	PP_FLOP_CARD = 1,	//等打开公共牌的下注
+};
+
+/** 每张牌桌最多暂存的消息数, 轮次来自消息本身, 不能让对方无限暂存 */
+static const size_t MAX_POKER_PARKED_MSGS = 64;
+
+/**
+ * 早到牌局消息的重排缓冲
+ *
+ * 按 (tableID, 阶段, 轮次, 发送者座位号) 暂存已经解析好的消息, 前置消息处理后按
+ * 阶段, 轮次, 座位号的顺序放行, 不用丢弃消息等超时, 也不用重新从 ipfs 拉取.
+ * 轮次区分同一阶段的多条消息(如翻牌, 转牌, 河牌都是 PP_FLOP_CARD), 不需要时为 0.
+ * 同一个键只保留先到的那条. 牌桌暂存满 MAX_POKER_PARKED_MSGS 条时, 淘汰协议顺序最靠后的一条.
+ * 只在牌局线程访问, 不加锁.
+ */
+class CPokerReorderBuffer
+{
+public:
+	/** 返回 true 表示该阶段该座位的消息现在可以处理 */
+	typedef std::function<bool(PokerPhase phase, int nRound, uint32_t nSeat)> ReadyFn;
+
+private:
+	typedef std::tuple<std::string, int, int, uint32_t> Key;
+	std::map<Key, std::function<void()> > mapParked;
+
+public:
+	/**
+	 * 暂存消息, apply 在放行时调用; 键已存在, 或牌桌已满且这条在协议顺序上最靠后时返回 false
+	 */
+	bool Park(const std::string &tableID, PokerPhase phase, int nRound, uint32_t nSeat, std::function<void()> apply);
+
+	/** 放行该牌桌所有就绪的消息, 直到没有新的消息就绪, 返回放行的条数 */
+	size_t Release(const std::string &tableID, const ReadyFn &fnReady);
+
+	size_t Count(const std::string &tableID) const;
+
+	void Clear(const std::string &tableID);
+};
+
+extern CPokerReorderBuffer pokerReorderBuffer;
+
+#endif // POKER_REORDER_BUFFER_H
@@ -0,0 +1,105 @@
+#include "sshecache.h"
+#include "hash.h"
+
+#include <libTMCG.hh>
+
+#include <iostream>
+#include <sstream>
+
+CPokerSsheCache pokerSsheCache;
+
+static std::string GroupString(size_t n, mpz_srcptr p, mpz_srcptr q, mpz_srcptr k)
+{
+	std::stringstream out;
+	out << n << std::endl << p << std::endl << q << std::endl << k << std::endl;
+	return out.str();
+}
+
+static std::string GeneratorString(const GrothVSSHE &vsshe)
+{
+	std::stringstream out;
+	for (size_t i = 0; i < vsshe.com->g.size(); i++)
+		out << vsshe.com->g[i] << std::endl;
+	return out.str();
+}
+
+static std::string StringHash(const std::string &str)
+{
+	return Hash(str.begin(), str.end()).GetHex();
+}
+
+std::shared_ptr<GrothVSSHE> CPokerSsheCache::Get(size_t n, const BarnettSmartVTMF_dlog &vtmf)
+{
+	std::string hash = StringHash(GroupString(n, vtmf.p, vtmf.q, vtmf.k));
+	std::string generators;
+	{
+		boost::unique_lock<boost::mutex> lock(mutex);
+		for (auto &entry : queueEntry)
+		{
+			if (entry.strGroupHash == hash)
+			{
+				generators = entry.strGenerators;
+				break;
+			}
+		}
+	}
+	if (generators.empty())
+		return nullptr;
+
+	// 与 GrothVSSHE::PublishGroup 的格式相同, 只换公钥 h
+	std::stringstream in;
+	in << vtmf.p << std::endl << vtmf.q << std::endl << vtmf.g << std::endl << vtmf.h << std::endl;
+	in << vtmf.p << std::endl << vtmf.q << std::endl << vtmf.k << std::endl << vtmf.h << std::endl;
+	in << generators;
+	return std::make_shared<GrothVSSHE>(n, in);
+}
+
+bool CPokerSsheCache::IsVerified(const GrothVSSHE &vsshe)
+{
+	std::string hash = StringHash(GroupString(vsshe.com->g.size(), vsshe.com->p, vsshe.com->q, vsshe.com->k) + GeneratorString(vsshe));
+	boost::unique_lock<boost::mutex> lock(mutex);
+	for (auto &entry : queueEntry)
+	{
+		if (entry.strComHash == hash)
+			return true;
+	}
+	return false;
+}
+
+void CPokerSsheCache::Add(const GrothVSSHE &vsshe)
+{
+	Entry entry;
+	std::string group = GroupString(vsshe.com->g.size(), vsshe.com->p, vsshe.com->q, vsshe.com->k);
+	entry.strGenerators = GeneratorString(vsshe);
+	entry.strGroupHash = StringHash(group);
+	entry.strComHash = StringHash(group + entry.strGenerators);
+
+	boost::unique_lock<boost::mutex> lock(mutex);
+	for (auto it = queueEntry.begin(); it != queueEntry.end(); ++it)
+	{
+		if (it->strComHash == entry.strComHash)
+			return ;
+		// 同一群参数只保留最新的一组生成元
+		if (it->strGroupHash == entry.strGroupHash)
+		{
+			queueEntry.erase(it);
+			break;
+		}
+	}
+	queueEntry.push_back(entry);
+	while (queueEntry.size() > MAX_POKER_SSHE_CACHE)
+		queueEntry.pop_front();
+	std::cout << "cache vsshe generators " << entry.strComHash << std::endl;
+}
+
+size_t CPokerSsheCache::Size()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return queueEntry.size();
+}
+
+void CPokerSsheCache::Clear()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	queueEntry.clear();
+}
@@ -0,0 +1,54 @@
+#ifndef POKER_SSHE_CACHE_H
+#define POKER_SSHE_CACHE_H
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+/** 缓存的承诺生成元组数, 按先进先出淘汰 */
+static const size_t MAX_POKER_SSHE_CACHE = 8;
+
+class BarnettSmartVTMF_dlog;
+class GrothVSSHE;
+
+/**
+ * vsshe 承诺生成元缓存
+ *
+ * GrothVSSHE 的构造要生成 DECKSIZE 个承诺生成元, 验证(CheckGroup)要做素性测试并
+ * 逐个检查生成元. 联合公钥 h 每局都变, 但生成元 g_1..g_n 只依赖 (牌数, p, q, k),
+ * 同一群参数(见 CPokerGroupPool::GetSession)的各局可以沿用.
+ * 只缓存验证通过的生成元, 主动方按 (牌数, p, q, k) 取用, 被动方按生成元的 hash 判断是否验证过.
+ */
+class CPokerSsheCache
+{
+private:
+	struct Entry
+	{
+		std::string strGroupHash;	//(牌数, p, q, k) 的 hash
+		std::string strComHash;		//(牌数, p, q, k, g_1..g_n) 的 hash
+		std::string strGenerators;	//g_1..g_n, 每行一个
+	};
+
+	boost::mutex mutex;
+	std::deque<Entry> queueEntry;
+
+public:
+	/** 主动方: 用缓存的生成元和 vtmf 的公钥 h 构造实例, 没有时返回空 */
+	std::shared_ptr<GrothVSSHE> Get(size_t n, const BarnettSmartVTMF_dlog &vtmf);
+
+	/** 被动方: 实例的群参数和生成元是否验证过, 验证过时只需检查公钥 */
+	bool IsVerified(const GrothVSSHE &vsshe);
+
+	/** 加入验证通过(CheckGroup)的实例的生成元 */
+	void Add(const GrothVSSHE &vsshe);
+
+	size_t Size();
+
+	void Clear();
+};
+
+extern CPokerSsheCache pokerSsheCache;
+
+#endif // POKER_SSHE_CACHE_H
@@ -0,0 +1,204 @@
+#include "tablemanager.h"
+#include "version.h"
+
+CPokerTableManager pokerTables;
+CPokerTableRef g_tmcg;
+
+static thread_local CPokerTableScope *pScope = nullptr;
+static thread_local CPokerTableRecorder *pRecorder = nullptr;
+
+tmcg *CPokerTableRef::get() const
+{
+	return pScope ? pScope->get() : pokerTables.GetDefault();
+}
+
+CPokerTableScope::CPokerTableScope(const std::shared_ptr<tmcg> &tableIn) : table(tableIn), pPrev(pScope)
+{
+	pScope = this;
+	if (pRecorder)
+		pRecorder->Add(table);
+}
+
+CPokerTableScope::~CPokerTableScope()
+{
+	pScope = pPrev;
+}
+
+std::shared_ptr<tmcg> CPokerTableScope::Current()
+{
+	return pScope ? pScope->table : std::shared_ptr<tmcg>();
+}
+
+CPokerTableRecorder::CPokerTableRecorder() : pPrev(pRecorder)
+{
+	pRecorder = this;
+}
+
+CPokerTableRecorder::~CPokerTableRecorder()
+{
+	pRecorder = pPrev;
+}
+
+void CPokerTableRecorder::Add(const std::shared_ptr<tmcg> &table)
+{
+	for (auto &it : vTable)
+	{
+		if (it == table)
+			return ;
+	}
+	vTable.push_back(table);
+}
+
+void CPokerTableManager::Init()
+{
+	LOCK(cs);
+	assert(vTable.empty());
+	vTable.push_back(std::make_shared<tmcg>());
+	vTable.back()->nLocalID = ++nLastLocalID;
+	pDefault = vTable.back().get();
+}
+
+void CPokerTableManager::SetDefault(const std::shared_ptr<tmcg> &table)
+{
+	LOCK(cs);
+	pDefault = table.get();
+}
+
+std::shared_ptr<tmcg> CPokerTableManager::Create()
+{
+	std::shared_ptr<tmcg> table = std::make_shared<tmcg>();
+
+	LOCK(cs);
+	tmcg *prev = pDefault.load();
+	if (prev)
+	{
+		table->selfip = prev->selfip;
+		table->selfaddress = prev->selfaddress;
+		table->fMatchNode = prev->fMatchNode;
+		table->nextMatchNode = prev->nextMatchNode;
+	}
+	table->nLocalID = ++nLastLocalID;
+	vTable.push_back(table);
+	std::cout << "new poker table " << table->nLocalID << ", tables: " << vTable.size() << std::endl;
+	return table;
+}
+
+std::shared_ptr<tmcg> CPokerTableManager::Find(const std::string &tableID)
+{
+	LOCK(cs);
+	auto it = mapTable.find(tableID);
+	if (it == mapTable.end())
+		return std::shared_ptr<tmcg>();
+	return it->second;
+}
+
+std::shared_ptr<tmcg> CPokerTableManager::Lookup(const std::string &id)
+{
+	LOCK(cs);
+	auto it = mapTable.find(id);
+	if (it != mapTable.end())
+		return it->second;
+	for (auto &table : vTable)
+	{
+		if (!id.empty() && (table->matchTxID == id || std::to_string(table->nLocalID) == id))
+			return table;
+	}
+	return std::shared_ptr<tmcg>();
+}
+
+std::shared_ptr<tmcg> CPokerTableManager::GetForMessage(CDataStream &vRecv)
+{
+	CPokerTableTag tag;
+	size_t nTagSize = ::GetSerializeSize(tag, SER_NETWORK, PROTOCOL_VERSION);
+	if (vRecv.size() >= nTagSize)
+	{
+		CDataStream ssTag(vRecv.end() - nTagSize, vRecv.end(), vRecv.GetType(), vRecv.GetVersion());
+		ssTag >> tag;
+		if (tag.nMagic == POKER_TABLE_TAG_MAGIC)
+		{
+			vRecv.resize(vRecv.size() - nTagSize);
+			if (!tag.tableID.IsNull())
+				return Find(tag.tableID.GetHex());
+		}
+	}
+	// 旧节点的消息和还没匹配的牌桌
+	return GetCurrent();
+}
+
+std::vector<std::shared_ptr<tmcg> > CPokerTableManager::GetPending()
+{
+	std::vector<std::shared_ptr<tmcg> > vPending;
+	LOCK(cs);
+	for (auto &table : vTable)
+	{
+		if (table->matchTableID.empty() && !table->matchTxID.empty())
+			vPending.push_back(table);
+	}
+	return vPending;
+}
+
+std::vector<std::shared_ptr<tmcg> > CPokerTableManager::GetTables()
+{
+	LOCK(cs);
+	return vTable;
+}
+
+std::shared_ptr<tmcg> CPokerTableManager::GetCurrent()
+{
+	std::shared_ptr<tmcg> table = CPokerTableScope::Current();
+	if (table)
+		return table;
+
+	LOCK(cs);
+	for (auto &it : vTable)
+	{
+		if (it.get() == pDefault.load())
+			return it;
+	}
+	return std::shared_ptr<tmcg>();
+}
+
+void CPokerTableManager::Bind(tmcg *table)
+{
+	if (table->matchTableID.empty())
+		return ;
+
+	LOCK(cs);
+	for (auto &it : vTable)
+	{
+		if (it.get() == table)
+		{
+			mapTable[table->matchTableID] = it;
+			return ;
+		}
+	}
+}
+
+void CPokerTableManager::Release(tmcg *table)
+{
+	LOCK(cs);
+	for (auto it = mapTable.begin(); it != mapTable.end(); )
+	{
+		if (it->second.get() == table)
+			it = mapTable.erase(it);
+		else
+			++it;
+	}
+
+	if (table == pDefault.load())
+		return ;
+	for (auto it = vTable.begin(); it != vTable.end(); ++it)
+	{
+		if (it->get() == table)
+		{
+			vTable.erase(it);
+			break;
+		}
+	}
+}
+
+size_t CPokerTableManager::Size()
+{
+	LOCK(cs);
+	return vTable.size();
+}
@@ -0,0 +1,141 @@
+#ifndef POKER_TABLE_MANAGER_H
+#define POKER_TABLE_MANAGER_H
+
+#include "poker.h"
+#include "serialize.h"
+#include "streams.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * 牌桌管理
+ *
+ * 一个进程可以同时打多桌, 每桌一个 tmcg. 匹配完成前牌桌只有 matchTxID,
+ * 匹配完成后按 matchTableID 登记, 交易池里的牌局消息按脚本中的 tableID 分发,
+ * P2P 牌局消息按末尾的牌桌标记(CPokerTableTag)分发. 没有标记的 P2P 消息和不带牌桌参数的
+ * rpc 作用在默认牌桌上, 默认牌桌只由 pokerusetable 切换. 匹配前的牌桌用本地编号指定.
+ * 牌桌状态只由牌局线程(pokerloop.h)修改, 这里的锁只保护牌桌列表.
+ */
+class CPokerTableManager
+{
+private:
+	CCriticalSection cs;
+	std::vector<std::shared_ptr<tmcg> > vTable;				//所有牌桌
+	std::map<std::string, std::shared_ptr<tmcg> > mapTable;	//tableID -> 牌桌
+	std::atomic<tmcg*> pDefault;
+	uint32_t nLastLocalID;
+
+public:
+	CPokerTableManager() : pDefault(nullptr), nLastLocalID(0) {}
+
+	/** 创建默认牌桌 */
+	void Init();
+
+	tmcg *GetDefault() const { return pDefault.load(); }
+	void SetDefault(const std::shared_ptr<tmcg> &table);
+
+	/** 新建牌桌, 默认牌桌不变, 本节点信息(ip, 地址, 是否匹配节点)从默认牌桌继承 */
+	std::shared_ptr<tmcg> Create();
+
+	/** 按 tableID 查找已匹配的牌桌 */
+	std::shared_ptr<tmcg> Find(const std::string &tableID);
+
+	/** 按 tableID, matchTxID 或本地编号查找牌桌 */
+	std::shared_ptr<tmcg> Lookup(const std::string &id);
+
+	/** 去掉 P2P 牌局消息末尾的牌桌标记, 返回消息所属的牌桌, 牌桌不存在时为空 */
+	std::shared_ptr<tmcg> GetForMessage(CDataStream &vRecv);
+
+	/** 已发出匹配交易, 还在等匹配结果的牌桌 */
+	std::vector<std::shared_ptr<tmcg> > GetPending();
+
+	std::vector<std::shared_ptr<tmcg> > GetTables();
+
+	/** 当前线程选定的牌桌, 没有选定时为默认牌桌 */
+	std::shared_ptr<tmcg> GetCurrent();
+
+	/** 匹配完成后按 matchTableID 登记 */
+	void Bind(tmcg *table);
+
+	/** 牌桌清空后取消登记, 非默认牌桌同时删除 */
+	void Release(tmcg *table);
+
+	size_t Size();
+};
+
+/** 牌桌标记的 magic, 以此判断 P2P 消息末尾是否带标记 */
+static const uint32_t POKER_TABLE_TAG_MAGIC = 0x6c627470;
+
+/**
+ * P2P 牌局消息的牌桌标记
+ *
+ * 附加在消息所有字段之后, 旧节点读完自己的字段会忽略它. tableID 为空(牌桌还没匹配)
+ * 时接收方把消息交给默认牌桌.
+ */
+class CPokerTableTag
+{
+public:
+	uint256 tableID;
+	uint32_t nMagic;
+
+	CPokerTableTag() : nMagic(POKER_TABLE_TAG_MAGIC) {}
+	explicit CPokerTableTag(const std::string &tableIDIn) : tableID(uint256S(tableIDIn)), nMagic(POKER_TABLE_TAG_MAGIC) {}
+
+	ADD_SERIALIZE_METHODS;
+
+	template <typename Stream, typename Operation>
+	inline void SerializationOp(Stream& s, Operation ser_action) {
+		READWRITE(tableID);
+		READWRITE(nMagic);
+	}
+};
+
+/**
+ * 在作用域内把当前线程的 g_tmcg 指向 table
+ *
+ * 可以嵌套, 析构时恢复原来的牌桌.
+ */
+class CPokerTableScope
+{
+private:
+	std::shared_ptr<tmcg> table;
+	CPokerTableScope *pPrev;
+
+public:
+	explicit CPokerTableScope(const std::shared_ptr<tmcg> &tableIn);
+	~CPokerTableScope();
+
+	tmcg *get() const { return table.get(); }
+
+	/** 当前线程选定的牌桌, 没有选定时为空 */
+	static std::shared_ptr<tmcg> Current();
+};
+
+/**
+ * 记录作用域内当前线程选定过的牌桌
+ *
+ * 牌局线程处理完一个事件后据此发布这些牌桌的快照.
+ */
+class CPokerTableRecorder
+{
+private:
+	std::vector<std::shared_ptr<tmcg> > vTable;
+	CPokerTableRecorder *pPrev;
+
+public:
+	CPokerTableRecorder();
+	~CPokerTableRecorder();
+
+	void Add(const std::shared_ptr<tmcg> &table);
+	const std::vector<std::shared_ptr<tmcg> > &Get() const { return vTable; }
+};
+
+extern CPokerTableManager pokerTables;
+
+#endif // POKER_TABLE_MANAGER_H
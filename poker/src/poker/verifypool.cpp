@@ -0,0 +1,120 @@
+#include "verifypool.h"
+#include "util.h"
+
+#include <iostream>
+
+CPokerVerifyPool pokerVerifyPool;
+int nPokerShuffleWorkers = 1;
+
+static void RunTask(std::function<void()> &task)
+{
+	try
+	{
+		task();
+	}
+	catch(const std::exception &e)
+	{
+		std::cout << "poker verify error : " << e.what() << std::endl;
+	}
+	task = nullptr;
+}
+
+bool CPokerVerifyPool::PopTask(std::function<void()> &task)
+{
+	if(queueTask.empty())
+		return false;
+	task = std::move(queueTask.front());
+	queueTask.pop_front();
+	++nRunning;
+	return true;
+}
+
+void CPokerVerifyPool::RunAll(std::vector<std::function<void()> > &vTask)
+{
+	if(vTask.empty())
+		return ;
+
+	boost::unique_lock<boost::mutex> lock(mutex);
+	if(nWorkers == 0 || vTask.size() == 1)
+	{
+		lock.unlock();
+		for(auto &task : vTask)
+			RunTask(task);
+		return ;
+	}
+
+	// 只有牌局线程调用 RunAll, 队列里只有这一批任务
+	for(auto &task : vTask)
+		queueTask.push_back(std::move(task));
+	condWorker.notify_all();
+
+	// 调用线程也取任务执行
+	std::function<void()> task;
+	while(PopTask(task))
+	{
+		lock.unlock();
+		RunTask(task);
+		lock.lock();
+		--nRunning;
+	}
+	while(nRunning > 0)
+		condDone.wait(lock);
+}
+
+void CPokerVerifyPool::Thread()
+{
+	std::function<void()> task;
+	while(true)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			while(!PopTask(task))
+				condWorker.wait(lock);
+		}
+
+		RunTask(task);
+
+		boost::unique_lock<boost::mutex> lock(mutex);
+		if(--nRunning == 0 && queueTask.empty())
+			condDone.notify_all();
+	}
+}
+
+void CPokerVerifyPool::SetWorkers(int n)
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	nWorkers = n;
+}
+
+int CPokerVerifyPool::GetWorkers()
+{
+	boost::unique_lock<boost::mutex> lock(mutex);
+	return nWorkers;
+}
+
+static void ThreadPokerVerify()
+{
+	RenameThread("bitcoin-pokervfy");
+	pokerVerifyPool.Thread();
+}
+
+void StartPokerVerify(boost::thread_group &threadGroup, int nThreads)
+{
+	// 0 = 自动, 调用线程也参与验证, 所以少开一个
+	if(nThreads <= 0)
+		nThreads = GetNumCores() - 1;
+	nThreads = std::max(0, std::min(nThreads, MAX_POKER_VERIFY_THREADS));
+	std::cout << "Using " << nThreads << " threads for poker proof verification" << std::endl;
+	pokerVerifyPool.SetWorkers(nThreads);
+	for(int i = 0; i < nThreads; ++i)
+		threadGroup.create_thread(&ThreadPokerVerify);
+}
+
+void SetPokerShuffleWorkers(int nWorkers)
+{
+	// 0 = 自动, 洗牌线程本身也算一个
+	if(nWorkers <= 0)
+		nWorkers = GetNumCores();
+	nPokerShuffleWorkers = std::max(1, std::min(nWorkers, MAX_POKER_SHUFFLE_WORKERS));
+	std::cout << "Using " << nPokerShuffleWorkers << " threads for poker shuffle proofs" << std::endl;
+}
@@ -0,0 +1,60 @@
+#ifndef POKER_VERIFY_POOL_H
+#define POKER_VERIFY_POOL_H
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+/** 默认验证线程数, 0 = 按 cpu 核数自动设置 */
+static const int DEFAULT_POKER_VERIFY_THREADS = 0;
+static const int MAX_POKER_VERIFY_THREADS = 16;
+/** 自己洗牌时(打乱牌堆, 生成 Groth 证明)的线程数, 包括牌局线程, 0 = 按 cpu 核数自动设置 */
+static const int DEFAULT_POKER_SHUFFLE_WORKERS = 0;
+static const int MAX_POKER_SHUFFLE_WORKERS = 16;
+
+extern int nPokerShuffleWorkers;
+
+/**
+ * 牌局证明的并行验证线程池
+ *
+ * 牌局线程把互相独立的验证任务(每个任务只读输入, 结果写到自己的位置)
+ * 交给 RunAll, 工作线程和调用线程一起执行, 全部完成后 RunAll 才返回.
+ * 没有工作线程时在调用线程内依次执行.
+ */
+class CPokerVerifyPool
+{
+private:
+	boost::mutex mutex;
+	boost::condition_variable condWorker;
+	boost::condition_variable condDone;
+
+	std::deque<std::function<void()> > queueTask;
+	//! 已取出但还没执行完的任务数
+	int nRunning;
+	int nWorkers;
+
+	bool PopTask(std::function<void()> &task);
+
+public:
+	CPokerVerifyPool() : nRunning(0), nWorkers(0) {}
+
+	void RunAll(std::vector<std::function<void()> > &vTask);
+
+	/** 工作线程主循环 */
+	void Thread();
+
+	void SetWorkers(int n);
+
+	int GetWorkers();
+};
+
+extern CPokerVerifyPool pokerVerifyPool;
+
+void StartPokerVerify(boost::thread_group &threadGroup, int nThreads);
+
+/** 设置 nPokerShuffleWorkers, 之后创建的 tmcgOne 和 vsshe 按此并行 */
+void SetPokerShuffleWorkers(int nWorkers);
+
+#endif // POKER_VERIFY_POOL_H
@@ -101,6 +101,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "pokertx", 0, "pokercode" },
     { "pokertx", 1, "balance" },
 	{ "pokerbet", 0, "bet" },
+	{ "pokertable", 2, "params" },
+	{ "pokernewtable", 0, "binarycards" },
+	{ "pokernewtable", 1, "ecgroup" },
 	{ "pokersign", 1, "index" },
 	//Portgas
 	
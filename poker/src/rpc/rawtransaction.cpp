@@ -37,6 +37,11 @@
 #include "serialize.h"
 #include "streams.h"
 #include "poker/cardtype.h"
+#include "poker/httpclient.h"
+#include "poker/payloadcache.h"
+#include "poker/pokertxindex.h"
+#include "poker/tablemanager.h"
+#include "poker/pokerloop.h"
 
 
 void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
@@ -988,6 +993,9 @@ UniValue sendrawtransaction(const JSONRPCRequest& request)
 //Portgas
 UniValue sendnodeindex(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&sendnodeindex, request);
+
 	if (request.fHelp || request.params.size() != 0)
 		throw std::runtime_error("sendnodeindex\n");
 	
@@ -1003,7 +1011,7 @@ UniValue sendnodeindex(const JSONRPCRequest& request)
 		if(it != g_tmcg->nodeIndexMap.end()) 
 		{
 			CNetMsgMaker msgMaker(pnode->GetSendVersion());
-			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_IP, g_tmcg->nodeIndexMap));
+			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::VTMF_IP, g_tmcg->nodeIndexMap, CPokerTableTag(g_tmcg->matchTableID)));
 		}
 	});
 	g_tmcg->playersize = g_tmcg->nodeIndexMap.size();
@@ -1020,11 +1028,14 @@ UniValue sendnodeindex(const JSONRPCRequest& request)
 
 UniValue senddeposit(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&senddeposit, request);
+
 	if (request.fHelp || request.params.size() != 0)
         throw std::runtime_error("senddeposit \n");
 
     LOCK(cs_main);
-	if(vTxDepositVerify.empty())
+	if(g_tmcg->txIndex->Count(PC_POKER_DEPOSIT) == 0)
 		throw std::runtime_error("senddeposit vTxDepositVerify is empty\n");
 
 	g_connman->ForEachNode([&](CNode* pnode)
@@ -1034,7 +1045,7 @@ UniValue senddeposit(const JSONRPCRequest& request)
 		if(it != g_tmcg->nodeIndexMap.end()) 
 		{			
 			CNetMsgMaker msgMaker(pnode->GetSendVersion());
-			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::POKER_DEPOSIT, g_tmcg->selfip, 10));
+			g_connman->PushMessage(pnode, msgMaker.Make(NetMsgType::POKER_DEPOSIT, g_tmcg->selfip, 10, CPokerTableTag(g_tmcg->matchTableID)));
 		}
 	});
 	
@@ -1047,6 +1058,9 @@ UniValue senddeposit(const JSONRPCRequest& request)
 
 UniValue pokersign(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokersign, request);
+
 #ifdef ENABLE_WALLET
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
 #endif
@@ -1191,7 +1205,7 @@ std::string getAmount(int amount, bool isWinner)
 	
 	//其他人拿回押金
 	if(!isWinner){
-		auto &ct = vTxDepositPlayer[g_tmcg->selfip];
+		auto &ct = g_tmcg->vTxDepositPlayer[g_tmcg->selfip];
 		for(size_t i=0; i < ct.vout.size(); i++){
 			UniValue input(UniValue::VOBJ);
 			if(ct.vout[i].scriptPubKey[0] == OP_POKER){
@@ -1206,7 +1220,7 @@ std::string getAmount(int amount, bool isWinner)
 	}
 	//赢家拿走奖池和自己的押金
 	else{
-		for (auto &ct: vTxBetVerify) {	
+		for (auto &ct: g_tmcg->vTxBetVerify) {	
 			for (size_t i=0; i<ct.vout.size(); i++) {
 				UniValue input(UniValue::VOBJ);
 				if (ct.vout[i].scriptPubKey[0] == OP_POKER) {
@@ -1218,7 +1232,7 @@ std::string getAmount(int amount, bool isWinner)
 			}
 		}
 		
-		auto &ct = vTxDepositPlayer[g_tmcg->selfip];
+		auto &ct = g_tmcg->vTxDepositPlayer[g_tmcg->selfip];
 		for (size_t i=0; i<ct.vout.size(); i++) {
 			UniValue input(UniValue::VOBJ);
 			if (ct.vout[i].scriptPubKey[0] == OP_POKER) {
@@ -1328,7 +1342,7 @@ std::string getAmount(int amount, bool isWinner)
 //有人作弊的情况调用
 void getAmount(int lieIndex, UniValue& result)
 {
-	if(vTxBetPlayer.empty())
+	if(g_tmcg->vTxBetPlayer.empty())
 		throw std::runtime_error("vTxBetPlayer is empty. \n");
 	
 	std::string lieIp;
@@ -1341,7 +1355,7 @@ void getAmount(int lieIndex, UniValue& result)
 	
 	std::vector<CTransaction> txs;
 	std::vector<CTransaction> txlie;
-	for(auto &it: vTxBetPlayer){
+	for(auto &it: g_tmcg->vTxBetPlayer){
 		if(it.first == g_tmcg->selfip){
 			txs.push_back(it.second);
 		}
@@ -1351,13 +1365,13 @@ void getAmount(int lieIndex, UniValue& result)
 	}
 	
 	
-	if(vTxBetPlayer.count(g_tmcg->selfip)){
+	if(g_tmcg->vTxBetPlayer.count(g_tmcg->selfip)){
 		
 		UniValue inputs(UniValue::VARR);
 		int total = 0;
 		
 		//拿回下过的押金
-		auto ct = vTxDepositPlayer[g_tmcg->selfip];
+		auto ct = g_tmcg->vTxDepositPlayer[g_tmcg->selfip];
 		for(size_t i = 0; i < ct.vout.size(); i++){
 			UniValue input(UniValue::VOBJ);
 			if(ct.vout[i].scriptPubKey[0] == OP_POKER){
@@ -1447,13 +1461,13 @@ void getAmount(int lieIndex, UniValue& result)
 	}
 	
 	
-	if(vTxDepositPlayer.count(lieIp)){	
+	if(g_tmcg->vTxDepositPlayer.count(lieIp)){	
 	
 		UniValue inputs(UniValue::VARR);
 		int total = 0;
 		
 		//平分作弊的押金
-		auto ct = vTxDepositPlayer[lieIp];
+		auto ct = g_tmcg->vTxDepositPlayer[lieIp];
 		for(size_t i = 0; i < ct.vout.size(); i++){
 			UniValue input(UniValue::VOBJ);
 			if(ct.vout[i].scriptPubKey[0] == OP_POKER){
@@ -1552,6 +1566,9 @@ void getAmount(int lieIndex, UniValue& result)
 
 UniValue pokerhistory(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokerhistory, request);
+
 	if (request.fHelp || request.params.size() != 0)
         throw std::runtime_error("pokerhistory\n");
 	
@@ -1661,64 +1678,206 @@ UniValue pokerhistory(const JSONRPCRequest& request)
 
 UniValue pokerclear(const JSONRPCRequest& request)
 {	
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokerclear, request);
+
 	g_tmcg->clearPoker();
 	return "";
 }
 
+UniValue pokercacheinfo(const JSONRPCRequest& request)
+{
+	if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "pokercacheinfo\n"
+            "\nReturns hit/miss counters of the poker payload cache.\n"
+        );
+
+	PokerPayloadCacheStats stats = pokerPayloadCache.GetStats();
+	UniValue result(UniValue::VOBJ);
+	result.push_back(Pair("hits", stats.nHits));
+	result.push_back(Pair("diskhits", stats.nDiskHits));
+	result.push_back(Pair("misses", stats.nMisses));
+	result.push_back(Pair("evictions", stats.nEvictions));
+	result.push_back(Pair("entries", (uint64_t)stats.nEntries));
+	result.push_back(Pair("bytes", (uint64_t)stats.nBytes));
+	return result;
+}
+
+UniValue pokerhttpinfo(const JSONRPCRequest& request)
+{
+	if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "pokerhttpinfo\n"
+            "\nReturns per-endpoint request timing of the poker http client.\n"
+        );
+
+	UniValue result(UniValue::VOBJ);
+	for (auto &it : pokerHttpClient.GetStats()) {
+		const PokerHttpStats &stats = it.second;
+		UniValue obj(UniValue::VOBJ);
+		obj.push_back(Pair("requests", stats.nRequests));
+		obj.push_back(Pair("failures", stats.nFailures));
+		obj.push_back(Pair("connects", stats.nConnects));
+		obj.push_back(Pair("totalmicros", stats.nTotalMicros));
+		obj.push_back(Pair("avgmicros", stats.nRequests ? stats.nTotalMicros / stats.nRequests : 0));
+		obj.push_back(Pair("maxmicros", stats.nMaxMicros));
+		result.push_back(Pair(it.first, obj));
+	}
+	return result;
+}
+
+UniValue pokertables(const JSONRPCRequest& request)
+{
+	if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "pokertables\n"
+            "\nLists the poker tables hosted by this node.\n"
+        );
+
+	UniValue result(UniValue::VARR);
+	for (auto &table : pokerTables.GetTables()) {
+		std::shared_ptr<const CPokerTableSnapshot> snap = GetTableSnapshot(*table);
+		UniValue obj(UniValue::VOBJ);
+		obj.push_back(Pair("table", (uint64_t)table->nLocalID));
+		obj.push_back(Pair("tableid", snap->matchTableID));
+		obj.push_back(Pair("matchtxid", snap->matchTxID));
+		obj.push_back(Pair("myindex", snap->myindex));
+		obj.push_back(Pair("playersize", snap->playersize));
+		obj.push_back(Pair("bets", (uint64_t)snap->nBetVerify));
+		obj.push_back(Pair("default", table.get() == pokerTables.GetDefault()));
+		result.push_back(obj);
+	}
+	return result;
+}
+
+UniValue pokernewtable(const JSONRPCRequest& request)
+{
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokernewtable, request);
+
+	if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "pokernewtable ( binarycards ecgroup )\n"
+            "\nCreates an empty poker table and returns its local table number. The default table does not change.\n"
+            "Use pokertable <number> pokermatch afterwards to join a new game while the other tables keep running.\n"
+            "\nArguments:\n"
+            "1. binarycards    (boolean, optional, default=-pokerbinarycards) Write card stacks and proofs of this table in the binary format.\n"
+            "2. ecgroup        (boolean, optional, default=-pokerecgroup) Deal over the secp256k1 curve if this node creates the game handle.\n"
+        );
+
+	std::shared_ptr<tmcg> table = pokerTables.Create();
+	if (request.params.size() > 0)
+		table->fBinaryCards = request.params[0].get_bool();
+	if (request.params.size() > 1)
+		table->fECGroup = request.params[1].get_bool();
+	return (uint64_t)table->nLocalID;
+}
+
+UniValue pokerusetable(const JSONRPCRequest& request)
+{
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokerusetable, request);
+
+	if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "pokerusetable \"table\"\n"
+            "\nMakes a table the default table of rpc calls and of P2P poker messages without a tableID.\n"
+            "\nArguments:\n"
+            "1. \"table\"    (string, required) tableID, matchTxID of a table not yet matched, or the local table number.\n"
+        );
+
+	std::shared_ptr<tmcg> table = pokerTables.Lookup(request.params[0].get_str());
+	if (!table)
+		throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown poker table");
+	pokerTables.SetDefault(table);
+	return NullUniValue;
+}
+
+UniValue pokertable(const JSONRPCRequest& request)
+{
+	if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
+        throw std::runtime_error(
+            "pokertable \"table\" \"method\" ( [params] )\n"
+            "\nCalls a poker rpc on the given table instead of the default table.\n"
+            "\nArguments:\n"
+            "1. \"table\"    (string, required) tableID, matchTxID of a table not yet matched, or the local table number.\n"
+            "2. \"method\"   (string, required) rpc method, e.g. pokerbet.\n"
+            "3. params       (array, optional) method parameters.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("pokertable", "\"768a99...\" \"pokerbet\" \"[10]\"")
+        );
+
+	std::shared_ptr<tmcg> table = pokerTables.Lookup(request.params[0].get_str());
+	if (!table)
+		throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown poker table");
+
+	JSONRPCRequest tableRequest = request;
+	tableRequest.strMethod = request.params[1].get_str();
+	tableRequest.params = request.params.size() > 2 ? request.params[2].get_array() : UniValue(UniValue::VARR);
+	if (tableRequest.strMethod.compare(0, 10, "pokertable") == 0)
+		throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid method");
+
+	CPokerTableScope scope(table);
+	return tableRPC.execute(tableRequest);
+}
+
 
 UniValue pokerdata(const JSONRPCRequest& request)
 {
 	if (request.fHelp || request.params.size() != 0)
         throw std::runtime_error("pokerdata\n");
 	
+	// 读牌局线程发布的快照, 不直接读牌桌状态
+	std::shared_ptr<tmcg> table = pokerTables.GetCurrent();
+	CPokerTableSnapshot snap = *GetTableSnapshot(*table);
 	UniValue result(UniValue::VOBJ);
 	
-	if (g_tmcg->matchTableID.empty()) {
+	if (snap.matchTableID.empty()) {
 		result.push_back(Pair("type", PC_POKER_MATCH));
 		return result;
 	}
 	// pokermatch
-	// result.push_back(Pair("matchTableID", g_tmcg->matchTableID));
-	result.push_back(Pair("matchTxID", g_tmcg->matchTxID));
-	result.push_back(Pair("myindex", g_tmcg->myindex));
-	result.push_back(Pair("playersize", g_tmcg->playersize));
+	// result.push_back(Pair("matchTableID", snap.matchTableID));
+	result.push_back(Pair("matchTxID", snap.matchTxID));
+	result.push_back(Pair("myindex", snap.myindex));
+	result.push_back(Pair("playersize", snap.playersize));
 	
 	
-	if (g_tmcg->mMatchAddress.size() != (size_t) g_tmcg->playersize) {
+	if (snap.nMatchAddress != (size_t) snap.playersize) {
 		result.push_back(Pair("type", PC_NEW_ADDRESS));
 		return result;
 	}
 	// pokeripfs 41
 
 	
-	if (!g_tmcg->fPokerAddressVerify) {
+	if (!snap.fPokerAddressVerify) {
 		result.push_back(Pair("type", PC_POKER_ADDRESS));
 		return result;
 	}
 	// pokeripfs 42 43
 	
 
-	if (g_tmcg->mPokerBalance.size() != (size_t) g_tmcg->playersize) {
+	if (snap.mPokerBalance.size() != (size_t) snap.playersize) {
 		result.push_back(Pair("type", PC_POKER_BALANCE));
 		return result;
 	}
 	// pokeripfs 44
-	// result.push_back(Pair("pokeraddress", g_tmcg->pokeraddress));
+	// result.push_back(Pair("pokeraddress", snap.pokeraddress));
 	
 	UniValue users(UniValue::VARR);
-	for (auto &it: g_tmcg->mPlayerTxid) {
+	for (auto &it: snap.mPlayerTxid) {
 		UniValue user(UniValue::VOBJ);
 		user.push_back(Pair("index", it.first));
 		user.push_back(Pair("txid", it.second));
-		// user.push_back(Pair("address", g_tmcg->mMatchAddress[it.first]));
-		user.push_back(Pair("balance", g_tmcg->mPokerBalance[it.second]));
+		// user.push_back(Pair("address", snap.mMatchAddress[it.first]));
+		user.push_back(Pair("balance", snap.mPokerBalance[it.second]));
 		users.push_back(user);
 	}
 	result.push_back(Pair("users", users));
 	
 	
-	std::string handle = g_tmcg->getVtmfHandle();
-	if (handle.empty()) {
+	if (!snap.fHandle) {
 		result.push_back(Pair("type", PC_POKER_HANDLE));
 		return result;
 	}
@@ -1726,15 +1885,15 @@ UniValue pokerdata(const JSONRPCRequest& request)
 	// result.push_back(Pair("tmcg_handle", handle.substr(0, 40) + "..." ));
 	
 	
-	if (!g_tmcg->fAllPubkeyVerify) {
+	if (!snap.fAllPubkeyVerify) {
 		result.push_back(Pair("type", PC_POKER_PUBKEY));
 		return result;
 	}
 	// pokeripfs 46
-	// result.push_back(Pair("tmcg_pubkey", g_tmcg->selfpubkey.substr(0, 40) + "..." ));
+	// result.push_back(Pair("tmcg_pubkey", snap.selfpubkey.substr(0, 40) + "..." ));
 	
 	
-	if (!g_tmcg->fMyPubkeyVerify) {
+	if (!snap.fMyPubkeyVerify) {
 		result.push_back(Pair("type", PC_POKER_PUBKEY_VERIFY));
 		return result;
 	}
@@ -1745,52 +1904,52 @@ UniValue pokerdata(const JSONRPCRequest& request)
 	// pokeripfs 48
 	
 	
-	if (g_tmcg->myindex == 0 && g_tmcg->selfsshe.empty()) {
+	if (snap.myindex == 0 && !snap.fSelfSshe) {
 		result.push_back(Pair("type", PC_POKER_SSH));
 		return result;
 	}
-	if (g_tmcg->myindex != 0 && !g_tmcg->fVerifySSHE) {
+	if (snap.myindex != 0 && !snap.fVerifySSHE) {
 		result.push_back(Pair("type", PC_POKER_SSH));
 		return result;
 	}
 	// pokeripfs 49
-	result.push_back(Pair("tmcg_shuffle", g_tmcg->nextShuffleIndex));
+	result.push_back(Pair("tmcg_shuffle", snap.nextShuffleIndex));
 	
 	
-	if (g_tmcg->private_hand.size() != 2) {
+	if (snap.vHandCard.size() != 2) {
 		result.push_back(Pair("type", PC_POKER_SHUFFLE));
 		return result;
 	}
 	// pokeripfs 50
 	UniValue handcards(UniValue::VARR);	
-	handcards.push_back(g_tmcg->showPokerNumber(g_tmcg->private_hand[0].first));
-	handcards.push_back(g_tmcg->showPokerNumber(g_tmcg->private_hand[1].first));
+	handcards.push_back(snap.vHandCard[0]);
+	handcards.push_back(snap.vHandCard[1]);
 	result.push_back(Pair("handcards", handcards));
 	
 	
-	if (vTxBetPlayer.size() == 0) {
+	if (snap.nBetPlayer == 0) {
 		result.push_back(Pair("type", PC_POKER_HAND_CARD));
 		return result;
 	}
 	// pokerbet	
-	result.push_back(Pair("curBetTxID", g_tmcg->gBetIpfsMsg.curBetTxID));
-	result.push_back(Pair("nextBetTxID", g_tmcg->gBetIpfsMsg.nextBetTxID));
-	result.push_back(Pair("curBetIndex", g_tmcg->mPlayerIndex[g_tmcg->gBetIpfsMsg.curBetTxID]));
-	result.push_back(Pair("nextBetIndex", g_tmcg->mPlayerIndex[g_tmcg->gBetIpfsMsg.nextBetTxID]));
-	result.push_back(Pair("curBet", g_tmcg->gBetIpfsMsg.curBet));
-	result.push_back(Pair("maxBet", g_tmcg->gBetIpfsMsg.maxBet));
-	result.push_back(Pair("jackpot", g_tmcg->gBetIpfsMsg.jackpot));
-	result.push_back(Pair("publicIndex", g_tmcg->gBetIpfsMsg.publicIndex));
-	result.push_back(Pair("fGameOver", g_tmcg->gBetIpfsMsg.fGameOver));
-	result.push_back(Pair("fFlopCard", g_tmcg->gBetIpfsMsg.fFlopCard));
+	result.push_back(Pair("curBetTxID", snap.gBetIpfsMsg.curBetTxID));
+	result.push_back(Pair("nextBetTxID", snap.gBetIpfsMsg.nextBetTxID));
+	result.push_back(Pair("curBetIndex", snap.mPlayerIndex[snap.gBetIpfsMsg.curBetTxID]));
+	result.push_back(Pair("nextBetIndex", snap.mPlayerIndex[snap.gBetIpfsMsg.nextBetTxID]));
+	result.push_back(Pair("curBet", snap.gBetIpfsMsg.curBet));
+	result.push_back(Pair("maxBet", snap.gBetIpfsMsg.maxBet));
+	result.push_back(Pair("jackpot", snap.gBetIpfsMsg.jackpot));
+	result.push_back(Pair("publicIndex", snap.gBetIpfsMsg.publicIndex));
+	result.push_back(Pair("fGameOver", snap.gBetIpfsMsg.fGameOver));
+	result.push_back(Pair("fFlopCard", snap.gBetIpfsMsg.fFlopCard));
 
 	UniValue betData(UniValue::VARR);	
-	for (auto &it: g_tmcg->mPlayerTxid) {
+	for (auto &it: snap.mPlayerTxid) {
 		UniValue bd(UniValue::VOBJ);
 		bd.push_back(Pair("index", it.first));
-		bd.push_back(Pair("hasbet", g_tmcg->gBetIpfsMsg.mHasBet[it.second]));
-		bd.push_back(Pair("balance", g_tmcg->gBetIpfsMsg.mBalance[it.second]));
-		bd.push_back(Pair("status", g_tmcg->gBetIpfsMsg.mPlayerStatus[it.first]));
+		bd.push_back(Pair("hasbet", snap.gBetIpfsMsg.mHasBet[it.second]));
+		bd.push_back(Pair("balance", snap.gBetIpfsMsg.mBalance[it.second]));
+		bd.push_back(Pair("status", snap.gBetIpfsMsg.mPlayerStatus[it.first]));
 		betData.push_back(bd);
 	}
 	result.push_back(Pair("betData", betData));
@@ -1798,38 +1957,41 @@ UniValue pokerdata(const JSONRPCRequest& request)
 
 	UniValue flopcards(UniValue::VARR);
 	// 避免只返回一张公共牌
-	if (g_tmcg->gBetIpfsMsg.publicIndex == 1 && g_tmcg->open_flop.size() != 3 && !g_tmcg->gBetIpfsMsg.fGameOver) {
+	if (snap.gBetIpfsMsg.publicIndex == 1 && snap.vFlopCard.size() != 3 && !snap.gBetIpfsMsg.fGameOver) {
 		result.push_back(Pair("type", PC_POKER_BET));
 		result.push_back(Pair("flopcards", flopcards));
 		return result;
 	}
 	
-	for(size_t k = 0; k < g_tmcg->open_flop.size(); k++) {
-		flopcards.push_back(g_tmcg->showPokerNumber(g_tmcg->open_flop[k].first));	
+	for(size_t k = 0; k < snap.vFlopCard.size(); k++) {
+		flopcards.push_back(snap.vFlopCard[k]);	
 	}
 	result.push_back(Pair("flopcards", flopcards));
 	
 	
 	UniValue openhands(UniValue::VARR);
-	for(size_t i = 0; i < g_tmcg->open_hand.size(); ++i) {
-       openhands.push_back(g_tmcg->showPokerNumber(g_tmcg->open_hand[i].first));
+	for(size_t i = 0; i < snap.vOpenHand.size(); ++i) {
+       openhands.push_back(snap.vOpenHand[i]);
 	}
 	result.push_back(Pair("openhands", openhands));
 	
 	
-	if (g_tmcg->gBetIpfsMsg.fGameOver) {
+	if (snap.gBetIpfsMsg.fGameOver) {
 		// 是否其他人都弃牌
-		int winIndex = isGameOver();
+		int winIndex = snap.nDiscardWinIndex;
 		if (winIndex > -1) {
-			if (g_tmcg->fDiscardMsg){
+			if (snap.fDiscardMsg){
 				result.push_back(Pair("fDiscard", true));	
 				result.push_back(Pair("winIndex", winIndex));
-				result.push_back(Pair("winStake", g_tmcg->gBetIpfsMsg.jackpot));
+				result.push_back(Pair("winStake", snap.gBetIpfsMsg.jackpot));
 				result.push_back(Pair("type", PC_POKER_HISTORY));
 			} else {
 				result.push_back(Pair("fDiscard", false));
 				result.push_back(Pair("type", PC_POKER_BET));
-				g_tmcg->fDiscardMsg = true;
+				pokerEventLoop.Post([table]() {
+					CPokerTableScope scope(table);
+					g_tmcg->fDiscardMsg = true;
+				});
 			}
 			return result;		
 		} else {
@@ -1838,28 +2000,27 @@ UniValue pokerdata(const JSONRPCRequest& request)
 	}
 	
 	
-	if (g_tmcg->vWinIndex.empty()) {
+	if (snap.vWinIndex.empty()) {
 		result.push_back(Pair("type", PC_POKER_BET));
 	} else {
 		result.push_back(Pair("type", PC_POKER_HISTORY));
 		
 		UniValue winners(UniValue::VARR);
-		for (auto &it: g_tmcg->vWinIndex) {
+		for (auto &it: snap.vWinIndex) {
 			winners.push_back(it);
 		}
 		result.push_back(Pair("winners", winners));
 		
 		UniValue pokertype(UniValue::VARR);
-		for (int i = 0; i < g_tmcg->playersize; i++) {
-			pokertype.push_back(g_tmcg->mPokerTypes[i]);
+		for (int i = 0; i < snap.playersize; i++) {
+			pokertype.push_back(snap.mPokerTypes[i]);
 		}
 		result.push_back(Pair("pokertype", pokertype));
-		result.push_back(Pair("winStake", (int) (g_tmcg->gBetIpfsMsg.jackpot / g_tmcg->vWinIndex.size())));
+		result.push_back(Pair("winStake", (int) (snap.gBetIpfsMsg.jackpot / snap.vWinIndex.size())));
 		
-		std::vector<int> vBest = g_tmcg->mBestGroups[g_tmcg->vWinIndex[0]];
 		UniValue bestGroup(UniValue::VARR);
-		for (auto &it: vBest) {
-			bestGroup.push_back(g_tmcg->showPokerNumber(it));
+		for (auto &it: snap.vBestGroup) {
+			bestGroup.push_back(it);
 		}
 		result.push_back(Pair("bestGroup", bestGroup));
 	}
@@ -1889,6 +2050,12 @@ static const CRPCCommand commands[] =
 	{ "poker",         		"pokerhistory",       	  &pokerhistory,           true,  {} },
 	{ "poker",         		"pokersign",        	  &pokersign,              true,  {"hex","index"} },
 	{ "poker",         		"pokerclear",        	  &pokerclear,             true,  {} },
+	{ "poker",         		"pokercacheinfo",     	  &pokercacheinfo,         true,  {} },
+	{ "poker",         		"pokerhttpinfo",     	  &pokerhttpinfo,          true,  {} },
+	{ "poker",         		"pokertables",     	  	  &pokertables,            true,  {} },
+	{ "poker",         		"pokernewtable",     	  &pokernewtable,          true,  {"binarycards"} },
+	{ "poker",         		"pokerusetable",     	  &pokerusetable,          true,  {"table"} },
+	{ "poker",         		"pokertable",     	  	  &pokertable,             true,  {"table","method","params"} },
 };
 
 void RegisterRawTransactionRPCCommands(CRPCTable &t)
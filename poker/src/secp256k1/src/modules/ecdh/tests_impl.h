@@ -96,10 +96,41 @@ void test_bad_scalar(void) {
     CHECK(secp256k1_ecdh(ctx, output, &point, s_overflow) == 1);
 }
 
+void test_ecdh_point(void) {
+    unsigned char s_zero[32] = { 0 };
+    int i;
+
+    /* Check against tweak_mul, which multiplies in variable time */
+    for (i = 0; i < 100; ++i) {
+        unsigned char s_b32[32];
+        unsigned char t_b32[32];
+        unsigned char ser[2][33];
+        size_t ser_len = 33;
+        secp256k1_pubkey point, res[2];
+        secp256k1_scalar s, t;
+
+        random_scalar_order(&s);
+        random_scalar_order(&t);
+        secp256k1_scalar_get_b32(s_b32, &s);
+        secp256k1_scalar_get_b32(t_b32, &t);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &point, t_b32) == 1);
+
+        CHECK(secp256k1_ecdh_point(ctx, &res[0], &point, s_b32) == 1);
+        res[1] = point;
+        CHECK(secp256k1_ec_pubkey_tweak_mul(ctx, &res[1], s_b32) == 1);
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, ser[0], &ser_len, &res[0], SECP256K1_EC_COMPRESSED) == 1);
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, ser[1], &ser_len, &res[1], SECP256K1_EC_COMPRESSED) == 1);
+        CHECK(memcmp(ser[0], ser[1], 33) == 0);
+
+        CHECK(secp256k1_ecdh_point(ctx, &res[0], &point, s_zero) == 0);
+    }
+}
+
 void run_ecdh_tests(void) {
     test_ecdh_api();
     test_ecdh_generator_basepoint();
     test_bad_scalar();
+    test_ecdh_point();
 }
 
 #endif
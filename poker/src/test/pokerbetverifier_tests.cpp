@@ -0,0 +1,190 @@
+#include "poker/betverifier.h"
+#include "poker/payloadcache.h"
+#include "poker/poker.h"
+#include "poker/tablemanager.h"
+#include "test/test_bitcoin.h"
+
+#include "amount.h"
+#include "script/script.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+static const std::string TXID_A = std::string(64, 'a');
+static const std::string TXID_B = std::string(64, 'b');
+
+// 两个玩家 A(座位 0), B(座位 1), 各 100. 下注链: A 下 10, B 跟 10, A 弃牌
+struct PokerBetVerifierSetup : public BasicTestingSetup
+{
+    std::shared_ptr<tmcg> table;
+    std::unique_ptr<CPokerTableScope> scope;
+    CTransactionRef txBetA, txCallB, txFoldA;
+
+    PokerBetVerifierSetup() : table(std::make_shared<tmcg>())
+    {
+        scope.reset(new CPokerTableScope(table));
+        table->mPlayerIndex[TXID_A] = 0;
+        table->mPlayerIndex[TXID_B] = 1;
+        table->mPlayerTxid[0] = TXID_A;
+        table->mPlayerTxid[1] = TXID_B;
+        table->mPokerBalance[TXID_A] = 100;
+        table->mPokerBalance[TXID_B] = 100;
+        table->TimeOut = false;
+
+        txBetA = BetTx("QmBetVerifierBetA", BetMsg(TXID_A, TXID_B, 10, 10, 10, 0, 90, 100, PS_DEFAULT, false), 10);
+        txCallB = BetTx("QmBetVerifierCallB", BetMsg(TXID_B, TXID_A, 10, 10, 10, 10, 90, 90, PS_DEFAULT, false), 10);
+        txFoldA = BetTx("QmBetVerifierFoldA", BetMsg(TXID_A, "", 0, 10, 10, 10, 90, 90, PS_DISCARD, true), 0);
+    }
+
+    static std::string BetMsg(const std::string &cur, const std::string &next, int curBet, int maxBet,
+        int hasBetA, int hasBetB, int balanceA, int balanceB, int statusA, bool fGameOver)
+    {
+        UniValue val(UniValue::VOBJ);
+        val.push_back(Pair("tableID", std::string(64, 'f')));
+        val.push_back(Pair("txID", cur));
+        val.push_back(Pair("curBetTxID", cur));
+        val.push_back(Pair("nextBetTxID", next));
+        val.push_back(Pair("curBet", curBet));
+        val.push_back(Pair("maxBet", maxBet));
+        val.push_back(Pair("jackpot", hasBetA + hasBetB));
+        val.push_back(Pair("publicIndex", 0));
+        val.push_back(Pair("fGameOver", fGameOver));
+        val.push_back(Pair("fFlopCard", false));
+        UniValue hbArr(UniValue::VARR), baArr(UniValue::VARR), psArr(UniValue::VARR);
+        const std::string vTxid[] = {TXID_A, TXID_B};
+        const int vHasBet[] = {hasBetA, hasBetB}, vBalance[] = {balanceA, balanceB}, vStatus[] = {statusA, PS_DEFAULT};
+        for (int i = 0; i < 2; ++i) {
+            UniValue hb(UniValue::VOBJ), ba(UniValue::VOBJ), ps(UniValue::VOBJ);
+            hb.push_back(Pair("txID", vTxid[i]));
+            hb.push_back(Pair("hasBet", vHasBet[i]));
+            ba.push_back(Pair("txID", vTxid[i]));
+            ba.push_back(Pair("balance", vBalance[i]));
+            ps.push_back(Pair("txIndex", i));
+            ps.push_back(Pair("status", vStatus[i]));
+            hbArr.push_back(hb), baArr.push_back(ba), psArr.push_back(ps);
+        }
+        val.push_back(Pair("mHasBet", hbArr));
+        val.push_back(Pair("mBalance", baArr));
+        val.push_back(Pair("mPlayerStatus", psArr));
+        return val.write();
+    }
+
+    // 下注交易: OP_POKER 输出为下注额, OP_RETURN 输出第 68 字节起是消息的 ipfs hash; nLockTime 只用来区分交易
+    static CTransactionRef BetTx(const std::string &hash, const std::string &msg, int nBet, uint32_t nLockTime = 0)
+    {
+        pokerPayloadCache.Put(hash, msg);
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        if (nBet)
+            mtx.vout.push_back(CTxOut(nBet * COIN, CScript() << OP_POKER));
+        std::vector<unsigned char> vch(68, 0x01);
+        vch[0] = OP_RETURN;
+        vch.insert(vch.end(), hash.begin(), hash.end());
+        mtx.vout.push_back(CTxOut(0, CScript(vch.begin(), vch.end())));
+        mtx.nLockTime = nLockTime;
+        return MakeTransactionRef(mtx);
+    }
+
+    // 这次验证读了几次缓存, 每笔交易两次(预取一次, 解析一次)
+    size_t VerifyHits(CBetChainVerifier &verifier, const std::vector<CTransactionRef> &vtx, bool &fRet, int &lieIndex)
+    {
+        std::vector<CTransaction> v;
+        for (auto &tx : vtx)
+            v.push_back(*tx);
+        uint64_t nHits = pokerPayloadCache.GetStats().nHits;
+        fRet = verifier.Verify(v, lieIndex);
+        return pokerPayloadCache.GetStats().nHits - nHits;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(pokerbetverifier_tests, PokerBetVerifierSetup)
+
+/* Each call only verifies the bets added since the last checkpoint */
+BOOST_AUTO_TEST_CASE(bet_verify_resume)
+{
+    CBetChainVerifier verifier;
+    bool fRet;
+    int lieIndex = -1;
+
+    // 游戏没结束时返回 false, 但检查点前进
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA}, fRet, lieIndex), 2U);
+    BOOST_CHECK(!fRet);
+    BOOST_CHECK_EQUAL(lieIndex, -1);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 1U);
+
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB}, fRet, lieIndex), 2U);
+    BOOST_CHECK(!fRet);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 2U);
+
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB, txFoldA}, fRet, lieIndex), 2U);
+    BOOST_CHECK(fRet);
+    BOOST_CHECK_EQUAL(lieIndex, -1);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 3U);
+
+    // 没有新交易, 不再读消息
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB, txFoldA}, fRet, lieIndex), 0U);
+    BOOST_CHECK(fRet);
+}
+
+/* A failed bet leaves the checkpoint at the last good one */
+BOOST_AUTO_TEST_CASE(bet_verify_failure_keeps_checkpoint)
+{
+    CBetChainVerifier verifier;
+    bool fRet;
+    int lieIndex = -1;
+
+    // B 声称跟了 10, 余额却没少
+    CTransactionRef txLieB = BetTx("QmBetVerifierLieB", BetMsg(TXID_B, TXID_A, 10, 10, 10, 10, 90, 100, PS_DEFAULT, false), 10);
+    VerifyHits(verifier, {txBetA, txLieB}, fRet, lieIndex);
+    BOOST_CHECK(!fRet);
+    BOOST_CHECK_EQUAL(lieIndex, 1);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 1U);
+
+    // 交易金额和消息不符
+    lieIndex = -1;
+    CTransactionRef txShortB = BetTx("QmBetVerifierCallB", "", 5, 1);
+    VerifyHits(verifier, {txBetA, txShortB}, fRet, lieIndex);
+    BOOST_CHECK(!fRet);
+    BOOST_CHECK_EQUAL(lieIndex, 1);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 1U);
+
+    lieIndex = -1;
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB, txFoldA}, fRet, lieIndex), 4U);
+    BOOST_CHECK(fRet);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 3U);
+}
+
+/* A replaced or shorter chain (reorg) and Reset() verify from the start */
+BOOST_AUTO_TEST_CASE(bet_verify_reset_on_reorg)
+{
+    CBetChainVerifier verifier;
+    bool fRet;
+    int lieIndex = -1;
+
+    VerifyHits(verifier, {txBetA, txCallB}, fRet, lieIndex);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 2U);
+
+    // 最后一笔换成另一笔交易, 从头验证
+    CTransactionRef txCallB2 = BetTx("QmBetVerifierCallB", "", 10, 2);
+    BOOST_CHECK(txCallB2->GetHash() != txCallB->GetHash());
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB2}, fRet, lieIndex), 4U);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 2U);
+
+    // 链变短
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA}, fRet, lieIndex), 2U);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 1U);
+
+    verifier.Reset();
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 0U);
+    BOOST_CHECK_EQUAL(VerifyHits(verifier, {txBetA, txCallB2, txFoldA}, fRet, lieIndex), 6U);
+    BOOST_CHECK(fRet);
+    BOOST_CHECK_EQUAL(lieIndex, -1);
+    BOOST_CHECK_EQUAL(verifier.GetVerifiedCount(), 3U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,331 @@
+#include "poker/pokercodec.h"
+#include "poker/poker.h"
+#include "poker/tablemanager.h"
+#include "test/test_bitcoin.h"
+
+#include "streams.h"
+#include "version.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+static const std::string TEST_TABLE_ID = "4f2c0e6d4b4a1d7c9a8e3b2f1c0d9e8f7a6b5c4d3e2f1a0b9c8d7e6f5a4b3c2d";
+
+// 三个玩家的牌桌, 座位号 0, 1, 2
+struct PokerCodecSetup : public BasicTestingSetup
+{
+    std::shared_ptr<tmcg> table;
+    std::unique_ptr<CPokerTableScope> scope;
+    std::vector<std::string> vTxid;
+
+    PokerCodecSetup() : table(std::make_shared<tmcg>())
+    {
+        scope.reset(new CPokerTableScope(table));
+        table->matchTableID = TEST_TABLE_ID;
+        for (int i = 0; i < 3; ++i) {
+            std::string txid = std::string(63, 'a' + i) + "0";
+            vTxid.push_back(txid);
+            table->mPlayerIndex[txid] = i;
+            table->mPlayerTxid[i] = txid;
+        }
+    }
+
+    UniValue NewMsg(int nSeat)
+    {
+        UniValue val(UniValue::VOBJ);
+        val.push_back(Pair("tableID", TEST_TABLE_ID));
+        val.push_back(Pair("txID", vTxid[nSeat]));
+        return val;
+    }
+};
+
+static std::string PackUnpack(const std::string &str)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << CPackedProof(str);
+    CPackedProof proof;
+    ss >> proof;
+    BOOST_CHECK(ss.empty());
+    return proof.str;
+}
+
+// 复制 val, 把 key 换成 value
+static UniValue Replace(const UniValue &val, const std::string &key, const UniValue &value)
+{
+    UniValue obj(UniValue::VOBJ);
+    const std::vector<std::string> &keys = val.getKeys();
+    const std::vector<UniValue> &values = val.getValues();
+    for (size_t i = 0; i < keys.size(); i++)
+        obj.push_back(Pair(keys[i], keys[i] == key ? value : values[i]));
+    return obj;
+}
+
+static std::string BinaryCard()
+{
+    std::string str(1, (char)POKER_CARD_BINARY_MAGIC);
+    for (int i = 0; i < 40; ++i)
+        str.push_back((char)(i * 7));
+    return str;
+}
+
+BOOST_FIXTURE_TEST_SUITE(pokercodec_tests, PokerCodecSetup)
+
+BOOST_AUTO_TEST_CASE(packed_proof_round_trip)
+{
+    const std::string vStr[] = {
+        "",
+        "|",
+        "1234567",                                  // 比 POKER_PROOF_MIN_DIGITS 短, 原样写
+        "12345678",
+        "00000000",                                 // 全是 0
+        "000000004JhrdeyrCcFwMDhz",                 // 前导 0
+        "stk^52^crd|4JhrdeyrCcFwMDhzxYfd|0001234|\n",
+        "crd|1|22|333|4444|55555|666666|7777777|88888888|999999999\n",
+        "ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ^zzzzzzzzzzzz",
+        BinaryCard(),
+        std::string("text\0with\0nul", 13) + "00000000000000000001",
+    };
+    for (auto &str : vStr)
+        BOOST_CHECK(PackUnpack(str) == str);
+
+    // 长的数字段按字节写, 比文本短
+    std::string proof = "crd|" + std::string(200, 'z') + "|" + std::string(200, 'A') + "\n";
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << CPackedProof(proof);
+    BOOST_CHECK(ss.size() < proof.size() * 7 / 8);
+}
+
+BOOST_AUTO_TEST_CASE(packed_proof_limits)
+{
+    CPackedProof proof;
+
+    // 原样字节段超过 MAX_POKER_PROOF_SIZE
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    WriteVarInt<CDataStream, uint64_t>(ss, (uint64_t)(MAX_POKER_PROOF_SIZE + 1) << 1);
+    BOOST_CHECK_THROW(ss >> proof, std::ios_base::failure);
+
+    // 数字段超过 MAX_POKER_PROOF_SIZE
+    ss.clear();
+    WriteVarInt<CDataStream, uint64_t>(ss, ((uint64_t)(MAX_POKER_PROOF_SIZE + 1) << 1) | 1);
+    ss << std::vector<unsigned char>(1, 1);
+    WriteVarInt<CDataStream, uint64_t>(ss, 0);
+    BOOST_CHECK_THROW(ss >> proof, std::ios_base::failure);
+
+    // 两段加起来超过 MAX_POKER_PROOF_SIZE
+    ss.clear();
+    WriteVarInt<CDataStream, uint64_t>(ss, (uint64_t)8 << 1);
+    ss.write("crd|1234", 8);
+    WriteVarInt<CDataStream, uint64_t>(ss, ((uint64_t)(MAX_POKER_PROOF_SIZE - 4) << 1) | 1);
+    ss << std::vector<unsigned char>(1, 1);
+    WriteVarInt<CDataStream, uint64_t>(ss, 0);
+    BOOST_CHECK_THROW(ss >> proof, std::ios_base::failure);
+
+    // 字节表示的数比声明的位数长
+    ss.clear();
+    WriteVarInt<CDataStream, uint64_t>(ss, ((uint64_t)2 << 1) | 1);
+    ss << std::vector<unsigned char>(4, 0xff);
+    WriteVarInt<CDataStream, uint64_t>(ss, 0);
+    BOOST_CHECK_THROW(ss >> proof, std::ios_base::failure);
+
+    // 座位数超过 MAX_POKER_SEATS
+    CSeatValues values;
+    ss.clear();
+    WriteCompactSize(ss, MAX_POKER_SEATS + 1);
+    for (uint32_t i = 0; i <= MAX_POKER_SEATS; ++i) {
+        WriteVarInt<CDataStream, uint32_t>(ss, i);
+        WriteVarInt<CDataStream, uint32_t>(ss, 1);
+    }
+    BOOST_CHECK_THROW(ss >> values, std::ios_base::failure);
+
+    ss.clear();
+    for (uint32_t i = 0; i < MAX_POKER_SEATS; ++i)
+        values.mValue[i] = i;
+    ss << values;
+    CSeatValues values2;
+    ss >> values2;
+    BOOST_CHECK(values2.mValue == values.mValue);
+}
+
+BOOST_AUTO_TEST_CASE(shuffle_msg_round_trip)
+{
+    UniValue val = NewMsg(1);
+    val.push_back(Pair("nextShuffleIndex", 2));
+    val.push_back(Pair("tmcg_shuffle", "stk^52^crd|4JhrdeyrCcFwMDhzxYfd|00000001234567\n"));
+
+    std::string payload;
+    BOOST_REQUIRE(EncodePokerPayload(PC_POKER_SHUFFLE, val, payload));
+    BOOST_CHECK(IsBinaryPayload(payload));
+
+    // 二进制和 json 解出同样的内容
+    for (auto &str : {payload, val.write()}) {
+        PokerShuffleMsg msg;
+        BOOST_REQUIRE(DecodeShuffleMsg(str, msg));
+        BOOST_CHECK_EQUAL(msg.txID, vTxid[1]);
+        BOOST_CHECK_EQUAL(msg.nextShuffleIndex, 2);
+        BOOST_CHECK_EQUAL(msg.shuffle, val["tmcg_shuffle"].get_str());
+    }
+
+    // 别的牌桌的消息, 或者多余的字节
+    PokerShuffleMsg msg;
+    table->matchTableID = std::string(64, '1');
+    BOOST_CHECK(!DecodeShuffleMsg(payload, msg));
+    table->matchTableID = TEST_TABLE_ID;
+    BOOST_CHECK(!DecodeShuffleMsg(payload + "x", msg));
+}
+
+BOOST_AUTO_TEST_CASE(hand_card_msg_round_trip)
+{
+    UniValue val = NewMsg(0);
+    UniValue handCards(UniValue::VARR);
+    for (int i = 1; i < 3; ++i) {
+        UniValue handcard(UniValue::VOBJ), hcard(UniValue::VARR);
+        hcard.push_back("crd|" + std::string(30, '0' + i) + "|1");
+        hcard.push_back("crd|00000000" + std::string(20, 'a' + i));
+        handcard.push_back(Pair("htxid", vTxid[i]));
+        handcard.push_back(Pair("hcard", hcard));
+        handCards.push_back(handcard);
+    }
+    val.push_back(Pair("handCards", handCards));
+
+    std::string payload;
+    BOOST_REQUIRE(EncodePokerPayload(PC_POKER_HAND_CARD, val, payload));
+    for (auto &str : {payload, val.write()}) {
+        PokerHandCardMsg msg;
+        BOOST_REQUIRE(DecodeHandCardMsg(str, msg));
+        BOOST_CHECK_EQUAL(msg.txID, vTxid[0]);
+        BOOST_REQUIRE_EQUAL(msg.mHandCard.size(), 2U);
+        for (int i = 1; i < 3; ++i) {
+            const std::vector<std::string> &vCard = msg.mHandCard[vTxid[i]];
+            BOOST_REQUIRE_EQUAL(vCard.size(), 2U);
+            BOOST_CHECK_EQUAL(vCard[0], handCards[i - 1]["hcard"][0].get_str());
+            BOOST_CHECK_EQUAL(vCard[1], handCards[i - 1]["hcard"][1].get_str());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cards_msg_round_trip)
+{
+    UniValue flop = NewMsg(2), open = NewMsg(2);
+    UniValue flopCards(UniValue::VARR), openhands(UniValue::VARR);
+    flopCards.push_back("crd|12345678901234567890|7");
+    openhands.push_back("crd|zzzzzzzzzzzz");
+    openhands.push_back(BinaryCard());
+    flop.push_back(Pair("flopCards", flopCards));
+    flop.push_back(Pair("flopIndex", 3));
+    open.push_back(Pair("openhands", openhands));
+
+    std::string payload;
+    BOOST_REQUIRE(EncodePokerPayload(PC_POKER_FLOP_CARD, flop, payload));
+    PokerCardsMsg msg;
+    BOOST_REQUIRE(DecodeCardsMsg(payload, PC_POKER_FLOP_CARD, msg));
+    BOOST_CHECK_EQUAL(msg.txID, vTxid[2]);
+    BOOST_CHECK_EQUAL(msg.flopIndex, 3);
+    BOOST_REQUIRE_EQUAL(msg.vCard.size(), 1U);
+    BOOST_CHECK_EQUAL(msg.vCard[0], flopCards[0].get_str());
+
+    // pokercode 不符
+    PokerCardsMsg msg2;
+    BOOST_CHECK(!DecodeCardsMsg(payload, PC_POKER_OPEN_HAND, msg2));
+
+    BOOST_REQUIRE(EncodePokerPayload(PC_POKER_OPEN_HAND, open, payload));
+    PokerCardsMsg msg3;
+    BOOST_REQUIRE(DecodeCardsMsg(payload, PC_POKER_OPEN_HAND, msg3));
+    BOOST_CHECK_EQUAL(msg3.flopIndex, -1);
+    BOOST_REQUIRE_EQUAL(msg3.vCard.size(), 2U);
+    BOOST_CHECK(msg3.vCard[0] == openhands[0].get_str());
+    BOOST_CHECK(msg3.vCard[1] == openhands[1].get_str());
+}
+
+BOOST_AUTO_TEST_CASE(bet_msg_round_trip)
+{
+    UniValue val = NewMsg(1);
+    val.push_back(Pair("curBetTxID", vTxid[1]));
+    val.push_back(Pair("nextBetTxID", vTxid[2]));
+    val.push_back(Pair("curBet", 20));
+    val.push_back(Pair("maxBet", 40));
+    val.push_back(Pair("jackpot", 130));
+    val.push_back(Pair("publicIndex", 1));
+    val.push_back(Pair("fGameOver", false));
+    val.push_back(Pair("fFlopCard", true));
+    UniValue hbArr(UniValue::VARR), baArr(UniValue::VARR), psArr(UniValue::VARR);
+    for (int i = 0; i < 3; ++i) {
+        UniValue hb(UniValue::VOBJ), ba(UniValue::VOBJ), ps(UniValue::VOBJ);
+        hb.push_back(Pair("txID", vTxid[i]));
+        hb.push_back(Pair("hasBet", 10 * (i + 1)));
+        ba.push_back(Pair("txID", vTxid[i]));
+        ba.push_back(Pair("balance", 1000 - i));
+        ps.push_back(Pair("txIndex", i));
+        ps.push_back(Pair("status", i % 2));
+        hbArr.push_back(hb), baArr.push_back(ba), psArr.push_back(ps);
+    }
+    val.push_back(Pair("mHasBet", hbArr));
+    val.push_back(Pair("mBalance", baArr));
+    val.push_back(Pair("mPlayerStatus", psArr));
+
+    std::string payload;
+    BOOST_REQUIRE(EncodePokerPayload(PC_POKER_BET, val, payload));
+    BetIpfsMsg bin, js;
+    std::string txBin, txJs;
+    BOOST_REQUIRE(DecodeBetMsg(payload, txBin, bin));
+    BOOST_REQUIRE(DecodeBetMsg(val.write(), txJs, js));
+    BOOST_CHECK_EQUAL(txBin, vTxid[1]);
+    BOOST_CHECK_EQUAL(txBin, txJs);
+    BOOST_CHECK_EQUAL(bin.curBetTxID, js.curBetTxID);
+    BOOST_CHECK_EQUAL(bin.nextBetTxID, vTxid[2]);
+    BOOST_CHECK_EQUAL(bin.curBet, 20);
+    BOOST_CHECK_EQUAL(bin.maxBet, 40);
+    BOOST_CHECK_EQUAL(bin.jackpot, 130);
+    BOOST_CHECK_EQUAL(bin.publicIndex, 1);
+    BOOST_CHECK(!bin.fGameOver);
+    BOOST_CHECK(bin.fFlopCard);
+    BOOST_CHECK(bin.mHasBet == js.mHasBet);
+    BOOST_CHECK(bin.mBalance == js.mBalance);
+    BOOST_CHECK(bin.mPlayerStatus == js.mPlayerStatus);
+    BOOST_CHECK_EQUAL(bin.mBalance[vTxid[2]], 998);
+
+    // 不在牌桌上的玩家, 超出 MAX_POKER_SEATS 的座位号, 负的金额都不能编码
+    BOOST_CHECK(!EncodePokerPayload(PC_POKER_BET, Replace(val, "nextBetTxID", std::string(64, 'f')), payload));
+    UniValue ps(UniValue::VOBJ), psBad = psArr;
+    ps.push_back(Pair("txIndex", (int)MAX_POKER_SEATS));
+    ps.push_back(Pair("status", 0));
+    psBad.push_back(ps);
+    BOOST_CHECK(!EncodePokerPayload(PC_POKER_BET, Replace(val, "mPlayerStatus", psBad), payload));
+    BOOST_CHECK(!EncodePokerPayload(PC_POKER_BET, Replace(val, "curBet", -1), payload));
+    table->mPlayerIndex[vTxid[2]] = MAX_POKER_SEATS;
+    BOOST_CHECK(!EncodePokerPayload(PC_POKER_BET, val, payload));
+}
+
+BOOST_AUTO_TEST_CASE(binary_cards_hex_fallback)
+{
+    const std::string card = BinaryCard();
+    UniValue val = NewMsg(0);
+    UniValue openhands(UniValue::VARR);
+    openhands.push_back(card);
+    openhands.push_back("crd|4JhrdeyrCcFwMDhz");
+    val.push_back(Pair("openhands", openhands));
+
+    // 二进制的牌转成 '#' + hex, 文本原样, 写成 json 后还能还原
+    UniValue hex = EncodeBinaryCardsAsHex(val);
+    const std::string &strHex = hex["openhands"][0].get_str();
+    BOOST_CHECK_EQUAL(strHex[0], POKER_CARD_HEX_PREFIX);
+    BOOST_CHECK_EQUAL(hex["openhands"][1].get_str(), openhands[1].get_str());
+    BOOST_CHECK_EQUAL(hex["txID"].get_str(), vTxid[0]);
+
+    PokerCardsMsg msg;
+    BOOST_REQUIRE(DecodeCardsMsg(hex.write(), PC_POKER_OPEN_HAND, msg));
+    BOOST_REQUIRE_EQUAL(msg.vCard.size(), 2U);
+    BOOST_CHECK(DecodeHexCards(msg.vCard[0]) == card);
+    BOOST_CHECK_EQUAL(DecodeHexCards(msg.vCard[1]), openhands[1].get_str());
+
+    // 不是合法 hex, 或者不是二进制牌的 hex, 原样返回
+    BOOST_CHECK_EQUAL(DecodeHexCards("#zz"), "#zz");
+    BOOST_CHECK_EQUAL(DecodeHexCards("#00ff"), "#00ff");
+    BOOST_CHECK_EQUAL(DecodeHexCards("#"), "#");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
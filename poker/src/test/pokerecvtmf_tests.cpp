@@ -0,0 +1,220 @@
+#include "poker/ecshuffle.h"
+#include "poker/ecvtmf.h"
+#include "test/test_bitcoin.h"
+
+#include <libTMCG.hh>
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokerecvtmf_tests, BasicTestingSetup)
+
+static const size_t POKER_TEST_TYPES = 52;
+
+// 两个玩家交换公钥后, 共同的 h = h_A + h_B
+struct PokerECSetup : public BasicTestingSetup
+{
+    CECVTMF a, b;
+
+    PokerECSetup() : a(POKER_TEST_TYPES), b(POKER_TEST_TYPES)
+    {
+        BOOST_REQUIRE(init_libTMCG());
+        a.KeyGenerationProtocol_GenerateKey();
+        b.KeyGenerationProtocol_GenerateKey();
+        std::stringstream ka, kb;
+        a.KeyGenerationProtocol_PublishKey(ka);
+        b.KeyGenerationProtocol_PublishKey(kb);
+        BOOST_REQUIRE(a.KeyGenerationProtocol_UpdateKey(kb));
+        BOOST_REQUIRE(b.KeyGenerationProtocol_UpdateKey(ka));
+    }
+
+    void MaskOpenCard(size_t type, VTMF_Card &c)
+    {
+        VTMF_Card open;
+        TMCG_StackSecret<VTMF_CardSecret> ss;
+        a.CreateOpenCard(open, type);
+        a.CreateStackSecret(ss, 1);
+        a.MaskCard(open, c, ss[0].second);
+    }
+
+    // a 用自己和 b 的份额解密
+    size_t OpenCard(const VTMF_Card &c)
+    {
+        std::stringstream proof;
+        b.VerifiableDecryptionProtocol_Prove(c.c_1, proof);
+        a.VerifiableDecryptionProtocol_Verify_Initialize(c.c_1);
+        if (!a.VerifiableDecryptionProtocol_Verify_Update(c.c_1, proof))
+            return POKER_TEST_TYPES;
+        return a.TypeOfCard(c);
+    }
+};
+
+// 把第 nSkip 个数(从 0 数)加 1, 其余原样写回
+static std::string TamperNumber(const std::string &str, size_t nSkip)
+{
+    std::stringstream in(str), out;
+    mpz_t v;
+    mpz_init(v);
+    for (size_t i = 0; in >> v; ++i)
+    {
+        if (i == nSkip)
+            mpz_add_ui(v, v, 1L);
+        out << v << std::endl;
+    }
+    mpz_clear(v);
+    return out.str();
+}
+
+BOOST_AUTO_TEST_CASE(ec_mul_secret)
+{
+    BOOST_REQUIRE(init_libTMCG());
+    mpz_t k;
+    mpz_init(k);
+    for (int i = 0; i < 8; ++i)
+    {
+        ECRandomScalar(k);
+        CECPoint P = ECMulG(k);
+        ECRandomScalar(k);
+        BOOST_CHECK(ECMulSecret(P, k) == ECMul(P, k));
+    }
+
+    // 0 和无穷远点都得到无穷远点
+    CECPoint P = ECMulG(k);
+    mpz_set_ui(k, 0L);
+    BOOST_CHECK(ECMulSecret(P, k).fInfinity);
+    mpz_set_ui(k, 7L);
+    BOOST_CHECK(ECMulSecret(CECPoint(), k).fInfinity);
+    mpz_clear(k);
+}
+
+BOOST_FIXTURE_TEST_CASE(ec_key_proof, PokerECSetup)
+{
+    BOOST_CHECK(a.h == ECAdd(a.h_i, b.h_i));
+    BOOST_CHECK(a.h == b.h);
+
+    CECVTMF c(POKER_TEST_TYPES);
+    c.KeyGenerationProtocol_GenerateKey();
+    std::stringstream kc;
+    c.KeyGenerationProtocol_PublishKey(kc);
+    const std::string key = kc.str();
+
+    // 篡改 c 或 r 都不能通过, 公钥不变
+    for (size_t i = 1; i <= 2; ++i)
+    {
+        std::stringstream bad(TamperNumber(key, i));
+        BOOST_CHECK(!a.KeyGenerationProtocol_UpdateKey(bad));
+    }
+    BOOST_CHECK(a.h == b.h);
+
+    // 自己的公钥和重复的公钥都拒绝
+    std::stringstream ka, kb;
+    a.KeyGenerationProtocol_PublishKey(ka);
+    b.KeyGenerationProtocol_PublishKey(kb);
+    BOOST_CHECK(!a.KeyGenerationProtocol_UpdateKey(ka));
+    BOOST_CHECK(!a.KeyGenerationProtocol_UpdateKey(kb));
+
+    std::stringstream good(key);
+    BOOST_CHECK(a.KeyGenerationProtocol_UpdateKey(good));
+    BOOST_CHECK(a.h == ECAdd(b.h, c.h_i));
+}
+
+BOOST_FIXTURE_TEST_CASE(ec_decryption_share, PokerECSetup)
+{
+    VTMF_Card c, c2;
+    MaskOpenCard(5, c);
+    MaskOpenCard(6, c2);
+    BOOST_CHECK_EQUAL(OpenCard(c), 5U);
+    BOOST_CHECK_EQUAL(OpenCard(c2), 6U);
+
+    std::stringstream proof;
+    b.VerifiableDecryptionProtocol_Prove(c.c_1, proof);
+    const std::string share = proof.str();
+
+    // 篡改 d_i, h_i, c, r, 或者拿别的牌的份额, 都不能通过
+    for (size_t i = 0; i < 4; ++i)
+    {
+        std::stringstream bad(TamperNumber(share, i));
+        a.VerifiableDecryptionProtocol_Verify_Initialize(c.c_1);
+        BOOST_CHECK(!a.VerifiableDecryptionProtocol_Verify_Update(c.c_1, bad));
+    }
+    std::stringstream other(share);
+    a.VerifiableDecryptionProtocol_Verify_Initialize(c2.c_1);
+    BOOST_CHECK(!a.VerifiableDecryptionProtocol_Verify_Update(c2.c_1, other));
+
+    // 批量验证逐个给出结果
+    std::stringstream ok(share), bad(TamperNumber(share, 3));
+    std::vector<mpz_srcptr> c_1;
+    std::vector<std::istream*> in;
+    std::vector<bool> result;
+    c_1.push_back(c.c_1), in.push_back(&ok);
+    c_1.push_back(c.c_1), in.push_back(&bad);
+    BOOST_CHECK(!a.VerifiableDecryptionProtocol_Verify_Batch(c_1, in, result));
+    BOOST_REQUIRE_EQUAL(result.size(), 2U);
+    BOOST_CHECK(result[0]);
+    BOOST_CHECK(!result[1]);
+}
+
+BOOST_FIXTURE_TEST_CASE(ec_remask, PokerECSetup)
+{
+    VTMF_Card c, cc;
+    MaskOpenCard(17, c);
+    TMCG_StackSecret<VTMF_CardSecret> ss;
+    b.CreateStackSecret(ss, 1);
+    b.MaskCard(c, cc, ss[0].second);
+    BOOST_CHECK(mpz_cmp(c.c_1, cc.c_1));
+    BOOST_CHECK(mpz_cmp(c.c_2, cc.c_2));
+    BOOST_CHECK_EQUAL(OpenCard(cc), 17U);
+}
+
+BOOST_FIXTURE_TEST_CASE(ec_shuffle, PokerECSetup)
+{
+    const size_t n = 8;
+    TMCG_Stack<VTMF_Card> s, s2;
+    for (size_t i = 0; i < n; ++i)
+    {
+        VTMF_Card c;
+        a.CreateOpenCard(c, i);
+        s.push(c);
+    }
+    TMCG_StackSecret<VTMF_CardSecret> ss;
+    a.CreateStackSecret(ss, n);
+    a.MixStack(s, s2, ss);
+
+    CECShuffle dealer(n, a.h);
+    std::stringstream group, proof;
+    dealer.PublishGroup(group);
+    dealer.Prove_noninteractive(s, s2, ss, proof);
+
+    // 被动方从发布的参数重建
+    CECShuffle shuffle(group);
+    BOOST_REQUIRE_EQUAL(shuffle.n, n);
+    std::stringstream in(proof.str());
+    BOOST_CHECK(shuffle.Verify_noninteractive(s, s2, in));
+
+    // 洗后每张牌还能解开, 且是原来的一个排列
+    std::vector<bool> seen(n, false);
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t type = OpenCard(s2[i]);
+        BOOST_REQUIRE(type < n);
+        seen[type] = true;
+    }
+    BOOST_CHECK(std::find(seen.begin(), seen.end(), false) == seen.end());
+
+    // 篡改证明
+    std::stringstream bad(TamperNumber(proof.str(), 10));
+    BOOST_CHECK(!shuffle.Verify_noninteractive(s, s2, bad));
+
+    // 交换输出的两张牌
+    TMCG_Stack<VTMF_Card> s3;
+    s3.push(s2[1]);
+    s3.push(s2[0]);
+    for (size_t i = 2; i < n; ++i)
+        s3.push(s2[i]);
+    std::stringstream in3(proof.str());
+    BOOST_CHECK(!shuffle.Verify_noninteractive(s, s3, in3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
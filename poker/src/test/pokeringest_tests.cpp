@@ -0,0 +1,109 @@
+#include "poker/pokeringest.h"
+#include "test/test_bitcoin.h"
+
+#include "utiltime.h"
+
+#include <future>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokeringest_tests, BasicTestingSetup)
+
+// 第 i 个输出: OP_RETURN <i>, script[2] 即 i
+static CScript IngestScript(unsigned char i)
+{
+    return CScript() << OP_RETURN << std::vector<unsigned char>(1, i);
+}
+
+// 等 fn() 成立, 最多 10 秒
+template<typename Fn>
+static bool WaitFor(Fn fn)
+{
+    for (int i = 0; i < 1000 && !fn(); ++i)
+        MilliSleep(10);
+    return fn();
+}
+
+/* Without workers every output is fetched and applied inside Push */
+BOOST_AUTO_TEST_CASE(ingest_sync)
+{
+    std::vector<int> vApplied;
+    CPokerIngestQueue queue(
+        [](const CScript &script, std::string &payload) { payload.assign(1, (char)script[2]); },
+        [&](const CScript &script, std::string &payload, const CTransaction &tx) { vApplied.push_back(payload[0]); });
+
+    CTransactionRef tx = MakeTransactionRef(CMutableTransaction());
+    for (unsigned char i = 0; i < 3; ++i) {
+        queue.Push(IngestScript(i), tx);
+        BOOST_CHECK_EQUAL(vApplied.size(), i + 1U);
+    }
+    BOOST_CHECK(vApplied == std::vector<int>({0, 1, 2}));
+    BOOST_CHECK_EQUAL(queue.Size(), 0U);
+}
+
+/* Fetches finish out of order; outputs are still applied in the order they were pushed */
+BOOST_AUTO_TEST_CASE(ingest_out_of_order_fetch)
+{
+    const int n = 4;
+    std::vector<std::promise<void> > vRelease(n);
+    std::vector<std::shared_future<void> > vGate;
+    for (auto &it : vRelease)
+        vGate.push_back(it.get_future().share());
+
+    boost::mutex mutex;
+    std::vector<int> vFetched, vApplied;
+    CPokerIngestQueue queue(
+        [&](const CScript &script, std::string &payload) {
+            int i = script[2];
+            vGate[i].wait();
+            payload.assign(1, (char)i);
+            boost::unique_lock<boost::mutex> lock(mutex);
+            vFetched.push_back(i);
+        },
+        [&](const CScript &script, std::string &payload, const CTransaction &tx) {
+            // 数据和输出对不上时记 -1
+            boost::unique_lock<boost::mutex> lock(mutex);
+            vApplied.push_back(payload[0] == (char)script[2] ? payload[0] : -1);
+        });
+    auto fnCount = [&](std::vector<int> &v) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return v.size();
+    };
+
+    boost::thread_group threadGroup;
+    queue.SetWorkers(n);
+    for (int i = 0; i < n; ++i)
+        threadGroup.create_thread(boost::bind(&CPokerIngestQueue::Thread, &queue));
+
+    CTransactionRef tx = MakeTransactionRef(CMutableTransaction());
+    for (int i = 0; i < n; ++i)
+        queue.Push(IngestScript(i), tx);
+    BOOST_CHECK_EQUAL(queue.Size(), (size_t)n);
+
+    // 3, 1 先拉取完成, 0 没完成前都不应用
+    vRelease[3].set_value();
+    vRelease[1].set_value();
+    BOOST_CHECK(WaitFor([&]() { return fnCount(vFetched) == 2; }));
+    BOOST_CHECK_EQUAL(fnCount(vApplied), 0U);
+
+    // 0 完成后应用 0, 1; 2 还在等
+    vRelease[0].set_value();
+    BOOST_CHECK(WaitFor([&]() { return fnCount(vApplied) == 2; }));
+    MilliSleep(50);
+    BOOST_CHECK_EQUAL(fnCount(vApplied), 2U);
+    BOOST_CHECK_EQUAL(queue.Size(), 2U);
+
+    vRelease[2].set_value();
+    BOOST_CHECK(WaitFor([&]() { return fnCount(vApplied) == (size_t)n; }));
+    BOOST_CHECK(vFetched == std::vector<int>({3, 1, 0, 2}) || vFetched == std::vector<int>({1, 3, 0, 2}));
+    BOOST_CHECK(vApplied == std::vector<int>({0, 1, 2, 3}));
+    BOOST_CHECK_EQUAL(queue.Size(), 0U);
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#include "poker/maskpool.h"
+#include "test/test_bitcoin.h"
+#include "utiltime.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokermaskpool_tests, BasicTestingSetup)
+
+// 小群参数, 只为测试速度
+struct PokerMaskPoolSetup : public BasicTestingSetup
+{
+    BarnettSmartVTMF_dlog vtmf;
+
+    PokerMaskPoolSetup() : vtmf(1024, 160)
+    {
+        BOOST_REQUIRE(init_libTMCG());
+        vtmf.KeyGenerationProtocol_GenerateKey();
+        vtmf.KeyGenerationProtocol_Finalize();
+    }
+
+    bool WaitReady(CPokerMaskPool &pool, size_t n)
+    {
+        for (int i = 0; i < 3000 && pool.GetReadyCount() < n; i++)
+            MilliSleep(10);
+        return pool.GetReadyCount() == n;
+    }
+
+    // g_r = g^r, h_r = h^r
+    bool CheckMask(mpz_srcptr r, mpz_srcptr g_r, mpz_srcptr h_r)
+    {
+        mpz_t foo;
+        mpz_init(foo);
+        mpz_powm(foo, vtmf.g, r, vtmf.p);
+        bool ret = !mpz_cmp(foo, g_r);
+        mpz_powm(foo, vtmf.h, r, vtmf.p);
+        ret = ret && !mpz_cmp(foo, h_r);
+        mpz_clear(foo);
+        return ret;
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(mask_pool_not_started, PokerMaskPoolSetup)
+{
+    CPokerMaskPool pool;
+    SchindelhauerTMCG tmcg(64, 2, 3);
+    TMCG_StackSecret<VTMF_CardSecret> ss;
+    std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+    std::vector<std::unique_ptr<CPokerMask> > vMask;
+    tmcg.TMCG_CreateStackSecret(ss, false, 4, &vtmf);
+    TMCG_StackSecret<VTMF_CardSecret> ss2 = ss;
+
+    // 没有预先计算的值, 调用方自己算, ss 不变
+    BOOST_CHECK(!pool.Take(ss, masks, vMask));
+    BOOST_CHECK(masks.empty() && vMask.empty());
+    for (size_t i = 0; i < ss.size(); i++)
+        BOOST_CHECK(!mpz_cmp(ss[i].second.r, ss2[i].second.r));
+}
+
+BOOST_FIXTURE_TEST_CASE(mask_pool_take, PokerMaskPoolSetup)
+{
+    CPokerMaskPool pool;
+    SchindelhauerTMCG tmcg(64, 2, 3);
+    TMCG_Stack<VTMF_Card> s, s2, s3;
+    for (size_t type = 0; type < 6; type++)
+    {
+        VTMF_Card c;
+        tmcg.TMCG_CreateOpenCard(c, &vtmf, type);
+        s.push(c);
+    }
+
+    pool.Start(&vtmf, 4);
+    BOOST_REQUIRE(WaitReady(pool, 4));
+
+    // 只算好了 4 组, 不够的 2 组当场计算
+    TMCG_StackSecret<VTMF_CardSecret> ss;
+    std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+    std::vector<std::unique_ptr<CPokerMask> > vMask;
+    tmcg.TMCG_CreateStackSecret(ss, false, s.size(), &vtmf);
+    BOOST_CHECK(pool.Take(ss, masks, vMask));
+    BOOST_CHECK_EQUAL(masks.size(), s.size());
+    BOOST_CHECK_EQUAL(vMask.size(), s.size());
+    for (size_t i = 0; i < ss.size(); i++)
+    {
+        BOOST_CHECK(!mpz_cmp(ss[i].second.r, vMask[i]->r));
+        BOOST_CHECK(CheckMask(ss[i].second.r, masks[i].first, masks[i].second));
+    }
+
+    // 用预先计算的值打乱牌堆, 结果与当场计算相同
+    tmcg.TMCG_MixStack(s, s2, ss, masks, &vtmf);
+    tmcg.TMCG_MixStack(s, s3, ss, &vtmf);
+    BOOST_CHECK(s2 == s3);
+
+    // 已经取空, 后面的调用方自己算
+    std::vector<mpz_ptr> rand;
+    BOOST_CHECK(!pool.Take(TMCG_GROTH_PRECOMPUTED, rand, masks, vMask));
+    BOOST_CHECK_EQUAL(pool.GetReadyCount(), 0U);
+}
+
+BOOST_FIXTURE_TEST_CASE(mask_pool_take_proof, PokerMaskPoolSetup)
+{
+    CPokerMaskPool pool;
+    pool.Start(&vtmf, 2 + TMCG_GROTH_PRECOMPUTED);
+    BOOST_REQUIRE(WaitReady(pool, 2 + TMCG_GROTH_PRECOMPUTED));
+
+    // 洗牌取走 2 组, 剩下的给洗牌证明
+    std::vector<mpz_ptr> rand;
+    std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+    std::vector<std::unique_ptr<CPokerMask> > vMask;
+    BOOST_CHECK(pool.Take(2, rand, masks, vMask));
+    BOOST_CHECK_EQUAL(pool.GetReadyCount(), (size_t)TMCG_GROTH_PRECOMPUTED);
+    BOOST_CHECK(pool.Take(TMCG_GROTH_PRECOMPUTED, rand, masks, vMask));
+    BOOST_CHECK_EQUAL(rand.size(), (size_t)TMCG_GROTH_PRECOMPUTED);
+    for (size_t i = 0; i < rand.size(); i++)
+        BOOST_CHECK(CheckMask(rand[i], masks[i].first, masks[i].second));
+    BOOST_CHECK_EQUAL(pool.GetReadyCount(), 0U);
+}
+
+BOOST_FIXTURE_TEST_CASE(mask_pool_stop, PokerMaskPoolSetup)
+{
+    CPokerMaskPool pool;
+    std::vector<mpz_ptr> rand;
+    std::vector<std::pair<mpz_ptr, mpz_ptr> > masks;
+    std::vector<std::unique_ptr<CPokerMask> > vMask;
+
+    // 停止后结果丢弃
+    pool.Start(&vtmf, 2);
+    BOOST_REQUIRE(WaitReady(pool, 2));
+    pool.Stop();
+    BOOST_CHECK_EQUAL(pool.GetReadyCount(), 0U);
+    BOOST_CHECK(!pool.Take(1, rand, masks, vMask));
+
+    // 重新开始时丢弃之前的结果, 没算完就取出时只拿到已经算好的部分
+    pool.Start(&vtmf, 2);
+    BOOST_REQUIRE(WaitReady(pool, 2));
+    pool.Start(&vtmf, 1000);
+    BOOST_CHECK(pool.GetReadyCount() < 1000);
+    if (pool.Take(3, rand, masks, vMask))
+    {
+        BOOST_CHECK_EQUAL(rand.size(), 3U);
+        for (size_t i = 0; i < rand.size(); i++)
+            BOOST_CHECK(CheckMask(rand[i], masks[i].first, masks[i].second));
+    }
+    pool.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
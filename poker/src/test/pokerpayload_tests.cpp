@@ -0,0 +1,34 @@
+#include "poker/payloadstore.h"
+#include "test/test_bitcoin.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokerpayload_tests, BasicTestingSetup)
+
+// data[i] = i % 251, so chunk boundaries do not line up with a repeating pattern
+static std::string PatternPayload(size_t nSize)
+{
+    std::string data(nSize, '\0');
+    for (size_t i = 0; i < nSize; ++i)
+        data[i] = (char)(i % 251);
+    return data;
+}
+
+/* Single chunk: the well known "ipfs add" hashes */
+BOOST_AUTO_TEST_CASE(payload_hash_single_chunk)
+{
+    BOOST_CHECK_EQUAL(ComputePayloadHash(""), "QmbFMke1KXqnYyBBWxB74N4c5SBnJMVAiMNRcGu6x1AwQH");
+    BOOST_CHECK_EQUAL(ComputePayloadHash("hello world\n"), "QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o");
+    BOOST_CHECK_EQUAL(ComputePayloadHash(PatternPayload(262144)), "QmeqfRyS3vkku7n6krqC3DgGMex3x2sCpSeKMDmrG13QQq");
+}
+
+/* More than one 256KiB chunk: root node linking the leaves */
+BOOST_AUTO_TEST_CASE(payload_hash_multi_chunk)
+{
+    BOOST_CHECK_EQUAL(ComputePayloadHash(PatternPayload(262145)), "QmUSjGawaz4ptvREcMKSMJneWCa5j8dAz2wSAAvHtW2rnB");
+    BOOST_CHECK_EQUAL(ComputePayloadHash(PatternPayload(2 * 262144 + 1000)), "QmZcZxYrxuDHjzgVm2FwQQdPAhm7xHmm8kbXCax5JvkcoX");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+#include "poker/reorderbuffer.h"
+#include "test/test_bitcoin.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokerreorder_tests, BasicTestingSetup)
+
+/* Messages are released in protocol order (phase, round, seat) once ready,
+   whatever order they were parked in */
+BOOST_AUTO_TEST_CASE(reorder_release_order)
+{
+    CPokerReorderBuffer buffer;
+    std::vector<std::string> vApplied;
+    int nFlopReady = -1;
+    bool fHandReady = false;
+    auto fnReady = [&](PokerPhase phase, int nRound, uint32_t nSeat) {
+        if (phase == PP_HAND_CARD)
+            return fHandReady;
+        return nRound <= nFlopReady;
+    };
+
+    BOOST_CHECK(buffer.Park("t1", PP_FLOP_CARD, 3, 1, [&]() { vApplied.push_back("turn 1"); }));
+    BOOST_CHECK(buffer.Park("t1", PP_FLOP_CARD, 0, 0, [&]() { vApplied.push_back("flop 0"); }));
+    BOOST_CHECK(buffer.Park("t1", PP_HAND_CARD, 0, 2, [&]() { vApplied.push_back("hand 2"); }));
+    BOOST_CHECK(buffer.Park("t1", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back("hand 0"); }));
+    BOOST_CHECK(buffer.Park("t2", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back("other table"); }));
+    // same key: only the first one is kept
+    BOOST_CHECK(!buffer.Park("t1", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back("hand 0 again"); }));
+    BOOST_CHECK_EQUAL(buffer.Count("t1"), 4U);
+
+    // nothing ready yet
+    BOOST_CHECK_EQUAL(buffer.Release("t1", fnReady), 0U);
+    BOOST_CHECK(vApplied.empty());
+
+    // the hand cards go first, by seat
+    fHandReady = true;
+    BOOST_CHECK_EQUAL(buffer.Release("t1", fnReady), 2U);
+    BOOST_CHECK_EQUAL(vApplied.size(), 2U);
+    BOOST_CHECK_EQUAL(vApplied[0], "hand 0");
+    BOOST_CHECK_EQUAL(vApplied[1], "hand 2");
+
+    // a released message may make the next one ready
+    vApplied.clear();
+    nFlopReady = 0;
+    BOOST_CHECK(buffer.Park("t1", PP_FLOP_CARD, 0, 1, [&]() { vApplied.push_back("flop 1"); nFlopReady = 3; }));
+    BOOST_CHECK_EQUAL(buffer.Release("t1", fnReady), 3U);
+    BOOST_CHECK_EQUAL(vApplied.size(), 3U);
+    BOOST_CHECK_EQUAL(vApplied[0], "flop 0");
+    BOOST_CHECK_EQUAL(vApplied[1], "flop 1");
+    BOOST_CHECK_EQUAL(vApplied[2], "turn 1");
+    BOOST_CHECK_EQUAL(buffer.Count("t1"), 0U);
+
+    // the other table is left alone
+    BOOST_CHECK_EQUAL(buffer.Count("t2"), 1U);
+}
+
+/* Clear drops a table, a full table evicts the message furthest in protocol order */
+BOOST_AUTO_TEST_CASE(reorder_eviction)
+{
+    CPokerReorderBuffer buffer;
+    std::vector<int> vApplied;
+    auto fnReady = [](PokerPhase phase, int nRound, uint32_t nSeat) { return true; };
+
+    BOOST_CHECK(buffer.Park("t1", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back(-1); }));
+    BOOST_CHECK(buffer.Park("t2", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back(-2); }));
+    buffer.Clear("t1");
+    BOOST_CHECK_EQUAL(buffer.Count("t1"), 0U);
+    BOOST_CHECK_EQUAL(buffer.Count("t2"), 1U);
+    BOOST_CHECK_EQUAL(buffer.Release("t1", fnReady), 0U);
+    BOOST_CHECK(vApplied.empty());
+    buffer.Clear("t2");
+
+    // fill with flop rounds 1 .. MAX_POKER_PARKED_MSGS
+    for (int i = 1; i <= (int)MAX_POKER_PARKED_MSGS; i++)
+        BOOST_CHECK(buffer.Park("t1", PP_FLOP_CARD, i, 0, [&vApplied, i]() { vApplied.push_back(i); }));
+    BOOST_CHECK_EQUAL(buffer.Count("t1"), MAX_POKER_PARKED_MSGS);
+
+    // a later message than all parked ones is refused
+    BOOST_CHECK(!buffer.Park("t1", PP_FLOP_CARD, MAX_POKER_PARKED_MSGS + 1, 0, [&]() { vApplied.push_back(1000); }));
+    // an earlier one evicts the last round
+    BOOST_CHECK(buffer.Park("t1", PP_HAND_CARD, 0, 0, [&]() { vApplied.push_back(0); }));
+    BOOST_CHECK_EQUAL(buffer.Count("t1"), MAX_POKER_PARKED_MSGS);
+    // other tables have their own limit
+    BOOST_CHECK(buffer.Park("t2", PP_FLOP_CARD, 1000, 0, [&]() { vApplied.push_back(-2); }));
+
+    BOOST_CHECK_EQUAL(buffer.Release("t1", fnReady), MAX_POKER_PARKED_MSGS);
+    BOOST_CHECK_EQUAL(vApplied.size(), MAX_POKER_PARKED_MSGS);
+    for (size_t i = 0; i < vApplied.size(); i++)
+        BOOST_CHECK_EQUAL(vApplied[i], (int)i);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
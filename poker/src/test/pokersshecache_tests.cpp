@@ -0,0 +1,118 @@
+#include "poker/sshecache.h"
+#include "test/test_bitcoin.h"
+
+#include <libTMCG.hh>
+
+#include <memory>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokersshecache_tests, BasicTestingSetup)
+
+// 1024 位的群只为测试速度, 子群仍用 256 位, Groth 的非交互证明需要; 各局沿用同一群参数, 每局重新生成密钥
+struct PokerSsheCacheSetup : public BasicTestingSetup
+{
+    std::string group;
+
+    PokerSsheCacheSetup()
+    {
+        BOOST_REQUIRE(init_libTMCG());
+        BarnettSmartVTMF_dlog vtmf(1024, 256);
+        std::stringstream out;
+        vtmf.PublishGroup(out);
+        group = out.str();
+    }
+
+    std::unique_ptr<BarnettSmartVTMF_dlog> NewHand()
+    {
+        std::stringstream in(group);
+        std::unique_ptr<BarnettSmartVTMF_dlog> vtmf(new BarnettSmartVTMF_dlog(in, 1024, 256));
+        vtmf->KeyGenerationProtocol_GenerateKey();
+        vtmf->KeyGenerationProtocol_Finalize();
+        return vtmf;
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(sshe_cache_hit_next_hand, PokerSsheCacheSetup)
+{
+    CPokerSsheCache cache;
+    const size_t n = 4;
+
+    // 第一局: 没有缓存, 生成并验证生成元
+    std::unique_ptr<BarnettSmartVTMF_dlog> hand1 = NewHand();
+    BOOST_CHECK(!cache.Get(n, *hand1));
+    GrothVSSHE vsshe1(n, hand1->p, hand1->q, hand1->k, hand1->g, hand1->h, TMCG_GROTH_L_E, 1024, 256);
+    BOOST_REQUIRE(vsshe1.CheckGroup());
+    BOOST_CHECK(!cache.IsVerified(vsshe1));
+    cache.Add(vsshe1);
+    BOOST_CHECK(cache.IsVerified(vsshe1));
+
+    // 第二局: 公钥变了, 生成元沿用
+    std::unique_ptr<BarnettSmartVTMF_dlog> hand2 = NewHand();
+    BOOST_REQUIRE(mpz_cmp(hand1->h, hand2->h));
+    std::shared_ptr<GrothVSSHE> vsshe2 = cache.Get(n, *hand2);
+    BOOST_REQUIRE(vsshe2);
+    BOOST_CHECK(!mpz_cmp(vsshe2->h, hand2->h));
+    BOOST_CHECK(!mpz_cmp(vsshe2->com->h, hand2->h));
+    BOOST_CHECK(!mpz_cmp(vsshe2->g, hand2->g));
+    BOOST_REQUIRE_EQUAL(vsshe2->com->g.size(), n);
+    for (size_t i = 0; i < n; i++)
+        BOOST_CHECK(!mpz_cmp(vsshe2->com->g[i], vsshe1.com->g[i]));
+    BOOST_CHECK(cache.IsVerified(*vsshe2));
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+
+    // 被动方收到的 sshe 串: 生成元验证过
+    std::stringstream sshe;
+    vsshe2->PublishGroup(sshe);
+    GrothVSSHE passive(n, sshe, TMCG_GROTH_L_E, 1024, 256);
+    BOOST_CHECK(cache.IsVerified(passive));
+    BOOST_CHECK(passive.CheckGroup());
+
+    // 沿用的实例能正常证明和验证洗牌
+    SchindelhauerTMCG tmcg(64, 1, 2);
+    TMCG_Stack<VTMF_Card> s, s2;
+    TMCG_StackSecret<VTMF_CardSecret> ss;
+    for (size_t type = 0; type < n; type++)
+    {
+        VTMF_Card c;
+        tmcg.TMCG_CreateOpenCard(c, hand2.get(), type);
+        s.push(c);
+    }
+    tmcg.TMCG_CreateStackSecret(ss, false, s.size(), hand2.get());
+    tmcg.TMCG_MixStack(s, s2, ss, hand2.get());
+    std::stringstream proof;
+    tmcg.TMCG_ProveStackEquality_Groth_noninteractive(s, s2, ss, hand2.get(), vsshe2.get(), proof);
+    BOOST_CHECK(tmcg.TMCG_VerifyStackEquality_Groth_noninteractive(s, s2, hand2.get(), &passive, proof));
+}
+
+BOOST_FIXTURE_TEST_CASE(sshe_cache_miss, PokerSsheCacheSetup)
+{
+    CPokerSsheCache cache;
+    const size_t n = 4;
+    std::unique_ptr<BarnettSmartVTMF_dlog> hand = NewHand();
+    GrothVSSHE vsshe(n, hand->p, hand->q, hand->k, hand->g, hand->h, TMCG_GROTH_L_E, 1024, 256);
+    cache.Add(vsshe);
+
+    // 牌数不同
+    BOOST_CHECK(!cache.Get(n + 1, *hand));
+
+    // 换了一个生成元: 不算验证过
+    std::stringstream sshe;
+    vsshe.PublishGroup(sshe);
+    GrothVSSHE other(n, sshe, TMCG_GROTH_L_E, 1024, 256);
+    mpz_powm_ui(other.com->g[0], other.com->g[0], 2L, other.p);
+    BOOST_CHECK(!cache.IsVerified(other));
+
+    // 别的群参数
+    BarnettSmartVTMF_dlog vtmf2(1024, 256);
+    vtmf2.KeyGenerationProtocol_GenerateKey();
+    vtmf2.KeyGenerationProtocol_Finalize();
+    BOOST_CHECK(!cache.Get(n, vtmf2));
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get(n, *hand));
+    BOOST_CHECK(!cache.IsVerified(vsshe));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
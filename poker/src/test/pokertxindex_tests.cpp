@@ -0,0 +1,171 @@
+#include "poker/poker.h"
+#include "poker/pokertxindex.h"
+#include "test/test_bitcoin.h"
+
+#include "hash.h"
+#include "utilstrencodings.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pokertxindex_tests, BasicTestingSetup)
+
+static uint160 MsgHash(const std::string &msg)
+{
+    return Hash160(msg.begin(), msg.end());
+}
+
+static std::vector<unsigned char> HexIp(const std::string &ip)
+{
+    std::string hex = HexStr(ip.begin(), ip.end());
+    return std::vector<unsigned char>(hex.begin(), hex.end());
+}
+
+static CScript CommitScript(unsigned char nPokerCode, const std::string &msg, const std::string &ip)
+{
+    uint160 hash = MsgHash(msg);
+    std::vector<unsigned char> vch(1, nPokerCode);
+    vch.insert(vch.end(), hash.begin(), hash.end());
+    return CScript() << OP_RETURN << vch << HexIp(ip);
+}
+
+// nLockTime 只用来区分交易
+static CTransactionRef CommitTx(const std::vector<CScript> &vScript, uint32_t nLockTime = 0)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 1000;
+    mtx.vout[0].scriptPubKey = CScript() << OP_DUP;
+    for (auto &script : vScript)
+        mtx.vout.push_back(CTxOut(0, script));
+    mtx.nLockTime = nLockTime;
+    return MakeTransactionRef(mtx);
+}
+
+static CTransactionRef CommitTx(unsigned char nPokerCode, const std::string &msg, const std::string &ip, uint32_t nLockTime = 0)
+{
+    return CommitTx(std::vector<CScript>(1, CommitScript(nPokerCode, msg, ip)), nLockTime);
+}
+
+BOOST_AUTO_TEST_CASE(commit_parse_and_find)
+{
+    PokerCommitKey key;
+    std::vector<unsigned char> vchData;
+    BOOST_CHECK(CPokerTxIndex::ParseCommitment(CommitScript(PC_NODE_INDEX, "m", "1.2.3.4"), key, vchData));
+    BOOST_CHECK_EQUAL(key.nPokerCode, PC_NODE_INDEX);
+    BOOST_CHECK(key.hash == MsgHash("m"));
+    BOOST_CHECK(vchData == HexIp("1.2.3.4"));
+
+    // 不是 OP_RETURN, 哈希长度不对, 后面多了操作码
+    std::vector<unsigned char> vchShort(20, 1);
+    BOOST_CHECK(!CPokerTxIndex::ParseCommitment(CScript() << OP_DUP, key, vchData));
+    BOOST_CHECK(!CPokerTxIndex::ParseCommitment(CScript() << OP_RETURN << vchShort << HexIp("1.2.3.4"), key, vchData));
+    BOOST_CHECK(!CPokerTxIndex::ParseCommitment(CommitScript(PC_NODE_INDEX, "m", "1.2.3.4") << OP_DUP, key, vchData));
+
+    CPokerTxIndex index;
+    CTransactionRef tx = CommitTx(PC_NODE_INDEX, "m", "1.2.3.4");
+    index.Add(tx);
+    BOOST_CHECK(index.Find(PC_NODE_INDEX, MsgHash("m"), HexIp("1.2.3.4")) == tx);
+    // ip, pokercode 或消息不一致
+    BOOST_CHECK(!index.Find(PC_NODE_INDEX, MsgHash("m"), HexIp("1.2.3.5")));
+    BOOST_CHECK(!index.Find(PC_NEW_ADDRESS, MsgHash("m"), HexIp("1.2.3.4")));
+    BOOST_CHECK(!index.Find(PC_NODE_INDEX, MsgHash("n"), HexIp("1.2.3.4")));
+
+    std::set<std::string> setIp;
+    BOOST_CHECK(CPokerTxIndex::GetCommitmentIps(*tx, setIp));
+    BOOST_CHECK(setIp == std::set<std::string>({"1.2.3.4"}));
+    BOOST_CHECK(!CPokerTxIndex::GetCommitmentIps(*CommitTx(std::vector<CScript>()), setIp));
+}
+
+/* Counts are per pokercode and per table (each table has its own index) */
+BOOST_AUTO_TEST_CASE(commit_count_per_table)
+{
+    CPokerTxIndex table1, table2;
+    for (uint32_t i = 0; i < 3; ++i) {
+        std::string ip = "10.0.0." + std::to_string(i);
+        table1.Add(CommitTx(PC_NEW_ADDRESS, "addr" + ip, ip, i));
+        if (i < 2)
+            table1.Add(CommitTx(PC_POKER_ADDRESS, "paddr" + ip, ip, 10 + i));
+    }
+    table2.Add(CommitTx(PC_NEW_ADDRESS, "addr", "10.1.0.1"));
+
+    BOOST_CHECK_EQUAL(table1.Count(PC_NEW_ADDRESS), 3U);
+    BOOST_CHECK_EQUAL(table1.Count(PC_POKER_ADDRESS), 2U);
+    BOOST_CHECK_EQUAL(table1.Count(PC_NODE_INDEX), 0U);
+    BOOST_CHECK_EQUAL(table2.Count(PC_NEW_ADDRESS), 1U);
+    BOOST_CHECK_EQUAL(table2.Count(PC_POKER_ADDRESS), 0U);
+
+    // 一笔交易里同一 pokercode 的两个承诺只算一笔
+    std::vector<CScript> vScript;
+    vScript.push_back(CommitScript(PC_NODE_INDEX, "a", "10.0.0.1"));
+    vScript.push_back(CommitScript(PC_NODE_INDEX, "b", "10.0.0.1"));
+    table1.Add(CommitTx(vScript, 20));
+    BOOST_CHECK_EQUAL(table1.Count(PC_NODE_INDEX), 1U);
+
+    table1.Clear();
+    BOOST_CHECK_EQUAL(table1.Count(PC_NEW_ADDRESS), 0U);
+    BOOST_CHECK_EQUAL(table2.Count(PC_NEW_ADDRESS), 1U);
+}
+
+/* KeepPeers drops commitments from senders that are not seated and recounts */
+BOOST_AUTO_TEST_CASE(commit_keep_peers)
+{
+    CPokerTxIndex index;
+    CTransactionRef tx1 = CommitTx(PC_NEW_ADDRESS, "a1", "10.0.0.1", 1);
+    CTransactionRef tx2 = CommitTx(PC_NEW_ADDRESS, "a2", "10.0.0.2", 2);
+    CTransactionRef tx3 = CommitTx(PC_NEW_ADDRESS, "a3", "10.9.9.9", 3);
+    std::vector<CScript> vScript;
+    vScript.push_back(CommitScript(PC_NODE_INDEX, "n1", "10.0.0.1"));
+    vScript.push_back(CommitScript(PC_NODE_INDEX, "n2", "10.9.9.9"));
+    CTransactionRef tx4 = CommitTx(vScript, 4);
+    for (auto &tx : {tx1, tx2, tx3, tx4})
+        index.Add(tx);
+    BOOST_CHECK_EQUAL(index.Count(PC_NEW_ADDRESS), 3U);
+    BOOST_CHECK_EQUAL(index.Count(PC_NODE_INDEX), 1U);
+
+    index.KeepPeers(std::set<std::string>({"10.0.0.1", "10.0.0.2"}));
+    BOOST_CHECK_EQUAL(index.Count(PC_NEW_ADDRESS), 2U);
+    BOOST_CHECK_EQUAL(index.Count(PC_NODE_INDEX), 1U);
+    BOOST_CHECK(index.Find(PC_NEW_ADDRESS, MsgHash("a1"), HexIp("10.0.0.1")) == tx1);
+    BOOST_CHECK(!index.Find(PC_NEW_ADDRESS, MsgHash("a3"), HexIp("10.9.9.9")));
+    BOOST_CHECK(index.Find(PC_NODE_INDEX, MsgHash("n1"), HexIp("10.0.0.1")) == tx4);
+    BOOST_CHECK(!index.Find(PC_NODE_INDEX, MsgHash("n2"), HexIp("10.9.9.9")));
+
+    index.KeepPeers(std::set<std::string>());
+    BOOST_CHECK_EQUAL(index.Count(PC_NEW_ADDRESS), 0U);
+    BOOST_CHECK_EQUAL(index.Count(PC_NODE_INDEX), 0U);
+}
+
+/* A disconnected block puts its transactions back into the mempool, which adds them again */
+BOOST_AUTO_TEST_CASE(commit_block_disconnect)
+{
+    CPokerTxIndex index;
+    CTransactionRef tx1 = CommitTx(PC_POKER_ADDRESS, "p1", "10.0.0.1", 1);
+    CTransactionRef tx2 = CommitTx(PC_POKER_ADDRESS, "p2", "10.0.0.2", 2);
+    index.Add(tx1);
+    index.Add(tx2);
+    BOOST_CHECK_EQUAL(index.Count(PC_POKER_ADDRESS), 2U);
+
+    // 块连接后交易离开交易池, 索引不变; 断块后同样的交易重新加入, 不重复计数
+    index.Add(tx2);
+    index.Add(tx1);
+    BOOST_CHECK_EQUAL(index.Count(PC_POKER_ADDRESS), 2U);
+    BOOST_CHECK(index.Find(PC_POKER_ADDRESS, MsgHash("p1"), HexIp("10.0.0.1")) == tx1);
+
+    // 新链上同一承诺换了一笔交易, 计数不变, 查找得到新交易
+    CTransactionRef tx1b = CommitTx(PC_POKER_ADDRESS, "p1", "10.0.0.1", 100);
+    BOOST_CHECK(tx1b->GetHash() != tx1->GetHash());
+    index.Add(tx1b);
+    BOOST_CHECK_EQUAL(index.Count(PC_POKER_ADDRESS), 2U);
+    BOOST_CHECK(index.Find(PC_POKER_ADDRESS, MsgHash("p1"), HexIp("10.0.0.1")) == tx1b);
+
+    // 之后的 KeepPeers 重新计数, 结果一致
+    index.KeepPeers(std::set<std::string>({"10.0.0.1", "10.0.0.2"}));
+    BOOST_CHECK_EQUAL(index.Count(PC_POKER_ADDRESS), 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
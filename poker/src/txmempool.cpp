@@ -24,6 +24,12 @@
 //Portgas
 #include "netmessagemaker.h"
 #include "poker/poker.h"
+#include "poker/pokeringest.h"
+#include "poker/pokerloop.h"
+#include "poker/pokercodec.h"
+#include "poker/pokertxindex.h"
+#include "poker/reorderbuffer.h"
+#include "poker/tablemanager.h"
 #include <map>
 
 #define LOG_PRINT(msg) printf("log msg is : [ %s ] file is : %s  function is %s line is : %d\n",(msg),__FILE__,__FUNCTION__,__LINE__);
@@ -374,28 +380,11 @@ void CTxMemPool::AddTransactionsUpdated(unsigned int n)
 
 // 	add   to  tmcg
 std::map<std::string, std::string> gMapAddress;
-std::vector< CTransaction> vTxIpVerify; //40
-std::vector< CTransaction> vTxNewAddressVerify; //41
-std::vector< CTransaction> vTxPublicAddressVerify; //42
-std::vector< CTransaction> vTxPokerBalanceVerify; //43
-std::vector< CTransaction> vTxPokerHandleVerify; //44
-std::vector< CTransaction> vTxPokerDlogVerify; //45 // not use
-std::vector< CTransaction> vTxPokerPubkeyVerify; //46
-std::vector< CTransaction> vTxPokerSshVerify; //47
-std::vector< CTransaction> vTxPokerShuffleVerify; //49
-std::vector< CTransaction> vTxPokerHandleCardVerify; //51
-std::vector< CTransaction> vTxPokerFlopCardVerify; //53
-std::vector< CTransaction> vTxPokerOpenHandVerify; //55
-std::vector< CTransaction> vTxDepositVerify; //70
-std::vector< CTransaction> vTxBetVerify; //80
 std::vector< MsgTimeOut > vMsgTimeOut;
 std::vector< CTransaction> vTxTimeOut; //
 
 std::vector< CTransaction > vTxMatchPlayer;
 
-std::multimap<std::string, CTransaction> vTxBetPlayer;
-std::map<std::string, CTransaction> vTxDepositPlayer;
-
 
 void saveTxBet(std::string &ip,const CTransaction &tx)
 {
@@ -413,15 +402,15 @@ void saveTxBet(std::string &ip,const CTransaction &tx)
 		// // int tempAmount = -1;
 		// // pokerhistory(tempIndex,tempAmount);
 	// }
-	vTxBetVerify.push_back(tx);
-	vTxBetPlayer.insert(std::make_pair(ip,tx));
+	g_tmcg->vTxBetVerify.push_back(tx);
+	g_tmcg->vTxBetPlayer.insert(std::make_pair(ip,tx));
 	return ;
 }
 
 void saveTxDeposit(std::string &ip,const CTransaction &tx)
 {
-	vTxDepositVerify.push_back(tx);
-	vTxDepositPlayer.insert(std::make_pair(ip, tx));
+	g_tmcg->txIndex->Add(MakeTransactionRef(tx));
+	g_tmcg->vTxDepositPlayer.insert(std::make_pair(ip, tx));
 	return ;
 }
 
@@ -447,47 +436,54 @@ void parseMatchJson(std::string & getResponseStr)
     }
     std::string nextMatchIp = jsonMsg.at("nextMatchNode").get<std::string>();
     json jsTables = jsonMsg.at("matchTables");
-    std::map< std::string,std::vector<std::string > > mTableTx;
     std::map< std::string,std::string > mTxTab;
     for(auto & itObj : jsTables)
     {
-        std::vector<std::string> v;
         std::string tabid = itObj.at("tableID").get<std::string>();
-        // for(auto & it : itObj.at("tableTx"))
-        // {
-            // v.push_back(it);
-            // mTxTab[it] = tabid;	
-        // }
-		
-        for(size_t i = 0; i < itObj.at("tableTx").size(); i++)
+        for(auto & it : itObj.at("tableTx"))
         {
-			auto it = itObj.at("tableTx").at(i);
-            v.push_back(it);
             mTxTab[it] = tabid;
-			
-			g_tmcg->mPlayerIndex[it] = i;
-			g_tmcg->mPlayerTxid[i] = it;
-			 
-			if (it == g_tmcg->matchTxID) {  
-	            g_tmcg->myindex = i;
-			}
         }
-		
-        mTableTx[tabid] = v;
-
-		g_tmcg->playersize = itObj.at("tableTx").size();
-		g_tmcg->pokeraddress = itObj.at("pokeraddress").get<std::string>();
-		g_tmcg->fPokerAddressVerify = true;
-    }
-	
-	g_tmcg->matchTableID = mTxTab[g_tmcg->matchTxID];
-	
-	std::cout << "myTabid: " << g_tmcg->matchTableID << std::endl;
-	std::cout << "mytxid : " << g_tmcg->matchTxID << std::endl;
-	std::cout << "myindex: " << g_tmcg->myindex << std::endl;
-	std::cout << "g_tmcg->playersize: " << g_tmcg->playersize << std::endl;
-	std::cout << "g_tmcg->pokeraddress: " << g_tmcg->pokeraddress << std::endl;
-	std::cout << "g_tmcg->mPlayerIndex.size: " << g_tmcg->mPlayerIndex.size() << std::endl;
+    }
+
+    // 一条匹配结果可能包含本进程的多桌, 每桌只取包含自己 matchTxID 的那一项
+    for(auto & table : pokerTables.GetPending())
+    {
+        if(mTxTab.count(table->matchTxID) == 0)
+            continue;
+
+        CPokerTableScope scope(table);
+        for(auto & itObj : jsTables)
+        {
+            if(itObj.at("tableID").get<std::string>() != mTxTab[g_tmcg->matchTxID])
+                continue;
+
+            for(size_t i = 0; i < itObj.at("tableTx").size(); i++)
+            {
+                auto it = itObj.at("tableTx").at(i);
+                g_tmcg->mPlayerIndex[it] = i;
+                g_tmcg->mPlayerTxid[i] = it;
+
+                if (it == g_tmcg->matchTxID) {
+                    g_tmcg->myindex = i;
+                }
+            }
+
+            g_tmcg->playersize = itObj.at("tableTx").size();
+            g_tmcg->pokeraddress = itObj.at("pokeraddress").get<std::string>();
+            g_tmcg->fPokerAddressVerify = true;
+        }
+
+        g_tmcg->matchTableID = mTxTab[g_tmcg->matchTxID];
+        pokerTables.Bind(g_tmcg.get());
+
+        std::cout << "myTabid: " << g_tmcg->matchTableID << std::endl;
+        std::cout << "mytxid : " << g_tmcg->matchTxID << std::endl;
+        std::cout << "myindex: " << g_tmcg->myindex << std::endl;
+        std::cout << "g_tmcg->playersize: " << g_tmcg->playersize << std::endl;
+        std::cout << "g_tmcg->pokeraddress: " << g_tmcg->pokeraddress << std::endl;
+        std::cout << "g_tmcg->mPlayerIndex.size: " << g_tmcg->mPlayerIndex.size() << std::endl;
+    }
 
     std::vector< CTransaction > vTran;
     for(auto &tx : vTxMatchPlayer)
@@ -662,7 +658,7 @@ void parseHandleJson(std::string & getResponseStr)
 
 
     if(g_tmcg->isOne) return ;
-    if(g_tmcg->vtmfOne) return ;
+    if(g_tmcg->HasGroup()) return ;
     if(!g_tmcg->vtmf_str.str().empty())
     {
         //repeat tmcg_handle
@@ -746,16 +742,9 @@ void parsePubkeyJson(std::string & getResponseStr)
 //"hcard":["I7GZLZbqSsi1LmWtXIJ0cfRu0JDB1EgYolQNyQlnY45GxYJOBylbhRIPqIx6ETtqUSh27mMGuvIWVSYKyZ8LEuUlNIlcIupyMxcGbsa3O91RWy1gYXpiATIkJDUsQYx
 //oXdDfn6Dja5\nmbz8rC3IomLAboSMGu85KEXlEVMBFPUinAYYJ2yeLnB\nAnGMpQRez3SJ6qet3SigIiHMXSuP65Q4aUskoaRshVb\ndsKYVrk7mmaSrwVtbqu2RHjf3TxGEz2DpdYHmt6QqKu\n"]}]}
 
-void  parseHandCardsJson(std::string & getResponseStr)
+void  parseHandCardsMsg(PokerHandCardMsg &handMsg)
 {
-    json jsonMsg = json::parse(getResponseStr);
-    if(jsonMsg.find("txID") == jsonMsg.end() || jsonMsg.find("handCards") == jsonMsg.end())// simple check --> replace other check
-    {
-        // error log
-        LOG_PRINT("parseHandCardsJson not found ")
-        return ;
-    }
-    std::string txid = jsonMsg["txID"].get<std::string>();
+    std::string txid = handMsg.txID;
     if(g_tmcg->mPlayerIndex.count(txid) == 0)
     {
         //error log
@@ -775,42 +764,20 @@ void  parseHandCardsJson(std::string & getResponseStr)
         std::cout << "repeat hand card verify " << std::endl;
         return ;
     }
-    if(!jsonMsg["handCards"].is_array())
-    {
-        //error log
-        LOG_PRINT("handCards is not array ")
-        return ;
-    }
-
     std::map<int,std::string> mHandCardMsg;
 
-    auto handCards = jsonMsg["handCards"];
-    for(auto &arrayIt : handCards)
+    auto handCardIt = handMsg.mHandCard.find(g_tmcg->matchTxID);
+    if(handCardIt != handMsg.mHandCard.end())
     {
-        std::string htxid = arrayIt["htxid"];
-        if(htxid != g_tmcg->matchTxID)
-        {
-            // log
-            continue;
-        }
-
-        if(!mHandCardMsg.empty())
-        {
-            //error log
-            LOG_PRINT("mHandCardMsg is not empty")
-            return ;
-        }
-        auto hcard = arrayIt["hcard"];
+        auto &hcard = handCardIt->second;
         if(hcard.size() != 2)
         {
             //error log
             LOG_PRINT("hcard.size() != 2")
             return ;
         }
-        std::string cardOne = hcard[0].get<std::string>();
-        std::string cardTwo = hcard[1].get<std::string>();
-        mHandCardMsg[0] = cardOne;
-        mHandCardMsg[1] = cardTwo;
+        mHandCardMsg[0] = hcard[0];
+        mHandCardMsg[1] = hcard[1];
         g_tmcg->mHandCardVerify[txid] = mHandCardMsg;
     }
 
@@ -820,13 +787,14 @@ void  parseHandCardsJson(std::string & getResponseStr)
         return ;
     }
 
+    std::vector<const VTMF_Card*> vCard;
+    std::vector<std::vector<std::string> > vCardMsg(HANDCARDSIZE);
     for(int verifyHandIndex = 0;verifyHandIndex < HANDCARDSIZE; ++verifyHandIndex)
     {
-        g_tmcg->selfCardSecret(g_tmcg->myindex, verifyHandIndex);//
-
+        vCard.push_back(&g_tmcg->hand[g_tmcg->myindex][verifyHandIndex]);
         for(auto & playerIt : g_tmcg->mHandCardVerify)
         {
-            auto handcardMap =  playerIt.second;
+            auto &handcardMap =  playerIt.second;
             auto handCardMapIt = handcardMap.find(verifyHandIndex);
             if(handCardMapIt == handcardMap.end())
             {
@@ -834,15 +802,21 @@ void  parseHandCardsJson(std::string & getResponseStr)
                 std::cout << "hand card index : " << verifyHandIndex << " not found " <<std::endl;
                 return ;
             }
-            std::string handCardMsg = handCardMapIt->second;
-            if(!g_tmcg->verifyCardSecret(g_tmcg->myindex, verifyHandIndex, handCardMsg))
-            {
-                // verify error
-
-                std::cout << "verify hand card error . card index is  : " << verifyHandIndex << "  myindex is : " << g_tmcg->myindex <<std::endl;
-                return ;
-            }
+            vCardMsg[verifyHandIndex].push_back(handCardMapIt->second);
         }
+    }
+    // 所有份额一起批量验证
+    if(!g_tmcg->verifyCardSecretBatch(vCard, vCardMsg))
+    {
+        std::cout << "verify hand card error . myindex is : " << g_tmcg->myindex <<std::endl;
+        return ;
+    }
+
+    for(int verifyHandIndex = 0;verifyHandIndex < HANDCARDSIZE; ++verifyHandIndex)
+    {
+        g_tmcg->selfCardSecret(g_tmcg->myindex, verifyHandIndex);//
+        for(auto &handCardMsg : vCardMsg[verifyHandIndex])
+            g_tmcg->updateCardSecret(handCardMsg);
         g_tmcg->saveHandCard(g_tmcg->myindex, verifyHandIndex);
     }
     g_tmcg->showPlayerInfo();
@@ -854,63 +828,80 @@ void  parseHandCardsJson(std::string & getResponseStr)
 //"txID":"d325d4dd731f1e2bdada510157a9f202e0acf4cbb1ee7dea835934e92cbc80ff",
 //"nextShuffleIndex":1,
 ///"tmcg_shuffle":"stk^52^crd|4JhrdeyrCcFwMDhzxYfd"}
-void  parseShuffleJson(std::string & getResponseStr)
+void  parseShuffleMsg(PokerShuffleMsg &shuffleMsg)
 {
-    json jsonMsg = json::parse(getResponseStr);
-    if(jsonMsg.find("txID") == jsonMsg.end() || jsonMsg.find("nextShuffleIndex") == jsonMsg.end()||  jsonMsg.find("tmcg_shuffle") == jsonMsg.end())// simple check --> replace other check
+    std::string txid = shuffleMsg.txID;
+    auto indexIt = g_tmcg->mPlayerIndex.find(txid);
+    if(indexIt == g_tmcg->mPlayerIndex.end())
     {
-        // error log
-        LOG_PRINT("parseShuffleJson not found ")
+        //error log
+        LOG_PRINT("player index not found ")
         return ;
     }
-    std::string txid = jsonMsg["txID"].get<std::string>();
-    std::string tmcg_shuffle = jsonMsg["tmcg_shuffle"].get<std::string>();
-    int nextShuffleIndex = jsonMsg["nextShuffleIndex"].get<int>();
+    int seat = indexIt->second;
 
-	g_tmcg->nextShuffleIndex = nextShuffleIndex;
-
-    if(g_tmcg->mPlayerIndex.count(txid) == 0)
+    std::cout << "parseShuffleJson tmcg_shuffle size is : " << shuffleMsg.shuffle.size() << std::endl;
+    if(seat < g_tmcg->nextShuffleIndex || g_tmcg->mShuffleMsg.count(seat))
     {
-        //error log
-        LOG_PRINT("player index not found ")
+        std::cout << "repeat shuffle, seat : " << seat << std::endl;
         return ;
     }
+    // 可能比 SSHE 交易或上一个人的洗牌交易先到达, 先存起来
+    g_tmcg->mShuffleMsg[seat] = shuffleMsg.shuffle;
+}
 
-    std::cout << "parseShuffleJson tmcg_shuffle size is : " << tmcg_shuffle.size() << std::endl;
+// 验证从 nextShuffleIndex 开始已经到达的连续一段洗牌, 各条证明并行验证, 再按座位顺序更新牌堆
+void  parseShuffleChain()
+{
+    if(!g_tmcg->isOne && !g_tmcg->fVerifySSHE)
+        return ;
 
-    if(txid != g_tmcg->matchTxID)
+    std::vector<int> vSeat;
+    std::vector<std::string> vShuffleMsg;
+    std::vector<bool> vVerify;
+    for(int seat = g_tmcg->nextShuffleIndex; ; ++seat)
     {
+        auto it = g_tmcg->mShuffleMsg.find(seat);
+        if(it == g_tmcg->mShuffleMsg.end())
+            break;
+        vSeat.push_back(seat);
+        vShuffleMsg.push_back(it->second);
+        vVerify.push_back(seat != g_tmcg->myindex);// 自己的洗牌不验证
+    }
+    if(vSeat.empty())
+        return ;
 
-    	if(g_tmcg->s.empty())
-    	{
-    		g_tmcg->createCard();
-			std::cout << "g_tmcg->createCard successful " <<std::endl;
-    	}
-
-    	if(!g_tmcg->verifyShuffleCard(tmcg_shuffle))
-    	{
-            //error log
-            LOG_PRINT("parseShuffleJson error")
-            return ;
-    	}
-
-        LOG_PRINT("parseShuffleJson successful")
+    if(g_tmcg->s.empty())
+    {
+        g_tmcg->createCard();
+        std::cout << "g_tmcg->createCard successful " <<std::endl;
     }
 
-    if(nextShuffleIndex == g_tmcg->playersize)
+    std::vector<TMCG_Stack<VTMF_Card> > vStack;
+    std::vector<bool> vResult;
+    int64_t nStart = GetTimeMillis();
+    g_tmcg->verifyShuffleChain(vShuffleMsg, vVerify, vStack, vResult);
+    std::cout << "verify shuffle chain, links : " << vSeat.size() << " time : " << GetTimeMillis() - nStart << "ms" << std::endl;
+
+    for(size_t i = 0; i < vSeat.size(); ++i)
     {
-        g_tmcg->createHandCard();
-        LOG_PRINT("createHandCard successful")
+        g_tmcg->mShuffleMsg.erase(vSeat[i]);
+        g_tmcg->nextShuffleIndex = vSeat[i] + 1;
+        g_tmcg->s = vStack[i];
+        if(!vResult[i])
+        {
+            //error log
+            std::cout << "parseShuffleJson error, seat : " << vSeat[i] << std::endl;
+            continue;
+        }
+        if(vVerify[i])
+            LOG_PRINT("parseShuffleJson successful")
 
-		// Egret
-		if (!g_tmcg->vHandCardMsg.empty()) {
-			LOG_PRINT("=================================================== verify eraly handcard msg. ")
-			LOG_PRINT("=================================================== vHandCardMsg.size(): " + g_tmcg->vHandCardMsg.size())
-			for(auto &it: g_tmcg->vHandCardMsg ){
-				parseHandCardsJson(it);
-			}
-			g_tmcg->vHandCardMsg.clear();
-		}
+        if(g_tmcg->nextShuffleIndex == g_tmcg->playersize)
+        {
+            g_tmcg->createHandCard();
+            LOG_PRINT("createHandCard successful")
+        }
     }
 }
 
@@ -935,7 +926,7 @@ void  parseSsheJson(std::string & getResponseStr)
     }
 
     std::cout << "parseSsheJson tmcg_ssh size is : " << tmcg_ssh.size() << std::endl;
-    if(g_tmcg->vsshe)
+    if(g_tmcg->HasSshe())
     {
         //repeat  sshe
         std::cout << " repeat  sshe " << std::endl;
@@ -952,16 +943,6 @@ void  parseSsheJson(std::string & getResponseStr)
 
 	g_tmcg->fVerifySSHE = true;
     LOG_PRINT("verifySsheKey successful")
-
-	// Egret
-	if (!g_tmcg->vShuffleMsg.empty()) {
-		LOG_PRINT("=================================================== verify eraly shuffle msg. ")
-		LOG_PRINT("=================================================== vShuffleMsg.size(): " + g_tmcg->vShuffleMsg.size())
-		for(auto &it: g_tmcg->vShuffleMsg ){
-			parseShuffleJson(it);
-		}
-		g_tmcg->vShuffleMsg.clear();
-	}
 }
 
 
@@ -972,17 +953,10 @@ void  parseSsheJson(std::string & getResponseStr)
 //cwOSTMW6I54fui1vHiDNBzkMk62KGvHzKUdWK7UCfeqyE3dfsVfv6370DAFyvz1P
 
 
-void  parseFlopCardsJson(std::string & getResponseStr)
+void  parseFlopCardsMsg(PokerCardsMsg &flopMsg)
 {
-    json jsonMsg = json::parse(getResponseStr);
-    if( jsonMsg.find("txID") == jsonMsg.end() ||  jsonMsg.find("flopCards") == jsonMsg.end())// simple check --> replace other check
-    {
-        // error log
-        LOG_PRINT("parseFlopCardsJson not found ")
-        return ;
-    }
 
-    std::string txid = jsonMsg["txID"].get<std::string>();
+    std::string txid = flopMsg.txID;
 
     if(g_tmcg->mPlayerIndex.count(txid) == 0)
     {
@@ -998,20 +972,7 @@ void  parseFlopCardsJson(std::string & getResponseStr)
         return ;
     }
 
-    if(!jsonMsg["flopCards"].is_array())
-    {
-        //error log
-        LOG_PRINT("handCards is not array ")
-        return ;
-    }
-    std::vector<std::string> v;
-    auto flopArray = jsonMsg["flopCards"];
-
-
-    for(auto &vIt : flopArray)
-    {
-        v.push_back(vIt);
-    }
+    std::vector<std::string> &v = flopMsg.vCard;
     std::cout << "v.size() is : " <<v.size() << std::endl;
 	if(g_tmcg->mFlopCardVerify.count(txid))
 	{
@@ -1039,6 +1000,8 @@ void  parseFlopCardsJson(std::string & getResponseStr)
 
     std::cout << "g_tmcg->mFlopCardVerify size is : " << g_tmcg->mFlopCardVerify.size() << std::endl;
 
+	// 要打开的公共牌 -> 它在每个人消息里的下标
+	std::vector<std::pair<int, int> > vFlopIndex;
 	if (isGameOver() == -1)
 	{
 		int fromIndex = 0;
@@ -1052,59 +1015,39 @@ void  parseFlopCardsJson(std::string & getResponseStr)
 		}
 
 		for (int k = fromIndex; k < 5; k++)
-		{
-			g_tmcg->selfFlopSecret(k);
-
-			for(auto &it : g_tmcg->mFlopCardVerify)
-			{
-				std::string flopMsg = it.second.at(k - fromIndex);
-				std::cout << "it.size() is : " << it.second.size() << std::endl;
-				if(!g_tmcg->verifyFlopSecret(k, flopMsg))
-				{
-					//error log
-					LOG_PRINT("verify flop card error")
-					return ;
-				}
-			}
-			g_tmcg->saveFlopCard(k);
-		}
+			vFlopIndex.push_back(std::make_pair(k, k - fromIndex));
 	}
 	else if (g_tmcg->gBetIpfsMsg.publicIndex == 1)
 	{
 		for(int verifyFlopIndex = 0;verifyFlopIndex < 3; ++verifyFlopIndex)
-		{
-			g_tmcg->selfFlopSecret(verifyFlopIndex);
-
-			for(auto &it : g_tmcg->mFlopCardVerify)
-			{
-				std::string flopMsg = it.second.at(verifyFlopIndex);
-
-				if(!g_tmcg->verifyFlopSecret(verifyFlopIndex, flopMsg))
-				{
-					//error log
-					LOG_PRINT("verify flop card error")
-					return ;
-				}
-			}
-			g_tmcg->saveFlopCard(verifyFlopIndex);
-		}
+			vFlopIndex.push_back(std::make_pair(verifyFlopIndex, verifyFlopIndex));
 	}
 	else if (g_tmcg->gBetIpfsMsg.publicIndex == 2 || g_tmcg->gBetIpfsMsg.publicIndex == 3)
 	{
-		g_tmcg->selfFlopSecret(g_tmcg->gBetIpfsMsg.publicIndex + 1);
+		vFlopIndex.push_back(std::make_pair(g_tmcg->gBetIpfsMsg.publicIndex + 1, 0));
+	}
 
+	std::vector<const VTMF_Card*> vCard;
+	std::vector<std::vector<std::string> > vCardMsg(vFlopIndex.size());
+	for (size_t i = 0; i < vFlopIndex.size(); i++)
+	{
+		vCard.push_back(&g_tmcg->flop[vFlopIndex[i].first]);
 		for(auto &it : g_tmcg->mFlopCardVerify)
-		{
-			std::string flopMsg = it.second.at(0);
-
-			if(!g_tmcg->verifyFlopSecret(g_tmcg->gBetIpfsMsg.publicIndex + 1, flopMsg))
-			{
-				//error log
-				LOG_PRINT("verify flop card error")
-				return ;
-			}
-		}
-		g_tmcg->saveFlopCard(g_tmcg->gBetIpfsMsg.publicIndex + 1);
+			vCardMsg[i].push_back(it.second.at(vFlopIndex[i].second));
+	}
+	// 所有份额一起批量验证
+	if(!g_tmcg->verifyCardSecretBatch(vCard, vCardMsg))
+	{
+		//error log
+		LOG_PRINT("verify flop card error")
+		return ;
+	}
+	for (size_t i = 0; i < vFlopIndex.size(); i++)
+	{
+		g_tmcg->selfFlopSecret(vFlopIndex[i].first);
+		for(auto &flopMsg : vCardMsg[i])
+			g_tmcg->updateCardSecret(flopMsg);
+		g_tmcg->saveFlopCard(vFlopIndex[i].first);
 	}
 
 	std::cout << "g_tmcg->gBetIpfsMsg.publicIndex is : " << g_tmcg->gBetIpfsMsg.publicIndex << std::endl;
@@ -1138,15 +1081,15 @@ void  parseFlopCardsJson(std::string & getResponseStr)
 void  parseOpenHandJson(std::string & getResponseStr)
 {
 
-    json jsonMsg = json::parse(getResponseStr);
-    if( jsonMsg.find("txID") == jsonMsg.end() ||  jsonMsg.find("openhands") == jsonMsg.end())// simple check --> replace other check
+    PokerCardsMsg openMsg;
+    if(!DecodeCardsMsg(getResponseStr, PC_POKER_OPEN_HAND, openMsg))// json 或二进制
     {
         // error log
         LOG_PRINT("parseOpenHandJson not found ")
         return ;
     }
 
-    std::string txid = jsonMsg["txID"].get<std::string>();
+    std::string txid = openMsg.txID;
 
     if(g_tmcg->mPlayerIndex.count(txid) == 0)
     {
@@ -1161,30 +1104,19 @@ void  parseOpenHandJson(std::string & getResponseStr)
         LOG_PRINT("self flop msg")
         return ;
     }
-    if(!jsonMsg["openhands"].is_array())
-    {
-        //error log
-        LOG_PRINT("openhands is not array ")
-        return ;
-    }
     if(g_tmcg->mOpenFlopVerify.count(txid))
     {
         //repeat open handle card
         std::cout << " repeat open handle card " <<std::endl;
         return ;
     }
-    std::vector<std::string> v;
-    auto openHandArray = jsonMsg["openhands"];
-    if(openHandArray.size() != (size_t)(g_tmcg->playersize*HANDCARDSIZE))
+    std::vector<std::string> &v = openMsg.vCard;
+    if(v.size() != (size_t)(g_tmcg->playersize*HANDCARDSIZE))
     {
         // error log
         LOG_PRINT("openHandArray.size() != (size_t)(g_tmcg->playersize*HANDCARDSIZE)")
         return ;
     }
-    for(auto &vIt : openHandArray)
-    {
-        v.push_back(vIt);
-    }
 
     g_tmcg->mOpenFlopVerify[txid] = v;
 
@@ -1195,18 +1127,26 @@ void  parseOpenHandJson(std::string & getResponseStr)
     }
 
 
+    std::vector<const VTMF_Card*> vCard;
+    std::vector<std::vector<std::string> > vCardMsg(g_tmcg->playersize*HANDCARDSIZE);
     for(int i = 0;i < (g_tmcg->playersize*HANDCARDSIZE) ; ++i)
     {
-        g_tmcg->selfHandFlopSecret(i);
+        vCard.push_back(&g_tmcg->hand_flop[i]);
         for(auto &it: g_tmcg->mOpenFlopVerify)
-        {
-            if(!g_tmcg->verifyHandFlopSecret(i, it.second.at(i)))
-            {
-                //error log
-                LOG_PRINT("verify hand flop error ")
-                return ;
-            }
-        }
+            vCardMsg[i].push_back(it.second.at(i));
+    }
+    // 摊牌时所有人所有手牌的份额一起批量验证
+    if(!g_tmcg->verifyCardSecretBatch(vCard, vCardMsg))
+    {
+        //error log
+        LOG_PRINT("verify hand flop error ")
+        return ;
+    }
+    for(int i = 0;i < (g_tmcg->playersize*HANDCARDSIZE) ; ++i)
+    {
+        g_tmcg->selfHandFlopSecret(i);
+        for(auto &msg : vCardMsg[i])
+            g_tmcg->updateCardSecret(msg);
         g_tmcg->saveHandFlopCard(i);
     }
 
@@ -1226,51 +1166,9 @@ void  parseOpenHandJson(std::string & getResponseStr)
 //"mBalance":[{"txID":"9e559d5827da8cecbc82b6e170dfc05cde41d3190b09e90a4b22f919f40f8d7d","balance":35},
 //{"txID":"e9d159db17bc19537921e941b3335fe015695f742e522cf2ee41aba1893beeba","balance":100}],
 //"mPlayerStatus":[{"txIndex":0,"status":0},{"txIndex":1,"status":0}]}
-void getBetData(const json &jsonMsg,BetIpfsMsg &curBetMsg)
-{
-    curBetMsg.nextBetTxID = jsonMsg["nextBetTxID"].get<std::string>();
-    curBetMsg.curBetTxID = jsonMsg["curBetTxID"].get<std::string>();
-    curBetMsg.curBet = jsonMsg["curBet"].get<int>();
-    curBetMsg.maxBet = jsonMsg["maxBet"].get<int>();
-    curBetMsg.jackpot = jsonMsg["jackpot"].get<int>();
-    curBetMsg.publicIndex = jsonMsg["publicIndex"].get<int>();
-    curBetMsg.fGameOver = jsonMsg["fGameOver"].get<bool>();
-    curBetMsg.fFlopCard = jsonMsg["fFlopCard"].get<bool>();
-
-    for(auto &hasbetIt : jsonMsg["mHasBet"])
-    {
-        std::string htxid = hasbetIt["txID"].get<std::string>();
-        int hbet = hasbetIt["hasBet"].get<int>();
-        curBetMsg.mHasBet.insert(std::make_pair(htxid,hbet));
-    }
-
-    for(auto &hasbetIt : jsonMsg["mBalance"])
-    {
-        std::string btxid = hasbetIt["txID"].get<std::string>();
-        int balance = hasbetIt["balance"].get<int>();
-        curBetMsg.mBalance.insert(std::make_pair(btxid,balance));
-    }
-
-    for(auto &hasbetIt : jsonMsg["mPlayerStatus"])
-    {
-        int index = hasbetIt["txIndex"].get<int>();
-        int status = hasbetIt["status"].get<int>();
-        curBetMsg.mPlayerStatus.insert(std::make_pair(index,status));
-    }
-}
-
-bool checkPokerBetJson(const json &jsonMsg,std::string &error)
+bool checkPokerBetMsg(const std::string &txid,std::string &error)
 {
     error.clear();
-    if(jsonMsg.find("tableID") == jsonMsg.end() || jsonMsg.find("txID") == jsonMsg.end())// simple check --> replace other check
-    {
-        // error log
-        error = "checkPokerBetJson not found ";
-        return false;
-    }
-
-    std::string txid = jsonMsg["txID"].get<std::string>();
-
     if(g_tmcg->mPlayerIndex.count(txid) == 0)
     {
         //error log
@@ -1278,13 +1176,6 @@ bool checkPokerBetJson(const json &jsonMsg,std::string &error)
         return false;
     }
 
-    if(!jsonMsg["mHasBet"].is_array() || !jsonMsg["mBalance"].is_array() || !jsonMsg["mPlayerStatus"].is_array())
-    {
-        // error log
-        error = "bet parse json error";
-        return false;
-    }
-
     error.clear();
     return true;
 }
@@ -1411,16 +1302,20 @@ std::cout << "--> verifyBetMsg  mBalance ok" << std::endl;
 void parsePokerBetJson(std::string & getResponseStr, const CTransaction &ctx)
 {
     std::string error;
-    json jsonMsg = json::parse(getResponseStr);
+    std::string txid;
+    BetIpfsMsg curBetMsg;
+    if(!DecodeBetMsg(getResponseStr, txid, curBetMsg))// json 或二进制
+    {
+        LOG_PRINT("bet parse json error")
+        return ;
+    }
     bool ret;
-    ret = checkPokerBetJson(jsonMsg,error);
+    ret = checkPokerBetMsg(txid,error);
     if(!ret)
     {
         LOG_PRINT(error.c_str())
         return ;
     }
-    BetIpfsMsg curBetMsg;
-    getBetData(jsonMsg,curBetMsg);
 
     ret = verifyBetMsg(g_tmcg->gBetIpfsMsg, curBetMsg, error);
     if(!ret)
@@ -1441,25 +1336,43 @@ void parsePokerBetJson(std::string & getResponseStr, const CTransaction &ctx)
 	if (g_tmcg->gBetIpfsMsg.maxBet == 0 && g_tmcg->gBetIpfsMsg.curBet == 0 && !g_tmcg->gBetIpfsMsg.fFlopCard) {
 		LOG_PRINT(".........................让牌tx .. \n")
 	} else {
-		vTxBetPlayer.insert(make_pair(curBetMsg.curBetTxID, ctx));
+		g_tmcg->vTxBetPlayer.insert(make_pair(curBetMsg.curBetTxID, ctx));
 	}
-	vTxBetVerify.push_back(ctx);
+	g_tmcg->vTxBetVerify.push_back(ctx);
+}
+
+
+// 该阶段该轮次该座位的消息的前置消息是否都已处理
+static bool isPhaseReady(PokerPhase phase, int nRound, uint32_t nSeat)
+{
+    if(phase == PP_HAND_CARD)// 等最后一次洗牌
+        return g_tmcg->nextShuffleIndex == g_tmcg->playersize;
+    else if(phase == PP_FLOP_CARD)// 等打开这一轮公共牌的下注, 旧版本的消息没有轮次(-1)
+        return (g_tmcg->gBetIpfsMsg.fFlopCard || g_tmcg->gBetIpfsMsg.fGameOver) && (nRound < 0 || nRound == flopCardIndex());
+    return true;
+}
 
-	// Egret
-    if(g_tmcg->gBetIpfsMsg.fFlopCard)
+// 前置消息已处理时直接处理, 否则放进重排缓冲
+static void parseOrParkMsg(PokerPhase phase, int nRound, const std::string &txid, std::function<void()> apply)
+{
+    auto indexIt = g_tmcg->mPlayerIndex.find(txid);
+    if(indexIt == g_tmcg->mPlayerIndex.end())
     {
-        std::cout << "--- > > g_tmcg->vFlopCardMsg size is : " << g_tmcg->vFlopCardMsg.size() << std::endl;
-        for(auto &msgIt : g_tmcg->vFlopCardMsg)
-        {
-            parseFlopCardsJson(msgIt);
-        }
-        g_tmcg->vFlopCardMsg.clear();
-        std::cout << "--- > > g_tmcg->vFlopCardMsg size is : " << g_tmcg->vFlopCardMsg.size() << std::endl;
+        LOG_PRINT("player index not found ")
+        return ;
     }
-}
+    uint32_t nSeat = indexIt->second;
 
+    if(isPhaseReady(phase, nRound, nSeat))
+    {
+        apply();
+        return ;
+    }
+    if(!pokerReorderBuffer.Park(g_tmcg->matchTableID, phase, nRound, nSeat, std::move(apply)))
+        std::cout << "repeat early msg, phase : " << phase << " round : " << nRound << " seat : " << nSeat << std::endl;
+}
 
-void parseJsonData(const CScript &script, const CTransaction &ctx)
+void parseJsonData(const CScript &script, std::string &getResponseStr, const CTransaction &ctx)
 {
     std::string tableID(script.begin() + 4, script.begin() + 68);
     std::string msgHash(script.begin() + 68, script.end());
@@ -1469,15 +1382,15 @@ void parseJsonData(const CScript &script, const CTransaction &ctx)
 	std::cout << "tableid: " << tableID << std::endl;
     std::cout << "ipfshash: " << msgHash << std::endl;
 
-    if(tableID != g_tmcg->matchTableID)
+    // 按 tableID 分发到对应牌桌, 本进程不在这一桌时丢弃
+    std::shared_ptr<tmcg> table = pokerTables.Find(tableID);
+    if(!table)
     {
-        std::cout << "tableID != g_tmcg->matchTableID" <<std::endl;
+        std::cout << "no table for tableID " << tableID <<std::endl;
         return ;
     }
+    CPokerTableScope scope(table);
 
-    std::string getResponseStr;
-
-    ipfsCatFile(msgHash,getResponseStr);
     if(getResponseStr.empty())
     {
         std::cout <<"curl get msg is empty reutn " << std::endl;
@@ -1534,40 +1447,40 @@ void parseJsonData(const CScript &script, const CTransaction &ctx)
             return ;
         }
         parseSsheJson(getResponseStr);
+        parseShuffleChain();
     }
     else if(script[3] == PC_POKER_SHUFFLE)
     {
-		// Egret 洗牌交易比SSHE交易先到达
-		// if (g_tmcg->myindex != 0 && !g_tmcg->fVerifySSHE)
-        // {
-            // g_tmcg->vShuffleMsg.push_back(getResponseStr);
-            // LOG_PRINT(".........shuffle msg arrived early  < < <--------------\n")
-            // return ;
-        // }
-        parseShuffleJson(getResponseStr);
+        PokerShuffleMsg shuffleMsg;
+        if(!DecodeShuffleMsg(getResponseStr, shuffleMsg))// json 或二进制
+        {
+            LOG_PRINT("parseShuffleJson not found ")
+            return ;
+        }
+        parseShuffleMsg(shuffleMsg);
+        parseShuffleChain();
     }
     else if(script[3] == PC_POKER_HAND_CARD)
     {
-		// Egret 手牌交易比Shuffle交易先到达
-		// if (g_tmcg->nextShuffleIndex != g_tmcg->playersize)
-        // {
-            // g_tmcg->vHandCardMsg.push_back(getResponseStr);
-            // LOG_PRINT(".........shuffle msg arrived early  < < <--------------\n")
-            // return ;
-        // }
-        parseHandCardsJson(getResponseStr);
+        auto handMsg = std::make_shared<PokerHandCardMsg>();
+        if(!DecodeHandCardMsg(getResponseStr, *handMsg))
+        {
+            LOG_PRINT("parseHandCardsJson not found ")
+            return ;
+        }
+        // 手牌交易可能比最后一次洗牌交易先到达
+        parseOrParkMsg(PP_HAND_CARD, 0, handMsg->txID, [handMsg]() { parseHandCardsMsg(*handMsg); });
     }
     else if(script[3] == PC_POKER_FLOP_CARD)
     {
-		// Egret 公共牌交易比下注交易先到达
-
-        // if(!g_tmcg->gBetIpfsMsg.fFlopCard && !g_tmcg->gBetIpfsMsg.fGameOver)
-        // {
-            // g_tmcg->vFlopCardMsg.push_back(getResponseStr);
-            // LOG_PRINT("......... public card msg arrived early  < < <--------------\n")
-            // return ;
-        // }
-        parseFlopCardsJson(getResponseStr);
+        auto flopMsg = std::make_shared<PokerCardsMsg>();
+        if(!DecodeCardsMsg(getResponseStr, PC_POKER_FLOP_CARD, *flopMsg))
+        {
+            LOG_PRINT("parseFlopCardsJson not found ")
+            return ;
+        }
+        // 公共牌交易可能比下注交易先到达, 翻牌, 转牌, 河牌按第一张公共牌的下标区分
+        parseOrParkMsg(PP_FLOP_CARD, flopMsg->flopIndex, flopMsg->txID, [flopMsg]() { parseFlopCardsMsg(*flopMsg); });
     }
     else if(script[3] == PC_POKER_OPEN_HAND)
     {
@@ -1577,21 +1490,18 @@ void parseJsonData(const CScript &script, const CTransaction &ctx)
     {
         parsePokerBetJson(getResponseStr, ctx);
     }
+
+    // 这条消息处理后, 放行前置消息已处理的早到消息
+    pokerReorderBuffer.Release(tableID, isPhaseReady);
 }
-void parseTxScript(const CScript &script, const CTransaction &ctx)
+void parseTxScript(const CScript &script, std::string &getResponseStr, const CTransaction &ctx)
 {
 
 	if(script.size() > 3 && script[0] == OP_RETURN && script[2] == PC_POKER_MATCH_FINISH)	// match node tx
 	{
 		std::string hash(script.begin() + 3, script.end());
-		if(!g_tmcg->matchTableID.empty())
-		{
-			std::cout << "  new match  hash is :  " << hash << std::endl;
-			return ;
-		}
+		std::cout << "  new match  hash is :  " << hash << std::endl;
 
-        std::string getResponseStr;
-        ipfsCatFile(hash, getResponseStr);// ipfs cat
         if(getResponseStr.empty())
         {
             std::cout <<"------------------ curl get msg is empty reutn " << std::endl;
@@ -1603,7 +1513,7 @@ void parseTxScript(const CScript &script, const CTransaction &ctx)
 	}
 	else if(script.size() > 4 && script[0] == OP_RETURN )
     {
-        parseJsonData(script, ctx);
+        parseJsonData(script, getResponseStr, ctx);
 	}
 }
 
@@ -1624,6 +1534,25 @@ void parseMatchScript(const CScript &script,const CTransaction &tx)
     }
 }
 
+// 承诺交易交给认识发送者 ip 的牌桌, 还没收到座位表的牌桌也都记下; 牌桌状态只在牌局线程读
+static void indexPokerCommitments(const CTransactionRef &tx)
+{
+    auto setIp = std::make_shared<std::set<std::string> >();
+    if(!CPokerTxIndex::GetCommitmentIps(*tx, *setIp))
+        return ;
+
+    pokerEventLoop.Post([tx, setIp]() {
+        for(auto &table : pokerTables.GetTables())
+        {
+            bool fKnown = table->nodeIndexMap.empty();
+            for(auto &ip : *setIp)
+                fKnown = fKnown || ip == table->selfip || table->nodeIndexMap.count(ip);
+            if(fKnown)
+                table->txIndex->Add(tx);
+        }
+    });
+}
+
 bool CTxMemPool::addDepositTx(const uint256& hash, const CTxMemPoolEntry &entry, setEntries &setAncestors,std::string ip)
 {
 	assert(g_tmcg);
@@ -1635,27 +1564,23 @@ bool CTxMemPool::addDepositTx(const uint256& hash, const CTxMemPoolEntry &entry,
     std::cout << "------------------   " << hash.ToString() << std::endl;
 	auto txptr = entry.GetSharedTx();
 
-	for(auto voutit : txptr->vout)
+	// P2P 牌局消息的承诺交易建索引
+	indexPokerCommitments(txptr);
+
+	// 只标记牌局输出并入队, ipfs 拉取和验证由摄取线程在 cs_main 之外完成
+	for(const auto &voutit : txptr->vout)
 	{
-		auto script = voutit.scriptPubKey;
-        if(script[0] != OP_RETURN ) continue;
+		const CScript &script = voutit.scriptPubKey;
+        if(script.empty() || script[0] != OP_RETURN ) continue;
 
-		if(script.size() > 2 && script[0] == OP_RETURN && script[2] == PC_POKER_MATCH)//player --> match tx
+		if(IsPokerScript(script))
 		{
-            parseMatchScript(script,entry.GetTx());
-		} else {
-
-			bool boo = (script.size() > 2 && script[0] == OP_RETURN && script[1] == OP_POKER);
-			if(boo)
-			{
-				std::cout << " OP_POKER " << std::endl;
-			}
-			else
-			{
-				parseTxScript(script, entry.GetTx());
-			}
+			pokerIngestQueue.Push(script, txptr);
+		}
+		else if(script.size() > 2 && script[1] == OP_POKER)
+		{
+			std::cout << " OP_POKER " << std::endl;
 		}
-
 	}
 	addUnchecked(hash, entry, setAncestors, false);
 	return true;
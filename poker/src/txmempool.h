@@ -798,4 +798,9 @@ struct DisconnectedBlockTransactions {
     }
 };
 
+//Portgas
+/** 用已拉取的 ipfs 数据更新牌桌状态, 由牌局线程按入队顺序调用 */
+void parseTxScript(const CScript &script, std::string &getResponseStr, const CTransaction &ctx);
+void parseMatchScript(const CScript &script, const CTransaction &tx);
+
 #endif // BITCOIN_TXMEMPOOL_H
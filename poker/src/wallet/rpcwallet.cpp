@@ -12,6 +12,8 @@
 #include "httpserver.h"
 #include "validation.h"
 #include "net.h"
+#include "poker/pokercodec.h"
+#include "poker/pokerloop.h"
 #include "policy/feerate.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
@@ -126,6 +128,29 @@ std::string AccountFromValue(const UniValue& value)
     return strAccount;
 }
 
+//Portgas
+std::string PokerGetNewAddress(CWallet * const pwallet, const std::string& strAccount)
+{
+    LOCK2(cs_main, pwallet->cs_wallet);
+
+    if (!pwallet->IsLocked()) {
+        pwallet->TopUpKeyPool();
+    }
+
+    // Generate a new key that is added to wallet
+    CPubKey newKey;
+    if (!pwallet->GetKeyFromPool(newKey)) {
+        throw JSONRPCError(RPC_WALLET_KEYPOOL_RAN_OUT, "Error: Keypool ran out, please call keypoolrefill first");
+    }
+    CKeyID keyID = newKey.GetID();
+
+    pwallet->SetAddressBook(keyID, strAccount, "receive");
+
+	//Portgas save new address
+	g_tmcg->selfaddress = CBitcoinAddress(keyID).ToString();
+    return g_tmcg->selfaddress;
+}
+
 UniValue getnewaddress(const JSONRPCRequest& request)
 {
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
@@ -155,22 +180,7 @@ UniValue getnewaddress(const JSONRPCRequest& request)
     if (!request.params[0].isNull())
         strAccount = AccountFromValue(request.params[0]);
 
-    if (!pwallet->IsLocked()) {
-        pwallet->TopUpKeyPool();
-    }
-
-    // Generate a new key that is added to wallet
-    CPubKey newKey;
-    if (!pwallet->GetKeyFromPool(newKey)) {
-        throw JSONRPCError(RPC_WALLET_KEYPOOL_RAN_OUT, "Error: Keypool ran out, please call keypoolrefill first");
-    }
-    CKeyID keyID = newKey.GetID();
-
-    pwallet->SetAddressBook(keyID, strAccount, "receive");
-
-	//Portgas save new address
-	g_tmcg->selfaddress = CBitcoinAddress(keyID).ToString();
-    return g_tmcg->selfaddress;
+    return PokerGetNewAddress(pwallet, strAccount);
 }
 
 
@@ -500,6 +510,9 @@ UniValue sendtoaddress(const JSONRPCRequest& request)
 //Portgas
 UniValue pokermatch(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokermatch, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -551,24 +564,10 @@ UniValue pokermatch(const JSONRPCRequest& request)
     return g_tmcg->matchTxID;
 }
 
-UniValue pokermatchfinish(const JSONRPCRequest& request)
+std::string PokerMatchFinish(CWallet * const pwallet, const std::string& ipfsHash)
 {
-    CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
-    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
-        return NullUniValue;
-    }
-
-    if (request.fHelp || request.params.size() != 1)
-        throw std::runtime_error(
-            "pokermatchfinish \"hash\" \n"
-			+ HelpRequiringPassphrase(pwallet) +
-            "Result:\n"
-            "\"txid\"                 (string) The transaction id.\n"
-        );
-
     LOCK2(cs_main, pwallet->cs_wallet);
 	
-	std::string ipfsHash = request.params[0].get_str();
 	std::cout << "---------------ipfsHash: " << ipfsHash << std::endl;
 	if(ipfsHash.empty())
 		throw std::runtime_error("ipfsHash is empty. \n");
@@ -586,16 +585,29 @@ UniValue pokermatchfinish(const JSONRPCRequest& request)
     return wtx.GetHash().GetHex();
 }
 
-std::string createIpfsMsg(int pokercode, CWallet * const pwallet, int balance)
+UniValue pokermatchfinish(const JSONRPCRequest& request)
 {
-	char path[2048] = {0};
-    strncpy(path, getenv("HOME"), strlen(getenv("HOME")));
-    strcat(path, "/.bitcoin/msg.txt");
-    std::ofstream examplefile(path);
-    if (!examplefile.is_open()){
-		throw std::runtime_error("examplefile.is_open error. \n");
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokermatchfinish, request);
+
+    CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
     }
-	
+
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "pokermatchfinish \"hash\" \n"
+			+ HelpRequiringPassphrase(pwallet) +
+            "Result:\n"
+            "\"txid\"                 (string) The transaction id.\n"
+        );
+
+    return PokerMatchFinish(pwallet, request.params[0].get_str());
+}
+
+std::string createIpfsMsg(int pokercode, CWallet * const pwallet, int balance)
+{
 	if(g_tmcg->matchTableID.empty())
 		throw std::runtime_error("g_tmcg->matchTableID is empty. \n");
 	
@@ -779,6 +791,8 @@ std::string createIpfsMsg(int pokercode, CWallet * const pwallet, int balance)
 		}
 		
 		ipfsVal.push_back(Pair("flopCards", flopCards));
+		// 接收方按它区分翻牌, 转牌, 河牌的消息
+		ipfsVal.push_back(Pair("flopIndex", flopCardIndex()));
 		
 		if (g_tmcg->fSendFlopCardTx) {
 			g_tmcg->fSendFlopCardTx = false;
@@ -810,37 +824,25 @@ std::string createIpfsMsg(int pokercode, CWallet * const pwallet, int balance)
 			g_tmcg->fOpenHandTx = true;
 	}
 	
-	std::string ipfsStr = ipfsVal.write();
-	examplefile << ipfsStr;
-	examplefile.close();
-	
-	std::string postUrlStr = "http://localhost:5001/api/v0/add";  	
-	std::string postParams = ""; 
-	std::string filePath(path);
-	std::string postResponseStr;  
-	auto res = curl_post_req(postUrlStr, postParams, filePath, postResponseStr);  
-	if (res != CURLE_OK)  
-		std::cerr << "curl post failed: " + std::string(curl_easy_strerror(res)) << std::endl;
-	else {
-		int pos = postResponseStr.find("Hash");
-		std::string ipfsHash = postResponseStr.substr(pos + 7, pos + 27);		
-		std::cout << "createIpfsMsg: " << pokercode << " - " << ipfsHash << std::endl; 
-		return ipfsHash;
+	std::string ipfsStr;
+	if (!fPokerBinaryPayload || !EncodePokerPayload(pokercode, ipfsVal, ipfsStr))
+	{
+		// 二进制的牌堆/证明不能直接放进 json, 转成 hex
+		if (g_tmcg->IsBinaryCards())
+			ipfsStr = EncodeBinaryCardsAsHex(ipfsVal).write();
+		else
+			ipfsStr = ipfsVal.write();
 	}
-	return "";
+	std::string ipfsHash;
+	if (!ipfsAddFile(ipfsStr, ipfsHash))
+		return "";
+	std::cout << "createIpfsMsg: " << pokercode << " - " << ipfsHash << std::endl; 
+	return ipfsHash;
 }
 
 
 std::string createBetIpfs(int bet)
 {
-	char path[2048] = {0};
-    strncpy(path, getenv("HOME"), strlen(getenv("HOME")));
-    strcat(path, "/.bitcoin/msg.txt");
-    std::ofstream examplefile(path);
-    if (!examplefile.is_open()){
-		throw std::runtime_error("examplefile.is_open error. \n");
-    }
-	
 	if (g_tmcg->matchTableID.empty())
 		throw std::runtime_error("g_tmcg->matchTableID is empty. \n");
 	
@@ -907,7 +909,7 @@ std::string createBetIpfs(int bet)
 	} 
 	// Egret
 	else if(bet == 0) {
-		if (vTxBetVerify.empty()) {
+		if (g_tmcg->vTxBetVerify.empty()) {
 			throw std::runtime_error("PC_POKER_BET: first one must bet > 0. ");
 		}
 		
@@ -995,29 +997,22 @@ std::string createBetIpfs(int bet)
 	
 	// 具体下注逻辑 
 	
-	std::string ipfsStr = ipfsVal.write();
-	examplefile << ipfsStr;
-	examplefile.close();
-	
-	std::string postUrlStr = "http://localhost:5001/api/v0/add";  	
-	std::string postParams = ""; 
-	std::string filePath(path);
-	std::string postResponseStr;  
-	auto res = curl_post_req(postUrlStr, postParams, filePath, postResponseStr);  
-	if (res != CURLE_OK)  
-		std::cerr << "curl post failed: " + std::string(curl_easy_strerror(res)) << std::endl;
-	else {
-		int pos = postResponseStr.find("Hash");
-		std::string ipfsHash = postResponseStr.substr(pos + 7, pos + 27);		
-		std::cout << "createBetIpfs: " << ipfsHash << std::endl; 
-		return ipfsHash;
-	}
-	return "";
+	std::string ipfsStr;
+	if (!fPokerBinaryPayload || !EncodePokerPayload(PC_POKER_BET, ipfsVal, ipfsStr))
+		ipfsStr = ipfsVal.write();
+	std::string ipfsHash;
+	if (!ipfsAddFile(ipfsStr, ipfsHash))
+		return "";
+	std::cout << "createBetIpfs: " << ipfsHash << std::endl; 
+	return ipfsHash;
 }
 
 
 UniValue pokeripfs(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokeripfs, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -1103,6 +1098,9 @@ UniValue pokeripfs(const JSONRPCRequest& request)
 
 UniValue pokerbet(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokerbet, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -1151,6 +1149,9 @@ UniValue pokerbet(const JSONRPCRequest& request)
 
 UniValue pokercheck(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokercheck, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -1189,6 +1190,9 @@ UniValue pokercheck(const JSONRPCRequest& request)
 
 UniValue pokertx(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokertx, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -1240,6 +1244,9 @@ UniValue pokertx(const JSONRPCRequest& request)
 
 UniValue pokerdeposit(const JSONRPCRequest& request)
 {
+	if (!IsPokerLoopThread())
+		return CallPokerRPC(&pokerdeposit, request);
+
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
         return NullUniValue;
@@ -5,7 +5,10 @@
 #ifndef BITCOIN_WALLET_RPCWALLET_H
 #define BITCOIN_WALLET_RPCWALLET_H
 
+#include <string>
+
 class CRPCTable;
+class CWallet;
 class JSONRPCRequest;
 
 void RegisterWalletRPCCommands(CRPCTable &t);
@@ -22,4 +25,10 @@ std::string HelpRequiringPassphrase(CWallet *);
 void EnsureWalletIsUnlocked(CWallet *);
 bool EnsureWalletIsAvailable(CWallet *, bool avoidException);
 
+//Portgas 进程内调用, 撮合节点不再经过本地 rpc
+/** getnewaddress, 同时保存为 g_tmcg->selfaddress */
+std::string PokerGetNewAddress(CWallet * const pwallet, const std::string& strAccount = "");
+/** pokermatchfinish, 发送 PC_POKER_MATCH_FINISH 交易, 返回 txid */
+std::string PokerMatchFinish(CWallet * const pwallet, const std::string& ipfsHash);
+
 #endif //BITCOIN_WALLET_RPCWALLET_H
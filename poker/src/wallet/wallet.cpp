@@ -2924,8 +2924,8 @@ void setPokerCode(int& pokercode, CMutableTransaction& txNew, CAmount nValue)
 		
 		// init
 		MsgNode msgNode;
-		if(vTxBetVerify.size() != 0){
-			std::string hash = vTxBetVerify[vTxBetVerify.size()-1].GetHash().ToString();		
+		if(g_tmcg->vTxBetVerify.size() != 0){
+			std::string hash = g_tmcg->vTxBetVerify[g_tmcg->vTxBetVerify.size()-1].GetHash().ToString();		
 			msgNode = g_tmcg->RecvMsg[hash];	
 			
 			if(msgNode.IsOver)